@@ -40,5 +40,13 @@
 #define PRACTICALLY_CONVERGED  6
 #define UNCONDITIONAL_LOCK_IT  7
 
+/* True if the user asked for the event stream (see eventParams) */
+#define EVENTS_ON(primme) ((primme)->eventParams.eventFun != NULL || \
+                           (primme)->eventParams.file != NULL)
+
+/* Default denseThreshold: the dense solver is off unless the user sets */
+/* it (see TEST/dense_bench.c for the crossover with the iterative one) */
+#define PRIMME_DENSE_THRESHOLD -1
+
 
 #endif /* CONST_H */
@@ -0,0 +1,179 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ * File: counters.c
+ *
+ * Purpose - Hardware counters (cycles, instructions and last level cache
+ *           misses) of the calling thread through the Linux perf_event_open
+ *           system call. They are compiled only with -DPRIMME_PERF_COUNTERS;
+ *           otherwise primme_counters_open always fails and the solver
+ *           measures only times.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+#ifdef PRIMME_PERF_COUNTERS
+#  include <unistd.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#  include <linux/perf_event.h>
+#endif
+#include "primme.h"
+#include "counters.h"
+
+#ifdef PRIMME_PERF_COUNTERS
+
+/*******************************************************************************
+ * Subroutine primme_counters_open - Opens a group of counters, one per
+ *    primme_counter up to primme_num_counters, that count the user-space
+ *    events of the calling thread on any CPU, and starts them.
+ *
+ * OUTPUT PARAMETERS
+ * -----------------
+ * fds         The file descriptors of the counters; the first is the leader
+ *             of the group. All are -1 on failure.
+ *
+ * Return value
+ * ------------
+ * 0 on success, or -1 if the kernel refused some counter (e.g., no PMU is
+ * exposed or /proc/sys/kernel/perf_event_paranoid is too high)
+ *
+ ******************************************************************************/
+
+int primme_counters_open(int *fds) {
+
+   static const unsigned long long config[primme_num_counters] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES};
+   struct perf_event_attr attr;
+   int i;
+
+   for (i=0; i < primme_num_counters; i++) fds[i] = -1;
+
+   for (i=0; i < primme_num_counters; i++) {
+      memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = config[i];
+      attr.disabled = (i == 0);
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      fds[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1,
+            i == 0 ? -1 : fds[0], 0);
+      if (fds[i] < 0) {
+         primme_counters_close(fds);
+         return -1;
+      }
+   }
+
+   ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+   ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+   return 0;
+}
+
+
+/*******************************************************************************
+ * Subroutine primme_counters_read - Reads all counters of the group at once.
+ *
+ * INPUT PARAMETERS
+ * ----------------
+ * fds         The counters returned by primme_counters_open
+ *
+ * OUTPUT PARAMETERS
+ * -----------------
+ * values      The current counts, primme_num_counters of them
+ *
+ ******************************************************************************/
+
+void primme_counters_read(int *fds, double *values) {
+
+   unsigned long long buf[1 + primme_num_counters];
+   int i;
+
+   if (read(fds[0], buf, sizeof(buf)) != (ssize_t)sizeof(buf)) {
+      buf[0] = 0;
+   }
+   for (i=0; i < primme_num_counters; i++) {
+      values[i] = i < (int)buf[0] ? (double)buf[1+i] : 0.0;
+   }
+}
+
+
+/*******************************************************************************
+ * Subroutine primme_counters_close - Closes the counters that are open.
+ *
+ ******************************************************************************/
+
+void primme_counters_close(int *fds) {
+
+   int i;
+
+   for (i=primme_num_counters-1; i >= 0; i--) {
+      if (fds[i] >= 0) close(fds[i]);
+      fds[i] = -1;
+   }
+}
+
+
+/*******************************************************************************
+ * Function primme_counters_line_size - Returns the size in bytes of the lines
+ *    of the last level cache, so that every miss is estimated as a transfer
+ *    of one line from memory. It assumes 64 if the size is unknown.
+ *
+ ******************************************************************************/
+
+double primme_counters_line_size(void) {
+
+#ifdef _SC_LEVEL3_CACHE_LINESIZE
+   long l3 = sysconf(_SC_LEVEL3_CACHE_LINESIZE);
+   long l2 = sysconf(_SC_LEVEL2_CACHE_LINESIZE);
+   if (l3 > 0) return (double)l3;
+   if (l2 > 0) return (double)l2;
+#endif
+   return 64.0;
+}
+
+#else
+
+int primme_counters_open(int *fds) {
+   int i;
+   for (i=0; i < primme_num_counters; i++) fds[i] = -1;
+   return -1;
+}
+
+void primme_counters_read(int *fds, double *values) {
+   int i;
+   (void)fds;
+   for (i=0; i < primme_num_counters; i++) values[i] = 0.0;
+}
+
+void primme_counters_close(int *fds) {
+   int i;
+   for (i=0; i < primme_num_counters; i++) fds[i] = -1;
+}
+
+double primme_counters_line_size(void) {
+   return 64.0;
+}
+
+#endif /* PRIMME_PERF_COUNTERS */
@@ -0,0 +1,46 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ * File: counters.h
+ *
+ * Purpose - Header file containing the hardware counter functions used to
+ *           measure the solver phases (see PRIMME_PERF_COUNTERS).
+ *
+ ******************************************************************************/
+
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int primme_counters_open(int *fds);
+void primme_counters_read(int *fds, double *values);
+void primme_counters_close(int *fds);
+double primme_counters_line_size(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COUNTERS_H */
@@ -182,9 +182,18 @@ static void convertToString(primme_function func, char *functionName) {
       case Primme_zprimme:
          strcpy(functionName, "zprimme");
          break;
+      case Primme_dprimme_slice:
+         strcpy(functionName, "dprimme_slice");
+         break;
+      case Primme_zprimme_slice:
+         strcpy(functionName, "zprimme_slice");
+         break;
       case Primme_main_iter:
          strcpy(functionName, "main_iter");
          break;
+      case Primme_solve_dense:
+         strcpy(functionName, "solve_dense");
+         break;
       case Primme_allocate_workspace:
          strcpy(functionName, "allocate_workspace");
          break;
@@ -215,9 +224,15 @@ static void convertToString(primme_function func, char *functionName) {
       case Primme_insert_submatrix:
          strcpy(functionName, "insert_submatrix");
          break;
+      case Primme_check_convergence:
+         strcpy(functionName, "check_convergence");
+         break;
       case Primme_lock_vectors:
          strcpy(functionName, "lock_vectors");
          break;
+      case Primme_lock_store:
+         strcpy(functionName, "lock_store");
+         break;
       case Primme_num_dsyev:
          strcpy(functionName, "Num_dsyev");
          break;
@@ -254,6 +269,9 @@ static void convertToString(primme_function func, char *functionName) {
       case Primme_malloc:
          strcpy(functionName, "malloc");
          break;
+      case Primme_gather_block:
+         strcpy(functionName, "gather_block");
+         break;
    }
 
 }
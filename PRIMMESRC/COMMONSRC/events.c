@@ -0,0 +1,312 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ * File: events.c
+ *
+ * Purpose - Buffered stream of typed records of the iteration history
+ *           (see eventParams in primme.h).
+ *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include "primme.h"
+#include "const.h"
+#include "wtime.h"
+#include "counters.h"
+#include "events_private.h"
+
+
+/*******************************************************************************
+ * Subroutine primme_event_begin - Allocates the event buffer and resets the
+ *    phase timers at the beginning of d/zprimme, and opens the hardware
+ *    counters if they were compiled in. It does nothing if neither eventFun
+ *    nor file are set.
+ *
+ * Input/Output parameters
+ * -----------------------
+ * primme      Structure containing the event parameters
+ *
+ ******************************************************************************/
+
+void primme_event_begin(primme_params *primme) {
+
+   event_params *ev = &primme->eventParams;
+   int i, j;
+
+   if (!EVENTS_ON(primme)) return;
+
+   if (ev->bufferSize <= 0) ev->bufferSize = 1;
+   if (ev->buffer == NULL) {
+      ev->buffer = (primme_event *)primme_calloc(ev->bufferSize,
+            sizeof(primme_event), "events");
+   }
+   ev->numBuffered = 0;
+   ev->timer0 = primme_get_wtime();
+   for (i=0; i < primme_num_phases; i++) {
+      ev->timePhase[i] = 0.0;
+      for (j=0; j < primme_num_counters; j++) ev->counterPhase[i][j] = 0.0;
+   }
+   primme_counters_open(ev->counterFd);
+}
+
+
+/*******************************************************************************
+ * Subroutine primme_event_push - Appends a record to the buffer and flushes
+ *    the buffer when it is full. The time and the counters of the record are
+ *    taken from primme->stats.
+ *
+ * INPUT PARAMETERS
+ * ----------------
+ * type, index, count, reason, value, resNorm  Fields of the record. Their
+ *             meaning depends on the type (see primme_event in primme.h)
+ *
+ * Input/Output parameters
+ * -----------------------
+ * primme      Structure containing the event parameters
+ *
+ ******************************************************************************/
+
+void primme_event_push(primme_event_type type, int index, int count,
+     int reason, double value, double resNorm, primme_params *primme) {
+
+   event_params *ev = &primme->eventParams;
+   primme_event *e;
+
+   if (!EVENTS_ON(primme) || ev->buffer == NULL) return;
+
+   e = &ev->buffer[ev->numBuffered++];
+   e->type = type;
+   e->time = primme_get_wtime() - ev->timer0;
+   e->numMatvecs = primme->stats.numMatvecs;
+   e->numOuterIterations = primme->stats.numOuterIterations;
+   e->index = index;
+   e->count = count;
+   e->reason = reason;
+   e->value = value;
+   e->resNorm = resNorm;
+
+   if (ev->numBuffered >= ev->bufferSize) flush_events(primme);
+}
+
+
+/*******************************************************************************
+ * Subroutine primme_phase_start - Starts measuring a phase.
+ *
+ * Return value
+ * ------------
+ * The current time, to be passed to primme_phase_stop
+ *
+ ******************************************************************************/
+
+double primme_phase_start(primme_params *primme) {
+
+   event_params *ev = &primme->eventParams;
+
+   if (ev->counterFd[0] >= 0) {
+      primme_counters_read(ev->counterFd, ev->counterStart);
+   }
+   return primme_get_wtime();
+}
+
+
+/*******************************************************************************
+ * Subroutine primme_phase_stop - Adds the time and the counts since the
+ *    matching primme_phase_start to the phase. Phases must not nest.
+ *
+ * INPUT PARAMETERS
+ * ----------------
+ * phase       The phase being measured
+ * t0          The value returned by primme_phase_start
+ *
+ ******************************************************************************/
+
+void primme_phase_stop(primme_phase phase, double t0, primme_params *primme) {
+
+   event_params *ev = &primme->eventParams;
+   double counts[primme_num_counters];
+   int i;
+
+   ev->timePhase[phase] += primme_get_wtime() - t0;
+   if (ev->counterFd[0] >= 0) {
+      primme_counters_read(ev->counterFd, counts);
+      for (i=0; i < primme_num_counters; i++) {
+         ev->counterPhase[phase][i] += counts[i] - ev->counterStart[i];
+      }
+   }
+}
+
+
+/*******************************************************************************
+ * Subroutine primme_event_end - Appends a primme_event_timing record per
+ *    phase and, with hardware counters, a primme_event_counter record per
+ *    phase and primme_counter; then flushes the buffer, frees it and closes
+ *    the counters at the end of d/zprimme.
+ *
+ * Input/Output parameters
+ * -----------------------
+ * primme      Structure containing the event parameters
+ *
+ ******************************************************************************/
+
+void primme_event_end(primme_params *primme) {
+
+   event_params *ev = &primme->eventParams;
+   int i;
+
+   if (!EVENTS_ON(primme) || ev->buffer == NULL) return;
+
+   for (i=0; i < primme_num_phases; i++) {
+      primme_event_push(primme_event_timing, i, 0, 0, ev->timePhase[i], 0.0,
+            primme);
+   }
+   if (ev->counterFd[0] >= 0) {
+      for (i=0; i < primme_num_phases; i++) {
+         push_counters(i, ev->counterPhase[i], primme);
+      }
+      primme_counters_close(ev->counterFd);
+   }
+   flush_events(primme);
+   if (ev->file && primme->procID == 0) fflush(ev->file);
+   free(ev->buffer);
+   ev->buffer = NULL;
+}
+
+
+/*******************************************************************************
+ * Subroutine push_counters - Appends the counts of a phase, and the bytes
+ *    from memory and the arithmetic intensity estimated from them.
+ *
+ * INPUT PARAMETERS
+ * ----------------
+ * phase       The phase
+ * counts      Its counts, primme_num_counters of them
+ *
+ ******************************************************************************/
+
+static void push_counters(int phase, double *counts, primme_params *primme) {
+
+   double bytes;
+   int i;
+
+   for (i=0; i < primme_num_counters; i++) {
+      primme_event_push(primme_event_counter, phase, 0, i, counts[i], 0.0,
+            primme);
+   }
+   bytes = counts[primme_counter_llcMisses]*primme_counters_line_size();
+   primme_event_push(primme_event_counter, phase, 0, primme_counter_bytes,
+         bytes, 0.0, primme);
+   primme_event_push(primme_event_counter, phase, 0, primme_counter_intensity,
+         bytes > 0.0 ? counts[primme_counter_instructions]/bytes : 0.0, 0.0,
+         primme);
+}
+
+
+/*******************************************************************************
+ * Subroutine flush_events - Passes the buffered records to eventFun, writes
+ *    them to file (only on the process with procID 0) and empties the buffer.
+ *    The CSV header is written when the file is empty.
+ *
+ * Input/Output parameters
+ * -----------------------
+ * primme      Structure containing the event parameters
+ *
+ ******************************************************************************/
+
+static void flush_events(primme_params *primme) {
+
+   event_params *ev = &primme->eventParams;
+   int i;
+
+   if (ev->numBuffered == 0) return;
+
+   if (ev->eventFun) ev->eventFun(ev->buffer, ev->numBuffered, primme);
+
+   if (ev->file && primme->procID == 0) {
+      if (ev->format == primme_event_csv && ftell(ev->file) == 0) {
+         fprintf(ev->file, "event,time,matvecs,iterations,index,count,"
+               "reason,value,resNorm\n");
+      }
+      for (i=0; i < ev->numBuffered; i++) {
+         write_event(&ev->buffer[i], ev->format, ev->file);
+      }
+   }
+
+   ev->numBuffered = 0;
+}
+
+
+/*******************************************************************************
+ * Subroutine write_event - Writes a record as a CSV line or as a JSON object
+ *    on a line of its own (JSON Lines). The phase of timing and counter
+ *    records, the exit reason of inner records and the counter of counter
+ *    records are written by name.
+ *
+ ******************************************************************************/
+
+static void write_event(primme_event *e, primme_event_format format,
+      FILE *file) {
+
+   static const char *types[] = {"outer", "restart", "lock", "inner",
+      "switch", "timing", "counter"};
+   static const char *reasons[] = {"maxits", "breakdown", "ltol", "eres",
+      "eval", "etol"};
+   static const char *phases[] = {"solveH", "convergence", "correction",
+      "ortho", "matvec", "restart"};
+   static const char *counters[] = {"cycles", "instructions", "llcMisses",
+      "bytes", "intensity"};
+   int byPhase = (e->type == primme_event_timing
+                  || e->type == primme_event_counter);
+   int byName = (e->type == primme_event_inner
+                 || e->type == primme_event_counter);
+   char index[16], reason[16];
+
+   if (byPhase) {
+      sprintf(index, "%s", phases[e->index]);
+   }
+   else {
+      sprintf(index, "%d", e->index);
+   }
+   if (e->type == primme_event_inner) {
+      sprintf(reason, "%s", reasons[e->reason]);
+   }
+   else if (e->type == primme_event_counter) {
+      sprintf(reason, "%s", counters[e->reason]);
+   }
+   else {
+      sprintf(reason, "%d", e->reason);
+   }
+
+   if (format == primme_event_json) {
+      fprintf(file, "{\"event\":\"%s\",\"time\":%.6e,\"matvecs\":%d,"
+            "\"iterations\":%d,\"index\":%s%s%s,\"count\":%d,"
+            "\"reason\":%s%s%s,\"value\":%.16e,\"resNorm\":%.6e}\n",
+            types[e->type], e->time, e->numMatvecs, e->numOuterIterations,
+            byPhase ? "\"" : "", index, byPhase ? "\"" : "", e->count,
+            byName ? "\"" : "", reason, byName ? "\"" : "", e->value,
+            e->resNorm);
+   }
+   else {
+      fprintf(file, "%s,%.6e,%d,%d,%s,%d,%s,%.16e,%.6e\n", types[e->type],
+            e->time, e->numMatvecs, e->numOuterIterations, index, e->count,
+            reason, e->value, e->resNorm);
+   }
+}
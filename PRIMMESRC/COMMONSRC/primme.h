@@ -43,9 +43,12 @@ extern "C" {
 typedef enum {
    Primme_dprimme,
    Primme_zprimme,
+   Primme_dprimme_slice,
+   Primme_zprimme_slice,
    Primme_check_input,
    Primme_allocate_workspace,
    Primme_main_iter,
+   Primme_solve_dense,
    Primme_init_basis,
    Primme_init_block_krylov,
    Primme_init_krylov,
@@ -54,7 +57,9 @@ typedef enum {
    Primme_restart,
    Primme_restart_h,
    Primme_insert_submatrix,
+   Primme_check_convergence,
    Primme_lock_vectors,
+   Primme_lock_store,
    Primme_num_dsyev,
    Primme_num_zheev,
    Primme_num_dspev,
@@ -66,7 +71,8 @@ typedef enum {
    Primme_inner_solve,
    Primme_solve_correction,
    Primme_fopen,
-   Primme_malloc
+   Primme_malloc,
+   Primme_gather_block
 } primme_function;
 
 
@@ -81,10 +87,19 @@ typedef enum {
 
 typedef enum {
    primme_thick,
-   primme_dtr
+   primme_dtr,
+   primme_adaptive_thick,
+   primme_budget_thick
 } primme_restartscheme;
 
 
+typedef enum {
+   primme_proj_RR,
+   primme_proj_harmonic,
+   primme_proj_refined
+} primme_projection;
+
+
 typedef enum {
    primme_full_LTolerance,
    primme_decreasing_LTolerance,
@@ -103,12 +118,49 @@ typedef struct stackTraceNode {
 } stackTraceNode;
 
 
+typedef enum {
+   primme_phase_solveH,     /* solve_H: Rayleigh-Ritz on the projection     */
+   primme_phase_convergence,/* check_convergence: residual vectors          */
+   primme_phase_correction, /* solve_correction, including inner solves     */
+   primme_phase_ortho,      /* ortho of the new block                       */
+   primme_phase_matvec,     /* update_W and update_projection               */
+   primme_phase_restart,    /* restart and locking                          */
+   primme_num_phases
+} primme_phase;
+
+
+typedef struct primme_model_stats {
+   double MV;               /* Cost of one matvec                             */
+   double PR;               /* Cost of one preconditioning                    */
+   double reorthoLocked;    /* Outer ortho cost per locked vector and step    */
+   double projectLocked;    /* Inner projection cost per locked vector, step  */
+   double lockPerVector;    /* Cost of locking one vector                     */
+   double ratioJDQMR_GDk;   /* Expected time of JDQMR relative to GD+k        */
+   int blockSize;           /* Block size chosen by the tuner                 */
+   int maxInnerIterations;  /* Inner iterations chosen by the tuner           */
+} primme_model_stats;
+
+typedef struct primme_comm_stats {
+   int numReductions;       /* Calls to globalSumDouble                       */
+   double numDoubles;       /* Doubles reduced by them                        */
+   double time;             /* Seconds spent in them, waiting included        */
+} primme_comm_stats;
+
 typedef struct primme_stats {
    int numOuterIterations;
    int numRestarts;
    int numMatvecs;
    int numPreconds;
    double elapsedTime; 
+   double startTime;        /* primme_get_wtime() at the call, internal    */
+   double bytesMoved;
+   double timeOrthoLocked;  /* Ortho against the locked vectors, internal  */
+   double timeProjectLocked;/* QMR projections per column, internal        */
+   int numProjectLocked;    /* QMR steps timed in timeProjectLocked        */
+   struct primme_model_stats model;  /* Runtime model of the method costs */
+   struct primme_comm_stats comm;    /* All calls to globalSumDouble      */
+   struct primme_comm_stats commPhase[primme_num_phases]; /* By phase     */
+   int currentPhase;        /* Phase being run or -1, used internally     */
 } primme_stats;
    
 typedef struct JD_projectors {
@@ -130,12 +182,157 @@ typedef struct correction_params {
 } correction_params;
 
 
+struct primme_params;
+
+typedef struct restart_trace {
+   int restartSize;      /* Number of vectors the basis was restarted with */
+   int numPrevRetained;  /* Number of previous vectors retained            */
+   double gapRatio;      /* Gap ratio of the first target at the restart   */
+   int matvecs;          /* Matvecs since the previous restart             */
+   double resNorm;       /* Residual norm of the first target vector       */
+   double convRate;      /* Residual reduction (log10) per matvec          */
+} restart_trace;
+
 typedef struct restarting_params {
    primme_restartscheme scheme;
    int maxPrevRetain;
+   long int maxBasisBytes;  /* Workspace with primme_budget_thick         */
+   int (*restartPolicy)     /* If not NULL, it chooses the restart size    */
+      (double *hVals, int basisSize, int lMin, int numFree, int target,
+       int *right, struct primme_params *primme);
+   struct restart_trace trace;  /* Filled at every restart                 */
+   int adaptStep;           /* Used internally by primme_adaptive_thick    */
+   double adaptRate;        /* Used internally by primme_adaptive_thick    */
 } restarting_params;
+
+
+typedef struct tuning_params {
+   int blockSize;        /* If true, tune the block size between restarts    */
+   int innerIterations;  /* If true, tune the inner iterations of JDQMR      */
+   int deterministic;    /* If true, measure costs in operator applications  */
+   char *cacheFile;      /* If not NULL, the model is stored in this file    */
+   long int cacheKey;    /* User signature of the problem, e.g., its nnz     */
+} tuning_params;
+
+
+typedef struct continuation_params {
+   int keepState;        /* If true, carry the solver state to the next call */
+   int maxExtraVectors;  /* Ritz vectors kept beyond numEvals for next call  */
+   void *state;          /* Carried state, allocated and used internally     */
+} continuation_params;
+
+
+typedef struct budget_sizes {  /* The sizes that memoryBudget may reduce  */
+   int maxBasisSize;
+   int minRestartSize;
+   int maxBlockSize;
+   int maxPrevRetain;
+   int SkewQ;
+   int locking;
+} budget_sizes;
+
+
+typedef enum {
+   primme_event_outer,      /* An outer iteration finished                  */
+   primme_event_restart,    /* The basis was restarted                      */
+   primme_event_lock,       /* An eigenpair was locked or flagged converged */
+   primme_event_inner,      /* The inner solver (JDQMR) returned            */
+   primme_event_switch,     /* Dynamic method switching changed the method  */
+   primme_event_timing,     /* Time spent in a phase, at the end of the run */
+   primme_event_counter     /* Hardware counter of a phase, at the end      */
+} primme_event_type;
+
+
+typedef enum {
+   primme_inner_maxits,     /* Reached the maximum number of iterations     */
+   primme_inner_breakdown,  /* sigma, alpha or rho became zero              */
+   primme_inner_ltol,       /* Linear system residual below the tolerance   */
+   primme_inner_eres,       /* Linear residual below the eigenresidual bound*/
+   primme_inner_eval,       /* Ritz value started to increase               */
+   primme_inner_etol        /* Eigenresidual below its adaptive tolerance   */
+} primme_inner_exit;
+
+
+typedef enum {
+   primme_counter_cycles,       /* Core cycles                              */
+   primme_counter_instructions, /* Retired instructions                     */
+   primme_counter_llcMisses,    /* Last level cache misses                  */
+   primme_num_counters,         /* Number of measured counters              */
+   primme_counter_bytes = primme_num_counters, /* llcMisses times line size */
+   primme_counter_intensity     /* instructions per byte from memory        */
+} primme_counter;
+
+
+typedef enum {
+   primme_event_csv,
+   primme_event_json
+} primme_event_format;
+
+
+typedef struct primme_event {
+   primme_event_type type;
+   double time;             /* Seconds since the solver was called          */
+   int numMatvecs;          /* stats.numMatvecs when the event happened     */
+   int numOuterIterations;  /* stats.numOuterIterations idem                */
+   int index;               /* Eigenpair, or primme_phase for timings and   */
+                            /* counters, or                                 */
+                            /* the previous dynamicMethodSwitch for switch  */
+   int count;               /* outer: converged; restart: basis size;       */
+                            /* lock: locked; inner: iterations;             */
+                            /* switch: new dynamicMethodSwitch              */
+   int reason;              /* inner: primme_inner_exit; lock: 1 if locked; */
+                            /* restart: number of previous vectors retained */
+                            /* counter: primme_counter                      */
+   double value;            /* Ritz value; seconds for timings; counts for  */
+                            /* counters; estimated                          */
+                            /* time ratio JDQMR/GD+k for switch             */
+   double resNorm;          /* Residual norm (linear residual for inner)    */
+} primme_event;
+
+
+typedef struct event_params {
+   void (*eventFun)         /* If not NULL, receives the buffered events    */
+      (primme_event *events, int numEvents, struct primme_params *primme);
+   FILE *file;              /* If not NULL, events are written here         */
+   primme_event_format format;  /* Format of the lines written to file      */
+   int bufferSize;          /* Events kept before they are flushed          */
+   primme_event *buffer;    /* Used internally                              */
+   int numBuffered;         /* Used internally                              */
+   double timer0;           /* Used internally                              */
+   double timePhase[primme_num_phases];  /* Used internally                 */
+   int counterFd[primme_num_counters];    /* Used internally                */
+   double counterStart[primme_num_counters];  /* Used internally            */
+   double counterPhase[primme_num_phases][primme_num_counters]; /* Idem     */
+} event_params;
+
+
+typedef struct projection_params {
+   primme_projection projection;
+} projection_params;
+
+
+typedef struct lockstore_params {
+   char *fileName;   /* If not NULL, locked vectors are stored in this file */
+   int panelSize;    /* Number of locked vectors read from the file at once */
+   FILE *file;       /* Handle of the file, used internally                 */
+   void *panel;      /* Buffer for panelSize vectors, used internally       */
+} lockstore_params;
    
 
+typedef struct primme_monitor {
+   primme_event_type event;  /* primme_event_outer, _restart or _lock      */
+   double *ritzVals;         /* Ritz values of the current basis           */
+   int basisSize;            /* Number of values in ritzVals               */
+   int *blockIndex;          /* Position in ritzVals of the block pairs    */
+   double *blockNorms;       /* Residual norms of the block pairs          */
+   int blockSize;            /* Number of pairs in the block (0 if none)   */
+   int numConverged;         /* Converged pairs, including the locked ones */
+   double *lockedVals;       /* Eigenvalues locked so far (with locking)   */
+   double *lockedNorms;      /* Residual norms of the locked pairs         */
+   int numLocked;            /* Number of locked pairs                     */
+} primme_monitor;
+
+
 /*--------------------------------------------------------------------------*/
 typedef struct primme_params {
 
@@ -144,6 +341,13 @@ typedef struct primme_params {
    void (*matrixMatvec)
       ( void *x,  void *y, int *blockSize, struct primme_params *primme);
 
+   /* Optional split-phase matvec: Begin starts y = A*x and End completes */
+   /* it, so that local work may be done while the product is in flight  */
+   void (*matrixMatvecBegin)
+      ( void *x,  void *y, int *blockSize, struct primme_params *primme);
+   void (*matrixMatvecEnd)
+      ( void *x,  void *y, int *blockSize, struct primme_params *primme);
+
    /* Preconditioner applied on block of vectors (if available) */
    void (*applyPreconditioner)
       ( void *x,  void *y, int *blockSize, struct primme_params *primme);
@@ -170,29 +374,44 @@ typedef struct primme_params {
    int dynamicMethodSwitch;
    int locking;
    int initSize;
+   int initFilterDegree;    /* Chebyshev filter degree on the random start */
    int numOrthoConst;
    int maxBasisSize;
    int minRestartSize;
    int maxBlockSize;
    int maxMatvecs;
    int maxOuterIterations;
+   double maxTime;          /* If positive, seconds allowed for the solver */
+   int denseThreshold;      /* n up to which a dense eigensolver is used,  */
+                            /* or -1 (the default) to never use it         */
    int intWorkSize;
    long int realWorkSize;
    int iseed[4];
    int *intWork;
    void *realWork;
+   long int memoryBudget;   /* If positive, bytes available to the solver */
+   budget_sizes userSizes;  /* Sizes before the budget fit, internal      */
+   budget_sizes fitSizes;   /* Sizes chosen by the budget fit, internal   */
    double aNorm;
    double eps;
 
    int printLevel;
    FILE *outputFile;
+
+   /* Optional callback to observe the progress; nonzero return stops */
+   int (*monitorFun)(primme_monitor *info, struct primme_params *primme);
    
    void *matrix;
    void *preconditioner;
    double *ShiftsForPreconditioner;
 
+   struct projection_params projectionParams;
+   struct lockstore_params lockStoreParams;
    struct restarting_params restartingParams;
    struct correction_params correctionParams;
+   struct tuning_params tuningParams;
+   struct continuation_params continuationParams;
+   struct event_params eventParams;
    struct primme_stats stats;
    struct stackTraceNode *stackTrace;
    
@@ -223,18 +442,33 @@ int dprimme(double *evals, double *evecs, double *resNorms,
             primme_params *primme);
 int zprimme(double *evals, Complex_Z *evecs, double *resNorms, 
             primme_params *primme);
+int dprimme_slice(double *evals, double *evecs, double *resNorms,
+            int *numFound, double lower, double upper, int numSlices,
+            primme_params *primme);
+int zprimme_slice(double *evals, Complex_Z *evecs, double *resNorms,
+            int *numFound, double lower, double upper, int numSlices,
+            primme_params *primme);
 void primme_initialize(primme_params *primme);
 int  primme_set_method(primme_preset_method method, primme_params *params);
+void primme_set_memory_budget(long int bytes, primme_params *primme);
 void primme_display_params(primme_params primme);
 void *primme_valloc(size_t byteSize, const char *target);
 void *primme_calloc(size_t nelem, size_t elsize, const char *target);
 void primme_Free(primme_params *primme);
 void primme_seq_globalSumDouble(void *sendBuf, void *recvBuf, int *count,
                                                    primme_params *params);
+void primme_globalSumDouble(void *sendBuf, void *recvBuf, int *count,
+      primme_params *primme);
 void primme_PushErrorMessage(const primme_function callingFunction, 
      const primme_function failedFunction, const int errorCode, 
      const char *fileName, const int lineNumber, primme_params *primme);
 void primme_PrintStackTrace(const primme_params primme);
+void primme_event_begin(primme_params *primme);
+void primme_event_push(primme_event_type type, int index, int count,
+     int reason, double value, double resNorm, primme_params *primme);
+void primme_event_end(primme_params *primme);
+double primme_phase_start(primme_params *primme);
+void primme_phase_stop(primme_phase phase, double t0, primme_params *primme);
 void primme_DeleteStackTrace(primme_params *primme);
 
 #ifdef __cplusplus
@@ -191,6 +191,8 @@ void primme_display_stats_f77(primme_params **primme)
                                         (*primme)->stats.numPreconds);
         fprintf((*primme)->outputFile, "Total elapsed wall clock Time: %g\n",
                                         (*primme)->stats.elapsedTime);
+        fprintf((*primme)->outputFile, "Bytes moved between vectors: %g\n",
+                                        (*primme)->stats.bytesMoved);
         fprintf((*primme)->outputFile, "--------------------------------------\n");
 }
 
@@ -321,6 +323,9 @@ void primme_set_member_f77(primme_params **primme, int *label, union f77_value v
       case PRIMMEF77_preconditioner:
               (*primme)->preconditioner = v.ptr_v;
       break;
+      case PRIMMEF77_projectionParams_projection:
+              (*primme)->projectionParams.projection = *v.projection_v;
+      break;
       case PRIMMEF77_restartingParams_scheme:
               (*primme)->restartingParams.scheme = *v.restartscheme_v;
       break;
@@ -519,6 +524,9 @@ void primme_get_member_f77(primme_params *primme, int *label, union f77_value_pt
       case PRIMMEF77_preconditioner:
               v->ptr_v = primme->preconditioner;
       break;
+      case PRIMMEF77_projectionParams_projection:
+              v->projection_v = primme->projectionParams.projection;
+      break;
       case PRIMMEF77_restartingParams_scheme:
               v->restartscheme_v = primme->restartingParams.scheme;
       break;
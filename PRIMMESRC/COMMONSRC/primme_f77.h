@@ -92,7 +92,8 @@ C-------------------------------------------------------
      : PRIMMEF77_stats_numPreconds,
      : PRIMMEF77_stats_elapsedTime,
      : PRIMMEF77_dynamicMethodSwitch,
-     : PRIMMEF77_massMatrixMatvec
+     : PRIMMEF77_massMatrixMatvec,
+     : PRIMMEF77_projectionParams_projection
 
       parameter(
      : PRIMMEF77_n = 0,
@@ -145,7 +146,8 @@ C-------------------------------------------------------
      : PRIMMEF77_stats_numPreconds = 47,
      : PRIMMEF77_stats_elapsedTime = 48,
      : PRIMMEF77_dynamicMethodSwitch = 49,
-     : PRIMMEF77_massMatrixMatvec = 50
+     : PRIMMEF77_massMatrixMatvec = 50,
+     : PRIMMEF77_projectionParams_projection = 51
      : )
 
 C-------------------------------------------------------
@@ -164,7 +166,10 @@ C-------------------------------------------------------
      : PRIMMEF77_full_LTolerance,
      : PRIMMEF77_decreasing_LTolerance,
      : PRIMMEF77_adaptive_ETolerance,
-     : PRIMMEF77_adaptive
+     : PRIMMEF77_adaptive,
+     : PRIMMEF77_proj_RR,
+     : PRIMMEF77_proj_harmonic,
+     : PRIMMEF77_proj_refined
 
       parameter(
      : PRIMMEF77_smallest = 0,
@@ -177,5 +182,8 @@ C-------------------------------------------------------
      : PRIMMEF77_full_LTolerance = 0,
      : PRIMMEF77_decreasing_LTolerance = 1,
      : PRIMMEF77_adaptive_ETolerance = 2,
-     : PRIMMEF77_adaptive = 3
+     : PRIMMEF77_adaptive = 3,
+     : PRIMMEF77_proj_RR = 0,
+     : PRIMMEF77_proj_harmonic = 1,
+     : PRIMMEF77_proj_refined = 2
      : )
@@ -103,6 +103,7 @@
 #define PRIMMEF77_stats_elapsedTime  48
 #define PRIMMEF77_dynamicMethodSwitch 49
 #define PRIMMEF77_massMatrixMatvec  50
+#define PRIMMEF77_projectionParams_projection  51
 
 /*----------------------------------------------------------*/
 /*     Defining easy to remember labels for setting the     */
@@ -121,6 +122,10 @@
 #define PRIMMEF77_decreasing_LTolerance  1
 #define PRIMMEF77_adaptive_ETolerance  2
 #define PRIMMEF77_adaptive  3
+/*-------------------------------------------------------*/
+#define PRIMMEF77_proj_RR  0
+#define PRIMMEF77_proj_harmonic  1
+#define PRIMMEF77_proj_refined  2
 
 
 /* Prototypes for Fortran-C interface */
@@ -140,6 +145,7 @@ union f77_value {
    FILE *file_v;
    primme_restartscheme *restartscheme_v;
    primme_convergencetest *convergencetest_v;
+   primme_projection *projection_v;
 };
 union f77_value_ptr {
    int int_v;
@@ -152,6 +158,7 @@ union f77_value_ptr {
    FILE *file_v;
    primme_restartscheme restartscheme_v;
    primme_convergencetest convergencetest_v;
+   primme_projection projection_v;
 };
 
 
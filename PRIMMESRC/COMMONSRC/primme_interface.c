@@ -37,6 +37,8 @@
 #include "primme.h"
 #include "common_numerical.h"
 #include "const.h"
+#include "wtime.h"
+#include "track.h"
 
 /***************************************************************************
 
@@ -45,6 +47,8 @@
 ***************************************************************************/
 void primme_initialize(primme_params *primme) {
 
+   int i;
+
    /* Essential parameters */
    primme->n                       = 0;
    primme->numEvals                = 1;
@@ -54,6 +58,8 @@ void primme_initialize(primme_params *primme) {
 
    /* Matvec and preconditioner */
    primme->matrixMatvec            = NULL;
+   primme->matrixMatvecBegin       = NULL;
+   primme->matrixMatvecEnd         = NULL;
    primme->applyPreconditioner     = NULL;
    primme->massMatrixMatvec        = NULL;
 
@@ -70,6 +76,7 @@ void primme_initialize(primme_params *primme) {
 
    /* Initial guesses/constraints */
    primme->initSize                = 0;
+   primme->initFilterDegree        = 0;
    primme->numOrthoConst           = 0;
 
    /* Eigensolver parameters (outer) */
@@ -80,8 +87,25 @@ void primme_initialize(primme_params *primme) {
    primme->maxBlockSize                        = 1;
    primme->maxMatvecs                          = INT_MAX;
    primme->maxOuterIterations                  = INT_MAX;
+   primme->maxTime                             = 0.0;
+   primme->denseThreshold                      = PRIMME_DENSE_THRESHOLD;
    primme->restartingParams.scheme             = primme_thick;
    primme->restartingParams.maxPrevRetain      = 0;
+   primme->restartingParams.maxBasisBytes      = 0;
+   primme->restartingParams.restartPolicy      = NULL;
+   primme->restartingParams.trace.restartSize  = 0;
+   primme->restartingParams.trace.numPrevRetained = 0;
+   primme->restartingParams.trace.gapRatio     = 0.0L;
+   primme->restartingParams.trace.matvecs      = 0;
+   primme->restartingParams.trace.resNorm      = 0.0L;
+   primme->restartingParams.trace.convRate     = 0.0L;
+   primme->restartingParams.adaptStep          = 0;
+   primme->restartingParams.adaptRate          = 0.0L;
+   primme->projectionParams.projection         = primme_proj_RR;
+   primme->lockStoreParams.fileName            = NULL;
+   primme->lockStoreParams.panelSize           = 0;
+   primme->lockStoreParams.file                = NULL;
+   primme->lockStoreParams.panel               = NULL;
 
    /* correction parameters (inner) */
    primme->correctionParams.precondition       = 0;
@@ -96,14 +120,55 @@ void primme_initialize(primme_params *primme) {
    primme->correctionParams.relTolBase         = 0;
    primme->correctionParams.convTest           = primme_adaptive_ETolerance;
 
+   /* Online tuning of the method */
+   primme->tuningParams.blockSize              = 0;
+   primme->tuningParams.innerIterations        = 0;
+   primme->tuningParams.deterministic          = 0;
+   primme->tuningParams.cacheFile              = NULL;
+   primme->tuningParams.cacheKey               = 0;
+
+   /* State carried between consecutive calls */
+   primme->continuationParams.keepState        = 0;
+   primme->continuationParams.maxExtraVectors  = 0;
+   primme->continuationParams.state            = NULL;
+
+   /* Event stream of the iteration history */
+   primme->eventParams.eventFun                = NULL;
+   primme->eventParams.file                    = NULL;
+   primme->eventParams.format                  = primme_event_csv;
+   primme->eventParams.bufferSize              = 256;
+   primme->eventParams.buffer                  = NULL;
+   primme->eventParams.numBuffered             = 0;
+
    /* Printing and reporting */
    primme->outputFile              = stdout;
    primme->printLevel              = 1;
+   primme->monitorFun              = NULL;
    primme->stats.numOuterIterations= 0;
    primme->stats.numRestarts       = 0;
    primme->stats.numMatvecs        = 0;
    primme->stats.numPreconds       = 0;
    primme->stats.elapsedTime       = 0.0L;
+   primme->stats.startTime         = 0.0L;
+   primme->stats.bytesMoved        = 0.0L;
+   primme->stats.timeOrthoLocked   = 0.0L;
+   primme->stats.timeProjectLocked = 0.0L;
+   primme->stats.numProjectLocked  = 0;
+   primme->stats.model.MV          = 0.0L;
+   primme->stats.model.PR          = 0.0L;
+   primme->stats.model.reorthoLocked = 0.0L;
+   primme->stats.model.projectLocked = 0.0L;
+   primme->stats.model.lockPerVector = 0.0L;
+   primme->stats.model.ratioJDQMR_GDk = 1.0L;
+   primme->stats.model.blockSize   = 0;
+   primme->stats.model.maxInnerIterations = 0;
+   primme->stats.comm.numReductions = 0;
+   primme->stats.comm.numDoubles   = 0.0L;
+   primme->stats.comm.time         = 0.0L;
+   for (i=0; i < primme_num_phases; i++) {
+      primme->stats.commPhase[i] = primme->stats.comm;
+   }
+   primme->stats.currentPhase      = -1;
 
    /* Optional user defined structures */
    primme->matrix                  = NULL;
@@ -118,6 +183,8 @@ void primme_initialize(primme_params *primme) {
    primme->realWorkSize            = 0;
    primme->intWork                 = NULL;
    primme->realWork                = NULL;
+   primme->memoryBudget            = 0;
+   primme->fitSizes.maxBasisSize   = 0;
    primme->stackTrace              = NULL;
    primme->ShiftsForPreconditioner = NULL;
 
@@ -132,6 +199,7 @@ void *primme_valloc(size_t byteSize, const char *target) {
 
    void *ptr;
 
+   TRACK_ALLOC(byteSize);
    if ( (ptr = malloc(byteSize)) == NULL) {
       perror("primme_alloc");
       fprintf(stderr,
@@ -150,6 +218,7 @@ void *primme_calloc(size_t nelem, size_t elsize, const char *target) {
 
    void *ptr;
 
+   TRACK_ALLOC(nelem*elsize);
    if ((ptr = calloc(nelem, elsize)) == NULL) {
       perror("primme_calloc");
       fprintf(stderr, 
@@ -167,8 +236,12 @@ void primme_Free(primme_params *params) {
 
    free(params->intWork);
    free(params->realWork);
+   free(params->continuationParams.state);
+   free(params->eventParams.buffer);
    params->intWorkSize  = 0;
    params->realWorkSize = 0;
+   params->continuationParams.state = NULL;
+   params->eventParams.buffer = NULL;
 
 } /**************************************************************************/
 
@@ -475,6 +548,30 @@ int primme_set_method(primme_preset_method method, primme_params *params) {
 } /* end of primme_set_method */
   /**************************************************************************/
 
+/******************************************************************************
+ *
+ * void primme_set_memory_budget(long int bytes, primme_params *primme);
+ *
+ *    Limits the workspace of dprimme/zprimme to the given bytes, per process.
+ *    Before allocating, the solver reduces, in this order, maxPrevRetain, 
+ *    the skew projector, maxBasisSize (and minRestartSize proportionally) and
+ *    maxBlockSize until the workspace fits. The values in primme, usually 
+ *    set by primme_set_method, are the largest to be tried. A budget of zero
+ *    or less removes the limit.
+ *
+ * INPUT/OUTPUT
+ * ------------
+ *    bytes      The bytes available for the workspace
+ *    primme     The structure whose field memoryBudget is set
+ *
+ *****************************************************************************/
+
+void primme_set_memory_budget(long int bytes, primme_params *primme) {
+
+   primme->memoryBudget = bytes > 0 ? bytes : 0;
+
+}
+
 /******************************************************************************
  *
  * void primme_display_params(primme_params *primme);
@@ -508,7 +605,10 @@ fprintf(outputFile, "primme.minRestartSize = %d \n",primme.minRestartSize);
 fprintf(outputFile, "primme.maxBlockSize = %d\n",primme.maxBlockSize);
 fprintf(outputFile,
                 "primme.maxOuterIterations = %d\n",primme.maxOuterIterations);
+fprintf(outputFile, "primme.maxTime = %e\n",primme.maxTime);
+fprintf(outputFile, "primme.denseThreshold = %d\n",primme.denseThreshold);
 fprintf(outputFile, "primme.maxMatvecs = %d\n",primme.maxMatvecs);
+fprintf(outputFile, "primme.memoryBudget = %ld\n",primme.memoryBudget);
 switch (primme.target){
    case primme_smallest:
       fprintf(outputFile, "primme.target = primme_smallest\n");
@@ -540,6 +640,7 @@ fprintf(outputFile, "primme.dynamicMethodSwitch = %d\n",
                                                 primme.dynamicMethodSwitch);
 fprintf(outputFile, "primme.locking = %d\n",primme.locking);
 fprintf(outputFile, "primme.initSize = %d\n",primme.initSize);
+fprintf(outputFile, "primme.initFilterDegree = %d\n",primme.initFilterDegree);
 fprintf(outputFile, "primme.numOrthoConst = %d\n",primme.numOrthoConst);
 fprintf(outputFile, "primme.iseed =");
 for (i=0; i<4;i++) {
@@ -547,17 +648,45 @@ for (i=0; i<4;i++) {
 }
 fprintf(outputFile, "\n");
 
+fprintf(outputFile, "\n// Projection\n");
+fprintf(outputFile, "primme.projection.projection = ");
+switch (primme.projectionParams.projection) {
+   case primme_proj_RR:
+      fprintf(outputFile, "primme_proj_RR\n");
+      break;
+   case primme_proj_harmonic:
+      fprintf(outputFile, "primme_proj_harmonic\n");
+      break;
+   case primme_proj_refined:
+      fprintf(outputFile, "primme_proj_refined\n");
+      break;
+}
+
+fprintf(outputFile, "\n// Locked vectors store\n");
+fprintf(outputFile, "primme.lockStore.panelSize = %d\n",
+                     primme.lockStoreParams.panelSize);
+
 fprintf(outputFile, "\n// Restarting\n");
 fprintf(outputFile, "primme.restarting.scheme = ");
-if (primme.restartingParams.scheme == primme_thick) {
-  fprintf(outputFile, "primme_thick\n");
-}
-else {
-  fprintf(outputFile, "primme_dtr\n");
+switch (primme.restartingParams.scheme) {
+   case primme_thick:
+      fprintf(outputFile, "primme_thick\n");
+      break;
+   case primme_dtr:
+      fprintf(outputFile, "primme_dtr\n");
+      break;
+   case primme_adaptive_thick:
+      fprintf(outputFile, "primme_adaptive_thick\n");
+      break;
+   case primme_budget_thick:
+      fprintf(outputFile, "primme_budget_thick\n");
+      break;
 }
 
 fprintf(outputFile, "primme.restarting.maxPrevRetain = %d\n",
                      primme.restartingParams.maxPrevRetain);
+fprintf(outputFile, "primme.restarting.maxBasisBytes = %ld\n",
+                     primme.restartingParams.maxBasisBytes);
 
 fprintf(outputFile, "\n// Correction parameters\n");
 fprintf(outputFile, "primme.correction.precondition = %d\n",
@@ -598,6 +727,48 @@ fprintf(outputFile, "primme.correction.projectors.RightX = %d\n",
                      primme.correctionParams.projectors.RightX);
 fprintf(outputFile, "primme.correction.projectors.SkewX = %d\n",
                      primme.correctionParams.projectors.SkewX);
+
+fprintf(outputFile, "\n// Online tuning\n");
+fprintf(outputFile, "primme.tuning.blockSize = %d\n",
+                     primme.tuningParams.blockSize);
+fprintf(outputFile, "primme.tuning.innerIterations = %d\n",
+                     primme.tuningParams.innerIterations);
+fprintf(outputFile, "primme.tuning.deterministic = %d\n",
+                     primme.tuningParams.deterministic);
+if (primme.tuningParams.cacheFile != NULL) {
+   fprintf(outputFile, "primme.tuning.cacheFile = %s\n",
+                        primme.tuningParams.cacheFile);
+}
+fprintf(outputFile, "primme.tuning.cacheKey = %ld\n",
+                     primme.tuningParams.cacheKey);
+
+fprintf(outputFile, "\n// Continuation\n");
+fprintf(outputFile, "primme.continuation.keepState = %d\n",
+                     primme.continuationParams.keepState);
+fprintf(outputFile, "primme.continuation.maxExtraVectors = %d\n",
+                     primme.continuationParams.maxExtraVectors);
+
+if (primme.stats.comm.numReductions > 0) {
+   static const char *phases[] = {"solveH", "convergence", "correction",
+      "ortho", "matvec", "restart"};
+   fprintf(outputFile, "\n// Communication of the last run\n");
+   fprintf(outputFile, "primme.stats.comm = %d reductions, %g doubles, %e s\n",
+      primme.stats.comm.numReductions, primme.stats.comm.numDoubles,
+      primme.stats.comm.time);
+   for (i=0; i < primme_num_phases; i++) {
+      fprintf(outputFile, "primme.stats.commPhase.%s = %d reductions, "
+         "%g doubles, %e s\n", phases[i],
+         primme.stats.commPhase[i].numReductions,
+         primme.stats.commPhase[i].numDoubles, primme.stats.commPhase[i].time);
+   }
+}
+if (primme.eventParams.eventFun != NULL || primme.eventParams.file != NULL) {
+   fprintf(outputFile, "\n// Event stream\n");
+   fprintf(outputFile, "primme.events.format = %s\n",
+      primme.eventParams.format == primme_event_json ? "json" : "csv");
+   fprintf(outputFile, "primme.events.bufferSize = %d\n",
+                        primme.eventParams.bufferSize);
+}
 fprintf(outputFile, "// ---------------------------------------------------\n");
 fflush(outputFile);
 
@@ -623,3 +794,35 @@ void primme_seq_globalSumDouble(void *sendBuf, void *recvBuf, int *count,
    Num_dcopy_primme(*count, (double *) sendBuf, 1, (double *) recvBuf, 1);
 
 }
+
+
+/******************************************************************************
+ * function 
+ * primme_globalSumDouble(void *sendBuf, void *recvBuf, int *count,
+ *                        primme_params *primme)
+ *
+ * Calls primme->globalSumDouble and adds the call, the doubles reduced and
+ * the time spent in it to stats.comm and, inside a phase, to
+ * stats.commPhase. All reductions in PRIMME go through this function.
+ * 
+ ******************************************************************************/
+
+void primme_globalSumDouble(void *sendBuf, void *recvBuf, int *count, 
+                      primme_params *primme) {
+
+   double t0 = primme_get_wtime();
+   primme_comm_stats *c;
+
+   (*primme->globalSumDouble)(sendBuf, recvBuf, count, primme);
+
+   t0 = primme_get_wtime() - t0;
+   primme->stats.comm.numReductions++;
+   primme->stats.comm.numDoubles += *count;
+   primme->stats.comm.time += t0;
+   if (primme->stats.currentPhase >= 0) {
+      c = &primme->stats.commPhase[primme->stats.currentPhase];
+      c->numReductions++;
+      c->numDoubles += *count;
+      c->time += t0;
+   }
+}
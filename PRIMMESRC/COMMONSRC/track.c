@@ -0,0 +1,86 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ * File: track.c
+ *
+ * Purpose - Debugging aid to audit the steady state of the solver: counts
+ *           the allocations made with primme_calloc and the other mallocs
+ *           of the library, and the bytes zeroed with Num_zero, and reports
+ *           every outer iteration that allocated memory. The calls are made
+ *           only with -DPRIMME_TRACK_ALLOC (see track.h). The counts are
+ *           global to the process and are not protected against concurrent
+ *           updates from several threads.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include "primme.h"
+#include "track.h"
+
+static double numAllocs;      /* Allocations since the program started     */
+static double allocBytes;     /* Bytes requested in them                   */
+static double zeroBytes;      /* Bytes zeroed with Num_zero                */
+static double lastAllocs;     /* numAllocs at the previous iteration       */
+static double lastAllocBytes; /* allocBytes idem                           */
+static double lastZeroBytes;  /* zeroBytes idem                            */
+
+
+void primme_track_alloc(size_t bytes) {
+   numAllocs++;
+   allocBytes += bytes;
+}
+
+void primme_track_zero(size_t bytes) {
+   zeroBytes += bytes;
+}
+
+
+/*******************************************************************************
+ * Subroutine primme_track_iteration - Called at the beginning of every outer
+ *    iteration. It reports the allocations made since the previous outer
+ *    iteration, which should not happen once the solver is in its steady
+ *    state, and with printLevel 5 also the bytes zeroed.
+ *
+ * INPUT PARAMETERS
+ * ----------------
+ * primme      Structure containing outputFile, printLevel and the stats
+ *
+ ******************************************************************************/
+
+void primme_track_iteration(primme_params *primme) {
+
+   if (primme->procID == 0 && primme->stats.numOuterIterations > 1) {
+      if (numAllocs > lastAllocs) {
+         fprintf(primme->outputFile, "TRACK outer iteration %d: %g "
+               "allocations of %g bytes\n", primme->stats.numOuterIterations-1,
+               numAllocs-lastAllocs, allocBytes-lastAllocBytes);
+      }
+      if (primme->printLevel >= 5) {
+         fprintf(primme->outputFile, "TRACK outer iteration %d: %g bytes "
+               "zeroed\n", primme->stats.numOuterIterations-1,
+               zeroBytes-lastZeroBytes);
+      }
+   }
+   lastAllocs = numAllocs;
+   lastAllocBytes = allocBytes;
+   lastZeroBytes = zeroBytes;
+}
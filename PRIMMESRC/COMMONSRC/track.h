@@ -0,0 +1,60 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ * File: track.h
+ *
+ * Purpose - Header file containing the tracker of the allocations and of
+ *           the zeroed memory in the solver (see PRIMME_TRACK_ALLOC).
+ *
+ ******************************************************************************/
+
+#ifndef TRACK_H
+#define TRACK_H
+
+#include <stddef.h>
+#include "primme.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void primme_track_alloc(size_t bytes);
+void primme_track_zero(size_t bytes);
+void primme_track_iteration(primme_params *primme);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* The calls compile to nothing unless -DPRIMME_TRACK_ALLOC */
+
+#ifdef PRIMME_TRACK_ALLOC
+#  define TRACK_ALLOC(bytes) primme_track_alloc(bytes)
+#  define TRACK_ZERO(bytes) primme_track_zero(bytes)
+#  define TRACK_ITERATION(primme) primme_track_iteration(primme)
+#else
+#  define TRACK_ALLOC(bytes)
+#  define TRACK_ZERO(bytes)
+#  define TRACK_ITERATION(primme)
+#endif
+
+#endif /* TRACK_H */
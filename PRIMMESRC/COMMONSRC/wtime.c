@@ -38,9 +38,12 @@
 #define   RUSAGE_SELF     0      /*needed in osx*/
 #endif
 
+/* primme_wTimer keeps its start in a static shared by the whole process,   */
+/* so it is not safe when several threads reset it. The solver does not use */
+/* it: each call of d/zprimme keeps its own start in stats.startTime.       */
 #if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
 double primme_wTimer(int zeroTimer) {
-   static struct timeval tv;
+   struct timeval tv;
    static double StartingTime;
    
    if (zeroTimer) {
@@ -84,7 +87,7 @@ double primme_wTimer(int zeroTimer) {
 
 /* Simply return the microseconds time of day */
 double primme_get_wtime() {
-   static struct timeval tv;
+   struct timeval tv;
 
    gettimeofday(&tv, NULL); 
    return ((double) tv.tv_sec) + ((double) tv.tv_usec ) / (double) 1E6;
@@ -93,7 +96,7 @@ double primme_get_wtime() {
 /* Return user/system times */
 double primme_get_time(double *utime, double *stime) {
    struct rusage usage;
-   static struct timeval utv,stv;
+   struct timeval utv,stv;
 
    getrusage(RUSAGE_SELF, &usage);
    utv = usage.ru_utime;
@@ -118,4 +121,8 @@ double primme_wTimer(int zeroTimer) {
    }
 }
 
+double primme_get_wtime() {
+   return GetTickCount()/1000.0;
+}
+
 #endif
@@ -43,4 +43,9 @@ double primme_get_time(double *, double *);
 }
 #endif
 
+/* Seconds since the running call to d/zprimme started (stats.startTime). */
+/* Unlike primme_wTimer, the start is private to the call, so concurrent  */
+/* calls (slices, threads) do not reset each other's clock.               */
+#define ELAPSED_TIME(primme) (primme_get_wtime() - (primme)->stats.startTime)
+
 #endif /* WTIME_H */
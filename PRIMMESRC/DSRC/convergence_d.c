@@ -34,6 +34,7 @@
 #include "convergence_d.h"
 #include "convergence_private_d.h"
 #include "numerical_d.h"
+#include "lock_store_d.h"
 
 /*******************************************************************************
  * Subroutine check_convergence - This procedure checks the block vectors for  
@@ -58,6 +59,7 @@
  * rwork          Real work array that must be of size 
  *                MAX(2*maxEvecsSize*primme->maxBlockSize, primme->maxBlockSize+
  *                    primme->maxBasisSize*primme->maxBlockSize);
+ * iwork          Integer work array of size maxBlockSize
  * primme           Structure containing various solver parameters
  *
  * INPUT/OUTPUT ARRAYS AND PARAMETERS
@@ -68,13 +70,19 @@
  * blockNorms    Residual norms of the Ritz vectors being computed during the
  *               current iteration
  * blockSize     Dimension of the block
+ *
+ * Return value
+ * ------------
+ * The number of Ritz vectors declared converged, or a negative value if
+ * the locked vectors could not be read from the store or the block could
+ * not be gathered.
  ******************************************************************************/
 
 int check_convergence_dprimme(double *V, double *W, double *hVecs, 
    double *hVals, int *flags, int basisSize, int *iev, int *ievMax, 
    double *blockNorms, int *blockSize, int numConverged, int numLocked, 
    double *evecs, double tol, double maxConvTol, double aNormEstimate, 
-   double *rwork, primme_params *primme) {
+   double *rwork, int *iwork, primme_params *primme) {
 
    int i;             /* Loop variable                                        */
    int left, right;   /* Range of block vectors to be checked for convergence */
@@ -83,6 +91,8 @@ int check_convergence_dprimme(double *V, double *W, double *hVecs,
    int recentlyConverged; /* The number of Ritz values declared converged     */
                           /* since the last iteration                         */
    int numToProject;      /* Number of vectors with potential accuracy problem*/
+   int ret;               /* Return value of check_practical_convergence     */
+   int *blockMap;         /* Physical position in the block of each vector   */
    double attainableTol;  /* Used in locking to check near convergence problem*/
 
    /* -------------------------------------------- */
@@ -113,6 +123,19 @@ int check_convergence_dprimme(double *V, double *W, double *hVecs,
    right = *blockSize - 1;
    numVacancies = 1;
 
+   /* ----------------------------------------------------------------- */
+   /* Block vector i is stored in V(:,basisSize+blockMap[i]) and in the */
+   /* same column of W. Reordering the block only changes blockMap, and */
+   /* the columns are moved into place once per pass by gather_block.   */
+   /* The map lives only for this call; on return the block is stored   */
+   /* in order, and the basis, locking and restart still move columns.  */
+   /* ----------------------------------------------------------------- */
+
+   blockMap = iwork;
+   for (i=0; i < primme->maxBlockSize; i++) {
+      blockMap[i] = i;
+   }
+
    while (numVacancies > 0 && 
           (numConverged + recentlyConverged) < primme->numEvals) {
 
@@ -166,9 +189,15 @@ int check_convergence_dprimme(double *V, double *W, double *hVecs,
                    primme->printLevel >= 2) { fprintf(primme->outputFile, 
                   "#Converged %d eval[ %d ]= %e norm %e Mvecs %d Time %g\n",
                   numConverged+recentlyConverged, iev[i], hVals[iev[i]], 
-                  blockNorms[i], primme->stats.numMatvecs,primme_wTimer(0));
+                  blockNorms[i], primme->stats.numMatvecs,ELAPSED_TIME(primme));
                   fflush(primme->outputFile);
                } /* printf */
+
+               if (!primme->locking && EVENTS_ON(primme)) {
+                  primme_event_push(primme_event_lock, iev[i],
+                     numConverged+recentlyConverged, 0, hVals[iev[i]],
+                     blockNorms[i], primme);
+               }
             } /*if */
          } /*if converged */
          /* ---------------------------------------------------------------- */
@@ -192,8 +221,7 @@ int check_convergence_dprimme(double *V, double *W, double *hVecs,
       /* ---------------------------------------------------------------- */
       if (numVacancies > 0 || numToProject > 0) {
 
-         swap_UnconvVecs(V, W, primme->nLocal, basisSize, iev, flags, 
-            blockNorms, primme->numOrthoConst + numLocked, *blockSize, left);
+         swap_UnconvVecs(blockMap, iev, flags, blockNorms, *blockSize, left);
       }
       /* --------------------------------------------------------------- */
       /* Project the TO_BE_PROJECTED residuals and check for practical   */
@@ -205,9 +233,32 @@ int check_convergence_dprimme(double *V, double *W, double *hVecs,
 
          start = *blockSize - numVacancies - numToProject;
 
-         check_practical_convergence(V, W, evecs, numLocked, basisSize, 
-            *blockSize, start, numToProject, iev, flags, blockNorms, tol, 
-            &recentlyConverged, &numVacancies, rwork, primme);
+         ret = check_practical_convergence(V, W, evecs, numLocked, 
+            basisSize, *blockSize, start, numToProject, iev, flags, 
+            blockNorms, blockMap, tol, &recentlyConverged, &numVacancies, 
+            rwork, primme);
+         if (ret != 0) {
+            return ret;
+         }
+      }
+
+      /* ---------------------------------------------------------------- */
+      /* Make the unconverged Ritz vectors and residuals contiguous again */
+      /* before the vacancies are filled. The columns of the converged    */
+      /* vectors are left at the end of the block.                        */
+      /* ---------------------------------------------------------------- */
+
+      if (numVacancies > 0 || numToProject > 0) {
+         ret = gather_block(V, W, basisSize, *blockSize, blockMap, iev,
+            flags, blockNorms, 0, *blockSize - numVacancies, primme);
+         if (ret != 0) {
+            primme_PushErrorMessage(Primme_check_convergence,
+               Primme_gather_block, ret, __FILE__, __LINE__, primme);
+            return ret;
+         }
+         for (i=*blockSize - numVacancies; i < *blockSize; i++) {
+            blockMap[i] = i;
+         }
       }
 
       /* ---------------------------------------------------------------- */
@@ -295,8 +346,8 @@ static void compute_resnorms(double *V, double *W, double *hVecs,
       &W[primme->nLocal*(basisSize+i)], 1, &W[primme->nLocal*(basisSize+i)], 1);
    }
    
-   (*primme->globalSumDouble)(&dwork[left], &blockNorms[left], &numResiduals,
-                              primme);
+   primme_globalSumDouble(&dwork[left], &blockNorms[left], &numResiduals,
+                          primme);
 
    for (i=left; i <= right; i++) {
       blockNorms[i] = sqrt(blockNorms[i]);
@@ -340,7 +391,7 @@ static void print_residuals(double *ritzValues, double *blockNorms,
          fprintf(primme->outputFile, 
             "OUT %d conv %d blk %d MV %d Sec %E EV %13E |r| %.3E\n",
          primme->stats.numOuterIterations, found, i, primme->stats.numMatvecs,
-         primme_wTimer(0), ritzValues[iev[i]], blockNorms[i]);
+         ELAPSED_TIME(primme), ritzValues[iev[i]], blockNorms[i]);
       }
 
       fflush(primme->outputFile);
@@ -352,34 +403,29 @@ static void print_residuals(double *ritzValues, double *blockNorms,
 
 
 /*******************************************************************************
- * Subroutine swap_UnconvVecs - This procedure copies unconverged Ritz vectors 
- *    towards the beginning of the block starting at V(:,basisSize+left).
- *    Flagged vectors are copied to the right end of the block, ending at 
- *    basisSize + blockSize-1. The corresponding residuals in W are also 
- *    copied towards the front and end correspondingly of the block 
- *    W(:,basisSize+left:basisSize+blockSize-1). This ensures that the 
- *    unconverged Ritz vectors as well as the residuals are contiguous.  Also, 
- *    new vectors selected to replace the converged ones will be contiguous too.
+ * Subroutine swap_UnconvVecs - This procedure moves unconverged Ritz vectors 
+ *    towards the beginning of the block starting at position left. Flagged
+ *    vectors are moved to the right end of the block, ending at blockSize-1.
+ *    Only the logical order of the block is changed: the columns of V and W
+ *    holding each block vector are tracked in blockMap, and gather_block 
+ *    later makes the unconverged Ritz vectors and residuals contiguous. Also,
+ *    new vectors selected to replace the converged ones will be contiguous.
  * 
  * INPUT ARRAYS AND PARAMETERS
  * ---------------------------
- * nLocal        Number of rows of V assigned to the node
- * basisSize     Number of vectors in the basis V
  * flags         Indicates which of the Ritz vectors have converged/flagged
  * blockSize     Number of block vectors
- * left, right   Indicies of the block vectors to be swapped  
+ * left          Index of the first block vector to be swapped  
  *
  * INPUT/OUTPUT ARRAYS AND PARAMETERS
  * ----------------------------------
- * V             The orthonormal basis
- * W             A*V
+ * blockMap      The column in the block of V and W of each block vector
  * iev           the index of each block vector
  * blockNorms    the norms for each vector in the block
  ******************************************************************************/
      
-static void swap_UnconvVecs(double *V, double *W, int nLocal, 
-   int basisSize, int *iev, int *flags, double *blockNorms, int dimEvecs, 
-   int blockSize, int left) {
+static void swap_UnconvVecs(int *blockMap, int *iev, int *flags, 
+   double *blockNorms, int blockSize, int left) {
 
    int right; /* holds the right swapping position */
    int temp;  /* used to swap integers */
@@ -387,9 +433,9 @@ static void swap_UnconvVecs(double *V, double *W, int nLocal,
 
    /* Search from left to right within the block looking for flagged     */
    /* Ritz vectors.  If a flagged one is found, find also an unconverged */
-   /* Ritz vector from the right side of the block. If the flagged was   */
-   /* converged, replace it with the unconverged, otherwise if it was    */
-   /* was flagged TO_BE_PROJECTED, swap it with the unconverged vector.  */
+   /* Ritz vector from the right side of the block, and swap them. A     */
+   /* converged vector is not needed anymore, but its column is kept in  */
+   /* blockMap so that it can be reused by the vector that replaces it.  */
 
    while (left < blockSize) {
 
@@ -421,31 +467,17 @@ static void swap_UnconvVecs(double *V, double *W, int nLocal,
          }
 
          /* An unconverged Ritz vector was found and should */
-         /* replace or be swapped with block vector left.   */
-
-         if (flags[iev[left]] != TO_BE_PROJECTED) { 
-                /* replace */
-            Num_dcopy_dprimme(nLocal, &V[nLocal*(basisSize+right)], 1,
-               &V[nLocal*(basisSize+left)], 1);
-            Num_dcopy_dprimme(nLocal, &W[nLocal*(basisSize+right)], 1,
-               &W[nLocal*(basisSize+left)], 1);
-            temp = iev[left];
-            iev[left] = iev[right];
-            iev[right] = temp;
-            blockNorms[left] = blockNorms[right];
-         }
-         else { /* swap */
-            Num_swap_dprimme(nLocal, &V[nLocal*(basisSize+left)], 1, 
-                              &V[nLocal*(basisSize+right)], 1);
-            Num_swap_dprimme(nLocal, &W[nLocal*(basisSize+left)], 1, 
-                              &W[nLocal*(basisSize+right)], 1);
-            temp = iev[left];
-            iev[left] = iev[right];
-            iev[right] = temp;
-            dtemp = blockNorms[left];
-            blockNorms[left] = blockNorms[right];
-            blockNorms[right] = dtemp;
-         } /* end of swaps */
+         /* be swapped with block vector left.              */
+
+         temp = blockMap[left];
+         blockMap[left] = blockMap[right];
+         blockMap[right] = temp;
+         temp = iev[left];
+         iev[left] = iev[right];
+         iev[right] = temp;
+         dtemp = blockNorms[left];
+         blockNorms[left] = blockNorms[right];
+         blockNorms[right] = dtemp;
 
          left++;
 
@@ -455,6 +487,95 @@ static void swap_UnconvVecs(double *V, double *W, int nLocal,
 }
 
 
+/*******************************************************************************
+ * Subroutine gather_block - Moves the columns of the block of V and W so that
+ *    the block vectors first through last-1 are stored in V(:,basisSize+i)
+ *    and W(:,basisSize+i), as the rest of the solver expects. The order of
+ *    these vectors is not relevant, so those already stored in one of the 
+ *    columns first through last-1 are relabeled to stay there, and only the 
+ *    rest are moved, once each, into the remaining columns. If a column
+ *    holds a converged vector, it is overwritten; otherwise the vectors are
+ *    swapped. The bytes moved are added to primme->stats.bytesMoved.
+ *
+ * INPUT ARRAYS AND PARAMETERS
+ * ---------------------------
+ * basisSize     Number of vectors in the basis V
+ * blockSize     Number of vectors in the block
+ * flags         Indicates which of the Ritz vectors have converged/flagged
+ * first, last   Range of block vectors to gather. The vectors before first
+ *               must be already in place
+ *
+ * INPUT/OUTPUT ARRAYS AND PARAMETERS
+ * ----------------------------------
+ * V, W          The basis and A*V, with the block after column basisSize
+ * blockMap      The column in the block of V and W of each block vector
+ * iev           the index of each block vector
+ * blockNorms    the norms for each vector in the block
+ *
+ * Return value
+ * ------------
+ * 0 on success, or BLOCK_MAP_FAILURE if blockMap is not a permutation of the
+ * block
+ ******************************************************************************/
+
+static int gather_block(double *V, double *W, int basisSize, int blockSize,
+   int *blockMap, int *iev, int *flags, double *blockNorms, int first, int last,
+   primme_params *primme) {
+
+   int i, j;          /* Loop variables                              */
+   int src;           /* Column where block vector i is stored       */
+   int temp;          /* used to swap integers                       */
+   double dtemp;      /* used to swap doubles                        */
+   int nLocal = primme->nLocal;
+
+   /* Relabel the vectors already stored in the range of columns */
+
+   for (i=first; i < last; i++) {
+      while (blockMap[i] != i && blockMap[i] >= first && blockMap[i] < last) {
+         j = blockMap[i];
+         temp = blockMap[i]; blockMap[i] = blockMap[j]; blockMap[j] = temp;
+         temp = iev[i]; iev[i] = iev[j]; iev[j] = temp;
+         dtemp = blockNorms[i]; blockNorms[i] = blockNorms[j]; 
+         blockNorms[j] = dtemp;
+      }
+   }
+
+   /* Move the others into the columns left, held by vectors after last */
+
+   for (i=first; i < last; i++) {
+      if (blockMap[i] == i) continue;
+
+      src = blockMap[i];
+
+      /* Find the vector stored in column i; it is one after last, as */
+      /* blockMap is a permutation of the block                       */
+      for (j=last; j < blockSize && blockMap[j] != i; j++);
+      if (j >= blockSize) {
+         return BLOCK_MAP_FAILURE;
+      }
+
+      if (flags[iev[j]] == UNCONVERGED || flags[iev[j]] == TO_BE_PROJECTED) {
+         Num_swap_dprimme(nLocal, &V[nLocal*(basisSize+src)], 1,
+            &V[nLocal*(basisSize+i)], 1);
+         Num_swap_dprimme(nLocal, &W[nLocal*(basisSize+src)], 1,
+            &W[nLocal*(basisSize+i)], 1);
+         primme->stats.bytesMoved += 4.0L*nLocal*sizeof(double);
+      }
+      else {
+         Num_dcopy_dprimme(nLocal, &V[nLocal*(basisSize+src)], 1,
+            &V[nLocal*(basisSize+i)], 1);
+         Num_dcopy_dprimme(nLocal, &W[nLocal*(basisSize+src)], 1,
+            &W[nLocal*(basisSize+i)], 1);
+         primme->stats.bytesMoved += 2.0L*nLocal*sizeof(double);
+      }
+      blockMap[j] = src;
+      blockMap[i] = i;
+   }
+
+   return 0;
+}
+
+
 /*******************************************************************************
  * Subroutine replace_vectors - This routine determines which eigenvectors
  *            are to be targeted in the next iteration.  If one is marked
@@ -545,6 +666,7 @@ static void replace_vectors(int *iev, int *flags, int blockSize, int basisSize,
  * iev             Indicates which Ritz value each block vector corresponds to
  * flags           Indicates which Ritz pairs have converged
  * blockNorms      The norms of the block vectors to be targeted
+ * blockMap        The column in the block of V and W of each block vector
  * recentlyConverged Number of converged vectors in the whole basis V
  *                   = converged+practicallyConverged 
  * numVacancies    Number of Ritz values between left and right that were
@@ -553,11 +675,16 @@ static void replace_vectors(int *iev, int *flags, int blockSize, int basisSize,
  *                 check_convergence.
  * left, right     Indices indicating which vectors are to be replaced
  * ievMax          Index of the next Ritz value to be targeted by the block
+ *
+ * Return value
+ * ------------
+ *  0  success
+ * -1  the locked vectors could not be read from the store
  ******************************************************************************/
-static void check_practical_convergence(double *V, double *W, 
+static int check_practical_convergence(double *V, double *W, 
    double *evecs, int numLocked, int basisSize, int blockSize, int start, 
-   int numToProject, int *iev, int *flags, double *blockNorms, double tol, 
-   int *recentlyConverged, int *numVacancies, double *rwork, 
+   int numToProject, int *iev, int *flags, double *blockNorms, int *blockMap,
+   double tol, int *recentlyConverged, int *numVacancies, double *rwork, 
    primme_params *primme) {
 
    int i, n, dimEvecs;
@@ -587,8 +714,14 @@ static void check_practical_convergence(double *V, double *W,
          flags[iev[i]] = UNCONVERGED;
 
    if (*numVacancies > 0)
-      swap_UnconvVecs(V, W, primme->nLocal, basisSize, iev, flags, 
-                   blockNorms, dimEvecs, blockSize, start);
+      swap_UnconvVecs(blockMap, iev, flags, blockNorms, blockSize, start);
+
+   /* The residuals to be projected must be contiguous in W */
+
+   gather_block(V, W, basisSize, blockSize, blockMap, iev, flags, blockNorms,
+      0, start, primme);
+   gather_block(V, W, basisSize, blockSize, blockMap, iev, flags, blockNorms,
+      start, start+numToProject, primme);
 
    /* ------------------------------------------------------------------ */
    /* Project the numToProject residuals agaist (I-evecs*evecs')         */
@@ -596,16 +729,46 @@ static void check_practical_convergence(double *V, double *W,
 
    /* overlaps = evecs'*residuals */
 
-   Num_gemm_dprimme("C", "N", dimEvecs, numToProject, n, tpone, evecs, n, 
+   if (primme->lockStoreParams.file != NULL) {
+      /* Only the constraints are in evecs; locked vectors are in the store */
+
+      Num_gemm_dprimme("C", "N", primme->numOrthoConst, numToProject, n, 
+                  tpone, evecs, n, &W[(basisSize+start)*n], n, tzero, rwork,
+                  dimEvecs);
+      if (lock_store_gemm_dprimme("C", 0, numLocked, numToProject, tpone,
+                  &W[(basisSize+start)*n], n, tzero, 
+                  &rwork[primme->numOrthoConst], dimEvecs, primme) != 0) {
+         primme_PushErrorMessage(Primme_check_convergence, Primme_lock_store,
+            LOCK_STORE_FAILURE, __FILE__, __LINE__, primme);
+         return LOCK_STORE_FAILURE;
+      }
+   }
+   else {
+      Num_gemm_dprimme("C", "N", dimEvecs, numToProject, n, tpone, evecs, n, 
                   &W[(basisSize+start)*n], n, tzero, rwork, dimEvecs);
+   }
 
    count = dimEvecs*numToProject;
-   (*primme->globalSumDouble)(rwork, overlaps, &count, primme);
+   primme_globalSumDouble(rwork, overlaps, &count, primme);
 
    /* residuals = residuals - evecs*overlaps */
 
-   Num_gemm_dprimme("N", "N", n, numToProject, dimEvecs, tmone, evecs, n, 
+   if (primme->lockStoreParams.file != NULL) {
+      Num_gemm_dprimme("N", "N", n, numToProject, primme->numOrthoConst, 
+                  tmone, evecs, n, overlaps, dimEvecs, tpone, 
+                  &W[(basisSize+start)*n], n);
+      if (lock_store_gemm_dprimme("N", 0, numLocked, numToProject, tmone,
+                  &overlaps[primme->numOrthoConst], dimEvecs, tpone, 
+                  &W[(basisSize+start)*n], n, primme) != 0) {
+         primme_PushErrorMessage(Primme_check_convergence, Primme_lock_store,
+            LOCK_STORE_FAILURE, __FILE__, __LINE__, primme);
+         return LOCK_STORE_FAILURE;
+      }
+   }
+   else {
+      Num_gemm_dprimme("N", "N", n, numToProject, dimEvecs, tmone, evecs, n, 
                   overlaps, dimEvecs, tpone, &W[(basisSize+start)*n], n);
+   }
 
    /* ------------------------------------------------------------------ */
    /* Compute norms^2 of the projected res and the differences from res  */ 
@@ -622,7 +785,7 @@ static void check_practical_convergence(double *V, double *W,
    }
    /* global sum ||overlaps|| and ||(I-QQ')r|| */
    count = 2*numToProject;
-   (*primme->globalSumDouble)(rwork, &rwork[count], &count, primme);
+   primme_globalSumDouble(rwork, &rwork[count], &count, primme);
 
    /* ------------------------------------------------------------------ */
    /* For each projected residual check whether there is an accuracy     */
@@ -662,7 +825,7 @@ static void check_practical_convergence(double *V, double *W,
 
    start = blockSize - *numVacancies;
 
-   swap_UnconvVecs(V, W, primme->nLocal, basisSize, iev, flags, blockNorms, 
-                         dimEvecs, blockSize, start);
+   swap_UnconvVecs(blockMap, iev, flags, blockNorms, blockSize, start);
 
+   return 0;
 }
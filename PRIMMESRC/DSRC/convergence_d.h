@@ -33,6 +33,6 @@ int check_convergence_dprimme(double *V, double *W, double *hVecs,
    double *hVals, int *flags, int basisSize, int *iev, int *ievMax, 
    double *blockNorms, int *blockSize, int numConverged, int numLocked, 
    double *evecs, double tol, double maxConvTol, double aNormEstimate, 
-   double *rwork, primme_params *primme);
+   double *rwork, int *iwork, primme_params *primme);
 
 #endif
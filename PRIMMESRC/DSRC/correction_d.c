@@ -714,7 +714,7 @@ static void Olsen_preconditioner_block(double *r, double *x,
                                    &r[primme->nLocal*blockIndex],1);
    }      
    count = 2*blockSize;
-   (*primme->globalSumDouble)(xKinvx_local, xKinvx, &count, primme);
+   primme_globalSumDouble(xKinvx_local, xKinvx, &count, primme);
 
    /*------------------------------------------------------------------*/
    /* Compute K^{-1}r                                                  */
@@ -897,7 +897,7 @@ static void setup_JD_projectors(double *x, double *r, double *evecs,
          primme->stats.numPreconds += 1;
          *RprojectorX  = Kinvx;
          xKinvx_local = Num_dot_dprimme(primme->nLocal, x, 1, Kinvx, 1);
-         (*primme->globalSumDouble)(&xKinvx_local, xKinvx, &count, primme);
+         primme_globalSumDouble(&xKinvx_local, xKinvx, &count, primme);
       }      
       else {
          *RprojectorX = x;
@@ -0,0 +1,320 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ * File: dense.c
+ *
+ * Purpose - Solves small problems directly: the matrix is assembled by
+ *           applying matrixMatvec to blocks of columns of the identity and
+ *           all its eigenpairs are computed with LAPACK. For a few hundred
+ *           rows this is much faster than the iterative solver, which
+ *           restarts and orthogonalizes a basis of almost the same size.
+ *           See denseThreshold in primme.h and TEST/dense_bench.c.
+ *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "primme.h"
+#include "const.h"
+#include "wtime.h"
+#include "dense_d.h"
+#include "dense_private_d.h"
+#include "numerical_d.h"
+
+
+/*******************************************************************************
+ * Function dense_suitable - Decides whether dprimme solves the problem with
+ *    solve_dense. It requires a single process, no orthogonality constraints,
+ *    no initial guesses, the locked vectors in core, and n <= denseThreshold or a basis that
+ *    spans the whole space (maxBasisSize >= n). The n + numEvals matvecs
+ *    and the n^2 matrix must also fit in maxMatvecs and memoryBudget.
+ *    A negative denseThreshold disables the dense solver.
+ *
+ * INPUT PARAMETERS
+ * ----------------
+ * primme  Structure containing various solver parameters
+ *
+ * Return value
+ * ------------
+ * int  1 if the dense solver is used, 0 otherwise
+ *
+ ******************************************************************************/
+
+int dense_suitable_dprimme(primme_params *primme) {
+
+   double bytes;
+
+#ifdef NUM_ESSL
+   /* ESSL has no dsyev; the dense solver is not built with it */
+   return 0;
+#endif
+
+   if (primme->denseThreshold < 0 ||
+       (primme->n > primme->denseThreshold &&
+        primme->n > primme->maxBasisSize)) {
+      return 0;
+   }
+
+   if (primme->numProcs > 1 || primme->numOrthoConst > 0 ||
+       primme->initSize > 0 || primme->lockStoreParams.fileName != NULL) {
+      return 0;
+   }
+
+   if (primme->maxMatvecs > 0 &&
+       primme->maxMatvecs < primme->n + primme->numEvals) {
+      return 0;
+   }
+
+   bytes = ((double)primme->n + primme->maxBlockSize + DENSE_WORK_COLS)
+              *primme->n*sizeof(double);
+   if (primme->memoryBudget > 0 && bytes > primme->memoryBudget) {
+      return 0;
+   }
+
+   return 1;
+}
+
+
+/*******************************************************************************
+ * Subroutine solve_dense - Computes the numEvals eigenpairs selected by
+ *    target from the dense matrix A. A is assembled with n matvecs on
+ *    blocks of maxBlockSize columns of the identity, and dsyev uses its
+ *    upper triangular part. The residual norms are computed with numEvals
+ *    further matvecs, so they are the true ones. The stats are reset as
+ *    in main_iter; numOuterIterations stays 0.
+ *
+ *    The initial guesses in evecs and monitorFun are not used, and the
+ *    state kept for continuationParams is discarded.
+ *
+ * OUTPUT ARRAYS AND PARAMETERS
+ * ----------------------------
+ * evals     The computed eigenvalues, in the order given by target
+ * evecs     The corresponding eigenvectors
+ * resNorms  The residual norms ||A*x - lambda*x|| of the eigenpairs
+ *
+ * Input/Output parameters
+ * -----------------------
+ * primme    Structure containing various solver parameters. On output,
+ *           initSize is numEvals
+ *
+ * Return value
+ * ------------
+ *  0  success
+ * -1  the workspace could not be allocated
+ * -2  dsyev failed
+ *
+ ******************************************************************************/
+
+int solve_dense_dprimme(double *evals, double *evecs, double *resNorms,
+   primme_params *primme) {
+
+   int i, j, k;        /* Loop variables                                     */
+   int n;              /* Dimension of the problem                           */
+   int blockSize;      /* Columns per matvec                                 */
+   int lwork;          /* Length of work                                     */
+   int info;           /* dsyev error value                                  */
+   int *selected;      /* Index in w of the i-th returned pair, or -1        */
+   double *A;          /* The matrix, and then its eigenvectors              */
+   double *w;          /* The eigenvalues of A, in ascending order           */
+   double *X;          /* Block of the identity, and then of A*evecs         */
+   double *work;       /* Workspace for dsyev                                */
+   double lworkOpt;    /* Optimal length of work returned by dsyev           */
+
+   /* Some constants                                                          */
+   double tpone = +1.0e+00, tzero = +0.0e+00;
+
+#ifdef NUM_ESSL
+   /* Not reached: dense_suitable rejects the dense solver with ESSL */
+   return DENSE_DSYEV_FAILURE;
+#else
+
+   n = primme->n;
+   blockSize = min(primme->maxBlockSize, n);
+
+   /* ------------------------------------------- */
+   /* Reset the counters as main_iter does        */
+   /* ------------------------------------------- */
+
+   primme->stats.numOuterIterations = 0;
+   primme->stats.numRestarts = 0;
+   primme->stats.numMatvecs = 0;
+   primme->stats.bytesMoved = 0.0L;
+   primme->stats.comm.numReductions = 0;
+   primme->stats.comm.numDoubles = 0.0L;
+   primme->stats.comm.time = 0.0L;
+   for (i=0; i < primme_num_phases; i++) {
+      primme->stats.commPhase[i] = primme->stats.comm;
+   }
+   primme->stats.currentPhase = -1;
+
+   free(primme->continuationParams.state);
+   primme->continuationParams.state = NULL;
+
+   /* ------------------------------------------------------------ */
+   /* Ask dsyev for the optimal workspace and allocate all at once */
+   /* ------------------------------------------------------------ */
+
+   Num_dsyev_dprimme("V", "U", n, NULL, n, NULL, &lworkOpt, -1, &info);
+   lwork = info == 0 ? max(3*n, (int)lworkOpt) : 3*n;
+
+   A = (double *)primme_calloc((size_t)n*n + (size_t)n*blockSize + n + lwork,
+         sizeof(double), "dense matrix");
+   selected = (int *)primme_calloc(n, sizeof(int), "dense selection");
+   if (A == NULL || selected == NULL) {
+      free(A);
+      free(selected);
+      return DENSE_MALLOC_FAILURE;
+   }
+   X = A + (size_t)n*n;
+   w = X + (size_t)n*blockSize;
+   work = w + n;
+
+   /* ----------------------------------------------------------- */
+   /* A = matrixMatvec(I), with blockSize columns of I at a time  */
+   /* ----------------------------------------------------------- */
+
+   for (j=0; j < n; j += blockSize) {
+      k = min(blockSize, n - j);
+      for (i=0; i < k; i++) {
+         X[(size_t)n*i+j+i] = tpone;
+      }
+      (*primme->matrixMatvec)(X, &A[(size_t)n*j], &k, primme);
+      primme->stats.numMatvecs += k;
+      for (i=0; i < k; i++) {
+         X[(size_t)n*i+j+i] = tzero;
+      }
+   }
+
+   /* -------------------------------- */
+   /* All the eigenpairs of A          */
+   /* -------------------------------- */
+
+   Num_dsyev_dprimme("V", "U", n, A, n, w, work, lwork, &info);
+
+   if (info != 0) {
+      primme_PushErrorMessage(Primme_solve_dense, Primme_num_dsyev, info,
+         __FILE__, __LINE__, primme);
+      free(A);
+      free(selected);
+      return DENSE_DSYEV_FAILURE;
+   }
+
+   /* --------------------------------------------------------- */
+   /* Copy the pairs selected by target into evals and evecs    */
+   /* --------------------------------------------------------- */
+
+   for (i=0; i < primme->numEvals; i++) {
+      k = select_target(i, w, n, selected, primme);
+      selected[k] = 1;
+      evals[i] = w[k];
+      Num_dcopy_dprimme(n, &A[(size_t)n*k], 1, &evecs[(size_t)n*i], 1);
+      primme->stats.bytesMoved += n*sizeof(double);
+   }
+
+   /* ---------------------------------------------------- */
+   /* resNorms = ||A*evecs - evecs*diag(evals)||, by block */
+   /* ---------------------------------------------------- */
+
+   for (j=0; j < primme->numEvals; j += blockSize) {
+      k = min(blockSize, primme->numEvals - j);
+      (*primme->matrixMatvec)(&evecs[(size_t)n*j], X, &k, primme);
+      primme->stats.numMatvecs += k;
+      for (i=0; i < k; i++) {
+         Num_axpy_dprimme(n, -evals[j+i], &evecs[(size_t)n*(j+i)], 1,
+            &X[(size_t)n*i], 1);
+         resNorms[j+i] = sqrt(Num_dot_dprimme(n, &X[(size_t)n*i], 1,
+            &X[(size_t)n*i], 1));
+      }
+   }
+
+   if (primme->printLevel >= 2 && primme->procID == 0) {
+      for (i=0; i < primme->numEvals; i++) {
+         fprintf(primme->outputFile,
+            "Dense epair[ %d ]= %e norm %.4e Mvecs %d Time %.4e\n",
+            i+1, evals[i], resNorms[i], primme->stats.numMatvecs,
+            ELAPSED_TIME(primme));
+      }
+      fflush(primme->outputFile);
+   }
+
+   primme->initSize = primme->numEvals;
+
+   free(A);
+   free(selected);
+   return 0;
+#endif
+}
+
+
+/*******************************************************************************
+ * Function select_target - Returns the index in w of the i-th pair to
+ *    return: the i-th smallest or largest eigenvalue, or the eigenvalue not
+ *    selected yet closest to targetShifts[min(i, numTargetShifts-1)], on its
+ *    right (closest_geq), on its left (closest_leq) or in absolute value.
+ *    If no eigenvalue is left on the requested side, the closest one in
+ *    absolute value is taken.
+ *
+ * INPUT PARAMETERS
+ * ----------------
+ * i         Index of the pair to return
+ * w         The eigenvalues in ascending order
+ * n         Number of eigenvalues
+ * selected  Nonzero for the eigenvalues already returned
+ * primme    Structure containing target and the shifts
+ *
+ ******************************************************************************/
+
+static int select_target(int i, double *w, int n, int *selected,
+   primme_params *primme) {
+
+   int j, best;
+   double shift;
+
+   if (primme->target == primme_smallest) return i;
+   if (primme->target == primme_largest) return n-1-i;
+
+   shift = primme->targetShifts[min(i, primme->numTargetShifts-1)];
+   best = -1;
+
+   if (primme->target == primme_closest_geq) {
+      for (j=0; j < n && best < 0; j++) {
+         if (!selected[j] && w[j] >= shift) best = j;
+      }
+   }
+   else if (primme->target == primme_closest_leq) {
+      for (j=n-1; j >= 0 && best < 0; j--) {
+         if (!selected[j] && w[j] <= shift) best = j;
+      }
+   }
+
+   if (best < 0) {
+      for (j=0; j < n; j++) {
+         if (!selected[j] && (best < 0 ||
+               fabs(w[j] - shift) < fabs(w[best] - shift))) {
+            best = j;
+         }
+      }
+   }
+
+   return best;
+}
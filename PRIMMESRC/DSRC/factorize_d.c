@@ -32,11 +32,15 @@
 #include "primme.h"
 #include "factorize_d.h"
 #include "numerical_d.h"
+#include "factorize_private_d.h"
 
 /******************************************************************************
  * Function UDUDecompose - This function computes an UDU decomposition of the
  *   matrix M.  See LAPACK routine dsytrf for more information on how the
- *   decomposition is performed.
+ *   decomposition is performed. The factorization is stored in the lower
+ *   triangular form (M = L*D*L') with leading dimension 
+ *   numOrthoConst+numEvals, so that UDUAppend can later border it with new
+ *   rows and columns of M.
  *
  *
  * Input Parameters
@@ -53,7 +57,8 @@
  *
  * Output Parameters
  * -----------------
- * UDU  Array of dimension dimM x dimM containing the UDU decomposition of M.
+ * UDU  Array of dimension dimM x dimM and leading dimension 
+ *      numOrthoConst+numEvals containing the UDU decomposition of M.
  *
  * ipivot  Integer array of length dimM containing pivot mapping
  *
@@ -69,30 +74,216 @@ int UDUDecompose_dprimme(double *M, double *UDU, int *ipivot, int dimM,
 
    int i, j;
    int info;
+   int ldM;
+
+   ldM = primme->numOrthoConst+primme->numEvals;
 
    /* Quick return for M of dimension 1 */
 
    if (dimM <= 1) {
-      *UDU = *M;
+      if (dimM == 1) {
+         *UDU = *M;
+         *ipivot = 1;
+      }
       info = 0;
    }
    else {
 
-      /* Copy the upper triangular portion of M into UDU */
+      /* Copy the upper triangular portion of M into the lower one of UDU */
 
       for (j = 0; j < dimM; j++) {
          for (i = 0; i <= j; i++) {
-            UDU[dimM*j+i] = M[(primme->numOrthoConst+primme->numEvals)*j+i];
+            UDU[ldM*i+j] = M[ldM*j+i];
          }
       }
 
       /* Perform the decomposition */
-      Num_dsytrf_dprimme("U", dimM, UDU, dimM, ipivot, rwork, rworkSize, &info);
+      Num_dsytrf_dprimme("L", dimM, UDU, ldM, ipivot, rwork, rworkSize, &info);
    }
 
    return info;
 }
 
+/******************************************************************************
+ * Function UDUAppend - This function extends the UDU decomposition of the
+ *   leading dimM x dimM block of M to its leading (dimM+numNew) block,
+ *   where the new rows and columns of M have been already computed (e.g. by
+ *   update_projection). Every new column b with diagonal c borders the
+ *   factorization as
+ *
+ *      [ M  b ]   [ L  0 ] [ D  0 ] [ L'  x ]
+ *      [ b' c ] = [ x' 1 ] [ 0  d ] [ 0   1 ],   x = D^{-1}L^{-1}b, d = c-x'Dx
+ *
+ *   at O(dimM^2) cost instead of the O(dimM^3) of UDUDecompose. The pivots
+ *   of the existing factorization are not revised, so the whole matrix is
+ *   refactorized with UDUDecompose if the new row of L grows beyond the
+ *   bound that Bunch-Kaufman pivoting guarantees, or if d is zero. As a
+ *   periodic guard, M is also refactorized every time its dimension reaches
+ *   a power of two, which keeps the overall cost of factorizing M as it
+ *   grows to n columns in O(n^3).
+ *
+ *
+ * Input Parameters
+ * ----------------
+ * M      As in UDUDecompose
+ *
+ * dimM   The dimension of the current factorization in UDU
+ *
+ * numNew The number of rows and columns to append
+ *
+ * rwork  Real work array of dimension at least dimM+numNew
+ *
+ *
+ * Input/Output Parameters
+ * -----------------------
+ * UDU, ipivot  As in UDUDecompose. On output, they hold the decomposition 
+ *              of the leading (dimM+numNew) block of M
+ *
+ *
+ * Return Value
+ * ------------
+ * int error code: 0 upon success
+ *                 dsytrf error code
+ ******************************************************************************/
+
+int UDUAppend_dprimme(double *M, double *UDU, int *ipivot, int dimM, 
+   int numNew, double *rwork, int rworkSize, primme_params *primme) {
+
+   int k;
+   int ldM;
+
+   ldM = primme->numOrthoConst+primme->numEvals;
+
+   if (numNew <= 0) {
+      return 0;
+   }
+
+   if (!refactorize(dimM, dimM+numNew) && rworkSize >= dimM+numNew) {
+      for (k = dimM; k < dimM+numNew; k++) {
+         if (append_row(M, UDU, ipivot, k, ldM, rwork) != 0) break;
+      }
+      if (k == dimM+numNew) {
+         return 0;
+      }
+   }
+
+   return UDUDecompose_dprimme(M, UDU, ipivot, dimM+numNew, rwork, rworkSize,
+      primme);
+}
+
+/******************************************************************************
+ * Function refactorize - Returns whether M of dimension dimOld is refactorized
+ *    from scratch when it grows to dimension dimNew, that is, when the 
+ *    dimension reaches a power of two.
+ *
+ ******************************************************************************/
+
+static int refactorize(int dimOld, int dimNew) {
+
+   int powerOfTwo = 1;
+
+   while (powerOfTwo <= dimOld) {
+      powerOfTwo *= 2;
+   }
+
+   return dimNew >= powerOfTwo;
+}
+
+/******************************************************************************
+ * Function append_row - Extends the UDU decomposition of the leading k x k 
+ *    block of M with the row and column k. See UDUAppend.
+ *
+ * Input Parameters
+ * ----------------
+ * M       As in UDUDecompose
+ *
+ * k       The dimension of the current factorization in UDU
+ *
+ * ldM     The leading dimension of M and UDU
+ *
+ * y       Work array of size k
+ *
+ * Input/Output Parameters
+ * -----------------------
+ * UDU, ipivot  The decomposition of M, to be extended by one row and column
+ *
+ * Return Value
+ * ------------
+ * 0 upon success, 1 if the new row is unstable and M must be refactorized
+ ******************************************************************************/
+
+static int append_row(double *M, double *UDU, int *ipivot, int k, int ldM,
+   double *y) {
+
+   int i, p;
+   double a, e, f;      /* The 2x2 block [a e; e f] of D */
+   double det, x0, x1, tmp;
+   double d;            /* The new pivot */
+   double maxMult;      /* The largest new multiplier in absolute value */
+
+   /* y = L^{-1}b, applying the interchanges and transformations of L */
+   /* in the same order as dsytrs                                     */
+
+   for (i = 0; i < k; i++) {
+      y[i] = M[ldM*k+i];
+   }
+
+   p = 0;
+   while (p < k) {
+      if (ipivot[p] > 0) {
+         tmp = y[p]; y[p] = y[ipivot[p]-1]; y[ipivot[p]-1] = tmp;
+         for (i = p+1; i < k; i++) {
+            y[i] -= UDU[ldM*p+i]*y[p];
+         }
+         p++;
+      }
+      else {
+         tmp = y[p+1]; y[p+1] = y[-ipivot[p]-1]; y[-ipivot[p]-1] = tmp;
+         for (i = p+2; i < k; i++) {
+            y[i] -= UDU[ldM*p+i]*y[p] + UDU[ldM*(p+1)+i]*y[p+1];
+         }
+         p += 2;
+      }
+   }
+
+   /* The new row of L is x = D^{-1}y, and d = c - x'*y */
+
+   d = M[ldM*k+k];
+   maxMult = 0.0;
+   p = 0;
+   while (p < k) {
+      if (ipivot[p] > 0) {
+         x0 = y[p]/UDU[ldM*p+p];
+         UDU[ldM*p+k] = x0;
+         d -= x0*y[p];
+         maxMult = max(maxMult, fabs(x0));
+         p++;
+      }
+      else {
+         a = UDU[ldM*p+p];
+         e = UDU[ldM*p+p+1];
+         f = UDU[ldM*(p+1)+p+1];
+         det = a*f - e*e;
+         x0 = (f*y[p] - e*y[p+1])/det;
+         x1 = (a*y[p+1] - e*y[p])/det;
+         UDU[ldM*p+k] = x0;
+         UDU[ldM*(p+1)+k] = x1;
+         d -= x0*y[p] + x1*y[p+1];
+         maxMult = max(maxMult, max(fabs(x0), fabs(x1)));
+         p += 2;
+      }
+   }
+
+   if (maxMult > UDU_MAX_MULTIPLIER || d == 0.0) {
+      return 1;
+   }
+
+   UDU[ldM*k+k] = d;
+   ipivot[k] = k+1;
+
+   return 0;
+}
+
 /******************************************************************************
  * Function UDUSolve - This function solves a dense hermitian linear system
  *   given a right hand side (rhs) and a UDU factorization.
@@ -100,10 +291,10 @@ int UDUDecompose_dprimme(double *M, double *UDU, int *ipivot, int dimM,
  *
  * Input Parameters
  * ----------------
- * UDU     Two-dimensional of dimension dim and leading dimension dim.
- *         Contains block diagonal and multipliers necessary to construct
- *         the upper triangular matrix U.  See LAPACK routine dsytrf for more
- *         details.
+ * UDU     Two-dimensional of dimension dim and leading dimension 
+ *         numOrthoConst+numEvals. Contains block diagonal and multipliers
+ *         necessary to construct the lower triangular matrix L.  See LAPACK
+ *         routine dsytrf for more details.
  *
  * ipivot  Permutation array that determines how rows and columns of the
  *         factorization were permuted for stability.
@@ -122,7 +313,7 @@ int UDUDecompose_dprimme(double *M, double *UDU, int *ipivot, int dimM,
  ******************************************************************************/
 
 int UDUSolve_dprimme(double *UDU, int *ipivot, int dim, double *rhs, 
-   double *sol) {
+   double *sol, primme_params *primme) {
 
    int info;
 
@@ -132,7 +323,8 @@ int UDUSolve_dprimme(double *UDU, int *ipivot, int dim, double *rhs,
    }
    else {
       Num_dcopy_dprimme(dim, rhs, 1, sol, 1);
-      Num_dsytrs_dprimme("U", dim, 1, UDU, dim, ipivot, sol, dim, &info);
+      Num_dsytrs_dprimme("L", dim, 1, UDU, 
+         primme->numOrthoConst+primme->numEvals, ipivot, sol, dim, &info);
    }
 
    return info;
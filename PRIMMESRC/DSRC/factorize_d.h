@@ -32,8 +32,11 @@
 int UDUDecompose_dprimme(double *M, double *UDU, int *ipivot, int dimM, 
    double *rwork, int rworkSize, primme_params *primme);
 
+int UDUAppend_dprimme(double *M, double *UDU, int *ipivot, int dimM, 
+   int numNew, double *rwork, int rworkSize, primme_params *primme);
+
 int UDUSolve_dprimme(double *UDU, int *ipivot, int dim, double *rhs,
-   double *sol);
+   double *sol, primme_params *primme);
 
 
 #endif
@@ -30,7 +30,7 @@
 #define INIT_H
 
 int init_basis_dprimme(double *V, double *W, double *evecs, 
-   double *evecsHat, double *M, double *UDU, int *ipivot, 
+   double *extra, int numExtra, double *evecsHat, double *M, double *UDU, int *ipivot, 
    double machEps, double *rwork, int rworkSize, int *basisSize, 
    int *nextGuess, int *numGuesses, double *timeForOP, primme_params *primme);
 
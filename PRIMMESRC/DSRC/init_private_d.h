@@ -34,8 +34,17 @@
 #define INIT_KRYLOV_FAILURE       -3
 #define UDUDECOMPOSE_FAILURE      -4
 
+/* Lanczos steps that estimate the spectrum for the Chebyshev filter */
+#define FILTER_LANCZOS_STEPS      10
+
 static int init_block_krylov(double *V, double *W, int dv1, int dv2, 
    double *locked, int numLocked, double machEps, double *rwork, 
    int rworkSize, primme_params *primme);
 
+static void chebyshev_filter(double *V, double *W, int dv1, int blockSize,
+   double machEps, primme_params *primme);
+
+static double tridiagonal_eigenvalue(double *alpha, double *beta, int k, 
+   int j, double machEps);
+
 #endif
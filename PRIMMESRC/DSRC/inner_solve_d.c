@@ -30,6 +30,7 @@
 #include <math.h>
 #include <stdlib.h>
 #include "primme.h"
+#include "const.h"
 #include "wtime.h"
 #include "inner_solve_d.h"
 #include "inner_solve_private_d.h"
@@ -129,10 +130,10 @@ int inner_solve_dprimme(double *x, double *r, double *rnorm,
    double eresTol, double aNormEstimate, double machEps, double *rwork, 
    int rworkSize, primme_params *primme) {
 
-   int i;             /* loop variable                                       */
    int numIts;        /* Number of inner iterations                          */
    int ret;           /* Return value used for error checking.               */
    int maxIterations; /* The maximum # iterations allowed. Depends on primme */
+   int exitReason;    /* primme_inner_exit reported to the event stream      */
 
    double *workSpace; /* Workspace needed by UDU routine */
 
@@ -157,9 +158,6 @@ int inner_solve_dprimme(double *x, double *r, double *rnorm,
    double absoluteTolerance;
    double LTolerance, ETolerance;
 
-   /* Some constants                                                          */
-   double tzero = +0.0e+00;
-
    /* -------------------------------------------*/
    /* Subdivide the workspace into needed arrays */
    /* -------------------------------------------*/
@@ -181,7 +179,7 @@ int inner_solve_dprimme(double *x, double *r, double *rnorm,
    else {
       absoluteTolerance = primme->aNorm*machEps;
    }
-   tau_prev = tau_init = *rnorm;       /* Assumes zero initial guess */
+   tau = tau_prev = tau_init = *rnorm; /* Assumes zero initial guess */
    LTolerance = eresTol;
 
    /* Andreas: note that eigenresidual tol may not be achievable, because we */
@@ -245,13 +243,11 @@ int inner_solve_dprimme(double *x, double *r, double *rnorm,
    Beta_prev = Delta_prev = Psi_prev = 0.0L;
    Gamma_prev = Phi_prev = 0.0L;
 
-   /* other initializations */
-   for (i = 0; i < primme->nLocal; i++) {
-      delta[i] = tzero;
-      sol[i] = tzero;
-   }
+   /* delta and sol start at zero; the first step of the recurrence sets  */
+   /* them without reading them, so they are not zeroed in advance        */
 
    numIts = 0;
+   exitReason = primme_inner_maxits;
       
    /*----------------------------------------------------------------------*/
    /*------------------------ Begin Inner Loop ----------------------------*/
@@ -267,6 +263,7 @@ int inner_solve_dprimme(double *x, double *r, double *rnorm,
          if (primme->printLevel >= 5 && primme->procID == 0) {
             fprintf(primme->outputFile,"Exiting because SIGMA %e\n",sigma_prev);
          }
+         exitReason = primme_inner_breakdown;
          break;
       }
 
@@ -275,12 +272,14 @@ int inner_solve_dprimme(double *x, double *r, double *rnorm,
          if (primme->printLevel >= 5 && primme->procID == 0) {
             fprintf(primme->outputFile,"Exiting because ALPHA %e\n",alpha_prev);
          }
+         exitReason = primme_inner_breakdown;
          break;
       }
 
-      Num_axpy_dprimme(primme->nLocal, -alpha_prev, w, 1, g, 1);
+      /* g = g - alpha_prev*w and Theta = g'*g in a single pass */
 
-      Theta = dist_dot(g, 1, g, 1, primme);
+      Theta = Num_axpy_dot_dprimme(primme->nLocal, -alpha_prev, w, g, g);
+      Theta = dist_sum(Theta, primme);
       Theta = sqrt(Theta);
       Theta = Theta/tau_prev;
       c = 1.0L/sqrt(1+Theta*Theta);
@@ -288,17 +287,27 @@ int inner_solve_dprimme(double *x, double *r, double *rnorm,
 
       gamma = c*c*Theta_prev*Theta_prev;
       eta = alpha_prev*c*c;
-      for (i = 0; i < primme->nLocal; i++) {
-          delta[i] = gamma*delta[i] + eta*d[i];
-          sol[i] = delta[i]+sol[i];
+
+      /* delta = gamma*delta + eta*d and sol = sol + delta, and also the */
+      /* local sol'*sol in the same pass for the adaptive stopping       */
+
+      if (numIts == 0) {
+         dot_sol = Num_recurrence_start_dprimme(primme->nLocal, eta, d,
+            delta, sol);
+      }
+      else {
+         dot_sol = Num_recurrence_update_dprimme(primme->nLocal, gamma, eta,
+            d, delta, sol);
       }
       numIts++;
+      primme->stats.numProjectLocked++;
 
       if (fabs(rho_prev) == 0.0L ) {
          if (primme->printLevel >= 5 && primme->procID == 0) {
             fprintf(primme->outputFile,"Exiting because abs(rho) %e\n",
                fabs(rho_prev));
          }
+         exitReason = primme_inner_breakdown;
          break;
       }
       
@@ -306,6 +315,7 @@ int inner_solve_dprimme(double *x, double *r, double *rnorm,
          if (primme->printLevel >= 5 && primme->procID == 0) {
             fprintf(primme->outputFile, " tau < LTol %e %e\n",tau, LTolerance);
          }
+         exitReason = primme_inner_ltol;
          break;
       }
       else if (primme->correctionParams.convTest == primme_adaptive_ETolerance
@@ -326,7 +336,7 @@ int inner_solve_dprimme(double *x, double *r, double *rnorm,
          /* Perform the update: update the eigenvalue and the square of the  */
          /* residual norm.                                                   */
          
-         dot_sol = dist_dot(sol, 1, sol, 1, primme);
+         dot_sol = dist_sum(dot_sol, primme);
          eval_updated = shift + (eval - shift + 2*Beta + Gamma)/(1 + dot_sol);
          eres2_updated = (tau*tau)/(1 + dot_sol) + 
             ((eval - shift + Beta)*(eval - shift + Beta))/(1 + dot_sol) - 
@@ -349,6 +359,7 @@ int inner_solve_dprimme(double *x, double *r, double *rnorm,
             if (primme->printLevel >= 5 && primme->procID == 0) {
                fprintf(primme->outputFile, " tau < R eres \n");
             }
+            exitReason = primme_inner_eres;
             break;
          }
 
@@ -356,12 +367,14 @@ int inner_solve_dprimme(double *x, double *r, double *rnorm,
             if (primme->printLevel >= 5 && primme->procID == 0) {
                fprintf(primme->outputFile, "eval_updated > eval_prev\n");
             }
+            exitReason = primme_inner_eval;
             break;
          }
          else if (primme->target == primme_largest && eval_updated < eval_prev){
             if (primme->printLevel >= 5 && primme->procID == 0) {
                fprintf(primme->outputFile, "eval_updated < eval_prev\n");
             }
+            exitReason = primme_inner_eval;
             break;
          }
          
@@ -369,6 +382,7 @@ int inner_solve_dprimme(double *x, double *r, double *rnorm,
             if (primme->printLevel >= 5 && primme->procID == 0) {
                fprintf(primme->outputFile, "eres < eresTol %e \n",eres_updated);
             }
+            exitReason = primme_inner_etol;
             break;
          }
 
@@ -377,7 +391,7 @@ int inner_solve_dprimme(double *x, double *r, double *rnorm,
          if (primme->printLevel >= 4 && primme->procID == 0) {
             fprintf(primme->outputFile,
            "INN MV %d Sec %e Eval %e Lin|r| %.3e EV|r| %.3e\n", primme->stats.
-            numMatvecs, primme_wTimer(0), eval_updated, tau, eres_updated);
+            numMatvecs, ELAPSED_TIME(primme), eval_updated, tau, eres_updated);
             fflush(primme->outputFile);
          }
 
@@ -388,7 +402,7 @@ int inner_solve_dprimme(double *x, double *r, double *rnorm,
         /* Report for non adaptive inner iterations */
         fprintf(primme->outputFile,
            "INN MV %d Sec %e Lin|r| %e\n", primme->stats.numMatvecs,
-           primme_wTimer(0),tau);
+           ELAPSED_TIME(primme),tau);
         fflush(primme->outputFile);
       }
 
@@ -427,6 +441,15 @@ int inner_solve_dprimme(double *x, double *r, double *rnorm,
    } /* End of QMR main while loop                              */
      /* --------------------------------------------------------*/
 
+   /* The correction is zero if no step was taken */
+
+   if (numIts == 0) Num_zero_dprimme(primme->nLocal, sol);
+
+   if (EVENTS_ON(primme)) {
+      primme_event_push(primme_event_inner, -1, numIts, exitReason,
+         eval_prev, tau, primme);
+   }
+
    *rnorm = eres_updated;
    return 0;
 }
@@ -485,6 +508,7 @@ static int apply_projected_preconditioner(double *v, double *Q,
 
    int ONE = 1;
    int ret;
+   double tstart; /* Time of the projection, for the cost model */
 
    if (primme->correctionParams.precondition) {
       /* Place K^{-1}v in result */
@@ -495,8 +519,13 @@ static int apply_projected_preconditioner(double *v, double *Q,
       Num_dcopy_dprimme(primme->nLocal, v, 1, result, 1);
    }
 
+   tstart = primme_get_wtime();
    ret = apply_skew_projector(Q, RprojectorQ, UDU, ipivot, sizeRprojectorQ,
                            result, rwork, primme);
+   if (sizeRprojectorQ > 0) {
+      primme->stats.timeProjectLocked += 
+         (primme_get_wtime() - tstart)/sizeRprojectorQ;
+   }
    if (ret != 0) {
          primme_PushErrorMessage(Primme_apply_projected_preconditioner, 
             Primme_apply_skew_projector, ret, __FILE__, __LINE__, primme);
@@ -585,7 +614,7 @@ static int apply_skew_projector(double *Q, double *Qhat, double *UDU,
 
          /* Global sum: overlaps = Q'*v */
          count = numCols;
-         (*primme->globalSumDouble)(workSpace, overlaps, &count, primme);   
+         primme_globalSumDouble(workSpace, overlaps, &count, primme);   
 
          /* --------------------------------------------*/
          /* Backsolve only if there is a skew projector */
@@ -594,7 +623,8 @@ static int apply_skew_projector(double *Q, double *Qhat, double *UDU,
             /* Solve (Q'Qhat)^{-1}*workSpace = overlaps = Q'*v for alpha by */
             /* backsolving  with the UDU decomposition.                 */
    
-            ret = UDUSolve_dprimme(UDU, ipivot, numCols, overlaps, workSpace);
+            ret = UDUSolve_dprimme(UDU, ipivot, numCols, overlaps, workSpace,
+               primme);
             if (ret != 0) {
                primme_PushErrorMessage(Primme_apply_skew_projector,
                   Primme_udusolve, ret, __FILE__, __LINE__, primme);
@@ -646,11 +676,15 @@ static void apply_projected_matrix(double *v, double shift, double *Q,
    int dimQ, double *result, double *rwork, primme_params *primme) {
    
    int ONE = 1;   /* For passing it by reference in matrixMatvec */
+   double tstart; /* Time of the projection, for the cost model  */
 
    (*primme->matrixMatvec)(v, result, &ONE, primme);
    Num_axpy_dprimme(primme->nLocal, -shift, v, 1, result, 1); 
-   if (dimQ > 0)
+   if (dimQ > 0) {
+      tstart = primme_get_wtime();
       apply_projector(Q, dimQ, result, rwork, primme); 
+      primme->stats.timeProjectLocked += (primme_get_wtime() - tstart)/dimQ;
+   }
 
    primme->stats.numMatvecs += 1;
 }
@@ -692,7 +726,7 @@ static void apply_projector(double *Q, int numCols, double *v,
    Num_gemv_dprimme("C", primme->nLocal, numCols, tpone, Q, primme->nLocal,
       v, 1, tzero, workSpace, 1);
    count = numCols;
-   (*primme->globalSumDouble)(workSpace, overlaps, &count, primme);   
+   primme_globalSumDouble(workSpace, overlaps, &count, primme);   
    Num_gemv_dprimme("N", primme->nLocal, numCols, tmone, Q, primme->nLocal,
       overlaps, 1, tpone, v, 1);
 
@@ -724,7 +758,29 @@ static double dist_dot(double *x, int incx,
                                                                                 
    temp = Num_dot_dprimme(primme->nLocal, x, incx, y, incy);
    count = 1;
-   (*primme->globalSumDouble)(&temp, &product, &count, primme);
+   primme_globalSumDouble(&temp, &product, &count, primme);
    return product;
                                                                                 
 }
+
+/*******************************************************************************
+ * Function dist_sum - Returns the sum of x among all processes. It completes
+ *    the local dot products computed by the fused kernels.
+ *
+ * Input Parameters
+ * ----------------
+ * x       Local value
+ *
+ * primme  Structure containing various solver parameters
+ *
+ ******************************************************************************/
+
+static double dist_sum(double x, primme_params *primme) {
+
+   double sum;
+   int count = 1;
+
+   primme_globalSumDouble(&x, &sum, &count, primme);
+   return sum;
+
+}
@@ -52,4 +52,6 @@ static void apply_projector(double *Q, int numCols, double *v,
 static double dist_dot(double *x, int incx,
    double *y, int incy, primme_params *primme);
 
+static double dist_sum(double x, primme_params *primme);
+
 #endif
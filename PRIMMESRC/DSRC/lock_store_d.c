@@ -0,0 +1,396 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ * File: lock_store.c
+ *
+ * Purpose - Keeps the locked eigenvectors out of core. When
+ *           primme->lockStoreParams.fileName is set, every locked vector
+ *           is written to that file instead of evecs, and the products with
+ *           the locked vectors needed by ortho and check_convergence are
+ *           computed by reading the file in panels of
+ *           primme->lockStoreParams.panelSize vectors. Thus the memory
+ *           required by the solver does not grow with numEvals.
+ *
+ *           The file keeps the local part of each vector, nLocal doubles,
+ *           in consecutive positions. Vector k in the file corresponds to
+ *           column numOrthoConst+k of evecs; the orthogonality constraints
+ *           are always kept in core.
+ *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "primme.h"
+#include "track.h"
+#include "numerical_d.h"
+#include "lock_store_d.h"
+#include "lock_store_private_d.h"
+
+#if defined(_WIN32)
+#  define LOCK_STORE_SEEK(f, off) _fseeki64((f), (__int64)(off), SEEK_SET)
+#  define LOCK_STORE_OFF __int64
+#elif defined(__unix__) || defined(__APPLE__)
+#  include <sys/types.h>
+#  define LOCK_STORE_SEEK(f, off) fseeko((f), (off_t)(off), SEEK_SET)
+#  define LOCK_STORE_OFF off_t
+#else
+#  define LOCK_STORE_SEEK(f, off) fseek((f), (long)(off), SEEK_SET)
+#  define LOCK_STORE_OFF long
+#endif
+
+
+/*******************************************************************************
+ * Function lock_store_open - Creates the file that stores the locked vectors
+ *    and allocates the panel used to read them back. An existing file with
+ *    the same name is truncated.
+ *
+ * Input/Output parameters
+ * -----------------------
+ * primme  Structure containing various solver parameters. On output, 
+ *         lockStoreParams.file and lockStoreParams.panel are set.
+ *
+ * Return value
+ * ------------
+ *  0  success
+ * -1  the file could not be opened
+ * -2  the panel could not be allocated
+ *
+ ******************************************************************************/
+
+int lock_store_open_dprimme(primme_params *primme) {
+
+   lockstore_params *store = &primme->lockStoreParams;
+
+   store->file = fopen(store->fileName, "w+b");
+   if (store->file == NULL) {
+      return LOCK_STORE_FOPEN_FAILURE;
+   }
+
+   TRACK_ALLOC((size_t)primme->nLocal*store->panelSize*sizeof(double));
+   store->panel = (void *) malloc(
+      (size_t)primme->nLocal*store->panelSize*sizeof(double));
+   if (store->panel == NULL) {
+      fclose(store->file);
+      store->file = NULL;
+      return LOCK_STORE_MALLOC_FAILURE;
+   }
+
+   return 0;
+}
+
+
+/*******************************************************************************
+ * Function lock_store_close - Closes the file and frees the panel. The file
+ *    is not removed; it keeps the eigenvectors computed by the solver.
+ *
+ ******************************************************************************/
+
+void lock_store_close_dprimme(primme_params *primme) {
+
+   lockstore_params *store = &primme->lockStoreParams;
+
+   if (store->file != NULL) {
+      fclose(store->file);
+      store->file = NULL;
+   }
+   if (store->panel != NULL) {
+      free(store->panel);
+      store->panel = NULL;
+   }
+}
+
+
+/*******************************************************************************
+ * Function lock_store_write - Writes count consecutive vectors into the file
+ *    starting at position index.
+ *
+ * Input parameters
+ * ----------------
+ * x       The vectors to be stored, with leading dimension nLocal
+ * index   Position in the file of the first vector
+ * count   Number of vectors
+ *
+ * Return value
+ * ------------
+ *  0  success
+ * -3  I/O error
+ *
+ ******************************************************************************/
+
+int lock_store_write_dprimme(double *x, int index, int count, 
+   primme_params *primme) {
+
+   size_t size = (size_t)primme->nLocal*count;
+
+   if (count <= 0) return 0;
+
+   if (seek_vector(index, primme) != 0 ||
+       fwrite(x, sizeof(double), size, primme->lockStoreParams.file) != size) {
+      return LOCK_STORE_IO_FAILURE;
+   }
+
+   return 0;
+}
+
+
+/*******************************************************************************
+ * Function lock_store_read - Reads count consecutive vectors from the file
+ *    starting at position index.
+ *
+ * Input parameters
+ * ----------------
+ * index   Position in the file of the first vector
+ * count   Number of vectors
+ *
+ * Output parameters
+ * -----------------
+ * x       The vectors read, with leading dimension nLocal
+ *
+ * Return value
+ * ------------
+ *  0  success
+ * -3  I/O error
+ *
+ ******************************************************************************/
+
+int lock_store_read_dprimme(double *x, int index, int count, 
+   primme_params *primme) {
+
+   size_t size = (size_t)primme->nLocal*count;
+
+   if (count <= 0) return 0;
+
+   if (seek_vector(index, primme) != 0 ||
+       fread(x, sizeof(double), size, primme->lockStoreParams.file) != size) {
+      return LOCK_STORE_IO_FAILURE;
+   }
+
+   return 0;
+}
+
+
+/*******************************************************************************
+ * Function lock_store_gemm - Computes the product of the stored vectors
+ *    L = [l_first ... l_first+numVecs-1] with a dense block, reading the
+ *    file in panels of lockStoreParams.panelSize vectors:
+ *
+ *    trans = "C":  C = alpha*L'*B + beta*C,  B is nLocal x ncols and
+ *                                             C is numVecs x ncols
+ *    trans = "N":  C = alpha*L*B + beta*C,   B is numVecs x ncols and
+ *                                             C is nLocal x ncols
+ *
+ *    No global sum is performed; as in the in-core case, the caller reduces
+ *    the local overlaps.
+ *
+ * Input parameters
+ * ----------------
+ * trans        "C" or "N", see above
+ * first        Position in the file of the first vector in L
+ * numVecs      Number of vectors in L
+ * ncols        Number of columns of B and C
+ * alpha, beta  Scalars of the product
+ * B, ldb       Input matrix and its leading dimension
+ * ldc          Leading dimension of C
+ *
+ * Input/Output parameters
+ * -----------------------
+ * C       Output matrix
+ *
+ * Return value
+ * ------------
+ *  0  success
+ * -3  I/O error
+ *
+ ******************************************************************************/
+
+int lock_store_gemm_dprimme(const char *trans, int first, int numVecs, 
+   int ncols, double alpha, double *B, int ldb, double beta, double *C, 
+   int ldc, primme_params *primme) {
+
+   int i, m;
+   int nLocal = primme->nLocal;
+   double *panel = (double *) primme->lockStoreParams.panel;
+   double tpone = +1.0e+00;
+
+   for (i=0; i < numVecs; i+=m) {
+      m = min(primme->lockStoreParams.panelSize, numVecs-i);
+
+      if (lock_store_read_dprimme(panel, first+i, m, primme) != 0) {
+         return LOCK_STORE_IO_FAILURE;
+      }
+
+      if (*trans == 'C' || *trans == 'c') {
+         Num_gemm_dprimme("C", "N", m, ncols, nLocal, alpha, panel, nLocal,
+            B, ldb, beta, &C[i], ldc);
+      }
+      else {
+         /* beta is applied only once, with the first panel */
+         Num_gemm_dprimme("N", "N", nLocal, ncols, m, alpha, panel, nLocal,
+            &B[i], ldb, i == 0 ? beta : tpone, C, ldc);
+      }
+   }
+
+   return 0;
+}
+
+
+/*******************************************************************************
+ * Function lock_store_project - Orthogonalizes the columns of X against the
+ *    stored vectors L = [l_first ... l_first+numVecs-1], X = X - L*(L'*X),
+ *    one panel at a time. Each panel is read once, and the overlaps of all
+ *    the columns with it are computed with one product and reduced with one
+ *    global sum. If rwork cannot hold the overlaps of all the columns with a
+ *    panel, the columns are processed in chunks that fit.
+ *
+ * Input parameters
+ * ----------------
+ * first      Position in the file of the first vector in L
+ * numVecs    Number of vectors in L
+ * ncols      Number of columns of X
+ * ldX        Leading dimension of X
+ * rworkSize  Length of rwork, at least 2*min(panelSize, numVecs)
+ *
+ * Input/Output parameters
+ * -----------------------
+ * X       The vectors to be orthogonalized
+ * rwork   Work array
+ *
+ * Return value
+ * ------------
+ *  0  success
+ * -3  I/O error
+ * >0  rworkSize is too small; the value is the required size
+ *
+ ******************************************************************************/
+
+int lock_store_project_dprimme(int first, int numVecs, double *X, int ldX,
+   int ncols, double *rwork, int rworkSize, primme_params *primme) {
+
+   int i, j, m, n, count;
+   int maxCols;     /* Number of columns whose overlaps fit in rwork */
+   int nLocal = primme->nLocal;
+   double *panel = (double *) primme->lockStoreParams.panel;
+   double *overlaps;
+   double tpone = +1.0e+00, tzero = +0.0e+00, tmone = -1.0e+00;
+
+   if (numVecs <= 0 || ncols <= 0) return 0;
+
+   m = min(primme->lockStoreParams.panelSize, numVecs);
+   if (rworkSize < 2*m) return 2*m;
+   maxCols = rworkSize/(2*m);
+
+   for (j=0; j < ncols; j+=n) {
+      n = min(maxCols, ncols-j);
+
+      for (i=0; i < numVecs; i+=m) {
+         m = min(primme->lockStoreParams.panelSize, numVecs-i);
+
+         if (lock_store_read_dprimme(panel, first+i, m, primme) != 0) {
+            return LOCK_STORE_IO_FAILURE;
+         }
+
+         overlaps = &rwork[m*n];
+         Num_gemm_dprimme("C", "N", m, n, nLocal, tpone, panel, nLocal,
+            &X[ldX*j], ldX, tzero, rwork, m);
+         count = m*n;
+         primme_globalSumDouble(rwork, overlaps, &count, primme);
+         Num_gemm_dprimme("N", "N", nLocal, n, m, tmone, panel, nLocal,
+            overlaps, m, tpone, &X[ldX*j], ldX);
+      }
+   }
+
+   return 0;
+}
+
+
+/*******************************************************************************
+ * Function lock_store_permute - Permutes the first nev vectors in the file
+ *    so that the vector at position perm[i] is moved to position i. The
+ *    permutation is applied following its cycles, so every vector is read
+ *    and written once.
+ *
+ * Input parameters
+ * ----------------
+ * nev     Number of vectors to permute
+ * rwork   Work array of size nLocal
+ *
+ * Input/Output parameters
+ * -----------------------
+ * perm    The permutation. It is destroyed on output.
+ *
+ * Return value
+ * ------------
+ *  0  success
+ * -3  I/O error
+ *
+ ******************************************************************************/
+
+int lock_store_permute_dprimme(int *perm, double *rwork, int nev, 
+   primme_params *primme) {
+
+   int i, cur, next;
+   double *panel = (double *) primme->lockStoreParams.panel;
+
+   for (i=0; i < nev; i++) {
+
+      if (perm[i] == i) continue;
+
+      /* Save the vector in position i and shift the cycle */
+
+      if (lock_store_read_dprimme(rwork, i, 1, primme) != 0) {
+         return LOCK_STORE_IO_FAILURE;
+      }
+
+      cur = i;
+      while (perm[cur] != i) {
+         next = perm[cur];
+         if (lock_store_read_dprimme(panel, next, 1, primme) != 0 ||
+             lock_store_write_dprimme(panel, cur, 1, primme) != 0) {
+            return LOCK_STORE_IO_FAILURE;
+         }
+         perm[cur] = cur;
+         cur = next;
+      }
+
+      if (lock_store_write_dprimme(rwork, cur, 1, primme) != 0) {
+         return LOCK_STORE_IO_FAILURE;
+      }
+      perm[cur] = cur;
+   }
+
+   return 0;
+}
+
+
+/*******************************************************************************
+ * Function seek_vector - Moves the file position to the beginning of the 
+ *    vector at position index.
+ *
+ ******************************************************************************/
+
+static int seek_vector(int index, primme_params *primme) {
+
+   LOCK_STORE_OFF offset;
+
+   offset = (LOCK_STORE_OFF)index*primme->nLocal*sizeof(double);
+   return LOCK_STORE_SEEK(primme->lockStoreParams.file, offset);
+}
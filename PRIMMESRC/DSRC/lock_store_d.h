@@ -0,0 +1,55 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ *
+ * File: lock_store.h
+ *
+ * Purpose - Header file containing prototypes for the routines that keep
+ *           the locked vectors out of core, in the file given in
+ *           primme->lockStoreParams.fileName.
+ *
+ ******************************************************************************/
+
+#ifndef LOCK_STORE_H
+#define LOCK_STORE_H
+
+int lock_store_open_dprimme(primme_params *primme);
+
+void lock_store_close_dprimme(primme_params *primme);
+
+int lock_store_write_dprimme(double *x, int index, int count, 
+   primme_params *primme);
+
+int lock_store_read_dprimme(double *x, int index, int count, 
+   primme_params *primme);
+
+int lock_store_gemm_dprimme(const char *trans, int first, int numVecs, 
+   int ncols, double alpha, double *B, int ldb, double beta, double *C, 
+   int ldc, primme_params *primme);
+
+int lock_store_project_dprimme(int first, int numVecs, double *X, int ldX,
+   int ncols, double *rwork, int rworkSize, primme_params *primme);
+
+int lock_store_permute_dprimme(int *perm, double *rwork, int nev, 
+   primme_params *primme);
+
+#endif
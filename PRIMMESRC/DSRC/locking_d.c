@@ -32,6 +32,7 @@
 #include "wtime.h"
 #include "const.h"
 #include "locking_d.h"
+#include "lock_store_d.h"
 #include "locking_private_d.h"
 #include "ortho_d.h"
 #include "update_projection_d.h"
@@ -106,6 +107,9 @@
  * 
  * H          The projection V'*A*V
  *
+ * WtW        The matrix W'*W, maintained only for the harmonic and refined
+ *            extraction (NULL otherwise)
+ *
  * evecsHat   The K*{-1}*evecs updated for the newly locked vectors (if needed)
  *
  * M          the matrix evecs'*evecsHat
@@ -149,13 +153,14 @@
  *                 -2 if a block Krylov basis could not be generated
  *                 -3 if the call to solve_H failed
  *                 -4 if the call to UDUDecompose failed
+ *                 -5 if the locked vector could not be stored
  *
  ******************************************************************************/
 
 int lock_vectors_dprimme(double tol, double *aNormEstimate, double *maxConvTol, 
    int *basisSize, int *numLocked, int *numGuesses, int *nextGuess,
-   double *V, double *W, double *H, double *evecsHat, double *M, 
-   double *UDU, int *ipivot, double *hVals, double *hVecs, 
+   double *V, double *W, double *H, double *WtW, double *evecsHat, 
+   double *M, double *UDU, int *ipivot, double *hVals, double *hVecs, 
    double *evecs, double *evals, int *perm, double machEps, 
    double *resNorms, int *numPrevRitzVals, double *prevRitzVals, 
    int *flag, double *rwork, int rworkSize, int *iwork, 
@@ -246,7 +251,7 @@ int lock_vectors_dprimme(double tol, double *aNormEstimate, double *maxConvTol,
    }
 
    /* Global sum the dot products */
-   (*primme->globalSumDouble)(tnorms, norms, &numCandidates, primme); 
+   primme_globalSumDouble(tnorms, norms, &numCandidates, primme); 
 
    numRecentlyLocked = 0;
 
@@ -288,16 +293,33 @@ int lock_vectors_dprimme(double tol, double *aNormEstimate, double *maxConvTol,
             fprintf(primme->outputFile, 
             "Lock epair[ %d ]= %e norm %.4e Mvecs %d Time %.4e Flag %d\n",
                   *numLocked+1, hVals[i], norms[candidate], 
-                   primme->stats.numMatvecs,primme_wTimer(0),flag[i]);
+                   primme->stats.numMatvecs,ELAPSED_TIME(primme),flag[i]);
             fflush(primme->outputFile);
          }
 
+         if (EVENTS_ON(primme)) {
+            primme_event_push(primme_event_lock, *numLocked, *numLocked+1, 1,
+               hVals[i], norms[candidate], primme);
+         }
+
          /* Copy the converged Ritz vector to the evecs array and  */
          /* insert the converged Ritz value in sorted order within */
          /* the evals array.                                       */
 
-         Num_dcopy_dprimme(primme->nLocal, &V[primme->nLocal*i], 1, 
-            &evecs[primme->nLocal*(primme->numOrthoConst + *numLocked)], 1);
+         if (primme->lockStoreParams.file != NULL) {
+            ret = lock_store_write_dprimme(&V[primme->nLocal*i], *numLocked,
+               1, primme);
+            if (ret != 0) {
+               primme_PushErrorMessage(Primme_lock_vectors, Primme_lock_store,
+                  ret, __FILE__, __LINE__, primme);
+               return LOCK_STORE_FAILURE;
+            }
+         }
+         else {
+            Num_dcopy_dprimme(primme->nLocal, &V[primme->nLocal*i], 1, 
+               &evecs[primme->nLocal*(primme->numOrthoConst + *numLocked)], 1);
+            primme->stats.bytesMoved += primme->nLocal*sizeof(double);
+         }
          insertionSort(hVals[i], evals, norms[candidate], resNorms, perm, 
             *numLocked, primme);
 
@@ -308,6 +330,7 @@ int lock_vectors_dprimme(double tol, double *aNormEstimate, double *maxConvTol,
          if (*numGuesses > 0) {
             Num_dcopy_dprimme(primme->nLocal, 
                &evecs[primme->nLocal*(*nextGuess)], 1, &V[primme->nLocal*i], 1);
+            primme->stats.bytesMoved += primme->nLocal*sizeof(double);
             flag[i] = INITIAL_GUESS;
             *numGuesses = *numGuesses - 1;
             *nextGuess = *nextGuess + 1;
@@ -359,8 +382,8 @@ int lock_vectors_dprimme(double tol, double *aNormEstimate, double *maxConvTol,
          evecsSize-numRecentlyLocked, primme->numOrthoConst+primme->numEvals, 
          numRecentlyLocked, rwork, primme);
 
-      ret = UDUDecompose_dprimme(M, UDU, ipivot, evecsSize, rwork, 
-         rworkSize, primme);
+      ret = UDUAppend_dprimme(M, UDU, ipivot, evecsSize-numRecentlyLocked, 
+         numRecentlyLocked, rwork, rworkSize, primme);
 
       if (ret != 0) {
          primme_PushErrorMessage(Primme_lock_vectors, Primme_ududecompose, ret,
@@ -376,8 +399,8 @@ int lock_vectors_dprimme(double tol, double *aNormEstimate, double *maxConvTol,
    /* replaced by new initial guesses.                                      */
    /* --------------------------------------------------------------------- */
 
-   numDeflated = swap_flagVecs_toEnd(*basisSize, LOCKED, V, W, H, hVals, flag, 
-      primme);
+   numDeflated = swap_flagVecs_toEnd(*basisSize, LOCKED, V, W, H, WtW, hVals,
+      flag, primme);
 
    /* --------------------------------------------------------------------- */
    /* Reduce the basis size by numDeflated and swap the new initial guesses */
@@ -385,7 +408,7 @@ int lock_vectors_dprimme(double tol, double *aNormEstimate, double *maxConvTol,
    /* --------------------------------------------------------------------- */
   
    numReplaced = swap_flagVecs_toEnd(*basisSize-numDeflated, INITIAL_GUESS, 
-      V, W, H, hVals, flag, primme);
+      V, W, H, WtW, hVals, flag, primme);
 
    *basisSize = *basisSize - (numDeflated + numReplaced);
 
@@ -427,6 +450,10 @@ int lock_vectors_dprimme(double tol, double *aNormEstimate, double *maxConvTol,
    if (numNewVectors > 0) {
       update_projection_dprimme(V, W, H, *basisSize, primme->maxBasisSize, 
          numNewVectors, hVecs, primme);
+      if (WtW != NULL) {
+         update_projection_dprimme(W, W, WtW, *basisSize, 
+            primme->maxBasisSize, numNewVectors, hVecs, primme);
+      }
       *basisSize = *basisSize + numNewVectors;
    }
 
@@ -435,8 +462,9 @@ int lock_vectors_dprimme(double tol, double *aNormEstimate, double *maxConvTol,
    /* ones have been added, we must solve the eigenproblem for H.       */
    /* ----------------------------------------------------------------- */
 
-   ret = solve_H_dprimme(H, hVecs, hVals, *basisSize, primme->maxBasisSize,
-      aNormEstimate, *numLocked, rworkSize, rwork, iwork, primme);
+   ret = solve_H_dprimme(H, WtW, hVecs, hVals, *basisSize, 
+      primme->maxBasisSize, aNormEstimate, *numLocked, rworkSize, rwork, 
+      iwork, primme);
    reset_flags_dprimme(flag, 0, primme->maxBasisSize - 1);
 
    if (ret < 0) {
@@ -593,6 +621,10 @@ static void insertionSort(double newVal, double *evals, double newNorm,
  *
  * H           The projection matrix V'*A*V
  *
+ * WtW         The matrix W'*W if the harmonic or refined extraction is used,
+ *             NULL otherwise. Then H and WtW are not diagonal after restart,
+ *             and their rows and columns are swapped as well.
+ *
  * hVals       The eigenvalues of H
  *
  * flag        Values indicating the state of each Ritz vector
@@ -604,9 +636,11 @@ static void insertionSort(double newVal, double *evals, double newNorm,
  ******************************************************************************/
 
 static int swap_flagVecs_toEnd(int basisSize, int flagValue, double *V, 
-  double *W, double *H, double *hVals, int *flag, primme_params *primme) {
+  double *W, double *H, double *WtW, double *hVals, int *flag, 
+  primme_params *primme) {
 
    int left, right; /* Search indices                                   */
+   int i, j;        /* Loop variables                                   */
    int numFlagged;  /* Number of Ritz vectors with flag value flagValue */
    int itemp;       /* Temporary value used for swapping                */
    double dtemp;    /* Temporary value used for swapping                */
@@ -615,6 +649,17 @@ static int swap_flagVecs_toEnd(int basisSize, int flagValue, double *V,
    right = basisSize - 1;
    numFlagged = 0;
 
+   /* Store H and WtW in full, so their rows and columns can be swapped */
+
+   if (WtW != NULL) {
+      for (j = 0; j < basisSize; j++) {
+         for (i = 0; i < j; i++) {
+            H[primme->maxBasisSize*i+j] = H[primme->maxBasisSize*j+i];
+            WtW[primme->maxBasisSize*i+j] = WtW[primme->maxBasisSize*j+i];
+         }
+      }
+   }
+
    /* Search for values that have flag value flagValue and swap */
    /* them towards the end of the basis.                        */
  
@@ -643,12 +688,23 @@ static int swap_flagVecs_toEnd(int basisSize, int flagValue, double *V,
          return numFlagged;
       }
 
-      /* Swap the two columns of V and W */
+      /* Swap the two columns of V and W. Locked vectors are already in  */
+      /* evecs, so their columns are just overwritten.                    */
 
-      Num_swap_dprimme(primme->nLocal, &V[primme->nLocal*left], 1, 
-                                       &V[primme->nLocal*right], 1);
-      Num_swap_dprimme(primme->nLocal, &W[primme->nLocal*left], 1, 
-                                       &W[primme->nLocal*right], 1);
+      if (flagValue == LOCKED) {
+         Num_dcopy_dprimme(primme->nLocal, &V[primme->nLocal*right], 1, 
+                                           &V[primme->nLocal*left], 1);
+         Num_dcopy_dprimme(primme->nLocal, &W[primme->nLocal*right], 1, 
+                                           &W[primme->nLocal*left], 1);
+         primme->stats.bytesMoved += 2.0L*primme->nLocal*sizeof(double);
+      }
+      else {
+         Num_swap_dprimme(primme->nLocal, &V[primme->nLocal*left], 1, 
+                                          &V[primme->nLocal*right], 1);
+         Num_swap_dprimme(primme->nLocal, &W[primme->nLocal*left], 1, 
+                                          &W[primme->nLocal*right], 1);
+         primme->stats.bytesMoved += 4.0L*primme->nLocal*sizeof(double);
+      }
 
       /* Swap Ritz values */
 
@@ -659,10 +715,24 @@ static int swap_flagVecs_toEnd(int basisSize, int flagValue, double *V,
       /* After restarting, the eigenvectors of H are the standard */
       /* basis vectors (H is diagonal).  Thus, they don't need to */
       /* be swapped.  Just swap the diagonal elements of H.       */
+      /* With WtW, swap the rows and columns of both H and WtW.   */
       
-      ztmp = H[primme->maxBasisSize*left+left];
-      H[primme->maxBasisSize*left+left] = H[primme->maxBasisSize*right+right];
-      H[primme->maxBasisSize*right+right] = ztmp;
+      if (WtW != NULL) {
+         Num_swap_dprimme(basisSize, &H[primme->maxBasisSize*left], 1, 
+            &H[primme->maxBasisSize*right], 1);
+         Num_swap_dprimme(basisSize, &H[left], primme->maxBasisSize, 
+            &H[right], primme->maxBasisSize);
+         Num_swap_dprimme(basisSize, &WtW[primme->maxBasisSize*left], 1, 
+            &WtW[primme->maxBasisSize*right], 1);
+         Num_swap_dprimme(basisSize, &WtW[left], primme->maxBasisSize, 
+            &WtW[right], primme->maxBasisSize);
+      }
+      else {
+         ztmp = H[primme->maxBasisSize*left+left];
+         H[primme->maxBasisSize*left+left] = 
+            H[primme->maxBasisSize*right+right];
+         H[primme->maxBasisSize*right+right] = ztmp;
+      }
 
       itemp = flag[left];
       flag[left] = flag[right];
@@ -32,8 +32,8 @@
 
 int lock_vectors_dprimme(double tol, double *aNormEstimate, double *maxConvTol, 
    int *basisSize, int *numLocked, int *numGuesses, int *nextGuess,
-   double *V, double *W, double *H, double *evecsHat, double *M, 
-   double *UDU, int *ipivot, double *hVals, double *hVecs, 
+   double *V, double *W, double *H, double *WtW, double *evecsHat, 
+   double *M, double *UDU, int *ipivot, double *hVals, double *hVecs, 
    double *evecs, double *evals, int *perm, double machEps, 
    double *resNorms, int *numPrevRitzVals, double *prevRitzVals, 
    int *flag, double *rwork, int rworkSize, int *iwork, 
@@ -33,9 +33,11 @@
 #define INIT_BLOCK_KRYLOV_FAILURE -2
 #define SOLVE_H_FAILURE           -3
 #define UDUDECOMPOSE_FAILURE      -4
+#define LOCK_STORE_FAILURE        -5
 
 static int swap_flagVecs_toEnd(int basisSize, int flagValue, double *V, 
-   double *W, double *H, double *hVals, int *flag, primme_params *primme);
+   double *W, double *H, double *WtW, double *hVals, int *flag, 
+   primme_params *primme);
 
 static void insertionSort(double newVal, double *evals, double newNorm,
    double *resNorms, int *perm, int numConverged, primme_params *primme);
@@ -30,6 +30,13 @@
 #ifndef MAIN_ITER_H
 #define MAIN_ITER_H
 
+/* Returned by main_iter when it stopped before converging, because of */
+/* maxMatvecs, maxOuterIterations or maxTime, or because monitorFun     */
+/* asked to; evals, evecs and resNorms hold the best approximations    */
+
+#define MAX_ITERATIONS_REACHED -1
+#define MONITOR_STOP           -10
+
 int main_iter_dprimme(double *evals, int *perm, double *evecs,
    double *resNorms, double machEps, int *intWork, void *realWork, 
    primme_params *primme);
@@ -32,6 +32,7 @@
 #include "numerical_private_d.h"
 #include "numerical_d.h"
 #include "primme.h"
+#include "track.h"
 #include <stdlib.h>   /* free */
 
 /******************************************************************************/
@@ -41,6 +42,12 @@ void Num_dcopy_dprimme(int n, double *x, int incx, double *y, int incy) {
    PRIMME_BLASINT lincx = incx;
    PRIMME_BLASINT lincy = incy;
 
+#ifdef NUM_KERNELS
+   if (incx == 1 && incy == 1) {
+      Num_copy_kernel_dprimme(n, x, y);
+      return;
+   }
+#endif
    DCOPY(&ln, x, &lincx, y, &lincy);
 }
 /******************************************************************************/
@@ -93,6 +100,31 @@ void Num_symm_dprimme(const char *side, const char *uplo, int m, int n, double a
 
 }
 
+/******************************************************************************/
+void Num_trsm_dprimme(const char *side, const char *uplo, const char *transa,
+   const char *diag, int m, int n, double alpha, double *a, int lda, double *b,
+   int ldb) {
+
+   PRIMME_BLASINT lm = m;
+   PRIMME_BLASINT ln = n;
+   PRIMME_BLASINT llda = lda;
+   PRIMME_BLASINT lldb = ldb;
+
+#ifdef NUM_CRAY
+   _fcd side_fcd, uplo_fcd, transa_fcd, diag_fcd;
+
+   side_fcd = _cptofcd(side, strlen(side));
+   uplo_fcd = _cptofcd(uplo, strlen(uplo));
+   transa_fcd = _cptofcd(transa, strlen(transa));
+   diag_fcd = _cptofcd(diag, strlen(diag));
+   DTRSM(side_fcd, uplo_fcd, transa_fcd, diag_fcd, &lm, &ln, &alpha, a, &llda,
+         b, &lldb);
+#else
+   DTRSM(side, uplo, transa, diag, &lm, &ln, &alpha, a, &llda, b, &lldb);
+#endif
+
+}
+
 /******************************************************************************/
 void Num_axpy_dprimme(int n, double alpha, double *x, int incx, 
    double *y, int incy) {
@@ -101,6 +133,12 @@ void Num_axpy_dprimme(int n, double alpha, double *x, int incx,
    PRIMME_BLASINT lincx = incx;
    PRIMME_BLASINT lincy = incy;
 
+#ifdef NUM_KERNELS
+   if (incx == 1 && incy == 1) {
+      Num_axpy_kernel_dprimme(n, alpha, x, y);
+      return;
+   }
+#endif
    DAXPY(&ln, &alpha, x, &lincx, y, &lincy);
 
 }
@@ -115,6 +153,13 @@ void Num_gemv_dprimme(const char *transa, int m, int n, double alpha, double *a,
    PRIMME_BLASINT lincx = incx;
    PRIMME_BLASINT lincy = incy;
 
+#ifdef NUM_KERNELS
+   if (incx == 1 && incy == 1) {
+      Num_gemv_kernel_dprimme(transa, m, n, alpha, a, lda, x, beta, y);
+      return;
+   }
+#endif
+
 #ifdef NUM_CRAY
    _fcd transa_fcd;
 
@@ -134,6 +179,11 @@ double Num_dot_dprimme(int n, double *x, int incx, double *y, int incy) {
    PRIMME_BLASINT lincx = incx;
    PRIMME_BLASINT lincy = incy;
 
+#ifdef NUM_KERNELS
+   if (incx == 1 && incy == 1) {
+      return Num_dot_kernel_dprimme(n, x, y);
+   }
+#endif
    return(DDOT(&ln, x, &lincx, y, &lincy));
 
 }
@@ -169,6 +219,12 @@ void Num_scal_dprimme(int n, double alpha, double *x, int incx) {
    PRIMME_BLASINT ln = n;
    PRIMME_BLASINT lincx = incx;
 
+#ifdef NUM_KERNELS
+   if (incx == 1) {
+      Num_scal_kernel_dprimme(n, alpha, x);
+      return;
+   }
+#endif
    DSCAL(&ln, &alpha, x, &lincx);
 
 }
@@ -180,10 +236,270 @@ void Num_swap_dprimme(int n, double *x, int incx, double *y, int incy) {
    PRIMME_BLASINT lincx = incx;
    PRIMME_BLASINT lincy = incy;
 
+#ifdef NUM_KERNELS
+   if (incx == 1 && incy == 1) {
+      Num_swap_kernel_dprimme(n, x, y);
+      return;
+   }
+#endif
    DSWAP(&ln, x, &lincx, y, &lincy);
 
 }
 
+/******************************************************************************
+ * Function Num_axpy_dot - y = y + alpha*x and returns the local y'*z, 
+ *    with unit increments. The update and the dot product are fused in a
+ *    single pass over the vectors (there is no BLAS routine for this).
+ ******************************************************************************/
+double Num_axpy_dot_dprimme(int n, double alpha, double *x, double *y, 
+   double *z) {
+
+   return Num_axpy_dot_kernel_dprimme(n, alpha, x, y, z);
+
+}
+
+/******************************************************************************
+ * Function Num_recurrence_update - performs in a single pass the two-vector
+ *    recurrence of the QMR iteration
+ *
+ *       delta = gamma*delta + eta*d,   sol = sol + delta
+ *
+ *    and returns the local sol'*sol. All vectors have unit increments.
+ ******************************************************************************/
+double Num_recurrence_update_dprimme(int n, double gamma, double eta, 
+   double *d, double *delta, double *sol) {
+
+   int i;
+   double sum = 0.0L;
+
+#ifdef _OPENMP
+#  pragma omp parallel for simd if (6*n >= NUM_KERNEL_OMP_MIN) \
+      reduction(+:sum) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      delta[i] = gamma*delta[i] + eta*d[i];
+      sol[i] += delta[i];
+      sum += sol[i]*sol[i];
+   }
+
+   return sum;
+}
+
+/******************************************************************************
+ * Function Num_recurrence_start - first step of Num_recurrence_update, when
+ *    delta and sol are zero, that does not read them:
+ *
+ *       delta = eta*d,   sol = delta
+ *
+ *    and returns the local sol'*sol. All vectors have unit increments.
+ ******************************************************************************/
+double Num_recurrence_start_dprimme(int n, double eta, double *d,
+   double *delta, double *sol) {
+
+   int i;
+   double sum = 0.0L;
+
+#ifdef _OPENMP
+#  pragma omp parallel for simd if (3*n >= NUM_KERNEL_OMP_MIN) \
+      reduction(+:sum) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      delta[i] = eta*d[i];
+      sol[i] = delta[i];
+      sum += sol[i]*sol[i];
+   }
+
+   return sum;
+}
+
+/******************************************************************************
+ * Function Num_zero - x = 0, with unit increment. The zeroed bytes are
+ *    counted with -DPRIMME_TRACK_ALLOC (see track.c).
+ ******************************************************************************/
+void Num_zero_dprimme(int n, double *x) {
+
+   int i;
+
+   TRACK_ZERO(sizeof(double)*n);
+   for (i=0; i < n; i++) {
+      x[i] = 0.0;
+   }
+}
+
+/******************************************************************************
+ * Internal kernels for the level 1 operations and gemv with unit increments.
+ * With -DNUM_KERNELS the Num_* wrappers above call them instead of the BLAS 
+ * when the increments are one. The loops are written so that the compiler 
+ * vectorizes them (e.g., -O3), and with OpenMP (-fopenmp) the loops with
+ * at least NUM_KERNEL_OMP_MIN flops are split among the threads. Note that
+ * the threaded reductions do not sum in a fixed order.
+ * They are always compiled so they can be compared against the BLAS.
+ ******************************************************************************/
+
+void Num_copy_kernel_dprimme(int n, double *x, double *y) {
+
+   int i;
+
+#ifdef _OPENMP
+#  pragma omp parallel for simd if (n >= NUM_KERNEL_OMP_MIN) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      y[i] = x[i];
+   }
+}
+
+/******************************************************************************/
+void Num_axpy_kernel_dprimme(int n, double alpha, double *x, double *y) {
+
+   int i;
+
+#ifdef _OPENMP
+#  pragma omp parallel for simd if (n >= NUM_KERNEL_OMP_MIN) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      y[i] += alpha*x[i];
+   }
+}
+
+/******************************************************************************/
+double Num_dot_kernel_dprimme(int n, double *x, double *y) {
+
+   int i;
+   double sum = 0.0L;
+
+#ifdef _OPENMP
+#  pragma omp parallel for simd if (n >= NUM_KERNEL_OMP_MIN) \
+      reduction(+:sum) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      sum += x[i]*y[i];
+   }
+
+   return sum;
+}
+
+/******************************************************************************/
+void Num_scal_kernel_dprimme(int n, double alpha, double *x) {
+
+   int i;
+
+#ifdef _OPENMP
+#  pragma omp parallel for simd if (n >= NUM_KERNEL_OMP_MIN) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      x[i] *= alpha;
+   }
+}
+
+/******************************************************************************/
+void Num_swap_kernel_dprimme(int n, double *x, double *y) {
+
+   int i;
+   double t;
+
+#ifdef _OPENMP
+#  pragma omp parallel for simd if (n >= NUM_KERNEL_OMP_MIN) \
+      private(t) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      t = x[i];
+      x[i] = y[i];
+      y[i] = t;
+   }
+}
+
+/******************************************************************************
+ * Function Num_gemv_kernel - y = alpha*op(A)*x + beta*y, where A is m x n
+ *    and op(A) is A if transa is "N", or A' otherwise. As in the BLAS, 
+ *    if beta is zero y is not read.
+ *    The columns of A are processed four at a time, so that y (for "N") or 
+ *    x (for "C") is loaded once every four columns. For "N", the rows are 
+ *    also split in chunks of NUM_KERNEL_ROWS, and every chunk of y is 
+ *    updated by all the columns while it is in cache.
+ ******************************************************************************/
+void Num_gemv_kernel_dprimme(const char *transa, int m, int n, double alpha,
+   double *a, int lda, double *x, double beta, double *y) {
+
+   int i, j, ib, i1;
+   double t0, t1, t2, t3, *a0, *a1, *a2, *a3;
+
+   if (*transa == 'n' || *transa == 'N') {
+#ifdef _OPENMP
+#     pragma omp parallel for if ((double)m*n >= NUM_KERNEL_OMP_MIN) \
+         private(i, j, i1, t0, t1, t2, t3, a0, a1, a2, a3) schedule(static)
+#endif
+      for (ib=0; ib < m; ib += NUM_KERNEL_ROWS) {
+         i1 = min(ib + NUM_KERNEL_ROWS, m);
+         if (beta == 0.0L) {
+            for (i=ib; i < i1; i++) y[i] = 0.0L;
+         }
+         else if (beta != 1.0L) {
+            for (i=ib; i < i1; i++) y[i] *= beta;
+         }
+         for (j=0; j+3 < n; j+=4) {
+            t0 = alpha*x[j]; t1 = alpha*x[j+1];
+            t2 = alpha*x[j+2]; t3 = alpha*x[j+3];
+            a0 = &a[(size_t)lda*j]; a1 = a0 + lda; a2 = a1 + lda; a3 = a2 + lda;
+            for (i=ib; i < i1; i++) {
+               y[i] += t0*a0[i] + t1*a1[i] + t2*a2[i] + t3*a3[i];
+            }
+         }
+         for (; j < n; j++) {
+            t0 = alpha*x[j];
+            a0 = &a[(size_t)lda*j];
+            for (i=ib; i < i1; i++) {
+               y[i] += t0*a0[i];
+            }
+         }
+      }
+   }
+   else {
+      for (j=0; j+3 < n; j+=4) {
+         t0 = t1 = t2 = t3 = 0.0L;
+         a0 = &a[(size_t)lda*j]; a1 = a0 + lda; a2 = a1 + lda; a3 = a2 + lda;
+#ifdef _OPENMP
+#        pragma omp parallel for simd if (8*m >= NUM_KERNEL_OMP_MIN) \
+            reduction(+:t0,t1,t2,t3) schedule(static)
+#endif
+         for (i=0; i < m; i++) {
+            t0 += a0[i]*x[i]; t1 += a1[i]*x[i];
+            t2 += a2[i]*x[i]; t3 += a3[i]*x[i];
+         }
+         if (beta == 0.0L) {
+            y[j] = alpha*t0; y[j+1] = alpha*t1;
+            y[j+2] = alpha*t2; y[j+3] = alpha*t3;
+         }
+         else {
+            y[j] = alpha*t0 + beta*y[j]; y[j+1] = alpha*t1 + beta*y[j+1];
+            y[j+2] = alpha*t2 + beta*y[j+2]; y[j+3] = alpha*t3 + beta*y[j+3];
+         }
+      }
+      for (; j < n; j++) {
+         t0 = alpha*Num_dot_kernel_dprimme(m, &a[(size_t)lda*j], x);
+         y[j] = (beta == 0.0L) ? t0 : t0 + beta*y[j];
+      }
+   }
+}
+
+/******************************************************************************/
+double Num_axpy_dot_kernel_dprimme(int n, double alpha, double *x, double *y,
+   double *z) {
+
+   int i;
+   double sum = 0.0L;
+
+#ifdef _OPENMP
+#  pragma omp parallel for simd if (n >= NUM_KERNEL_OMP_MIN) \
+      reduction(+:sum) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      y[i] += alpha*x[i];
+      sum += y[i]*z[i];
+   }
+
+   return sum;
+}
+
 /******************************************************************************/
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 #ifdef NUM_ESSL
@@ -198,9 +514,10 @@ int Num_dspev_dprimme(int iopt, double *ap, double *w, double *z, int ldz,
    return dspev(liopt, ap, w, z, lldz, ln, aux, lnaux);
 }
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+#endif
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
-/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
-#else
+/* Also with ESSL, used by restart and the dense solver      */
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 void Num_dsyev_dprimme(const char *jobz, const char *uplo, int n, double *a, int lda, 
    double *w, double *work, int ldwork, int *info) {
@@ -226,10 +543,6 @@ void Num_dsyev_dprimme(const char *jobz, const char *uplo, int n, double *a, int
    *info = linfo;
 }
 
-/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
-
-#endif
-
 /******************************************************************************/
 void Num_dsytrf_dprimme(const char *uplo, int n, double *a, int lda, int *ipivot, 
    double *work, int ldwork, int *info) {
@@ -305,3 +618,22 @@ void Num_dsytrs_dprimme(const char *uplo, int n, int nrhs, double *a, int lda,
 
 }
 
+/******************************************************************************/
+void Num_dpotrf_dprimme(const char *uplo, int n, double *a, int lda, int *info) {
+
+   PRIMME_BLASINT ln = n;
+   PRIMME_BLASINT llda = lda;
+   PRIMME_BLASINT linfo = 0;
+
+#ifdef NUM_CRAY
+   _fcd uplo_fcd;
+
+   uplo_fcd = _cptofcd(uplo, strlen(uplo));
+   DPOTRF(uplo_fcd, &ln, a, &llda, &linfo);
+#else
+   DPOTRF(uplo, &ln, a, &llda, &linfo);
+#endif
+
+   *info = (int)linfo;
+
+}
@@ -44,6 +44,7 @@ void Num_dsytrf_dprimme(const char *uplo, int n, double *a, int lda, int *ipivot
    double *work, int ldwork, int *info);
 void Num_dsytrs_dprimme(const char *uplo, int n, int nrhs, double *a, int lda, 
    int *ipivot, double *b, int ldb, int *info);
+void Num_dpotrf_dprimme(const char *uplo, int n, double *a, int lda, int *info);
 
 void Num_dcopy_dprimme(int n, double *x, int incx, double *y, int incy);
 double Num_dot_dprimme(int n, double *x, int incx, double *y, int incy);
@@ -53,6 +54,9 @@ void Num_gemm_dprimme(const char *transa, const char *transb, int m, int n, int
 void Num_symm_dprimme(const char *side, const char *uplo, int m, int n, double alpha, 
    double *a, int lda, double *b, int ldb, double beta, 
    double *c, int ldc);
+void Num_trsm_dprimme(const char *side, const char *uplo, const char *transa,
+   const char *diag, int m, int n, double alpha, double *a, int lda, double *b,
+   int ldb);
 void Num_axpy_dprimme(int n, double alpha, double *x, int incx, 
    double *y, int incy);
 void Num_gemv_dprimme(const char *transa, int m, int n, double alpha, double *a,
@@ -60,6 +64,23 @@ void Num_gemv_dprimme(const char *transa, int m, int n, double alpha, double *a,
 void Num_larnv_dprimme(int idist, int *iseed, int length, double *x);
 void Num_scal_dprimme(int n, double alpha, double *x, int incx);
 void Num_swap_dprimme(int n, double *x, int incx, double *y, int incy);
+double Num_axpy_dot_dprimme(int n, double alpha, double *x, double *y, 
+   double *z);
+double Num_recurrence_update_dprimme(int n, double gamma, double eta, 
+   double *d, double *delta, double *sol);
+double Num_recurrence_start_dprimme(int n, double eta, double *d,
+   double *delta, double *sol);
+void Num_zero_dprimme(int n, double *x);
+
+void Num_copy_kernel_dprimme(int n, double *x, double *y);
+void Num_axpy_kernel_dprimme(int n, double alpha, double *x, double *y);
+double Num_dot_kernel_dprimme(int n, double *x, double *y);
+void Num_scal_kernel_dprimme(int n, double alpha, double *x);
+void Num_swap_kernel_dprimme(int n, double *x, double *y);
+void Num_gemv_kernel_dprimme(const char *transa, int m, int n, double alpha,
+   double *a, int lda, double *x, double beta, double *y);
+double Num_axpy_dot_kernel_dprimme(int n, double alpha, double *x, double *y,
+   double *z);
 
 #ifdef __cplusplus
 }
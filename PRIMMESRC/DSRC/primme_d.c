@@ -49,6 +49,7 @@
 
 #include <stdlib.h>   /* mallocs, free */
 #include <stdio.h>    
+#include <string.h>   /* memcmp */
 #include "primme.h"
 #include "const.h"
 #include "wtime.h"
@@ -56,6 +57,8 @@
 #include "ortho_d.h"
 #include "solve_H_d.h"
 #include "correction_d.h"
+#include "lock_store_d.h"
+#include "dense_d.h"
 #include "primme_private_d.h"
 #include "numerical_d.h"
 
@@ -75,7 +78,11 @@
  *        primme->numEvals.
  * 
  * evecs  The local portions of the converged Ritz vectors.  The dimension of
- *        the array is at least primme->nLocal*primme->numEvals
+ *        the array is at least primme->nLocal*primme->numEvals. If 
+ *        primme->lockStoreParams.fileName is set, the converged vectors are
+ *        returned in that file instead, and evecs only needs room for the
+ *        primme->numOrthoConst constraints and the primme->initSize initial
+ *        guesses.
  *
  * resNorms  The residual norms of the converged Ritz vectors.  Should be of 
  *           size primme->numEvals
@@ -90,8 +97,15 @@
  * -1 - Failure to allocate workspace
  * -2 - Malloc failure in allocating a permutation integer array
  * -3 - main_iter encountered a problem
- * -4 ...-32 - Invalid input (parameters or primme struct) returned 
+ * -4 ...-33 - Invalid input (parameters or primme struct) returned 
  *             by check_input()
+ * -34 - The file for the locked vectors could not be opened or written
+ * -35 - The workspace does not fit in memoryBudget, or in maxBasisBytes
+ *       with primme_budget_thick
+ * -36 - monitorFun asked to stop; initSize pairs are converged
+ * -37 - maxMatvecs, maxOuterIterations or maxTime reached; initSize pairs
+ *       are converged
+ * -38 - The dense solver for small problems failed (see denseThreshold)
  *
  ******************************************************************************/
  
@@ -99,13 +113,18 @@ int dprimme(double *evals, double *evecs, double *resNorms,
             primme_params *primme) {
       
    int ret;
+   int numCopies;
+   int stopped;       /* main_iter stopped before converging (budget  */
+                      /* exhausted or stop asked by monitorFun)       */
    int *perm;
+   long int budget;   /* Bytes for the workspace, 0 if not bounded     */
    double machEps;
 
-   /* ------------------ */
-   /* zero out the timer */
-   /* ------------------ */
-   primme_wTimer(1);
+   /* ------------------------------------------------------------------ */
+   /* Start the clock of this call; it is kept in primme and not in the  */
+   /* static of primme_wTimer, as several calls may run concurrently     */
+   /* ------------------------------------------------------------------ */
+   primme->stats.startTime = primme_get_wtime();
 
    /* ---------------------------- */
    /* Clear previous error reports */
@@ -127,6 +146,20 @@ int dprimme(double *evals, double *evecs, double *resNorms,
          primme->globalSumDouble = primme_seq_globalSumDouble;
    }
 
+   /* --------------------------------------------------------------------- */
+   /* With a memory budget, start from the sizes given by the user, also if */
+   /* a previous call with this primme fitted them to the budget            */
+   /* --------------------------------------------------------------------- */
+   budget = primme->memoryBudget;
+   if (primme->restartingParams.scheme == primme_budget_thick &&
+       primme->restartingParams.maxBasisBytes > 0 &&
+       (budget <= 0 || primme->restartingParams.maxBasisBytes < budget)) {
+      budget = primme->restartingParams.maxBasisBytes;
+   }
+   if (budget > 0) {
+      keep_user_sizes(primme);
+   }
+
    /* --------------------------------------------------------------------- */
    /* Decide on whether to use locking (hard locking), or not (soft locking)*/
    /* --------------------------------------------------------------------- */
@@ -140,6 +173,46 @@ int dprimme(double *evals, double *evecs, double *resNorms,
          /* use locking when not enough vectors to restart with */
          primme->locking = (primme->numEvals > primme->minRestartSize);   
       }
+      /* Harmonic and refined extraction only apply to interior targets */
+      primme->projectionParams.projection = primme_proj_RR;
+   }
+
+   /* --------------------------------------------------------------------- */
+   /* Keeping the locked vectors out of core requires locking. The Q        */
+   /* projectors in the correction equation are disabled because they need */
+   /* the locked vectors in memory.                                         */
+   /* --------------------------------------------------------------------- */
+   if (primme->lockStoreParams.fileName != NULL) {
+      primme->locking = 1;
+      primme->correctionParams.projectors.LeftQ = 0;
+      primme->correctionParams.projectors.RightQ = 0;
+      primme->correctionParams.projectors.SkewQ = 0;
+      if (primme->lockStoreParams.panelSize <= 0) {
+         primme->lockStoreParams.panelSize = primme->maxBasisSize;
+      }
+   }
+
+   /* --------------------------------------------------------------------- */
+   /* With a memory budget, choose the largest sizes whose workspace fits.  */
+   /* With primme_budget_thick, maxBasisBytes also bounds the workspace.    */
+   /* --------------------------------------------------------------------- */
+   if (budget > 0) {
+      ret = check_sizes(primme);
+      if (ret != 0) {
+         primme_PushErrorMessage(Primme_dprimme, Primme_check_input, 
+                         ret, __FILE__, __LINE__, primme);
+         restore_user_sizes(primme);
+         primme->stats.elapsedTime = ELAPSED_TIME(primme);
+         return ret;
+      }
+      ret = fit_memory_budget(budget, primme);
+      if (ret != 0) {
+         primme_PushErrorMessage(Primme_dprimme, Primme_allocate_workspace, 
+                         ret, __FILE__, __LINE__, primme);
+         restore_user_sizes(primme);
+         primme->stats.elapsedTime = ELAPSED_TIME(primme);
+         return ret;
+      }
    }
 
    /* -------------------------------------------------------------- */
@@ -171,10 +244,30 @@ int dprimme(double *evals, double *evecs, double *resNorms,
    if (ret != 0) {
       primme_PushErrorMessage(Primme_dprimme, Primme_check_input, ret,
                       __FILE__, __LINE__, primme);
-      primme->stats.elapsedTime = primme_wTimer(0);
+      if (budget > 0) restore_user_sizes(primme);
+      primme->stats.elapsedTime = ELAPSED_TIME(primme);
       return ret;
    }
    
+   /* ------------------------------------------------------------------ */
+   /* Small problems are solved with a dense eigensolver on the matrix   */
+   /* assembled with matvecs, without the workspace of main_iter         */
+   /* ------------------------------------------------------------------ */
+
+   if (dense_suitable_dprimme(primme)) {
+      primme_event_begin(primme);
+      ret = solve_dense_dprimme(evals, evecs, resNorms, primme);
+      primme_event_end(primme);
+      primme->stats.elapsedTime = ELAPSED_TIME(primme);
+      if (ret != 0) {
+         primme_PushErrorMessage(Primme_dprimme, Primme_solve_dense, ret,
+                         __FILE__, __LINE__, primme);
+         if (budget > 0) restore_user_sizes(primme);
+         return DENSE_FAILURE;
+      }
+      return 0;
+   }
+
    /* ----------------------------------------------------------------------- */
    /* Compute AND allocate memory requirements for main_iter and subordinates */
    /* ----------------------------------------------------------------------- */
@@ -184,7 +277,8 @@ int dprimme(double *evals, double *evecs, double *resNorms,
    if (ret != 0) {
       primme_PushErrorMessage(Primme_dprimme, Primme_allocate_workspace, ret,
                       __FILE__, __LINE__, primme);
-      primme->stats.elapsedTime = primme_wTimer(0);
+      if (budget > 0) restore_user_sizes(primme);
+      primme->stats.elapsedTime = ELAPSED_TIME(primme);
       return ALLOCATE_WORKSPACE_FAILURE;
    }
 
@@ -196,21 +290,44 @@ int dprimme(double *evals, double *evecs, double *resNorms,
    if (perm == NULL) {
       primme_PushErrorMessage(Primme_dprimme, Primme_malloc, 0, 
                       __FILE__, __LINE__, primme);
-      primme->stats.elapsedTime = primme_wTimer(0);
+      if (budget > 0) restore_user_sizes(primme);
+      primme->stats.elapsedTime = ELAPSED_TIME(primme);
       return MALLOC_FAILURE;
    }
 
+   /*----------------------------------------------------------------------*/
+   /* Open the file for the locked vectors if they are kept out of core    */
+   /*----------------------------------------------------------------------*/
+
+   if (primme->lockStoreParams.fileName != NULL) {
+      ret = lock_store_open_dprimme(primme);
+      if (ret != 0) {
+         primme_PushErrorMessage(Primme_dprimme, Primme_lock_store, ret,
+                         __FILE__, __LINE__, primme);
+         free(perm);
+         if (budget > 0) restore_user_sizes(primme);
+         primme->stats.elapsedTime = ELAPSED_TIME(primme);
+         return LOCK_STORE_FAILURE;
+      }
+   }
+
    /*----------------------------------------------------------------------*/
    /* Call the solver                                                      */
    /*----------------------------------------------------------------------*/
 
+   primme_event_begin(primme);
    ret = main_iter_dprimme(evals, perm, evecs, resNorms, machEps, 
                    primme->intWork, primme->realWork, primme);
+   primme_event_end(primme);
 
-   if (ret < 0) {
+   stopped = ret;
+   if (ret < 0 && ret != MONITOR_STOP && ret != MAX_ITERATIONS_REACHED) {
       primme_PushErrorMessage(Primme_dprimme, Primme_main_iter, 
                       ret, __FILE__, __LINE__, primme);
-      primme->stats.elapsedTime = primme_wTimer(0);
+      lock_store_close_dprimme(primme);
+      free(perm);
+      if (budget > 0) restore_user_sizes(primme);
+      primme->stats.elapsedTime = ELAPSED_TIME(primme);
       return MAIN_ITER_FAILURE;
    }
    /*----------------------------------------------------------------------*/
@@ -221,12 +338,31 @@ int dprimme(double *evals, double *evecs, double *resNorms,
    /* correspond to the sorted Ritz values in evals.                       */
    /*----------------------------------------------------------------------*/
 
-   permute_evecs_dprimme(&evecs[primme->numOrthoConst], perm, 
-        (double *) primme->realWork, primme->numEvals, primme->nLocal);
+   if (primme->lockStoreParams.file != NULL) {
+      ret = lock_store_permute_dprimme(perm, (double *) primme->realWork, 
+         primme->numEvals, primme);
+      lock_store_close_dprimme(primme);
+      if (ret != 0) {
+         primme_PushErrorMessage(Primme_dprimme, Primme_lock_store, ret,
+                         __FILE__, __LINE__, primme);
+         free(perm);
+         if (budget > 0) restore_user_sizes(primme);
+         primme->stats.elapsedTime = ELAPSED_TIME(primme);
+         return LOCK_STORE_FAILURE;
+      }
+   }
+   else {
+      numCopies = permute_evecs_dprimme(
+           &evecs[primme->numOrthoConst*primme->nLocal], perm, 
+           (double *) primme->realWork, primme->numEvals, primme->nLocal);
+      primme->stats.bytesMoved += (double)numCopies*primme->nLocal*sizeof(double);
+   }
 
    free(perm);
 
-   primme->stats.elapsedTime = primme_wTimer(0);
+   primme->stats.elapsedTime = ELAPSED_TIME(primme);
+   if (stopped == MONITOR_STOP) return USER_STOP;
+   if (stopped == MAX_ITERATIONS_REACHED) return BUDGET_EXHAUSTED;
    return(0);
 }
 
@@ -287,6 +423,14 @@ static int allocate_workspace(primme_params *primme, int allocate) {
       + primme->restartingParams.maxPrevRetain*primme->maxBasisSize;
                                                    /* size of prevHVecs    */
 
+   /*----------------------------------------------------------------------*/
+   /* Add also memory needed for W'*W by harmonic and refined extraction   */
+   /*----------------------------------------------------------------------*/
+   if (primme->projectionParams.projection != primme_proj_RR) {
+      dataSize = dataSize 
+         + primme->maxBasisSize*primme->maxBasisSize; /* Size of WtW       */
+   }
+
    /*----------------------------------------------------------------------*/
    /* Add also memory needed for JD skew projectors                        */
    /*----------------------------------------------------------------------*/
@@ -316,6 +460,15 @@ static int allocate_workspace(primme_params *primme, int allocate) {
          primme->numOrthoConst+1, primme->nLocal, NULL, 0.0, NULL, 0, primme);
    }
 
+   /* With the out-of-core lock store, ortho projects a block against a   */
+   /* whole panel at once; make room for the overlaps of a full block,    */
+   /* and for the norms of the largest block, the whole basis.            */
+
+   if (primme->lockStoreParams.fileName != NULL) {
+      orthoSize = max(orthoSize, 3*primme->maxBasisSize
+         + 2*primme->lockStoreParams.panelSize*primme->maxBlockSize);
+   }
+
    /*----------------------------------------------------------------------*/
    /* Determine workspace required by solve_correction and its children    */
    /*----------------------------------------------------------------------*/
@@ -328,7 +481,7 @@ static int allocate_workspace(primme_params *primme, int allocate) {
    /*----------------------------------------------------------------------*/
    /* Workspace is reused in many functions. Allocate the max needed by any*/
    /*----------------------------------------------------------------------*/
-   realWorkSize = Num_imax_primme(8,
+   realWorkSize = Num_imax_primme(9,
 
       /* Workspace needed by init_basis */
       Num_imax_primme(3, 
@@ -344,6 +497,10 @@ static int allocate_workspace(primme_params *primme, int allocate) {
 #else
       3*primme->maxBasisSize,
 #endif
+
+      /* Workspace needed by the harmonic and refined solve_H and restart */
+      primme->projectionParams.projection == primme_proj_RR ? 0 :
+         2*primme->maxBasisSize*primme->maxBasisSize + 4*primme->maxBasisSize,
    
       /* Workspace needed by function check_convergence */ 
       max(primme->maxBasisSize*primme->maxBlockSize + primme->maxBlockSize,
@@ -383,6 +540,7 @@ static int allocate_workspace(primme_params *primme, int allocate) {
    intWorkSize = primme->maxBasisSize /* Size of flag               */
       + 2*primme->maxBlockSize        /* Size of iev and ilev       */
       + maxEvecsSize                  /* Size of ipivot             */
+      + primme->numEvals              /* Size of evecsSlot          */
       + 2*primme->maxBasisSize;       /* Size of 2 perms in solve_H */
 
    /*----------------------------------------------------------------------*/
@@ -438,6 +596,223 @@ static int allocate_workspace(primme_params *primme, int allocate) {
 } /* end of allocate workspace
   ****************************************************************************/
 
+/******************************************************************************
+ * Function fit_memory_budget - Reduces the sizes of the solver until the 
+ *    workspace computed by allocate_workspace, plus the panel of the locked 
+ *    vectors store if used, fits in budget bytes. In order, it
+ *    halves maxPrevRetain down to one, drops the skew projector (and so
+ *    evecsHat), takes the largest maxBasisSize that fits, with minRestartSize 
+ *    in the same proportion, and halves maxBlockSize if no basis size fits. 
+ *    The sizes set by the user or primme_set_method are upper bounds. When
+ *    printLevel >= 2 the chosen layout is reported.
+ *
+ * INPUT PARAMETERS
+ * ----------------
+ * budget  Bytes available, memoryBudget or restartingParams.maxBasisBytes
+ *
+ * INPUT/OUTPUT PARAMETERS
+ * -----------------------
+ * primme  The fields maxPrevRetain, SkewQ, maxBasisSize, minRestartSize, 
+ *         maxBlockSize and locking may be changed
+ *
+ * Return value
+ * ------------
+ *  0  the workspace fits in the budget
+ * -35 the workspace does not fit even with the smallest sizes
+ ******************************************************************************/
+
+static int fit_memory_budget(long int budget, primme_params *primme) {
+
+   int intWorkSize;       /* User's integer workspace size, to restore     */
+   long int realWorkSize; /* User's real workspace size, to restore        */
+   long int bytes;        /* Workspace of the current sizes                */
+   int lo, hi, mid;       /* Bisection interval for maxBasisSize           */
+   double restartRatio;   /* minRestartSize/maxBasisSize to be kept        */
+   int fits;              /* True if the workspace fits                    */
+   int locking;           /* Locking before the fit                        */
+
+   intWorkSize = primme->intWorkSize;
+   locking = primme->locking;
+   realWorkSize = primme->realWorkSize;
+   restartRatio = (double)primme->minRestartSize/primme->maxBasisSize;
+
+   fits = workspace_bytes(primme) <= budget;
+
+   /* Retain fewer vectors from the previous iteration */
+
+   while (!fits && primme->restartingParams.maxPrevRetain > 1) {
+      primme->restartingParams.maxPrevRetain /= 2;
+      fits = workspace_bytes(primme) <= budget;
+   }
+
+   /* Use the orthogonal projector instead of the skew one, so that      */
+   /* evecsHat, M and UDU are not needed                                 */
+
+   if (!fits && primme->correctionParams.projectors.SkewQ) {
+      primme->correctionParams.projectors.SkewQ = 0;
+      fits = workspace_bytes(primme) <= budget;
+   }
+
+   /* Find the largest basis that fits. If not even the smallest one, */
+   /* try again with a smaller block                                   */
+
+   while (!fits) {
+      lo = primme->maxBlockSize + primme->restartingParams.maxPrevRetain + 1;
+      hi = primme->maxBasisSize - 1;
+      while (lo <= hi) {
+         mid = (lo + hi)/2;
+         set_basis_size(mid, restartRatio, locking, primme);
+         if (workspace_bytes(primme) <= budget) {
+            fits = 1;
+            lo = mid + 1;
+         }
+         else {
+            hi = mid - 1;
+         }
+      }
+      if (fits) {
+         set_basis_size(hi, restartRatio, locking, primme);
+      }
+      else if (primme->maxBlockSize > 1) {
+         primme->maxBlockSize /= 2;
+         fits = workspace_bytes(primme) <= budget;
+      }
+      else {
+         break;
+      }
+   }
+
+   bytes = workspace_bytes(primme);
+   primme->intWorkSize = intWorkSize;
+   primme->realWorkSize = realWorkSize;
+   get_sizes(&primme->fitSizes, primme);
+
+   if (primme->printLevel >= 2 && primme->procID == 0) {
+      fprintf(primme->outputFile, "Memory budget %ld bytes: workspace %ld "
+         "maxBasisSize %d minRestartSize %d maxBlockSize %d maxPrevRetain %d "
+         "SkewQ %d locking %d\n", budget, bytes, 
+         primme->maxBasisSize, primme->minRestartSize, primme->maxBlockSize, 
+         primme->restartingParams.maxPrevRetain,
+         primme->correctionParams.projectors.SkewQ, primme->locking);
+      fflush(primme->outputFile);
+   }
+
+   return fits ? 0 : MEMORY_BUDGET_FAILURE;
+}
+
+/******************************************************************************
+ * Function check_sizes - Returns the error code of check_input for the sizes
+ *    that fit_memory_budget and workspace_bytes divide by or allocate with,
+ *    or 0 if they are valid. It is called before the fit, as check_input 
+ *    runs after it.
+ ******************************************************************************/
+
+static int check_sizes(primme_params *primme) {
+
+   if (primme->n <= 0 || primme->nLocal <= 0) 
+      return -5;
+   else if (primme->maxBasisSize < 2) 
+      return -17;
+   else if (primme->minRestartSize <= 0) 
+      return -18;
+   else if (primme->maxBlockSize <= 0) 
+      return -19;
+   else if (primme->restartingParams.maxPrevRetain < 0)
+      return -20;
+   return 0;
+}
+
+/******************************************************************************
+ * Function workspace_bytes - Returns the bytes of the workspace required by
+ *    the current sizes, including the panel of the locked vectors store.
+ *    Overwrites primme.intWorkSize and primme.realWorkSize.
+ ******************************************************************************/
+
+static long int workspace_bytes(primme_params *primme) {
+
+   long int bytes;
+
+   allocate_workspace(primme, FALSE);
+   bytes = primme->realWorkSize + primme->intWorkSize;
+   if (primme->lockStoreParams.fileName != NULL) {
+      bytes += (long int)primme->lockStoreParams.panelSize*primme->nLocal
+               *sizeof(double);
+   }
+   return bytes;
+}
+
+/******************************************************************************
+ * Subroutine set_basis_size - Sets maxBasisSize and minRestartSize, in the
+ *    proportion restartRatio but leaving room for a block and the retained
+ *    vectors. As dprimme does, locking is used if it was used before the
+ *    fit (the argument locking) or if minRestartSize does not hold all the
+ *    wanted pairs.
+ ******************************************************************************/
+
+static void set_basis_size(int maxBasisSize, double restartRatio,
+   int locking, primme_params *primme) {
+
+   primme->maxBasisSize = maxBasisSize;
+   primme->minRestartSize = max(1, min((int)(restartRatio*maxBasisSize),
+      maxBasisSize - primme->maxBlockSize 
+      - primme->restartingParams.maxPrevRetain));
+   primme->locking = locking || primme->numEvals > primme->minRestartSize;
+}
+
+/******************************************************************************
+ * Subroutine keep_user_sizes - Keeps in primme.userSizes the sizes that 
+ *    fit_memory_budget may change, so that the fit always starts from the 
+ *    sizes given by the user. If the sizes are still the ones chosen by the
+ *    fit of a previous call (primme.fitSizes), as happens in the call that
+ *    solves after the call that only reports the workspace, the sizes of
+ *    the user are restored instead, and the fit gives the same result.
+ ******************************************************************************/
+
+static void keep_user_sizes(primme_params *primme) {
+
+   budget_sizes current;
+
+   get_sizes(&current, primme);
+   if (primme->fitSizes.maxBasisSize > 0 &&
+       memcmp(&current, &primme->fitSizes, sizeof(budget_sizes)) == 0) {
+      restore_user_sizes(primme);
+   }
+   else {
+      primme->userSizes = current;
+   }
+}
+
+/******************************************************************************
+ * Subroutine restore_user_sizes - Sets back the sizes kept in 
+ *    primme.userSizes. It is called when a call with a memory budget fails,
+ *    so that the sizes tried by the fit are not left in primme.
+ ******************************************************************************/
+
+static void restore_user_sizes(primme_params *primme) {
+
+   primme->maxBasisSize = primme->userSizes.maxBasisSize;
+   primme->minRestartSize = primme->userSizes.minRestartSize;
+   primme->maxBlockSize = primme->userSizes.maxBlockSize;
+   primme->restartingParams.maxPrevRetain = primme->userSizes.maxPrevRetain;
+   primme->correctionParams.projectors.SkewQ = primme->userSizes.SkewQ;
+   primme->locking = primme->userSizes.locking;
+}
+
+/******************************************************************************
+ * Subroutine get_sizes - Copies to sizes the sizes that fit_memory_budget
+ *    may change
+ ******************************************************************************/
+
+static void get_sizes(budget_sizes *sizes, primme_params *primme) {
+
+   sizes->maxBasisSize = primme->maxBasisSize;
+   sizes->minRestartSize = primme->minRestartSize;
+   sizes->maxBlockSize = primme->maxBlockSize;
+   sizes->maxPrevRetain = primme->restartingParams.maxPrevRetain;
+   sizes->SkewQ = primme->correctionParams.projectors.SkewQ;
+   sizes->locking = primme->locking;
+}
+
 /******************************************************************************
  *
  * static int check_input(double *evals, double *evecs, double *resNorms, 
@@ -449,7 +824,7 @@ static int allocate_workspace(primme_params *primme, int allocate) {
  *  primme                   the main structure of parameters 
  *
  * return value -   0    If input parameters in primme are appropriate
- *              -4..-32  Inappropriate input parameters were found
+ *              -4..-33  Inappropriate input parameters were found
  *
  ******************************************************************************/
 static int check_input(double *evals, double *evecs, double *resNorms, 
@@ -482,6 +857,10 @@ static int check_input(double *evals, double *evecs, double *resNorms,
              primme->target != primme_closest_leq  &&
              primme->target != primme_closest_abs    )
       ret = -13;
+   else if (primme->projectionParams.projection != primme_proj_RR &&
+            primme->projectionParams.projection != primme_proj_harmonic &&
+            primme->projectionParams.projection != primme_proj_refined )
+      ret = -33;
    else if ( primme->target == primme_closest_geq ||
              primme->target == primme_closest_leq ||
              primme->target == primme_closest_abs   ) {
@@ -503,7 +882,9 @@ static int check_input(double *evals, double *evecs, double *resNorms,
    else if (primme->restartingParams.maxPrevRetain < 0)
       ret = -20;
    else if (primme->restartingParams.scheme != primme_thick &&
-            primme->restartingParams.scheme != primme_dtr)
+            primme->restartingParams.scheme != primme_dtr &&
+            primme->restartingParams.scheme != primme_adaptive_thick &&
+            primme->restartingParams.scheme != primme_budget_thick)
       ret = -21;
    else if (primme->initSize < 0) 
       ret = -22;
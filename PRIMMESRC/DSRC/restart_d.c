@@ -86,6 +86,11 @@
  *
  * H                The projection V'*A*V
  *
+ * WtW              The matrix W'*W if the harmonic or refined extraction is
+ *                  used, NULL otherwise. With WtW, hVecs are not orthonormal
+ *                  and they are orthonormalized before restarting. Then the
+ *                  restarted H and WtW are computed explicitly.
+ *
  * hVecs            The eigenvectors of H
  *
  * hVals            The eigenvalues of H
@@ -106,6 +111,10 @@
  *
  * numConvergedStored The # of converged vectors copied to evecs w/o locking
  *
+ * evecsSlot        evecsSlot[i] is the position after the constraints in 
+ *                  evecs of the converged Ritz vector i, or -1 if it is not 
+ *                  stored there (w/o locking)
+ *
  *
  * Return value
  * ------------
@@ -116,12 +125,13 @@
  *       
  ******************************************************************************/
  
-int restart_dprimme(double *V, double *W, double *H, double *hVecs,
-   double *hVals, int *flags, int *iev, double *evecs, double *evecsHat, 
-   double *M, double *UDU, int *ipivot, int basisSize, int numConverged, 
-   int *numConvergedStored, int numLocked, int numGuesses, 
-   double *previousHVecs, int numPrevRetained, double machEps, 
-   double *rwork, int rworkSize, primme_params *primme) {
+int restart_dprimme(double *V, double *W, double *H, double *WtW, 
+   double *hVecs, double *hVals, int *flags, int *iev, double *evecs, 
+   double *evecsHat, double *M, double *UDU, int *ipivot, int basisSize, 
+   int numConverged, int *numConvergedStored, int *evecsSlot, 
+   int numLocked, int numGuesses, double *previousHVecs, 
+   int numPrevRetained, double machEps, double *rwork, int rworkSize, 
+   primme_params *primme) {
   
    int numFree;             /* The number of basis vectors to be left free    */
    int numPacked;           /* The number of coefficient vectors moved to the */
@@ -129,26 +139,42 @@ int restart_dprimme(double *V, double *W, double *H, double *hVecs,
    int restartSize;         /* The number of vectors to restart with          */
    int indexOfPreviousVecs=0; /* Position within hVecs array the previous       */
                             /* coefficient vectors will be stored             */
-   int i, n, eStart;        /* various variables                              */
    int ret;                 /* Return value                                   */
 
    numPacked = 0;
 
    /* --------------------------------------------------------------------- */
-   /* If dynamic thick restarting is to be used, then determine the minimum */
-   /* number of free spaces to be maintained and call the DTR routine.      */
-   /* The DTR routine will determine how many coefficient vectors from the  */
-   /* left and right of H-spectrum to retain at restart. If DTR is not used */
-   /* then set the restart size to the minimum restart size.                */
+   /* The harmonic and refined coefficient vectors are orthonormalized in   */
+   /* the targeting order, so the restarted V remains orthonormal and the   */
+   /* first vectors keep their directions. The vectors are full rank, so    */
+   /* ortho_retained_vectors does not drop any of them.                     */
    /* --------------------------------------------------------------------- */
 
-   if (primme->restartingParams.scheme == primme_dtr) {
+   if (WtW != NULL) {
+      ortho_retained_vectors_dprimme(hVecs, basisSize, 0, hVecs, basisSize, 
+         machEps, rwork);
+   }
+
+   /* --------------------------------------------------------------------- */
+   /* If dynamic thick restarting, adaptive thick restarting or a user      */
+   /* restart policy is to be used, then determine the minimum number of    */
+   /* free spaces to be maintained and call restart_size. It will determine */
+   /* how many coefficient vectors from the left and right of H-spectrum to */
+   /* retain at restart. Otherwise set the restart size to the minimum      */
+   /* restart size.                                                         */
+   /* --------------------------------------------------------------------- */
+
+   if (primme->restartingParams.restartPolicy != NULL ||
+       primme->restartingParams.scheme == primme_dtr ||
+       primme->restartingParams.scheme == primme_adaptive_thick) {
       numFree = numPrevRetained+max(3, primme->maxBlockSize);
-      restartSize = dtr(numLocked, hVecs, hVals, flags, basisSize, numFree, 
-                        iev, rwork, primme);
+      restartSize = restart_size(numLocked, hVecs, hVals, flags, basisSize, 
+                        numFree, iev, rwork, primme);
    }
    else {
       restartSize = min(basisSize, primme->minRestartSize);
+      primme->restartingParams.trace.gapRatio = gap_ratio(hVals, 
+         hVals[iev[0]], basisSize, restartSize, 0);
    }
 
    /* ----------------------------------------------------------------------- */
@@ -193,14 +219,28 @@ int restart_dprimme(double *V, double *W, double *H, double *hVecs,
 
    restart_X(W, hVecs, primme->nLocal, basisSize, restartSize, rwork,rworkSize);
 
+   /* restart_X copies the new V and W from rwork into place */
+   primme->stats.bytesMoved += 2.0L*primme->nLocal*restartSize*sizeof(double);
+
    /* ---------------------------------------------------------------- */
    /* Because we have replaced V by the Ritz vectors, V'*A*V should be */
    /* diagonal with the Ritz values on the diagonal.  The eigenvectors */
    /* of the new matrix V'*A*V become the standard basis vectors.      */
    /* ---------------------------------------------------------------- */
 
-   ret = restart_H(H, hVecs, hVals, restartSize, basisSize, previousHVecs, 
-      numPrevRetained, indexOfPreviousVecs, rworkSize, rwork, primme);
+   /* The restarted H and WtW are not diagonal for the harmonic and refined */
+   /* extraction, so compute them explicitly. That includes the columns of  */
+   /* the retained previous coefficient vectors.                            */
+
+   if (WtW != NULL) {
+      restart_projection(H, WtW, hVecs, hVals, restartSize, basisSize, rwork,
+         primme);
+      ret = 0;
+   }
+   else {
+      ret = restart_H(H, hVecs, hVals, restartSize, basisSize, previousHVecs, 
+         numPrevRetained, indexOfPreviousVecs, rworkSize, rwork, primme);
+   }
 
    if (ret != 0) {
       primme_PushErrorMessage(Primme_restart, Primme_restart_h, ret, __FILE__, 
@@ -217,57 +257,159 @@ int restart_dprimme(double *V, double *W, double *H, double *hVecs,
    /* We recommend against this type of usage. It's better to use locking.  */
    /* --------------------------------------------------------------------- */
 
-   /* Andreas NOTE: is done inefficiently for the moment. We should only */
-   /* add the recently converged. But we need to differentiate them      */
-   /* from flags...                                                      */
-
    if (!primme->locking && primme->correctionParams.maxInnerIterations != 0 && 
-        numConverged > 0 &&
         (primme->correctionParams.projectors.LeftQ ||
          primme->correctionParams.projectors.RightQ )  ) {
 
-       n = primme->nLocal;
-       *numConvergedStored = 0;
-       eStart = primme->numOrthoConst;
-
-       for (i=0;i<primme->numEvals;i++) {
-           if (flags[i] == CONVERGED) {
-              if (*numConvergedStored < numConverged) {
-                 Num_dcopy_dprimme(n, &V[i*n], 1, 
-                              &evecs[(eStart+*numConvergedStored)*n], 1);
-                 (*numConvergedStored)++;
-              }
-           } /* if converged */
-       } /* for */
-       if (*numConvergedStored != numConverged) {
-          if (primme->printLevel >= 1 && primme->procID == 0) {
-             fprintf(primme->outputFile, 
-             "Flags and converged eigenpairs do not correspond %d %d\n",
-                numConverged, *numConvergedStored);
-          }
-          return PSEUDOLOCK_FAILURE;
-       }
-
-      /* Update also the M = K^{-1}evecs and its udu factorization if needed */
-      if (UDU != NULL) {
-
-         apply_preconditioner_block(&evecs[eStart*n], &evecsHat[eStart*n], 
-                                    numConverged, primme );
+      ret = pseudo_lock_converged(V, flags, evecs, evecsHat, M, UDU, ipivot,
+         numConverged, numConvergedStored, evecsSlot, rwork, rworkSize, 
+         primme);
+      if (ret != 0) {
+         return ret;
+      }
+   } /* if this pseudo locking should take place */
+
+   /* ---------------------------------------------- */
+   /* Complete the trace of the restart and print it */
+   /* ---------------------------------------------- */
+
+   primme->restartingParams.trace.restartSize = restartSize;
+   primme->restartingParams.trace.numPrevRetained = numPrevRetained;
+
+   if (primme->printLevel >= 3 && primme->procID == 0) {
+      fprintf(primme->outputFile, 
+         "RESTART %d size %d prev %d gap %e MV %d rate %e\n",
+         primme->stats.numRestarts+1, restartSize, numPrevRetained, 
+         primme->restartingParams.trace.gapRatio, 
+         primme->restartingParams.trace.matvecs,
+         primme->restartingParams.trace.convRate);
+      fflush(primme->outputFile);
+   }
+
+   return restartSize;
+}
+
+
+/*******************************************************************************
+ * Subroutine pseudo_lock_converged - Keeps the converged Ritz vectors in 
+ *    evecs after the orthogonality constraints for the Q projectors when
+ *    locking is not used. Only the vectors that converged since the last
+ *    restart are appended to evecs, and M = evecs'*evecsHat and its UDU
+ *    factorization are bordered with their rows and columns. The vectors 
+ *    already stored are at most a tolerance away from the current Ritz 
+ *    vectors, so they are not copied again. If some of them are no longer flagged as converged, their 
+ *    slots are stale and evecs is rebuilt from the converged vectors.
+ *
+ * INPUT ARRAYS AND PARAMETERS
+ * ---------------------------
+ * V             The restarted basis. Column i is the Ritz vector i
+ * flags         Array indicating the convergence of the Ritz vectors
+ * numConverged  The number of converged Ritz vectors
+ * rwork         Real work array of size maxEvecsSize*numEvals
+ * rworkSize     Size of rwork
+ *
+ * INPUT/OUTPUT ARRAYS AND PARAMETERS
+ * ----------------------------------
+ * evecs, evecsHat, M, UDU, ipivot  As in restart
+ * numConvergedStored  The number of converged vectors stored in evecs
+ * evecsSlot     evecsSlot[i] is the position of Ritz vector i in evecs
+ *               after the constraints, or -1
+ *
+ * Return value
+ * ------------
+ *  0  success
+ * -4  factorization of M failed
+ * -5  flags do not correspond to converged pairs
+ ******************************************************************************/
+
+static int pseudo_lock_converged(double *V, int *flags, double *evecs, 
+   double *evecsHat, double *M, double *UDU, int *ipivot, int numConverged,
+   int *numConvergedStored, int *evecsSlot, double *rwork, int rworkSize, 
+   primme_params *primme) {
+
+   int i, n, eStart;
+   int numOld;        /* Number of vectors stored before this call */
+   int rebuild;       /* Whether some stored vector became stale   */
+   int ret;
+
+   n = primme->nLocal;
+   eStart = primme->numOrthoConst;
+
+   /* ---------------------------------------------------------------- */
+   /* If some stored vector is no longer converged, start from scratch */
+   /* ---------------------------------------------------------------- */
+
+   rebuild = 0;
+   for (i=0; i < primme->numEvals; i++) {
+      if (evecsSlot[i] >= 0 && flags[i] != CONVERGED) {
+         rebuild = 1;
+         break;
+      }
+   }
+
+   if (rebuild) {
+      for (i=0; i < primme->numEvals; i++) {
+         evecsSlot[i] = -1;
+      }
+      *numConvergedStored = 0;
+   }
+
+   /* ------------------------------------------ */
+   /* Append the recently converged Ritz vectors */
+   /* ------------------------------------------ */
+
+   numOld = *numConvergedStored;
+
+   for (i=0; i < primme->numEvals && *numConvergedStored < numConverged; i++){
+      if (flags[i] == CONVERGED && evecsSlot[i] < 0) {
+         Num_dcopy_dprimme(n, &V[i*n], 1, 
+                           &evecs[(eStart+*numConvergedStored)*n], 1);
+         primme->stats.bytesMoved += n*sizeof(double);
+         evecsSlot[i] = (*numConvergedStored)++;
+      }
+   }
+
+   if (*numConvergedStored != numConverged) {
+      if (primme->printLevel >= 1 && primme->procID == 0) {
+         fprintf(primme->outputFile, 
+         "Flags and converged eigenpairs do not correspond %d %d\n",
+            numConverged, *numConvergedStored);
+      }
+      return PSEUDOLOCK_FAILURE;
+   }
+
+   /* ---------------------------------------------------------------- */
+   /* Border M = evecs'*K^{-1}evecs with the new vectors and factorize */
+   /* ---------------------------------------------------------------- */
+
+   if (UDU != NULL && (rebuild || numConverged > numOld) &&
+         eStart+numConverged > 0) {
+
+      if (numConverged > numOld) {
+         apply_preconditioner_block(&evecs[(eStart+numOld)*n], 
+            &evecsHat[(eStart+numOld)*n], numConverged-numOld, primme);
          /* rwork must be maxEvecsSize*numEvals! */
-         update_projection_dprimme(evecs, evecsHat, M, eStart*n,
-           primme->numOrthoConst+primme->numEvals, numConverged, rwork, primme);
+         update_projection_dprimme(evecs, evecsHat, M, eStart+numOld,
+            primme->numOrthoConst+primme->numEvals, numConverged-numOld, 
+            rwork, primme);
+      }
 
+      if (rebuild) {
          ret = UDUDecompose_dprimme(M, UDU, ipivot, eStart+numConverged, 
                          rwork, rworkSize, primme);
-         if (ret != 0) {
-            primme_PushErrorMessage(Primme_lock_vectors,Primme_ududecompose,ret,
-               __FILE__, __LINE__, primme);
-            return UDUDECOMPOSE_FAILURE;
-         }
-      } /* if UDU factorization is needed */
-   } /* if this pseudo locking should take place */
+      }
+      else {
+         ret = UDUAppend_dprimme(M, UDU, ipivot, eStart+numOld, 
+                         numConverged-numOld, rwork, rworkSize, primme);
+      }
+      if (ret != 0) {
+         primme_PushErrorMessage(Primme_lock_vectors,Primme_ududecompose,ret,
+            __FILE__, __LINE__, primme);
+         return UDUDECOMPOSE_FAILURE;
+      }
+   }
 
-   return restartSize;
+   return 0;
 }
 
 
@@ -457,9 +599,83 @@ static int restart_H(double *H, double *hVecs, double *hVals,
 
 
 /*******************************************************************************
- * Function dtr - This function determines the number of coefficient vectors
- *    to retain from both the left and right side of the spectrum.  The vectors
- *    are then copied so that they are contiguous in memory.
+ * Subroutine restart_projection - This routine recomputes H = V'*A*V and 
+ *   WtW = W'*W after restarting V and W with the orthonormal coefficient
+ *   vectors hVecs, when the harmonic or refined extraction is used. In that
+ *   case the restarted matrices are not diagonal. The Ritz values are then
+ *   the diagonal of the new H, and hVecs become the standard basis vectors.
+ *   The coefficients retained from the previous iteration have already been
+ *   inserted into hVecs by combine_retained_vectors, and restartSize counts
+ *   them, so they are projected here as any other column. Unlike restart_H,
+ *   no separate treatment of previousHVecs is needed.
+ *
+ * INPUT PARAMETERS
+ * ----------------
+ * restartSize   Number of vectors the basis was restarted with
+ * 
+ * basisSize     Size of the basis before restarting
+ *
+ * rwork         Work array of size basisSize*restartSize + restartSize^2
+ *
+ * INPUT/OUTPUT ARRAYS
+ * -------------------
+ * H      The projection V'*A*V before and after restarting
+ *
+ * WtW    The matrix W'*W before and after restarting
+ *
+ * hVecs  The coefficient vectors before restarting, and the standard basis
+ *        vectors after restarting
+ * 
+ * hVals  The Rayleigh quotients of the restarted V
+ *
+ ******************************************************************************/
+
+static void restart_projection(double *H, double *WtW, double *hVecs, 
+   double *hVals, int restartSize, int basisSize, double *rwork, 
+   primme_params *primme) {
+
+   int i, j, k;     /* Loop variables                         */
+   double *X[2];    /* The matrices to be restarted, H and WtW */
+   double *XC;      /* Stores X*hVecs                         */
+   double *CtXC;    /* Stores hVecs'*X*hVecs                  */
+   double tpone = +1.0e+00, tzero = +0.0e+00;
+
+   X[0] = H;
+   X[1] = WtW;
+   XC   = rwork;
+   CtXC = rwork + basisSize*restartSize;
+
+   for (k=0; k < 2; k++) {
+      Num_symm_dprimme("L", "U", basisSize, restartSize, tpone, X[k], 
+         primme->maxBasisSize, hVecs, basisSize, tzero, XC, basisSize);
+      Num_gemm_dprimme("C", "N", restartSize, restartSize, basisSize, tpone, 
+         hVecs, basisSize, XC, basisSize, tzero, CtXC, restartSize);
+
+      for (j=0; j < restartSize; j++) {
+         for (i=0; i <= j; i++) {
+            X[k][primme->maxBasisSize*j+i] = CtXC[restartSize*j+i];
+         }
+      }
+   }
+
+   for (j=0; j < restartSize; j++) {
+      hVals[j] = H[primme->maxBasisSize*j+j];
+      for (i=0; i < j; i++) {
+          hVecs[restartSize*j+i] = tzero;
+          hVecs[restartSize*i+j] = tzero;
+      }
+      hVecs[restartSize*j+j] = tpone;
+   }
+}
+
+
+/*******************************************************************************
+ * Function restart_size - This function determines the number of coefficient
+ *    vectors to retain from both the left and right side of the spectrum.
+ *    The numbers are chosen by the user function restartPolicy if given, or
+ *    else by dynamic thick restarting (dtr_search) or adaptive thick 
+ *    restarting (adaptive_size). The vectors are then copied so that they are
+ *    contiguous in memory.
  *
  * Input parameters
  * ----------------
@@ -493,17 +709,16 @@ static int restart_H(double *H, double *hVecs, double *hVals,
  ******************************************************************************/
 
 
-static int dtr(int numLocked, double *hVecs, double *hVals, int *flags, 
-  int basisSize, int numFree, int *iev, double *rwork, primme_params *primme)
+static int restart_size(int numLocked, double *hVecs, double *hVals, 
+  int *flags, int basisSize, int numFree, int *iev, double *rwork, 
+  primme_params *primme)
 {
 
    int i;                 /* Loop variable */
    int l, lOpt, lMin;     /* Determine how many left side vectors to retain   */
-   int r, rOpt;           /* Determine how many right side vectors to retain  */
-   int maxIndex;          /* basisSize - 1                                    */
+   int rOpt;              /* Determine how many right side vectors to retain  */
    int restartSize;       /* The new restart size                             */
    double currentRitzVal; /* The current Ritz value the solver is computing   */
-   double newVal, optVal; /* Used to find the optimum gap ratio               */
 
    /* ---------------------------------------------------------------- */
    /* Compute lOpt and rOpt with respect to the first Ritz value being */
@@ -511,7 +726,6 @@ static int dtr(int numLocked, double *hVecs, double *hVals, int *flags,
    /* ---------------------------------------------------------------- */
 
    currentRitzVal = hVals[iev[0]];
-   maxIndex = basisSize-1;
 
    /* If locking is engaged, then lMin must be large enough to retain */
    /* the coefficient vector associated with a converged target.      */
@@ -538,41 +752,30 @@ static int dtr(int numLocked, double *hVecs, double *hVals, int *flags,
       lMin = min(basisSize, primme->minRestartSize);
    }
 
-   
-   lOpt = lMin;
-   rOpt = 0;   
-   optVal = 0.0L;
-
    if (primme->printLevel >= 5 && primme->procID == 0) {
       fprintf(primme->outputFile,"DTR basisSize: %d\n", basisSize);
    }
 
-   /* ---------------------------------------------------------------------- */
-   /* Compute lOpt and rOpt that maximize the function.                      */
-   /* maximize the function (basisSize-numFree-lMin-rMin)*                   */
-   /*                       sqrt((currentRitzVal - hVals[l+1])/              */
-   /*                            (hVals[l+1]-hVals[basisSize-1-r]))          */
-   /* ---------------------------------------------------------------------- */
-
-   for (l = lMin; l < basisSize - numFree; l++) {
-      for (r = 0; r < basisSize - l - numFree; r++)       {
-         if ((basisSize - l - r) % primme->maxBlockSize == 0) {
-            newVal = (basisSize - l - r)
-                     * sqrt((currentRitzVal - hVals[l+1])/
-                            (hVals[l+1]-hVals[maxIndex-r]));
-
-            if (newVal > optVal) {
-               optVal = newVal;
-               lOpt = l;
-               rOpt = r;
-            }
-
-         }
-      }
+   if (primme->restartingParams.restartPolicy != NULL) {
+      rOpt = 0;
+      lOpt = primme->restartingParams.restartPolicy(hVals, basisSize, lMin,
+         numFree, iev[0], &rOpt, primme);
+      /* Leave numFree vacancies as the built-in schemes do */
+      lOpt = max(lMin, min(lOpt, basisSize - numFree));
+      rOpt = max(0, min(rOpt, basisSize - numFree - lOpt));
+   }
+   else if (primme->restartingParams.scheme == primme_dtr) {
+      lOpt = dtr_search(hVals, currentRitzVal, basisSize, lMin, numFree, 
+         &rOpt, primme);
+   }
+   else {
+      lOpt = adaptive_size(basisSize, lMin, numFree, primme);
+      rOpt = 0;
    }
-
 
    restartSize = lOpt + rOpt;
+   primme->restartingParams.trace.gapRatio = gap_ratio(hVals, currentRitzVal,
+      basisSize, lOpt, rOpt);
 
    /* --------------------------------------------------------------- */
    /* Swap the rOpt vectors from the right hand side so that they are */
@@ -607,6 +810,136 @@ static int dtr(int numLocked, double *hVecs, double *hVals, int *flags,
 
 }
 
+/*******************************************************************************
+ * Function dtr_search - Dynamic thick restarting. It returns the number of 
+ *    Ritz vectors l to retain from the left of the spectrum and the number r
+ *    from the right that maximize
+ *       (basisSize-l-r)*sqrt((currentRitzVal - hVals[l+1])/
+ *                            (hVals[l+1]-hVals[basisSize-1-r]))
+ *    among those with basisSize-l-r multiple of the block size.
+ *
+ * Input parameters
+ * ----------------
+ * hVals           The Ritz values sorted by the target
+ * currentRitzVal  The Ritz value of the first block vector
+ * basisSize       The current size of the basis
+ * lMin            The minimum number of vectors to retain from the left
+ * numFree         Number of vacancies to be left in the basis
+ *
+ * Output parameters
+ * -----------------
+ * right           Number of vectors to retain from the right
+ *
+ * Return value
+ * ------------
+ * int  The number of vectors to retain from the left
+ ******************************************************************************/
+
+static int dtr_search(double *hVals, double currentRitzVal, int basisSize,
+   int lMin, int numFree, int *right, primme_params *primme) {
+
+   int l, lOpt;           /* Determine how many left side vectors to retain   */
+   int r, rOpt;           /* Determine how many right side vectors to retain  */
+   int maxIndex;          /* basisSize - 1                                    */
+   double newVal, optVal; /* Used to find the optimum gap ratio               */
+
+   maxIndex = basisSize-1;
+   lOpt = lMin;
+   rOpt = 0;   
+   optVal = 0.0L;
+
+   /* ---------------------------------------------------------------------- */
+   /* Only the r for which basisSize-l-r is a multiple of the block size are */
+   /* considered, so r starts at (basisSize-l) mod maxBlockSize and          */
+   /* advances by maxBlockSize.                                              */
+   /* ---------------------------------------------------------------------- */
+
+   for (l = lMin; l < basisSize - numFree; l++) {
+      for (r = (basisSize - l) % primme->maxBlockSize; 
+           r < basisSize - l - numFree; r += primme->maxBlockSize) {
+         newVal = (basisSize - l - r)
+                  * sqrt((currentRitzVal - hVals[l+1])/
+                         (hVals[l+1]-hVals[maxIndex-r]));
+
+         if (newVal > optVal) {
+            optVal = newVal;
+            lOpt = l;
+            rOpt = r;
+         }
+      }
+   }
+
+   *right = rOpt;
+   return lOpt;
+}
+
+/*******************************************************************************
+ * Function adaptive_size - Adaptive thick restarting. The restart size moves
+ *    by maxBlockSize at every restart in the direction that sped up the 
+ *    convergence of the first target, measured as the reduction of its 
+ *    residual norm per matvec since the previous restart (trace.convRate).
+ *    If the last move slowed down the convergence, the direction is 
+ *    reversed. If the residual norm did not decrease, for instance because
+ *    a new pair is targeted, the restart size is kept.
+ *
+ * Input parameters
+ * ----------------
+ * basisSize  The current size of the basis
+ * lMin       The minimum number of vectors to retain
+ * numFree    Number of vacancies to be left in the basis
+ *
+ * Input/output parameters
+ * -----------------------
+ * primme     The fields restartingParams.adaptStep and adaptRate are updated
+ *
+ * Return value
+ * ------------
+ * int  The number of vectors to retain
+ ******************************************************************************/
+
+static int adaptive_size(int basisSize, int lMin, int numFree,
+   primme_params *primme) {
+
+   int size;              /* The new restart size                            */
+   double rate;           /* Convergence rate since the previous restart     */
+   restarting_params *params = &primme->restartingParams;
+
+   size = params->trace.restartSize - params->trace.numPrevRetained;
+   if (size <= 0) size = primme->minRestartSize;
+   if (params->adaptStep == 0) params->adaptStep = primme->maxBlockSize;
+   rate = params->trace.convRate;
+
+   if (rate > 0.0L) {
+      if (params->adaptRate > 0.0L) {
+         if (rate < params->adaptRate) params->adaptStep = -params->adaptStep;
+         size += params->adaptStep;
+      }
+      params->adaptRate = rate;
+   }
+   else {
+      params->adaptRate = 0.0L;
+   }
+
+   return max(lMin, min(size, basisSize - numFree));
+}
+
+/*******************************************************************************
+ * Function gap_ratio - Returns the gap ratio of the first target when 
+ *    restarting with the left l and right r Ritz vectors,
+ *       |currentRitzVal - hVals[l]| / |hVals[l] - hVals[basisSize-1-r]|,
+ *    or zero if no Ritz vector is discarded.
+ ******************************************************************************/
+
+static double gap_ratio(double *hVals, double currentRitzVal, int basisSize,
+   int l, int r) {
+
+   double den;
+
+   if (l >= basisSize - r) return 0.0L;
+   den = fabs(hVals[l] - hVals[basisSize-1-r]);
+   return den > 0.0L ? fabs(currentRitzVal - hVals[l])/den : 0.0L;
+}
+
 /******************************************************************************
  * Function pack_converged_coefficients - This function is called before
  *    restart so that the coefficient vectors (eigenvectors of H) are packed
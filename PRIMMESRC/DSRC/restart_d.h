@@ -31,11 +31,12 @@
 
 void reset_flags_dprimme(int *flag, int first, int last);
 
-int restart_dprimme(double *V, double *W, double *H, double *hVecs, 
-   double *hVals, int *flags, int *iev, double *evecs, double *evecsHat, 
-   double *M, double *UDU, int *ipivot, int basisSize, int numConverged, 
-   int *numConvergedStored, int numLocked, int numGuesses, 
-   double *previousHVecs, int numPrevRetained, double machEps, 
-   double *rwork, int rworkSize, primme_params *primme);
+int restart_dprimme(double *V, double *W, double *H, double *WtW, 
+   double *hVecs, double *hVals, int *flags, int *iev, double *evecs, 
+   double *evecsHat, double *M, double *UDU, int *ipivot, int basisSize, 
+   int numConverged, int *numConvergedStored, int *evecsSlot, 
+   int numLocked, int numGuesses, double *previousHVecs, 
+   int numPrevRetained, double machEps, double *rwork, int rworkSize, 
+   primme_params *primme);
 
 #endif
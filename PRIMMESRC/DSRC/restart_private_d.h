@@ -43,8 +43,22 @@ static int restart_H(double *H, double *hVecs, double *hVals,
    int numPrevRetained, int indexOfPreviousVecs, int rworkSize, 
    double *rwork, primme_params *primme);
 
-static int dtr(int numLocked, double *hVecs, double *hVals, int *flags, 
- int basisSize, int numFree, int *iev, double *rwork, primme_params *primme);
+static void restart_projection(double *H, double *WtW, double *hVecs, 
+   double *hVals, int restartSize, int basisSize, double *rwork, 
+   primme_params *primme);
+
+static int restart_size(int numLocked, double *hVecs, double *hVals, 
+  int *flags, int basisSize, int numFree, int *iev, double *rwork, 
+  primme_params *primme);
+
+static int dtr_search(double *hVals, double currentRitzVal, int basisSize,
+   int lMin, int numFree, int *right, primme_params *primme);
+
+static int adaptive_size(int basisSize, int lMin, int numFree,
+   primme_params *primme);
+
+static double gap_ratio(double *hVals, double currentRitzVal, int basisSize,
+   int l, int r);
 
 static int pack_converged_coefficients(int *restartSize, int basisSize, 
    int *numPrevRetained, int numLocked, int numGuesses, double *hVecs, 
@@ -63,6 +77,11 @@ static int insert_submatrix(double *H, double *hVals, double *hVecs,
    int indexOfPreviousVecs, int rworkSize, double *rwork, 
    primme_params *primme);
 
+static int pseudo_lock_converged(double *V, int *flags, double *evecs, 
+   double *evecsHat, double *M, double *UDU, int *ipivot, int numConverged,
+   int *numConvergedStored, int *evecsSlot, double *rwork, int rworkSize, 
+   primme_params *primme);
+
 static void apply_preconditioner_block(double *v, double *result,
    int blockSize, primme_params *primme);
 
@@ -39,6 +39,8 @@
  * INPUT ARRAYS AND PARAMETERS
  * ---------------------------
  * H             The matrix V'*A*V
+ * WtW           The matrix W'*W, with W = A*V. It is maintained only if
+ *               the harmonic or the refined extraction is used (NULL else)
  * basisSize     Current size of the orthonormal basis V
  * maxBasisSize  The maximum size of the basis V
  * numLocked     Number of eigenvalues locked, to determine ordering shift.
@@ -50,7 +52,8 @@
  * hVecs             The eigenvectors of H
  * hVals             The eigenvalues of H
  * largestRitzValue  Maintains the largest in absolute value Ritz value seen
- * rwork             Must be of size at least 3*maxBasisSize
+ * rwork             Must be of size at least 3*maxBasisSize, or
+ *                   2*maxBasisSize^2 + 3*maxBasisSize if WtW is not NULL
  * iwork             Permutation array for evecs/evals with desired targeting 
  *                   order. hVecs/hVals are permuted in the right order.
  *
@@ -60,13 +63,14 @@
  *     - -1 Num_dsyev was unsuccsessful
  ******************************************************************************/
 
-int solve_H_dprimme(double *H, double *hVecs, double *hVals, 
+int solve_H_dprimme(double *H, double *WtW, double *hVecs, double *hVals, 
    int basisSize, int maxBasisSize, double *largestRitzValue, int numLocked, 
    int lrwork, double *rwork, int *iwork, primme_params *primme) {
 
    int i, j; /* Loop variables    */
    int info; /* dsyev error value */
    int index;
+   int ret;  /* Return value      */
    int *permu, *permw;
    double targetShift;
 
@@ -81,6 +85,37 @@ int solve_H_dprimme(double *H, double *hVecs, double *hVals,
    int apSize, idx;
 #endif
 
+   /* ------------------------------------------------------------------- */
+   /* Interior targets may use the harmonic or the refined extraction     */
+   /* with respect to the current shift instead of the Rayleigh-Ritz one. */
+   /* If W'*W-2*shift*H+shift^2*I is not numerically positive definite,   */
+   /* V contains a vector y with (A-shift*I)*V*y close to zero. The       */
+   /* harmonic extraction then falls back to the refined one, which finds */
+   /* that vector without factorizing the matrix.                         */
+   /* ------------------------------------------------------------------- */
+
+   if (WtW != NULL) {
+      targetShift = 
+        primme->targetShifts[min(primme->numTargetShifts-1, numLocked)];
+
+      if (primme->projectionParams.projection == primme_proj_harmonic) {
+         ret = solve_H_harmonic(H, WtW, hVecs, hVals, basisSize, 
+            maxBasisSize, targetShift, lrwork, rwork, iwork, primme);
+      }
+      if (primme->projectionParams.projection != primme_proj_harmonic
+            || ret == 1) {
+         ret = solve_H_refined(H, WtW, hVecs, hVals, basisSize, 
+            maxBasisSize, targetShift, lrwork, rwork, iwork, primme);
+      }
+
+      if (ret == 0) {
+         for (i = 0; i < basisSize; i++) {
+            *largestRitzValue = max(*largestRitzValue, fabs(hVals[i]));
+         }
+      }
+      return ret;
+   }
+
 
    /* ------------------------------------------------------------------- */
    /* Copy the upper triangular portion of H into hvecs.  We need to do   */
@@ -252,6 +287,296 @@ int solve_H_dprimme(double *H, double *hVecs, double *hVals,
    return 0;   
 }
 
+/*******************************************************************************
+ * Subroutine solve_H_harmonic - This procedure computes the harmonic Ritz 
+ *            pairs of A with respect to the shift sigma. With G = R'*R the 
+ *            Cholesky factorization of (W-sigma*V)'*(W-sigma*V), that is
+ *            W'*W - 2*sigma*H + sigma^2*I, it solves the symmetric problem
+ *
+ *               R^{-T}*(H-sigma*I)*R^{-1}*z = nu*z,  y = R^{-1}*z,
+ *
+ *            whose largest eigenvalues nu = 1/(theta-sigma) correspond to
+ *            the harmonic Ritz values theta closest to sigma. The vectors y
+ *            are normalized and their Rayleigh quotients y'*H*y are returned
+ *            in hVals, as they give smaller residuals than theta.
+ *        
+ * INPUT ARRAYS AND PARAMETERS
+ * ---------------------------
+ * H             The matrix V'*A*V
+ * WtW           The matrix W'*W
+ * basisSize     Current size of the orthonormal basis V
+ * maxBasisSize  The maximum size of the basis V (leading dimension of H, WtW)
+ * targetShift   The shift sigma
+ * lrwork        Length of the work array rwork
+ * primme        Strucuture containing various solver parameters
+ * 
+ * OUTPUT ARRAYS
+ * -------------
+ * hVecs         The harmonic Ritz vectors in the desired targeting order
+ * hVals         Their Rayleigh quotients
+ * rwork         Must be of size at least 2*basisSize^2 + 3*basisSize
+ * iwork         Permutation array of size 2*basisSize
+ *
+ * Return Value
+ * ------------
+ * int -  0 upon successful return
+ *     -  1 if the Cholesky factorization failed
+ *     - -1 Num_dsyev was unsuccsessful
+ ******************************************************************************/
+
+static int solve_H_harmonic(double *H, double *WtW, double *hVecs, 
+   double *hVals, int basisSize, int maxBasisSize, double targetShift,
+   int lrwork, double *rwork, int *iwork, primme_params *primme) {
+
+   int i, j;        /* Loop variables    */
+   int info;        /* LAPACK error value */
+   int index;
+   int *permu, *permw;
+   double *R;       /* The Cholesky factor of (W-sigma*V)'*(W-sigma*V) */
+   double *work;
+   double norm;
+   double tpone = +1.0e+00, tzero = +0.0e+00;
+
+   permu = iwork;
+   permw = permu + basisSize;
+   R     = rwork;
+   work  = rwork + basisSize*basisSize;
+   lrwork = lrwork - basisSize*basisSize;
+
+   /* ------------------------------------------------------------------- */
+   /* R = chol(W'*W - 2*sigma*H + sigma^2*I) and hVecs = H - sigma*I,     */
+   /* the latter stored in full since it is multiplied from both sides   */
+   /* ------------------------------------------------------------------- */
+
+   for (j=0; j < basisSize; j++) {
+      for (i=0; i <= j; i++) {
+         R[basisSize*j+i] = WtW[maxBasisSize*j+i] 
+                            - 2.0L*targetShift*H[maxBasisSize*j+i];
+         hVecs[basisSize*j+i] = hVecs[basisSize*i+j] = H[maxBasisSize*j+i];
+      }
+      R[basisSize*j+j] += targetShift*targetShift;
+      hVecs[basisSize*j+j] -= targetShift;
+   }
+
+   Num_dpotrf_dprimme("U", basisSize, R, basisSize, &info);
+
+   if (info != 0) {
+      return 1;
+   }
+
+   Num_trsm_dprimme("L", "U", "C", "N", basisSize, basisSize, tpone, R, 
+      basisSize, hVecs, basisSize);
+   Num_trsm_dprimme("R", "U", "N", "N", basisSize, basisSize, tpone, R, 
+      basisSize, hVecs, basisSize);
+
+#ifdef NUM_ESSL
+   for (j=0, index=0; j < basisSize; j++) {
+      for (i=0; i <= j; i++) {
+         work[index++] = hVecs[basisSize*j+i];
+      }
+   }
+
+   info = Num_dspev_dprimme(21, work, hVals, hVecs, basisSize, basisSize, 
+      &work[index], lrwork-index);
+
+   if (info != 0) {
+      primme_PushErrorMessage(Primme_solve_h, Primme_num_dspev, info, __FILE__, 
+         __LINE__, primme);
+      return NUM_DSPEV_FAILURE;
+   }
+
+#else
+   Num_dsyev_dprimme("V", "U", basisSize, hVecs, basisSize, hVals, work, 
+                lrwork, &info);
+
+   if (info != 0) {
+      primme_PushErrorMessage(Primme_solve_h, Primme_num_dsyev, info, __FILE__, 
+         __LINE__, primme);
+      return NUM_DSYEV_FAILURE;
+   }
+
+#endif
+
+   Num_trsm_dprimme("L", "U", "N", "N", basisSize, basisSize, tpone, R, 
+      basisSize, hVecs, basisSize);
+
+   /* ---------------------------------------------------------------------- */
+   /* ORDER the vectors according to the desired target. hVals holds nu in   */
+   /* ascending order; positive nu correspond to harmonic Ritz values to the */
+   /* right of the shift, and the largest |nu| to the closest to the shift.  */
+   /* ---------------------------------------------------------------------- */
+
+   for (j=0; j < basisSize && hVals[j] < 0.0L; j++);
+
+   index = 0;
+   if (primme->target == primme_closest_geq) {
+      for (i=basisSize-1; i >= j; i--) permu[index++] = i;
+      for (i=0; i < j; i++) permu[index++] = i;
+   }
+   else if (primme->target == primme_closest_leq) {
+      for (i=0; i < j; i++) permu[index++] = i;
+      for (i=basisSize-1; i >= j; i--) permu[index++] = i;
+   }
+   else { /* primme_closest_abs */
+      i = 0; 
+      j = basisSize-1;
+      while (i <= j) {
+         if (fabs(hVals[i]) > fabs(hVals[j]))
+            permu[index++] = i++;
+         else
+            permu[index++] = j--;
+      }
+   }
+
+   for (i=0; i < basisSize; i++) 
+       permw[i] = permu[i];
+   permute_evecs_dprimme(hVals, permu, work, basisSize, 1);
+   permute_evecs_dprimme(hVecs, permw, work, basisSize, basisSize);
+
+   /* ------------------------------------------------------------------- */
+   /* Normalize the vectors and set hVals to their Rayleigh quotients     */
+   /* ------------------------------------------------------------------- */
+
+   for (i=0; i < basisSize; i++) {
+      norm = sqrt(Num_dot_dprimme(basisSize, &hVecs[basisSize*i], 1,
+                                             &hVecs[basisSize*i], 1));
+      Num_scal_dprimme(basisSize, 1.0L/norm, &hVecs[basisSize*i], 1);
+   }
+
+   Num_symm_dprimme("L", "U", basisSize, basisSize, tpone, H, maxBasisSize,
+      hVecs, basisSize, tzero, R, basisSize);
+
+   for (i=0; i < basisSize; i++) {
+      hVals[i] = Num_dot_dprimme(basisSize, &hVecs[basisSize*i], 1,
+                                            &R[basisSize*i], 1);
+   }
+
+   return 0;
+}
+
+/*******************************************************************************
+ * Subroutine solve_H_refined - This procedure computes the refined Ritz 
+ *            vectors with respect to the shift sigma, i.e., the unit vectors
+ *            y that minimize ||(A-sigma*I)*V*y||. They are the eigenvectors
+ *            of W'*W - 2*sigma*H + sigma^2*I with the smallest eigenvalues.
+ *            That matrix is R'*R, with R the triangular factor of the QR
+ *            decomposition of W-sigma*V, so they are the right singular
+ *            vectors of R. It is formed from the projections kept by the
+ *            solver instead of factorizing the distributed W-sigma*V, and
+ *            it needs no factorization that could fail when V contains an
+ *            eigenvector with eigenvalue sigma.
+ *            hVals returns their Rayleigh quotients y'*H*y. For closest_geq
+ *            (closest_leq) the vectors whose Rayleigh quotient is to the
+ *            right (left) of the shift are moved first, keeping their order.
+ *
+ * INPUT ARRAYS AND PARAMETERS
+ * ---------------------------
+ * H             The matrix V'*A*V
+ * WtW           The matrix W'*W
+ * basisSize     Current size of the orthonormal basis V
+ * maxBasisSize  The maximum size of the basis V (leading dimension of H, WtW)
+ * targetShift   The shift sigma
+ * lrwork        Length of the work array rwork
+ * primme        Strucuture containing various solver parameters
+ * 
+ * OUTPUT ARRAYS
+ * -------------
+ * hVecs         The refined Ritz vectors in the desired targeting order
+ * hVals         Their Rayleigh quotients
+ * rwork         Must be of size at least 2*basisSize^2 + 3*basisSize
+ * iwork         Permutation array of size 2*basisSize
+ *
+ * Return Value
+ * ------------
+ * int -  0 upon successful return
+ *     - -1 Num_dsyev was unsuccsessful
+ ******************************************************************************/
+
+static int solve_H_refined(double *H, double *WtW, double *hVecs, 
+   double *hVals, int basisSize, int maxBasisSize, double targetShift,
+   int lrwork, double *rwork, int *iwork, primme_params *primme) {
+
+   int i, j;        /* Loop variables    */
+   int info;        /* LAPACK error value */
+   int index;
+   int *permu, *permw;
+   double *HY;
+   double *work;
+   double tpone = +1.0e+00, tzero = +0.0e+00;
+
+   permu = iwork;
+   permw = permu + basisSize;
+   HY    = rwork;
+   work  = rwork + basisSize*basisSize;
+   lrwork = lrwork - basisSize*basisSize;
+
+   for (j=0; j < basisSize; j++) {
+      for (i=0; i <= j; i++) {
+         hVecs[basisSize*j+i] = WtW[maxBasisSize*j+i] 
+                                - 2.0L*targetShift*H[maxBasisSize*j+i];
+      }
+      hVecs[basisSize*j+j] += targetShift*targetShift;
+   }
+
+#ifdef NUM_ESSL
+   for (j=0, index=0; j < basisSize; j++) {
+      for (i=0; i <= j; i++) {
+         work[index++] = hVecs[basisSize*j+i];
+      }
+   }
+
+   info = Num_dspev_dprimme(21, work, hVals, hVecs, basisSize, basisSize, 
+      &work[index], lrwork-index);
+
+   if (info != 0) {
+      primme_PushErrorMessage(Primme_solve_h, Primme_num_dspev, info, __FILE__, 
+         __LINE__, primme);
+      return NUM_DSPEV_FAILURE;
+   }
+
+#else
+   Num_dsyev_dprimme("V", "U", basisSize, hVecs, basisSize, hVals, work, 
+                lrwork, &info);
+
+   if (info != 0) {
+      primme_PushErrorMessage(Primme_solve_h, Primme_num_dsyev, info, __FILE__, 
+         __LINE__, primme);
+      return NUM_DSYEV_FAILURE;
+   }
+
+#endif
+
+   Num_symm_dprimme("L", "U", basisSize, basisSize, tpone, H, maxBasisSize,
+      hVecs, basisSize, tzero, HY, basisSize);
+
+   for (i=0; i < basisSize; i++) {
+      hVals[i] = Num_dot_dprimme(basisSize, &hVecs[basisSize*i], 1,
+                                            &HY[basisSize*i], 1);
+   }
+
+   if (primme->target == primme_closest_abs) 
+      return 0;
+
+   index = 0;
+   for (i=0; i < basisSize; i++) {
+      if ((primme->target == primme_closest_geq && hVals[i] >= targetShift) ||
+          (primme->target == primme_closest_leq && hVals[i] <= targetShift))
+         permu[index++] = i;
+   }
+   for (i=0; i < basisSize; i++) {
+      if (!((primme->target == primme_closest_geq && hVals[i] >= targetShift) ||
+            (primme->target == primme_closest_leq && hVals[i] <= targetShift)))
+         permu[index++] = i;
+   }
+
+   for (i=0; i < basisSize; i++) 
+       permw[i] = permu[i];
+   permute_evecs_dprimme(hVals, permu, work, basisSize, 1);
+   permute_evecs_dprimme(hVecs, permw, work, basisSize, basisSize);
+
+   return 0;
+}
+
 /******************************************************************************
  * Subroutine permute_evecs- This routine permutes a set of vectors according
  *            to a permutation array perm. It is supposed to be called on 
@@ -272,17 +597,22 @@ int solve_H_dprimme(double *H, double *hVecs, double *hVals,
  *       should be the perm[i]-th vector from the original ordering.
  * evecs  The eigenvectors to be put in sorted order.
  *
+ * Return value
+ * ------------
+ * The number of vectors copied, counting those copied to and from rwork
  ******************************************************************************/
      
-void permute_evecs_dprimme(double *evecs, int *perm, double *rwork, int nev, 
+int permute_evecs_dprimme(double *evecs, int *perm, double *rwork, int nev, 
    int nLocal) {
 
    int currentIndex;     /* Index of eigenvector in sorted order              */
    int sourceIndex;      /* Position of out-of-order vector in original order */
    int destinationIndex; /* Position of out-of-order vector in sorted order   */
    int tempIndex;        /* Used to swap                                      */
+   int numCopies;        /* Number of vectors copied                          */
    
    currentIndex = 0;
+   numCopies = 0;
 
    /* Continue until all eigenvectors are in the sorted order */
 
@@ -295,11 +625,12 @@ void permute_evecs_dprimme(double *evecs, int *perm, double *rwork, int nev,
 
       /* Return if they are in the sorted order */
       if (currentIndex >= nev) {
-         return;
+         return numCopies;
       }
 
       /* Copy the vector to a buffer for swapping */
       Num_dcopy_primme(nLocal, &evecs[currentIndex*nLocal], 1, rwork, 1);
+      numCopies++;
 
       destinationIndex = currentIndex;
       /* Copy vector perm[destinationIndex] into position destinationIndex */
@@ -309,6 +640,7 @@ void permute_evecs_dprimme(double *evecs, int *perm, double *rwork, int nev,
          sourceIndex = perm[destinationIndex];
          Num_dcopy_primme(nLocal, &evecs[sourceIndex*nLocal], 1, 
             &evecs[destinationIndex*nLocal], 1);
+         numCopies++;
          tempIndex = perm[destinationIndex];
          perm[destinationIndex] = destinationIndex;
          destinationIndex = tempIndex;
@@ -316,6 +648,7 @@ void permute_evecs_dprimme(double *evecs, int *perm, double *rwork, int nev,
 
       /* Copy the vector from the buffer to where it belongs */
       Num_dcopy_primme(nLocal, rwork, 1, &evecs[destinationIndex*nLocal], 1);
+      numCopies++;
       perm[destinationIndex] = destinationIndex;
 
       currentIndex++;
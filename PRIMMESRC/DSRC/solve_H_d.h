@@ -29,11 +29,11 @@
 #ifndef SOLVE_H_H
 #define SOLVE_H_H
 
-int solve_H_dprimme(double *H, double *hVecs, double *hVals, 
+int solve_H_dprimme(double *H, double *WtW, double *hVecs, double *hVals, 
    int basisSize, int maxBasisSize, double *largestEval, int numLocked,
    int lrwork, double *rwork, int *perm, primme_params *primme);
 
-void permute_evecs_dprimme(double *evecs, int *perm, double *rwork, 
+int permute_evecs_dprimme(double *evecs, int *perm, double *rwork, 
    int nev, int nLocal);
 
 
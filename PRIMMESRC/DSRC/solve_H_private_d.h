@@ -31,9 +31,16 @@
 
 #ifdef NUM_ESSL
 #define NUM_DSPEV_FAILURE -1
-#else
-#define NUM_DSYEV_FAILURE -1
 #endif
+#define NUM_DSYEV_FAILURE -1
+
+static int solve_H_harmonic(double *H, double *WtW, double *hVecs, 
+   double *hVals, int basisSize, int maxBasisSize, double targetShift,
+   int lrwork, double *rwork, int *iwork, primme_params *primme);
+
+static int solve_H_refined(double *H, double *WtW, double *hVecs, 
+   double *hVals, int basisSize, int maxBasisSize, double targetShift,
+   int lrwork, double *rwork, int *iwork, primme_params *primme);
 
 #endif
 
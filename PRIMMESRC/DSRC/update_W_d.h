@@ -33,4 +33,10 @@
 void update_W_dprimme(double *V, double *W, int basisSize, int blockSize,
    primme_params *primme);
 
+void update_W_begin_dprimme(double *V, double *W, int basisSize, 
+   int blockSize, primme_params *primme);
+
+void update_W_end_dprimme(double *V, double *W, int basisSize, 
+   int blockSize, primme_params *primme);
+
 #endif
@@ -30,6 +30,7 @@
 #include "primme.h"
 #include "const.h"
 #include "update_projection_d.h"
+#include "update_projection_private_d.h"
 #include "numerical_d.h"
 
 /*******************************************************************************
@@ -48,33 +49,28 @@
  * 
  * INPUT/OUTPUT ARRAYS
  * -------------------
- * Z      X'*Y where Y is some nLocal x numCols matrix.
- * rwork  Must be at least maxCols*blockSize in length
+ * Z      X'*Y where Y is some nLocal x numCols matrix. Only the first
+ *        numCols+blockSize rows of the new columns are written.
+ * rwork  Must be at least (numCols+blockSize)*blockSize in length
  ******************************************************************************/
 
 void update_projection_dprimme(double *X, double *Y, double *Z, 
    int numCols, int maxCols, int blockSize, double *rwork, 
    primme_params *primme) {
 
-   int j;    /* Loop variable  */ 
+   int m = numCols+blockSize;    /* Rows of the new columns */
    int count;
    double tpone = +1.0e+00, tzero = +0.0e+00;
 
    /* --------------------------------------------------------------------- */
-   /* Zero the work array to prevent floating point traps during all-reduce */
+   /* Grow Z by blockSize number of rows and columns all at once. The new   */
+   /* columns are computed with leading dimension m, so that only their m   */
+   /* rows are summed, and then they are spread out in Z                    */
    /* --------------------------------------------------------------------- */
 
-   for (j = 0; j < maxCols*blockSize; j++) {
-      rwork[j] = tzero;
-   }
-
-   /* --------------------------------------------------------------------- */
-   /* Grow Z by blockSize number of rows and columns all at once            */
-   /* --------------------------------------------------------------------- */
-
-   Num_gemm_dprimme("C", "N", numCols+blockSize, blockSize, primme->nLocal, tpone, 
+   Num_gemm_dprimme("C", "N", m, blockSize, primme->nLocal, tpone, 
       X, primme->nLocal, &Y[primme->nLocal*numCols], primme->nLocal, 
-      tzero, rwork, maxCols);
+      tzero, rwork, m);
 
    /* -------------------------------------------------------------- */
    /* Alternative to the previous call:                              */
@@ -86,10 +82,104 @@ void update_projection_dprimme(double *X, double *Y, double *Z,
    for (j = numCols; j < numCols+blockSize; j++) {
       Num_gemv_dprimme("C", primme->nLocal, j-numCols+1, tpone,
          &X[primme->nLocal*numCols], primme->nLocal, &Y[primme->nLocal*j], 1, 
-         tzero, &rwork[maxCols*(j-numCols)+numCols], 1);  
+         tzero, &rwork[m*(j-numCols)+numCols], 1);  
    }
    */
    
-   count = maxCols*blockSize;
-   (*primme->globalSumDouble)(rwork, &Z[maxCols*numCols], &count, primme);
+   count = m*blockSize;
+   primme_globalSumDouble(rwork, &Z[maxCols*numCols], &count, primme);
+   spread_columns(&Z[maxCols*numCols], m, maxCols, blockSize);
+}
+
+/*******************************************************************************
+ * Subroutine update_projection_begin - First half of update_projection for 
+ *    H = V'*W, with W = A*V and A hermitian, that does not need the new 
+ *    columns of W. It is called while W(:,numCols:numCols+blockSize-1) is 
+ *    being computed by a split-phase matvec (see update_W_begin). 
+ *    As A is hermitian, the rows of the new columns against the previous 
+ *    basis, V(:,0:numCols-1)'*A*V(:,numCols:), are computed locally as 
+ *    W(:,0:numCols-1)'*V(:,numCols:).
+ *
+ * INPUT ARRAYS AND PARAMETERS
+ * ---------------------------
+ * V             The basis, with the new blockSize vectors
+ * W             A*V for the first numCols vectors
+ * numCols       Number of rows and columns in H
+ * maxCols       Maximum (leading) dimension of H
+ * blockSize     Number of rows and columns to be added to H
+ * 
+ * OUTPUT ARRAYS
+ * -------------
+ * rwork  The local rows of the new columns. Must be at least 
+ *        (numCols+blockSize)*blockSize in length and passed unchanged to 
+ *        update_projection_end.
+ ******************************************************************************/
+
+void update_projection_begin_dprimme(double *V, double *W, int numCols, 
+   int maxCols, int blockSize, double *rwork, primme_params *primme) {
+
+   double tpone = +1.0e+00, tzero = +0.0e+00;
+
+   if (numCols > 0) {
+      Num_gemm_dprimme("C", "N", numCols, blockSize, primme->nLocal, tpone, 
+         W, primme->nLocal, &V[primme->nLocal*numCols], primme->nLocal, 
+         tzero, rwork, numCols+blockSize);
+   }
+}
+
+/*******************************************************************************
+ * Subroutine update_projection_end - Completes update_projection_begin once
+ *    the new columns of W are available: computes the new diagonal block 
+ *    V(:,numCols:)'*W(:,numCols:) and sums the new columns over all 
+ *    processes into H.
+ *
+ * INPUT ARRAYS AND PARAMETERS
+ * ---------------------------
+ * V, W, numCols, maxCols, blockSize  As in update_projection_begin
+ * 
+ * INPUT/OUTPUT ARRAYS
+ * -------------------
+ * rwork  As left by update_projection_begin
+ * H      V'*W with the new blockSize columns
+ ******************************************************************************/
+
+void update_projection_end_dprimme(double *V, double *W, double *H, 
+   int numCols, int maxCols, int blockSize, double *rwork, 
+   primme_params *primme) {
+
+   int m = numCols+blockSize;    /* Rows of the new columns */
+   int count;
+   double tpone = +1.0e+00, tzero = +0.0e+00;
+
+   Num_gemm_dprimme("C", "N", blockSize, blockSize, primme->nLocal, tpone, 
+      &V[primme->nLocal*numCols], primme->nLocal, &W[primme->nLocal*numCols],
+      primme->nLocal, tzero, &rwork[numCols], m);
+
+   count = m*blockSize;
+   primme_globalSumDouble(rwork, &H[maxCols*numCols], &count, primme);
+   spread_columns(&H[maxCols*numCols], m, maxCols, blockSize);
+}
+
+
+/*******************************************************************************
+ * Subroutine spread_columns - Moves in place the n columns of Z stored with
+ *    leading dimension m to leading dimension ldZ >= m. The last column is
+ *    moved first and its last element first, so no element is overwritten
+ *    before it is moved. The rows m to ldZ-1 of the first n-1 columns keep
+ *    whatever the packed copy left there: the reduction into Z writes the
+ *    m*n packed values over them. The callers pass m = numCols+blockSize,
+ *    so those rows are in the strictly lower triangle of the new columns,
+ *    which is never read, and they need not be zeroed.
+ ******************************************************************************/
+
+static void spread_columns(double *Z, int m, int ldZ, int n) {
+
+   int i, j;
+
+   if (m == ldZ) return;
+   for (j = n-1; j > 0; j--) {
+      for (i = m-1; i >= 0; i--) {
+         Z[ldZ*j+i] = Z[m*j+i];
+      }
+   }
 }
@@ -34,4 +34,11 @@ void update_projection_dprimme(double *X, double *Y, double *Z,
    int numCols, int maxCols, int blockSize, double *rwork, 
    primme_params *primme);
 
+void update_projection_begin_dprimme(double *V, double *W, int numCols, 
+   int maxCols, int blockSize, double *rwork, primme_params *primme);
+
+void update_projection_end_dprimme(double *V, double *W, double *H, 
+   int numCols, int maxCols, int blockSize, double *rwork, 
+   primme_params *primme);
+
 #endif
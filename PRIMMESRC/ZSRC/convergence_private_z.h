@@ -29,6 +29,9 @@
 #ifndef CONVERGENCE_PRIVATE_H
 #define CONVERGENCE_PRIVATE_H
 
+#define LOCK_STORE_FAILURE -1
+#define BLOCK_MAP_FAILURE  -2
+
 static void compute_resnorms(Complex_Z *V, Complex_Z *W, Complex_Z *hVecs, 
    double *hVals, int basisSize, double *blockNorms, int *iev, int left,
    int right, void *rwork, primme_params *primme);
@@ -37,17 +40,20 @@ static void print_residuals(double *ritzValues, double *blockNorms,
    int numConverged, int numLocked, int *iev, int left, int right, 
    primme_params *primme);
 
-static void swap_UnconvVecs(Complex_Z *V, Complex_Z *W, int nLocal, 
-   int basisSize, int *iev, int *flag, double *blockNorms, int dimEvecs, 
-   int blockSize, int left);
+static void swap_UnconvVecs(int *blockMap, int *iev, int *flag, 
+   double *blockNorms, int blockSize, int left);
+
+static int gather_block(Complex_Z *V, Complex_Z *W, int basisSize, 
+   int blockSize, int *blockMap, int *iev, int *flag, double *blockNorms,
+   int first, int last, primme_params *primme);
 
 static void replace_vectors(int *iev, int *flag, int blockSize, int basisSize,
    int numVacancies, int *left, int *right, int *ievMax);
 
-static void check_practical_convergence(Complex_Z *V, Complex_Z *W, 
+static int check_practical_convergence(Complex_Z *V, Complex_Z *W, 
   Complex_Z *evecs, int numLocked, int basisSize, int blockSize, int start, 
-  int numToProject, int *iev, int *flags, double *blockNorms, double tol, 
-  int *recentlyConverged, int *numVacancies, Complex_Z *rwork, 
+  int numToProject, int *iev, int *flags, double *blockNorms, int *blockMap,
+  double tol, int *recentlyConverged, int *numVacancies, Complex_Z *rwork, 
   primme_params *primme);
 
 #endif /* CONVERGENCE_PRIVATE_H */
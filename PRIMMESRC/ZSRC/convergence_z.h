@@ -33,6 +33,6 @@ int check_convergence_zprimme(Complex_Z *V, Complex_Z *W, Complex_Z *hVecs,
    double *hVals, int *flags, int basisSize, int *iev, int *ievMax, 
    double *blockNorms, int *blockSize, int numConverged, int numLocked, 
    Complex_Z *evecs, double tol, double maxConvTol, double aNormEstimate, 
-   Complex_Z *rwork, primme_params *primme);
+   Complex_Z *rwork, int *iwork, primme_params *primme);
 
 #endif
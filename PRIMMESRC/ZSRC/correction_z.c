@@ -715,7 +715,7 @@ static void Olsen_preconditioner_block(Complex_Z *r, Complex_Z *x,
                                    &r[primme->nLocal*blockIndex],1);
    }      
    count = 4*blockSize;
-   (*primme->globalSumDouble)(xKinvx_local, xKinvx, &count, primme);
+   primme_globalSumDouble(xKinvx_local, xKinvx, &count, primme);
 
    /*------------------------------------------------------------------*/
    /* Compute K^{-1}r                                                  */
@@ -903,7 +903,7 @@ static void setup_JD_projectors(Complex_Z *x, Complex_Z *r, Complex_Z *evecs,
          primme->stats.numPreconds += 1;
          *RprojectorX  = Kinvx;
          xKinvx_local = Num_dot_zprimme(primme->nLocal, x, 1, Kinvx, 1);
-         (*primme->globalSumDouble)(&xKinvx_local, xKinvx, &count, primme);
+         primme_globalSumDouble(&xKinvx_local, xKinvx, &count, primme);
       }      
       else {
          *RprojectorX = x;
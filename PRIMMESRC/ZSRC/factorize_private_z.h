@@ -0,0 +1,41 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ * File: factorize_private.h
+ *
+ * Purpose - Definitions used exclusively by factorize.c
+ *
+ ******************************************************************************/
+
+#ifndef FACTORIZE_PRIVATE_H
+#define FACTORIZE_PRIVATE_H
+
+/* Bound of the multipliers in L with Bunch-Kaufman pivoting, 1/(1-alpha) */
+/* where alpha = (1+sqrt(17))/8                                           */
+#define UDU_MAX_MULTIPLIER 2.7808
+
+static int refactorize(int dimOld, int dimNew);
+
+static int append_row(Complex_Z *M, Complex_Z *UDU, int *ipivot, int k, 
+   int ldM, Complex_Z *y);
+
+#endif
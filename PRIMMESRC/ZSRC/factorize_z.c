@@ -32,11 +32,15 @@
 #include "primme.h"
 #include "factorize_z.h"
 #include "numerical_z.h"
+#include "factorize_private_z.h"
 
 /******************************************************************************
  * Function UDUDecompose - This function computes an UDU decomposition of the
- *   matrix M.  See LAPACK routine dsytrf for more information on how the
- *   decomposition is performed.
+ *   matrix M.  See LAPACK routine zhetrf for more information on how the
+ *   decomposition is performed. The factorization is stored in the lower
+ *   triangular form (M = L*D*L^H) with leading dimension 
+ *   numOrthoConst+numEvals, so that UDUAppend can later border it with new
+ *   rows and columns of M.
  *
  *
  * Input Parameters
@@ -53,7 +57,8 @@
  *
  * Output Parameters
  * -----------------
- * UDU  Array of dimension dimM x dimM containing the UDU decomposition of M.
+ * UDU  Array of dimension dimM x dimM and leading dimension 
+ *      numOrthoConst+numEvals containing the UDU decomposition of M.
  *
  * ipivot  Integer array of length dimM containing pivot mapping
  *
@@ -61,7 +66,7 @@
  * Return Value
  * ------------
  * int error code: 0 upon success
- *                 dsytrf error code
+ *                 zhetrf error code
  ******************************************************************************/
  
 int UDUDecompose_zprimme(Complex_Z *M, Complex_Z *UDU, int *ipivot, int dimM, 
@@ -69,30 +74,234 @@ int UDUDecompose_zprimme(Complex_Z *M, Complex_Z *UDU, int *ipivot, int dimM,
 
    int i, j;
    int info;
+   int ldM;
+
+   ldM = primme->numOrthoConst+primme->numEvals;
 
    /* Quick return for M of dimension 1 */
 
    if (dimM <= 1) {
-      *UDU = *M;
+      if (dimM == 1) {
+         *UDU = *M;
+         *ipivot = 1;
+      }
       info = 0;
    }
    else {
 
-      /* Copy the upper triangular portion of M into UDU */
+      /* Copy the upper triangular portion of M into the lower one of UDU */
 
       for (j = 0; j < dimM; j++) {
          for (i = 0; i <= j; i++) {
-            UDU[dimM*j+i] = M[(primme->numOrthoConst+primme->numEvals)*j+i];
+            UDU[ldM*i+j].r = M[ldM*j+i].r;
+            UDU[ldM*i+j].i = -M[ldM*j+i].i;
          }
       }
 
       /* Perform the decomposition */
-      Num_zhetrf_zprimme("U", dimM, UDU, dimM, ipivot, rwork, rworkSize, &info);
+      Num_zhetrf_zprimme("L", dimM, UDU, ldM, ipivot, rwork, rworkSize, &info);
    }
 
    return info;
 }
 
+/******************************************************************************
+ * Function UDUAppend - This function extends the UDU decomposition of the
+ *   leading dimM x dimM block of M to its leading (dimM+numNew) block,
+ *   where the new rows and columns of M have been already computed (e.g. by
+ *   update_projection). Every new column b with diagonal c borders the
+ *   factorization as
+ *
+ *      [ M  b ]   [ L  0 ] [ D  0 ] [ L'  x ]
+ *      [ b' c ] = [ x' 1 ] [ 0  d ] [ 0   1 ],   x = D^{-1}L^{-1}b, d = c-x'Dx
+ *
+ *   at O(dimM^2) cost instead of the O(dimM^3) of UDUDecompose. The pivots
+ *   of the existing factorization are not revised, so the whole matrix is
+ *   refactorized with UDUDecompose if the new row of L grows beyond the
+ *   bound that Bunch-Kaufman pivoting guarantees, or if d is zero. As a
+ *   periodic guard, M is also refactorized every time its dimension reaches
+ *   a power of two, which keeps the overall cost of factorizing M as it
+ *   grows to n columns in O(n^3).
+ *
+ *
+ * Input Parameters
+ * ----------------
+ * M      As in UDUDecompose
+ *
+ * dimM   The dimension of the current factorization in UDU
+ *
+ * numNew The number of rows and columns to append
+ *
+ * rwork  Work array of dimension at least dimM+numNew
+ *
+ *
+ * Input/Output Parameters
+ * -----------------------
+ * UDU, ipivot  As in UDUDecompose. On output, they hold the decomposition 
+ *              of the leading (dimM+numNew) block of M
+ *
+ *
+ * Return Value
+ * ------------
+ * int error code: 0 upon success
+ *                 zhetrf error code
+ ******************************************************************************/
+
+int UDUAppend_zprimme(Complex_Z *M, Complex_Z *UDU, int *ipivot, int dimM, 
+   int numNew, Complex_Z *rwork, int rworkSize, primme_params *primme) {
+
+   int k;
+   int ldM;
+
+   ldM = primme->numOrthoConst+primme->numEvals;
+
+   if (numNew <= 0) {
+      return 0;
+   }
+
+   if (!refactorize(dimM, dimM+numNew) && rworkSize >= dimM+numNew) {
+      for (k = dimM; k < dimM+numNew; k++) {
+         if (append_row(M, UDU, ipivot, k, ldM, rwork) != 0) break;
+      }
+      if (k == dimM+numNew) {
+         return 0;
+      }
+   }
+
+   return UDUDecompose_zprimme(M, UDU, ipivot, dimM+numNew, rwork, rworkSize,
+      primme);
+}
+
+/******************************************************************************
+ * Function refactorize - Returns whether M of dimension dimOld is refactorized
+ *    from scratch when it grows to dimension dimNew, that is, when the 
+ *    dimension reaches a power of two.
+ *
+ ******************************************************************************/
+
+static int refactorize(int dimOld, int dimNew) {
+
+   int powerOfTwo = 1;
+
+   while (powerOfTwo <= dimOld) {
+      powerOfTwo *= 2;
+   }
+
+   return dimNew >= powerOfTwo;
+}
+
+/******************************************************************************
+ * Function append_row - Extends the UDU decomposition of the leading k x k 
+ *    block of M with the row and column k. See UDUAppend.
+ *
+ * Input Parameters
+ * ----------------
+ * M       As in UDUDecompose
+ *
+ * k       The dimension of the current factorization in UDU
+ *
+ * ldM     The leading dimension of M and UDU
+ *
+ * y       Work array of size k
+ *
+ * Input/Output Parameters
+ * -----------------------
+ * UDU, ipivot  The decomposition of M, to be extended by one row and column
+ *
+ * Return Value
+ * ------------
+ * 0 upon success, 1 if the new row is unstable and M must be refactorized
+ ******************************************************************************/
+
+static int append_row(Complex_Z *M, Complex_Z *UDU, int *ipivot, int k, 
+   int ldM, Complex_Z *y) {
+
+   int i, p;
+   double a, f;         /* The 2x2 block [a e'; e f] of D */
+   Complex_Z e;
+   double det;
+   Complex_Z x0, x1, t0, t1, tmp;
+   double d;            /* The new pivot */
+   double maxMult;      /* The largest new multiplier in absolute value */
+
+   /* y = L^{-1}b, applying the interchanges and transformations of L */
+   /* in the same order as zhetrs                                     */
+
+   for (i = 0; i < k; i++) {
+      y[i] = M[ldM*k+i];
+   }
+
+   p = 0;
+   while (p < k) {
+      if (ipivot[p] > 0) {
+         tmp = y[p]; y[p] = y[ipivot[p]-1]; y[ipivot[p]-1] = tmp;
+         for (i = p+1; i < k; i++) {
+            zz_mult_primme(t0, UDU[ldM*p+i], y[p]);
+            z_sub_primme(y[i], y[i], t0);
+         }
+         p++;
+      }
+      else {
+         tmp = y[p+1]; y[p+1] = y[-ipivot[p]-1]; y[-ipivot[p]-1] = tmp;
+         for (i = p+2; i < k; i++) {
+            zz_mult_primme(t0, UDU[ldM*p+i], y[p]);
+            zz_mult_primme(t1, UDU[ldM*(p+1)+i], y[p+1]);
+            z_add_primme(t0, t0, t1);
+            z_sub_primme(y[i], y[i], t0);
+         }
+         p += 2;
+      }
+   }
+
+   /* x = D^{-1}y, the new row of L is conj(x), and d = c - x'*y */
+
+   d = M[ldM*k+k].r;
+   maxMult = 0.0;
+   p = 0;
+   while (p < k) {
+      if (ipivot[p] > 0) {
+         zd_mult_primme(x0, y[p], 1.0L/UDU[ldM*p+p].r);
+         UDU[ldM*p+k].r = x0.r;
+         UDU[ldM*p+k].i = -x0.i;
+         d -= x0.r*y[p].r + x0.i*y[p].i;
+         maxMult = max(maxMult, z_abs_primme(x0));
+         p++;
+      }
+      else {
+         a = UDU[ldM*p+p].r;
+         e = UDU[ldM*p+p+1];
+         f = UDU[ldM*(p+1)+p+1].r;
+         det = a*f - (e.r*e.r + e.i*e.i);
+         /* x0 = (f*y0 - e'*y1)/det, x1 = (a*y1 - e*y0)/det */
+         zconjz_mult_primme(t0, e, y[p+1]);
+         zd_mult_primme(x0, y[p], f);
+         z_sub_primme(x0, x0, t0);
+         zd_mult_primme(x0, x0, 1.0L/det);
+         zz_mult_primme(t1, e, y[p]);
+         zd_mult_primme(x1, y[p+1], a);
+         z_sub_primme(x1, x1, t1);
+         zd_mult_primme(x1, x1, 1.0L/det);
+         UDU[ldM*p+k].r = x0.r;
+         UDU[ldM*p+k].i = -x0.i;
+         UDU[ldM*(p+1)+k].r = x1.r;
+         UDU[ldM*(p+1)+k].i = -x1.i;
+         d -= x0.r*y[p].r + x0.i*y[p].i + x1.r*y[p+1].r + x1.i*y[p+1].i;
+         maxMult = max(maxMult, max(z_abs_primme(x0), z_abs_primme(x1)));
+         p += 2;
+      }
+   }
+
+   if (maxMult > UDU_MAX_MULTIPLIER || d == 0.0) {
+      return 1;
+   }
+
+   UDU[ldM*k+k].r = d;
+   UDU[ldM*k+k].i = 0.0L;
+   ipivot[k] = k+1;
+
+   return 0;
+}
+
 /******************************************************************************
  * Function UDUSolve - This function solves a dense hermitian linear system
  *   given a right hand side (rhs) and a UDU factorization.
@@ -100,10 +309,10 @@ int UDUDecompose_zprimme(Complex_Z *M, Complex_Z *UDU, int *ipivot, int dimM,
  *
  * Input Parameters
  * ----------------
- * UDU     Two-dimensional of dimension dim and leading dimension dim.
- *         Contains block diagonal and multipliers necessary to construct
- *         the upper triangular matrix U.  See LAPACK routine dsytrf for more
- *         details.
+ * UDU     Two-dimensional of dimension dim and leading dimension 
+ *         numOrthoConst+numEvals. Contains block diagonal and multipliers
+ *         necessary to construct the lower triangular matrix L.  See LAPACK
+ *         routine zhetrf for more details.
  *
  * ipivot  Permutation array that determines how rows and columns of the
  *         factorization were permuted for stability.
@@ -122,7 +331,7 @@ int UDUDecompose_zprimme(Complex_Z *M, Complex_Z *UDU, int *ipivot, int dimM,
  ******************************************************************************/
 
 int UDUSolve_zprimme(Complex_Z *UDU, int *ipivot, int dim, Complex_Z *rhs, 
-   Complex_Z *sol) {
+   Complex_Z *sol, primme_params *primme) {
 
    int info;
 
@@ -132,7 +341,8 @@ int UDUSolve_zprimme(Complex_Z *UDU, int *ipivot, int dim, Complex_Z *rhs,
    }
    else {
       Num_zcopy_zprimme(dim, rhs, 1, sol, 1);
-      Num_zhetrs_zprimme("U", dim, 1, UDU, dim, ipivot, sol, dim, &info);
+      Num_zhetrs_zprimme("L", dim, 1, UDU, 
+         primme->numOrthoConst+primme->numEvals, ipivot, sol, dim, &info);
    }
 
    return info;
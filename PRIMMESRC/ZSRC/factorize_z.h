@@ -32,8 +32,11 @@
 int UDUDecompose_zprimme(Complex_Z *M, Complex_Z *UDU, int *ipivot, int dimM, 
    Complex_Z *rwork, int rworkSize, primme_params *primme);
 
+int UDUAppend_zprimme(Complex_Z *M, Complex_Z *UDU, int *ipivot, int dimM, 
+   int numNew, Complex_Z *rwork, int rworkSize, primme_params *primme);
+
 int UDUSolve_zprimme(Complex_Z *UDU, int *ipivot, int dim, Complex_Z *rhs,
-   Complex_Z *sol);
+   Complex_Z *sol, primme_params *primme);
 
 
 #endif
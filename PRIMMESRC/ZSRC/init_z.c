@@ -72,6 +72,11 @@
  *        A Krylov subspace of dimension restartSize - initSize vectors
  *        is created so that restartSize initial vectors will be available.
  * 
+ * In both cases, the extra Ritz vectors kept by the previous call (see
+ * primme.continuationParams) follow the initial guesses in V, up to 
+ * minRestartSize vectors. Guesses and extra vectors are orthonormalized
+ * together and multiplied by A with a single call to matrixMatvec.
+ *
  *
  * INPUT ARRAYS AND PARAMETERS
  * ---------------------------
@@ -79,6 +84,10 @@
  *            guesses. Holds as many as primme->numOrthoConst + primme->numEvals
  *            vectors.
  *
+ * extra      The extra Ritz vectors carried from the previous call
+ *
+ * numExtra   The number of vectors in extra
+ *
  * machEps    double machine precision
  * 
  * rwork      Double precision work array needed by other subroutines called
@@ -100,7 +109,8 @@
  * *numGuesses  When locking is enabled, the number of remaining initial guesses
  * 
  * *timeForMV   Time estimate for applying the matvec operator.
- *              Measured only if primme.dynamicMethodSwitch is on.
+ *              Measured only if primme.dynamicMethodSwitch is on and
+ *              timeForMV is not NULL.
  *
  * INPUT/OUTPUT ARRAYS AND PARAMETERS
  * ----------------------------------
@@ -128,7 +138,7 @@
  ******************************************************************************/
 
 int init_basis_zprimme(Complex_Z *V, Complex_Z *W, Complex_Z *evecs, 
-   Complex_Z *evecsHat, Complex_Z *M, Complex_Z *UDU, int *ipivot, 
+   Complex_Z *extra, int numExtra, Complex_Z *evecsHat, Complex_Z *M, Complex_Z *UDU, int *ipivot, 
    double machEps,  Complex_Z *rwork, int rworkSize, int *basisSize, 
    int *nextGuess, int *numGuesses, double *timeForMV,
    primme_params *primme) {
@@ -189,8 +199,11 @@ int init_basis_zprimme(Complex_Z *V, Complex_Z *W, Complex_Z *evecs,
    /*-----------------------------------------------------------------------*/
    if (!primme->locking) {
 
+      numExtra = min(numExtra, max(0, primme->minRestartSize-primme->initSize));
+      currentSize = primme->initSize + numExtra;
+
       /* Handle case when no initial guesses are provided by the user */
-      if (primme->initSize == 0) {
+      if (currentSize == 0) {
 
          ret = init_block_krylov(V, W, 0, primme->minRestartSize - 1, evecs, 
             primme->numOrthoConst, machEps, rwork, rworkSize, primme); 
@@ -207,15 +220,20 @@ int init_basis_zprimme(Complex_Z *V, Complex_Z *W, Complex_Z *evecs,
       }
       else {
       /* Handle case when some or all initial guesses are provided by */ 
-      /* the user                                                     */
+      /* the user or kept from the previous call                      */
 
-         /* Copy over the initial guesses provided by the user */
+         /* Copy over the initial guesses provided by the user and the */
+         /* extra Ritz vectors after them                              */
          Num_zcopy_zprimme(primme->nLocal*primme->initSize, 
             &evecs[primme->numOrthoConst*primme->nLocal], 1, V, 1);
+         Num_zcopy_zprimme(primme->nLocal*numExtra, extra, 1,
+            &V[primme->nLocal*primme->initSize], 1);
+         primme->stats.bytesMoved += 
+            (double)primme->nLocal*(primme->initSize+numExtra)*sizeof(Complex_Z);
 
-         /* Orthonormalize the guesses provided by the user */ 
+         /* Orthonormalize the guesses */ 
 
-         ret = ortho_zprimme(V, primme->nLocal, 0, primme->initSize-1, 
+         ret = ortho_zprimme(V, primme->nLocal, 0, currentSize-1, 
             evecs, primme->nLocal, primme->numOrthoConst, primme->nLocal, 
             primme->iseed, machEps, rwork, rworkSize, primme);
 
@@ -226,15 +244,15 @@ int init_basis_zprimme(Complex_Z *V, Complex_Z *W, Complex_Z *evecs,
             return ORTHO_FAILURE;
          }
 
-         update_W_zprimme(V, W, 0, primme->initSize, primme);
+         update_W_zprimme(V, W, 0, currentSize, primme);
 
          /* An insufficient number of initial guesses were provided by */
          /* the user.  Generate a block Krylov space to fill the       */
          /* remaining vacancies.                                       */
 
-         if (primme->initSize < primme->minRestartSize) {
+         if (currentSize < primme->minRestartSize) {
 
-            ret = init_block_krylov(V, W, primme->initSize, 
+            ret = init_block_krylov(V, W, currentSize, 
                primme->minRestartSize - 1, evecs, primme->numOrthoConst, 
                machEps, rwork, rworkSize, primme);
 
@@ -248,7 +266,7 @@ int init_basis_zprimme(Complex_Z *V, Complex_Z *W, Complex_Z *evecs,
             *basisSize = primme->minRestartSize;
          }
          else {
-            *basisSize = primme->initSize;
+            *basisSize = currentSize;
          }
 
       }
@@ -269,10 +287,19 @@ int init_basis_zprimme(Complex_Z *V, Complex_Z *W, Complex_Z *evecs,
       /* and orthogonalize them against themselves and the orthogonalization */
       /* constraints.                                                        */
 
-      if (primme->initSize > 0) {
-         currentSize = min(primme->initSize, primme->minRestartSize);
+      currentSize = min(primme->initSize, primme->minRestartSize);
+      numExtra = min(numExtra, primme->minRestartSize - currentSize);
+
+      if (currentSize + numExtra > 0) {
          Num_zcopy_zprimme(primme->nLocal*currentSize, 
             &evecs[primme->numOrthoConst*primme->nLocal], 1, V, 1);
+         Num_zcopy_zprimme(primme->nLocal*numExtra, extra, 1,
+            &V[primme->nLocal*currentSize], 1);
+         primme->stats.bytesMoved += 
+            (double)primme->nLocal*(currentSize+numExtra)*sizeof(Complex_Z);
+         *numGuesses = *numGuesses - currentSize;
+         *nextGuess = *nextGuess + currentSize;
+         currentSize = currentSize + numExtra;
 
          ret = ortho_zprimme(V, primme->nLocal, 0, currentSize-1, evecs,
             primme->nLocal, primme->numOrthoConst, primme->nLocal,
@@ -285,13 +312,8 @@ int init_basis_zprimme(Complex_Z *V, Complex_Z *W, Complex_Z *evecs,
          }
       
          update_W_zprimme(V, W, 0, currentSize, primme);
-         *numGuesses = *numGuesses - currentSize;
-         *nextGuess = *nextGuess + currentSize;
          
       }
-      else {
-         currentSize = 0;
-      }
 
       /* If an insufficient number of guesses was provided, then fill */
       /* the remaining vacancies with a block Krylov space.           */
@@ -316,12 +338,12 @@ int init_basis_zprimme(Complex_Z *V, Complex_Z *W, Complex_Z *evecs,
    /* If time measurements are needed, waste one MV + one Precond */
    /* Put dummy results in the first open space of W (currentSize)*/
    /* ----------------------------------------------------------- */
-   if (primme->dynamicMethodSwitch) {
+   if (primme->dynamicMethodSwitch && timeForMV != NULL) {
       currentSize = primme->nLocal*(*basisSize);
       ret = 1;
-      *timeForMV = primme_wTimer(0);
+      *timeForMV = ELAPSED_TIME(primme);
        (*primme->matrixMatvec)(V, &W[currentSize], &ret, primme);
-      *timeForMV = primme_wTimer(0) - *timeForMV;
+      *timeForMV = ELAPSED_TIME(primme) - *timeForMV;
       primme->stats.numMatvecs += 1;
    }
       
@@ -331,7 +353,10 @@ int init_basis_zprimme(Complex_Z *V, Complex_Z *W, Complex_Z *evecs,
 
 /*******************************************************************************
  * Subroutine init_block_krylov - Initializes the basis as an orthonormal 
- *    block Krylov subspace.  
+ *    block Krylov subspace. Every step multiplies the last block by A with
+ *    a single call to matrixMatvec and orthogonalizes the new block at once.
+ *    If primme->initFilterDegree > 0, the random initial block is first
+ *    passed through a Chebyshev filter (see chebyshev_filter).
  *
  * INPUT ARRAYS AND PARAMETERS
  * ---------------------------
@@ -367,8 +392,9 @@ static int init_block_krylov(Complex_Z *V, Complex_Z *W, int dv1, int dv2,
 
    int i;               /* Loop variables */
    int numNewVectors;   /* Number of vectors to be generated */
+   int blockSize;       /* Number of vectors of the Krylov blocks */
+   int m;               /* Number of vectors generated in a step */
    int ret;             /* Return code.                      */  
-   int ONE = 1;         /* Used for passing it by reference in matrixmatvec */
    
    numNewVectors = dv2 - dv1 + 1;
 
@@ -378,79 +404,236 @@ static int init_block_krylov(Complex_Z *V, Complex_Z *W, int dv1, int dv2,
    /* primme->maxBlockSize as the block Size.                              */ 
    /*----------------------------------------------------------------------*/
 
-   if (numNewVectors <= primme->maxBlockSize) {
+   blockSize = numNewVectors <= primme->maxBlockSize ? 1 : primme->maxBlockSize;
 
-      /* Create and orthogonalize the inital vectors */
+   /*----------------------------------------------------------------------*/
+   /* Generate the initial vectors.                                        */
+   /*----------------------------------------------------------------------*/
+
+   Num_larnv_zprimme(2, primme->iseed, primme->nLocal*blockSize,
+      &V[primme->nLocal*dv1]);
+   if (primme->initFilterDegree > 0) {
+      chebyshev_filter(V, W, dv1, blockSize, machEps, primme);
+   }
+   ret = ortho_zprimme(V, primme->nLocal, dv1, dv1+blockSize-1, locked, 
+      primme->nLocal, numLocked, primme->nLocal, primme->iseed, machEps, 
+      rwork, rworkSize, primme);
+
+   if (ret < 0) {
+      primme_PushErrorMessage(Primme_init_block_krylov, Primme_ortho, ret, 
+         __FILE__, __LINE__, primme);
+      return ORTHO_FAILURE;
+   }
 
-      Num_larnv_zprimme(2, primme->iseed,primme->nLocal,&V[primme->nLocal*dv1]);
-      ret = ortho_zprimme(V, primme->nLocal, dv1, dv1, locked, 
-         primme->nLocal, numLocked, primme->nLocal, primme->iseed, machEps, 
+   /* Generate the remaining vectors in the sequence, a block at a time. */
+   /* A times the previous block is also the W of the previous block.    */
+
+   for (i = dv1+blockSize; i <= dv2; i += m) {
+      m = min(blockSize, dv2-i+1);
+      (*primme->matrixMatvec)(&V[primme->nLocal*(i-blockSize)], 
+         &V[primme->nLocal*i], &m, primme);
+      Num_zcopy_zprimme(primme->nLocal*m, &V[primme->nLocal*i], 1,
+         &W[primme->nLocal*(i-blockSize)], 1);
+
+      ret = ortho_zprimme(V, primme->nLocal, i, i+m-1, locked, 
+         primme->nLocal, numLocked, primme->nLocal, primme->iseed, machEps,
          rwork, rworkSize, primme);
 
       if (ret < 0) {
-         primme_PushErrorMessage(Primme_init_block_krylov, Primme_ortho, ret, 
-            __FILE__, __LINE__, primme);
+         primme_PushErrorMessage(Primme_init_block_krylov, Primme_ortho, 
+                         ret, __FILE__, __LINE__, primme);
          return ORTHO_FAILURE;
       }
+   }
 
-      /* Generate the remainder of the Krylov space. */
+   primme->stats.numMatvecs += numNewVectors - blockSize;
+   update_W_zprimme(V, W, dv2-blockSize+1, blockSize, primme);
+         
+   return 0;
+}
 
-      for (i = dv1; i < dv2; i++) {
-         (*primme->matrixMatvec)
-           (&V[primme->nLocal*i], &V[primme->nLocal*(i+1)], &ONE, primme);
-         Num_zcopy_zprimme(primme->nLocal, &V[primme->nLocal*(i+1)], 1,
-            &W[primme->nLocal*i], 1);
-         ret = ortho_zprimme(V, primme->nLocal, i+1, i+1, locked, 
-            primme->nLocal, numLocked, primme->nLocal, primme->iseed, machEps,
-            rwork, rworkSize, primme);
-      
-         if (ret < 0) {
-            primme_PushErrorMessage(Primme_init_block_krylov, Primme_ortho, 
-                            ret, __FILE__, __LINE__, primme);
-            return ORTHO_FAILURE;
-         }
+/*******************************************************************************
+ * Subroutine chebyshev_filter - Replaces the random block 
+ *    V(:,dv1:dv1+blockSize-1) by p(A)V, with p the Chebyshev polynomial of
+ *    degree primme->initFilterDegree that damps the unwanted part of the
+ *    spectrum, so that the initial block Krylov space starts closer to the
+ *    target eigenvectors.
+ *
+ *    The spectrum is estimated with FILTER_LANCZOS_STEPS steps of Lanczos 
+ *    on the first vector of the block. With Ritz values t_1 <= ... <= t_k,
+ *    median t_m and last Lanczos coefficient beta, the damped interval 
+ *    [a, b] is [t_m, t_k + beta] for primme_smallest, and [t_1 - beta, t_m]
+ *    for primme_largest. The scaled 
+ *    three-term recurrence
+ *
+ *       Y_{j+1} = 2 s_{j+1}/e (A - c I) Y_j - s_j s_{j+1} Y_{j-1},
+ *
+ *    with c = (a+b)/2, e = (b-a)/2, s_1 = e/(t0-c), s_{j+1} = 1/(2/s_1-s_j)
+ *    and t0 the estimate of the wanted end of the spectrum (t_1 or t_k),
+ *    keeps p(t0) = 1 and avoids overflow. The block is not filtered for
+ *    other targets, or if the basis has no room for the workspace.
+ *    Matvecs are accounted for in primme->stats.numMatvecs.
+ *
+ * INPUT ARRAYS AND PARAMETERS
+ * ---------------------------
+ * dv1         Index of the first vector of the block in V
+ * blockSize   Number of vectors in the block
+ * machEps     Machine precision
+ *
+ * INPUT/OUTPUT ARRAYS
+ * -------------------
+ * V           The block to filter, not normalized on output
+ * W           Columns dv1 to dv1+max(2*blockSize,3)-1 are used as workspace
+ *
+ ******************************************************************************/
+
+static void chebyshev_filter(Complex_Z *V, Complex_Z *W, int dv1, 
+   int blockSize, double machEps, primme_params *primme) {
+
+   int j, k;            /* Loop variable and number of Lanczos steps    */
+   int ONE = 1;         /* Used for passing it by reference             */
+   double alpha[FILTER_LANCZOS_STEPS], beta[FILTER_LANCZOS_STEPS];
+   double a, b, c, e;   /* Damped interval, its center and half width   */
+   double t0;           /* Estimate of the wanted end of the spectrum   */
+   double s, s1, snew;  /* Scaling factors of the recurrence            */
+   double tmp, gtmp;
+   Complex_Z ztmp = {+0.0e+00,+0.0e00};
+   Complex_Z *q0, *q1, *w; /* Lanczos vectors                           */
+   Complex_Z *Y0, *Y1, *Y2;/* Blocks of the Chebyshev recurrence        */
+   int nLocal = primme->nLocal;
+
+   if ((primme->target != primme_smallest && primme->target != primme_largest)
+       || dv1 + max(2*blockSize, 3) > primme->maxBasisSize) {
+      return;
+   }
+
+   /* --------------------------------------------------------------- */
+   /* Lanczos on the first vector to estimate the spectrum            */
+   /* --------------------------------------------------------------- */
+
+   q0 = &W[nLocal*dv1];
+   q1 = &W[nLocal*(dv1+1)];
+   w  = &W[nLocal*(dv1+2)];
+
+   tmp = Num_dot_zprimme(nLocal, &V[nLocal*dv1], 1, &V[nLocal*dv1], 1).r;
+   primme_globalSumDouble(&tmp, &gtmp, &ONE, primme);
+   Num_zcopy_zprimme(nLocal, &V[nLocal*dv1], 1, q1, 1);
+   ztmp.r = 1.0L/sqrt(gtmp);
+   Num_scal_zprimme(nLocal, ztmp, q1, 1);
+   ztmp.r = 0.0L;
+   Num_scal_zprimme(nLocal, ztmp, q0, 1);
+
+   beta[0] = 0.0L;
+   for (k = 0; k < min(FILTER_LANCZOS_STEPS, primme->n); k++) {
+      (*primme->matrixMatvec)(q1, w, &ONE, primme);
+      primme->stats.numMatvecs++;
+      tmp = Num_dot_zprimme(nLocal, q1, 1, w, 1).r;
+      primme_globalSumDouble(&tmp, &alpha[k], &ONE, primme);
+      ztmp.r = -alpha[k];
+      Num_axpy_zprimme(nLocal, ztmp, q1, 1, w, 1);
+      if (k > 0) {
+         ztmp.r = -beta[k-1];
+         Num_axpy_zprimme(nLocal, ztmp, q0, 1, w, 1);
       }
+      tmp = Num_dot_zprimme(nLocal, w, 1, w, 1).r;
+      primme_globalSumDouble(&tmp, &gtmp, &ONE, primme);
+      beta[k] = sqrt(gtmp);
 
-      primme->stats.numMatvecs += dv2-dv1;
-      update_W_zprimme(V, W, dv2, 1, primme);
+      if (beta[k] <= machEps*fabs(alpha[k])) {k++; break;}
 
+      /* Rotate the vectors: q0 <- q1, q1 <- w/beta */
+      Y0 = q0; q0 = q1; q1 = w; w = Y0;
+      ztmp.r = 1.0L/beta[k];
+      Num_scal_zprimme(nLocal, ztmp, q1, 1);
    }
-   else {
-   /*----------------------------------------------------------------------*/
-   /* Generate the initial vectors.                                        */
-   /*----------------------------------------------------------------------*/
 
-      Num_larnv_zprimme(2, primme->iseed, primme->nLocal*primme->maxBlockSize,
-         &V[primme->nLocal*dv1]);
-      ret = ortho_zprimme(V, primme->nLocal, dv1, 
-         dv1+primme->maxBlockSize-1, locked, primme->nLocal, numLocked, 
-         primme->nLocal, primme->iseed, machEps, rwork, rworkSize, primme);
+   a = tridiagonal_eigenvalue(alpha, beta, k, 0, machEps);
+   b = tridiagonal_eigenvalue(alpha, beta, k, k-1, machEps);
+   c = tridiagonal_eigenvalue(alpha, beta, k, k/2, machEps);
+   if (primme->target == primme_smallest) {
+      t0 = a; a = c; b = b + beta[k-1];
+   }
+   else {
+      t0 = b; b = c; a = a - beta[k-1];
+   }
+   c = (a + b)/2.0L;
+   e = (b - a)/2.0L;
+   if (e <= 0.0L || t0 == c) return;
+
+   /* --------------------------------------------------------------- */
+   /* Scaled Chebyshev recurrence on the block, Y0 = V(:,dv1:...)     */
+   /* --------------------------------------------------------------- */
+
+   Y0 = &V[nLocal*dv1];
+   Y1 = &W[nLocal*dv1];
+   Y2 = &W[nLocal*(dv1+blockSize)];
+
+   s1 = e/(t0 - c);
+   s = s1;
+   (*primme->matrixMatvec)(Y0, Y1, &blockSize, primme);
+   primme->stats.numMatvecs += blockSize;
+   ztmp.r = -c;
+   Num_axpy_zprimme(nLocal*blockSize, ztmp, Y0, 1, Y1, 1);
+   ztmp.r = s1/e;
+   Num_scal_zprimme(nLocal*blockSize, ztmp, Y1, 1);
+
+   for (j = 1; j < primme->initFilterDegree; j++) {
+      snew = 1.0L/(2.0L/s1 - s);
+      (*primme->matrixMatvec)(Y1, Y2, &blockSize, primme);
+      primme->stats.numMatvecs += blockSize;
+      ztmp.r = -c;
+      Num_axpy_zprimme(nLocal*blockSize, ztmp, Y1, 1, Y2, 1);
+      ztmp.r = 2.0L*snew/e;
+      Num_scal_zprimme(nLocal*blockSize, ztmp, Y2, 1);
+      ztmp.r = -s*snew;
+      Num_axpy_zprimme(nLocal*blockSize, ztmp, Y0, 1, Y2, 1);
+      s = snew;
+      w = Y0; Y0 = Y1; Y1 = Y2; Y2 = w;
+   }
 
-      /* Generate the remaining vectors in the sequence */
+   if (Y1 != &V[nLocal*dv1]) {
+      Num_zcopy_zprimme(nLocal*blockSize, Y1, 1, &V[nLocal*dv1], 1);
+   }
 
-      for (i = dv1+primme->maxBlockSize; i <= dv2; i++) {
-         (*primme->matrixMatvec)(&V[primme->nLocal*(i-primme->maxBlockSize)], 
-            &V[primme->nLocal*i], &ONE, primme);
-         Num_zcopy_zprimme(primme->nLocal, &V[primme->nLocal*i], 1,
-            &W[primme->nLocal*(i-primme->maxBlockSize)], 1);
+   if (primme->printLevel >= 3 && primme->procID == 0) {
+      fprintf(primme->outputFile, 
+         "Chebyshev filter degree %d damping [%e, %e] target %e\n",
+         primme->initFilterDegree, a, b, t0);
+   }
+}
 
-         ret = ortho_zprimme(V, primme->nLocal, i, i, locked, 
-            primme->nLocal, numLocked, primme->nLocal, primme->iseed, machEps,
-            rwork, rworkSize, primme);
+/*******************************************************************************
+ * Function tridiagonal_eigenvalue - Returns the j-th smallest eigenvalue 
+ *    (from 0) of the symmetric tridiagonal matrix of order k with diagonal
+ *    alpha and off-diagonal beta, by bisection on the Sturm sequence count
+ *    within the Gershgorin interval.
+ ******************************************************************************/
 
-         if (ret < 0) {
-            primme_PushErrorMessage(Primme_init_block_krylov, Primme_ortho, 
-                            ret, __FILE__, __LINE__, primme);
-            return ORTHO_FAILURE;
-         }
+static double tridiagonal_eigenvalue(double *alpha, double *beta, int k, 
+   int j, double machEps) {
 
-      }
+   int i, iter, count;
+   double lo, hi, mid, d, r;
 
-      primme->stats.numMatvecs += dv2-(dv1+primme->maxBlockSize)+1;
-      update_W_zprimme(V, W, dv2-primme->maxBlockSize+1, primme->maxBlockSize,
-         primme);
+   lo = hi = alpha[0];
+   for (i = 0; i < k; i++) {
+      r = (i > 0 ? fabs(beta[i-1]) : 0.0L) + (i < k-1 ? fabs(beta[i]) : 0.0L);
+      lo = min(lo, alpha[i] - r);
+      hi = max(hi, alpha[i] + r);
+   }
 
+   for (iter = 0; iter < 100 && hi - lo > machEps*(fabs(lo)+fabs(hi)); 
+        iter++) {
+      mid = (lo + hi)/2.0L;
+      count = 0;
+      d = 1.0L;
+      for (i = 0; i < k; i++) {
+         d = alpha[i] - mid - (i > 0 ? beta[i-1]*beta[i-1]/d : 0.0L);
+         if (d == 0.0L) d = -machEps*(fabs(lo)+fabs(hi));
+         if (d < 0.0L) count++;
+      }
+      if (count > j) hi = mid; else lo = mid;
    }
-         
-   return 0;
+
+   return (lo + hi)/2.0L;
 }
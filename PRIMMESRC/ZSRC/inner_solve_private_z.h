@@ -52,4 +52,6 @@ static void apply_projector(Complex_Z *Q, int numCols, Complex_Z *v,
 static Complex_Z dist_dot(Complex_Z *x, int incx,
    Complex_Z *y, int incy, primme_params *primme);
 
+static double dist_sum(double x, primme_params *primme);
+
 #endif
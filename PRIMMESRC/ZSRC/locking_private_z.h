@@ -33,9 +33,11 @@
 #define INIT_BLOCK_KRYLOV_FAILURE -2
 #define SOLVE_H_FAILURE           -3
 #define UDUDECOMPOSE_FAILURE      -4
+#define LOCK_STORE_FAILURE        -5
 
 static int swap_flagVecs_toEnd(int basisSize, int flagValue, Complex_Z *V, 
-   Complex_Z *W, Complex_Z *H, double *hVals, int *flag, primme_params *primme);
+   Complex_Z *W, Complex_Z *H, Complex_Z *WtW, double *hVals, int *flag, 
+   primme_params *primme);
 
 static void insertionSort(double newVal, double *evals, double newNorm,
    double *resNorms, int *perm, int numConverged, primme_params *primme);
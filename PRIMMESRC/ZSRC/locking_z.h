@@ -32,9 +32,10 @@
 
 int lock_vectors_zprimme(double tol, double *aNormEstimate, double *maxConvTol, 
    int *basisSize, int *numLocked, int *numGuesses, int *nextGuess,
-   Complex_Z *V, Complex_Z *W, Complex_Z *H, Complex_Z *evecsHat, Complex_Z *M, 
-   Complex_Z *UDU, int *ipivot, double *hVals, Complex_Z *hVecs, 
-   Complex_Z *evecs, double *evals, int *perm, double machEps, 
+   Complex_Z *V, Complex_Z *W, Complex_Z *H, Complex_Z *WtW, 
+   Complex_Z *evecsHat, Complex_Z *M, Complex_Z *UDU, int *ipivot, 
+   double *hVals, Complex_Z *hVecs, Complex_Z *evecs, double *evals, 
+   int *perm, double machEps, 
    double *resNorms, int *numPrevRitzVals, double *prevRitzVals, 
    int *flag, Complex_Z *rwork, int rworkSize, int *iwork, 
    int *LockingProblem, primme_params *primme);
@@ -31,13 +31,14 @@
 
 /* Failure codes returned by main_iter */
 
-#define MAX_ITERATIONS_REACHED    -1
 #define INIT_FAILURE              -2
 #define ORTHO_FAILURE             -3
 #define SOLVE_H_FAILURE           -4
 #define SOLVE_CORRECTION_FAILURE  -5
 #define RESTART_FAILURE           -6
 #define LOCK_VECTORS_FAILURE      -7
+#define CHECK_CONVERGENCE_FAILURE -8
+#define LOCK_STORE_FAILURE        -9
 
 static void adjust_blockSize(int *iev, int *flag, int *blockSize, 
    int maxBlockSize, int *ievMax, int basisSize, int maxBasisSize, 
@@ -55,10 +56,37 @@ static int verify_norms(Complex_Z *V, Complex_Z *W, Complex_Z *hVecs, double *hV
    int basisSize, double *resNorms, int *flag, double tol, double aNormEstimate,
    void *rwork, int *numConverged, primme_params *primme);
 
+static void record_restart_progress(double resNorm, int restartMatvecs,
+   primme_params *primme);
+
+static int time_exhausted(primme_params *primme);
+
+static int return_best_effort(Complex_Z *V, Complex_Z *W, double *hVals,
+   int basisSize, int numLocked, double tol, double aNormEstimate,
+   double *evals, Complex_Z *evecs, double *resNorms, int *perm,
+   Complex_Z *rwork, primme_params *primme);
+
+static int monitor_stop(primme_event_type event, double *hVals, int basisSize,
+   int *iev, double *blockNorms, int blockSize, int numConverged,
+   double *evals, double *resNorms, int numLocked, primme_params *primme);
+
+/* Accumulate the time, and the hardware counters if PRIMME_PERF_COUNTERS, */
+/* of a phase for the event stream (see primme_phase). The reductions in  */
+/* between are also counted in stats.commPhase.                           */
+
+#define PHASE_START(phase, primme) ((primme)->stats.currentPhase = (phase), \
+   EVENTS_ON(primme) ? primme_phase_start(primme) : 0.0L)
+#define PHASE_STOP(phase, t0, primme) \
+   (primme)->stats.currentPhase = -1; \
+   if (EVENTS_ON(primme)) primme_phase_stop(phase, t0, primme)
+
 /*----------------------------------------------------------------------------*
  * The following are needed for the Dynamic Method Switching
  *----------------------------------------------------------------------------*/
 
+/* Number of model parameters stored per problem in the tuning cache */
+#define MODEL_CACHE_SIZE 12
+
 typedef struct {
    /* Time measurements for various components of the solver */
    double MV_PR;          /* OPp operator MV+PR time                          */
@@ -68,9 +96,10 @@ typedef struct {
    double qmr_plus_MV_PR; /* a   QMR plus operators                           */
    double gdk_plus_MV_PR; /* b   GD plus operators                            */
    double gdk_plus_MV;    /* b_m GD plus MV (i.e., GD without correction)     */
-                          /* The following two are not currently updated:     */
+                          /* The following are measured in the outer loop:   */
    double project_locked; /* c_p projection time per locked eigenvector in QMR*/
    double reortho_locked; /* c_g (usu 2*c_p) ortho per locked vector in outer */
+   double lock_per_vector;/* time to lock one converged vector                */
 
    /* Average convergence estimates. Updated at restart/switch/convergence    */
    double gdk_conv_rate;  /* convergence rate of all (|r|/|r0|) seen for GD+k */
@@ -102,6 +131,17 @@ typedef struct {
    double accum_jdq;      /* Accumulates jdq_times += ratio*(gdk+MV+PR)       */
    double accum_gdk;      /* Accumulates gdk_times += gdk+MV+PR               */
 
+   /* Online tuning of the block size and the inner iterations at restart    */
+   int blockSize;         /* Current maximum block size                       */
+   int tuneKnob;          /* Parameter moved last: 0 block size, 1 inner its  */
+   int tuneStep[2];       /* Direction of the next move of each parameter     */
+   int tuneConverged;     /* numConverged at the previous restart             */
+   int tuneMV;            /* numMatvecs at the previous restart               */
+   int tuneIt;            /* numOuterIterations at the previous restart       */
+   double tuneTimer;      /* Clock at the previous restart                    */
+   double tuneResid;      /* Residual norm of the first target at that time   */
+   double tuneRate;       /* log10 residual reduction per unit of time        */
+
 } primme_CostModel;
 
 static void initializeModel(primme_CostModel *model, primme_params *primme);
@@ -113,6 +153,42 @@ static int update_statistics(primme_CostModel *model, primme_params *primme,
 static double ratio_JDQMR_GDpk(primme_CostModel *CostModel, int numLocked,
    double estimate_slowdown, double estimate_ratio_outer_MV);
 static void update_slowdown(primme_CostModel *model);
+static double model_clock(primme_params *primme);
+static int read_model_cache(primme_CostModel *model, primme_params *primme);
+static void write_model_cache(primme_CostModel *model, primme_params *primme);
+static void update_locked_costs(primme_CostModel *model, double orthoTime,
+   int numColumns, double projectTime, int numSteps, int blockSize,
+   primme_params *primme);
+static void tune_parameters(primme_CostModel *model, double resNorm,
+   int numConverged, primme_params *primme);
+static void export_model(primme_CostModel *model, primme_params *primme);
+static void get_model_parameters(primme_CostModel *model, double *values);
+static void set_model_parameters(primme_CostModel *model, double *values);
+
+/*----------------------------------------------------------------------------*
+ * State carried to the next call in primme->continuationParams.state. The 
+ * header is followed in the same allocation by numPrevRitzVals doubles of 
+ * the shift history and numExtra Ritz vectors of nLocal entries each, so 
+ * primme_Free releases everything with a single free().
+ *----------------------------------------------------------------------------*/
+
+typedef struct {
+   int n;                    /* Dimension of the problem that saved it       */
+   int nLocal;               /* Local dimension of the problem               */
+   int elemSize;             /* sizeof the entries of the Ritz vectors       */
+   int numPrevRitzVals;      /* Size of the robust shift history             */
+   int numExtra;             /* Number of extra Ritz vectors                 */
+   int dynamic;              /* True if model holds a measured cost model    */
+   double largestRitzValue;  /* Largest modulus of any Ritz value computed   */
+   double model[MODEL_CACHE_SIZE]; /* Model parameters, as in the cache      */
+} primme_continuation;
+
+static int restore_continuation(double *prevRitzVals, int *numPrevRitzVals,
+   double *largestRitzValue, primme_CostModel *model, Complex_Z **extra, 
+   int *numExtra, primme_params *primme);
+static void save_continuation(Complex_Z *V, int first, int basisSize, 
+   double *prevRitzVals, int numPrevRitzVals, double largestRitzValue, 
+   primme_CostModel *model, primme_params *primme);
 
 #if 0
 static void displayModel(primme_CostModel *model);
@@ -28,10 +28,15 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
+#if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
+#  include <unistd.h>
+#endif
 #include "primme.h"
 #include "const.h"
 #include "wtime.h"
+#include "track.h"
 #include "main_iter_z.h"
 #include "main_iter_private_z.h"
 #include "convergence_z.h"
@@ -40,6 +45,7 @@
 #include "ortho_z.h"
 #include "restart_z.h"
 #include "locking_z.h"
+#include "lock_store_z.h"
 #include "solve_H_z.h"
 #include "update_projection_z.h"
 #include "update_W_z.h"
@@ -95,13 +101,16 @@
  * ----------------------------------
  * evecs    Stores initial guesses. Upon return, it contains the converged Ritz
  *          vectors.  If locking is not engaged, then converged Ritz vectors 
- *          are copied to this array just before return.  
+ *          are copied to this array just before return.  If the locked
+ *          vectors are kept out of core, they are written to the file in
+ *          primme->lockStoreParams instead.
  *
  * primme.initSize: On output, it stores the number of converged eigenvectors. 
  *           If smaller than numEvals and locking is used, there are
  *              only primme.initSize vectors in evecs.
  *           Without locking all numEvals approximations are in evecs
- *              but only the initSize ones are converged.
+ *              but only the initSize ones are converged; they come
+ *              first in evals, evecs and resNorms.
  *           During the execution, access to primme.initSize gives 
  *              the number of converged pairs up to that point. The pairs
  *              are available in evals and evecs, but only when locking is used
@@ -116,6 +125,8 @@
  *       -5 if solve_correction failed
  *       -6 if restart failed
  *       -7 if lock_vectors failed
+ *       -8 if check_convergence failed
+ *       -9 if the locked vectors store failed
  *       
  ******************************************************************************/
 
@@ -135,10 +146,13 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
    int recentlyConverged;   /* Number of target Ritz pairs that have         */
                             /*    converged during the current iteration.    */
    int numConvergedStored;  /* Numb of Ritzvecs temporarily stored in evecs  */
+   int *evecsSlot;          /* Position in evecs of each stored Ritz vector  */
                             /*    to allow for skew projectors w/o locking   */
    int converged;           /* True when all required Ritz vals. converged   */
    int LockingProblem;      /* Flag==1 if practically converged pairs locked */
    int restartLimitReached; /* True when maximum restarts performed          */
+   int stopRequested;       /* True when monitorFun asked to stop            */
+   int timeExhausted;       /* True when maxTime has been reached            */
    int numPrevRetained;     /* Number of vectors retained using recurrence-  */
                             /* based restarting.                             */
    int maxEvecsSize;        /* Maximum capacity of evecs array               */
@@ -146,6 +160,7 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
                             /*                      prevRitzVals, blockNorms */
    int rworkSize;           /* Size of rwork array                           */
    int numPrevRitzVals = 0; /* Size of the prevRitzVals updated in correction*/
+   int restartMatvecs;      /* Number of matvecs at the previous restart     */
    int ret;                 /* Return value                                  */
 
    int *iwork;              /* Integer workspace pointer                     */
@@ -155,11 +170,14 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
    int ONE = 1;             /* To be passed by reference in matrixMatvec     */
 
    double largestRitzValue; /* The largest modulus of any Ritz value computed*/
+   double targetResNorm;    /* Residual norm of the first target at the last */
+                            /* convergence check, 0 if none is unconverged   */
    double tol;              /* Required tolerance for residual norms         */
    double maxConvTol;       /* Max locked residual norm (see convergence.c)  */
    Complex_Z *V;               /* Basis vectors                               */
    Complex_Z *W;               /* Work space storing A*V                      */
    Complex_Z *H;               /* Upper triangular portion of V'*A*V          */
+   Complex_Z *WtW;             /* Upper triangular portion of W'*W (harmonic) */
    Complex_Z *M;               /* The projection Q'*K*Q, where Q = [evecs, x] */
                             /* x is the current Ritz vector and K is a       */
                             /* hermitian preconditioner.                     */
@@ -182,6 +200,15 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
                             /* the parameters of the model.Only visible here */
    double timeForMV;        /* Measures time for 1 matvec operation          */
    double tstart;           /* Timing variable for accumulative time spent   */
+   double tphase;           /* Start of the phase timed for the event stream */
+   double orthoLocked;      /* stats.timeOrthoLocked before the ortho        */
+   double projectLocked;    /* stats.timeProjectLocked after the last ortho  */
+   int projectSteps;        /* stats.numProjectLocked after the last ortho   */
+   int modelCached;         /* True if the model was read from the cache     */
+                            /*    or kept from the previous call             */
+   Complex_Z *extra;        /* Extra Ritz vectors kept by the previous call  */
+   int numExtra;            /* Number of vectors in extra                    */
+   int numPrevLocked;       /* numLocked before locking, to time the locking */
 
    /* -------------------------------------------------------------- */
    /* Subdivide the workspace                                        */
@@ -194,6 +221,16 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
    H             = W + primme->nLocal*primme->maxBasisSize;
    hVecs         = H + primme->maxBasisSize*primme->maxBasisSize;
    previousHVecs = hVecs + primme->maxBasisSize*primme->maxBasisSize;
+   if (primme->projectionParams.projection != primme_proj_RR) {
+      WtW        = previousHVecs + primme->restartingParams.maxPrevRetain*
+                           primme->maxBasisSize;
+      rwork      = WtW + primme->maxBasisSize*primme->maxBasisSize;
+   }
+   else {
+      WtW        = NULL;
+      rwork      = previousHVecs + primme->restartingParams.maxPrevRetain*
+                           primme->maxBasisSize;
+   }
    if (! (primme->correctionParams.precondition && 
           primme->correctionParams.maxInnerIterations != 0 &&
           primme->correctionParams.projectors.RightQ &&
@@ -201,12 +238,9 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
       evecsHat   = NULL;
       M          = NULL;
       UDU        = NULL;
-      rwork      = previousHVecs + primme->restartingParams.maxPrevRetain*
-                           primme->maxBasisSize;
    }
    else {
-      evecsHat   = previousHVecs + primme->restartingParams.maxPrevRetain*
-                           primme->maxBasisSize;
+      evecsHat   = rwork;
       M          = evecsHat + primme->nLocal*maxEvecsSize;
       UDU        = M + maxEvecsSize*maxEvecsSize; 
       rwork      = UDU + maxEvecsSize*maxEvecsSize; 
@@ -227,7 +261,8 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
    flag = intWork;
    iev = flag + primme->maxBasisSize;
    ipivot = iev + primme->maxBlockSize;
-   iwork = ipivot + maxEvecsSize;
+   evecsSlot = ipivot + maxEvecsSize;
+   iwork = evecsSlot + primme->numEvals;
 
    /* -------------------------------------------------------------- */
    /* Initialize counters and flags                                  */
@@ -236,8 +271,31 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
    primme->stats.numOuterIterations = 0;
    primme->stats.numRestarts = 0;
    primme->stats.numMatvecs = 0;
+   primme->stats.bytesMoved = 0.0L;
+   primme->stats.timeOrthoLocked = 0.0L;
+   primme->stats.timeProjectLocked = 0.0L;
+   primme->stats.numProjectLocked = 0;
+   projectLocked = 0.0L;
+   projectSteps = 0;
+   primme->stats.comm.numReductions = 0;
+   primme->stats.comm.numDoubles = 0.0L;
+   primme->stats.comm.time = 0.0L;
+   for (i=0; i < primme_num_phases; i++) {
+      primme->stats.commPhase[i] = primme->stats.comm;
+   }
+   primme->stats.currentPhase = -1;
+   primme->restartingParams.trace.restartSize = 0;
+   primme->restartingParams.trace.numPrevRetained = 0;
+   primme->restartingParams.trace.resNorm = 0.0L;
+   primme->restartingParams.trace.convRate = 0.0L;
+   primme->restartingParams.adaptStep = 0;
+   primme->restartingParams.adaptRate = 0.0L;
+   restartMatvecs = 0;
+   targetResNorm = 0.0L;
    numLocked = 0;
    converged = FALSE;
+   stopRequested = FALSE;
+   timeExhausted = FALSE;
    LockingProblem = 0;
 
    numPrevRetained = 0;
@@ -266,23 +324,52 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
    /* -------------------------------------- */
 
    if (primme->n == 1) {
-      evecs[0] = tpone;
-      (*primme->matrixMatvec)(&evecs[0], W, &ONE, primme);
-      evals[0] = W[0].r;
       V[0] = tpone;
+      (*primme->matrixMatvec)(V, W, &ONE, primme);
+      evals[0] = W[0].r;
+      if (primme->lockStoreParams.file != NULL) {
+         ret = lock_store_write_zprimme(V, 0, 1, primme);
+         if (ret < 0) {
+            primme_PushErrorMessage(Primme_main_iter, Primme_lock_store, ret,
+                            __FILE__, __LINE__, primme);
+            return LOCK_STORE_FAILURE;
+         }
+      }
+      else {
+         evecs[0] = tpone;
+      }
 
       resNorms[0] = 0.0L;
       primme->stats.numMatvecs++;
       return 0;
    }
 
+   /* ------------------------------------------------------------ */
+   /* The cost model drives the online tuning and is reported in   */
+   /* stats.model. With a tuning cache, the dynamic method switch  */
+   /* starts from the model measured by a previous run on the same */
+   /* problem, and the matvec is not timed in init_basis.          */
+   /* A state kept by the previous call (continuationParams) gives */
+   /* the model, the shift history, the norm estimate and extra    */
+   /* Ritz vectors for the initial basis.                          */
+   /* ------------------------------------------------------------ */
+
+   initializeModel(&CostModel, primme);
+   modelCached = restore_continuation(prevRitzVals, &numPrevRitzVals,
+                    &largestRitzValue, &CostModel, &extra, &numExtra, primme);
+   if (!modelCached) {
+      modelCached = primme->dynamicMethodSwitch > 0 &&
+                    primme->tuningParams.cacheFile != NULL &&
+                    read_model_cache(&CostModel, primme);
+   }
+
    /* -------------------- */
    /* Initialize the basis */
    /* -------------------- */
 
-   ret = init_basis_zprimme(V, W, evecs, evecsHat, M, UDU, ipivot, machEps,
-           rwork, rworkSize, &basisSize, &nextGuess, &numGuesses, &timeForMV,
-           primme);
+   ret = init_basis_zprimme(V, W, evecs, extra, numExtra, evecsHat, M, UDU,
+           ipivot, machEps, rwork, rworkSize, &basisSize, &nextGuess, 
+           &numGuesses, modelCached ? NULL : &timeForMV, primme);
 
    if (ret < 0) {
       primme_PushErrorMessage(Primme_main_iter, Primme_init_basis, ret, 
@@ -294,22 +381,36 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
    /* Dynamic method switch means we need to decide whether to    */
    /* allow inner iterations based on runtime timing measurements */
    /* ----------------------------------------------------------- */
-   if (primme->dynamicMethodSwitch > 0) {
-      initializeModel(&CostModel, primme);
+
+   CostModel.numMV_0 = CostModel.tuneMV = primme->stats.numMatvecs;
+   CostModel.timer_0 = CostModel.tuneTimer = model_clock(primme);
+   if (primme->tuningParams.deterministic)
+      CostModel.MV = 1.0L;
+   else if (primme->dynamicMethodSwitch > 0 && !modelCached)
       CostModel.MV = timeForMV;
-      if (primme->numEvals < 5)
-         primme->dynamicMethodSwitch = 1;   /* Start tentatively GD+k */
-      else
-         primme->dynamicMethodSwitch = 3;   /* Start GD+k for 1st pair */
-      primme->correctionParams.maxInnerIterations = 0; 
+
+   if (primme->dynamicMethodSwitch > 0) {
+      if (modelCached && CostModel.accum_jdq_gdk < 0.96) {
+         /* Start with JDQMR as recommended by the previous run */
+         primme->dynamicMethodSwitch = primme->numEvals < 5 ? 2 : 4;
+         primme->correctionParams.maxInnerIterations = -1; 
+      }
+      else {
+         if (primme->numEvals < 5)
+            primme->dynamicMethodSwitch = 1;   /* Start tentatively GD+k */
+         else
+            primme->dynamicMethodSwitch = 3;   /* Start GD+k for 1st pair */
+         primme->correctionParams.maxInnerIterations = 0; 
+      }
    }
+   export_model(&CostModel, primme);
 
    /* ---------------------------------------------------------------------- */
    /* Outer most loop                                                        */
    /* Without locking, restarting can cause converged Ritz values to become  */
    /* unconverged. Keep performing JD iterations until they remain converged */
    /* ---------------------------------------------------------------------- */
-   while (!converged &&
+   while (!converged && !timeExhausted &&
           ( primme->maxMatvecs == 0 || 
             primme->stats.numMatvecs < primme->maxMatvecs ) &&
           ( primme->maxOuterIterations == 0 ||
@@ -319,13 +420,23 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
 
       primme->initSize = numConverged = numConvergedStored = 0;
       reset_flags_zprimme(flag, 0, primme->maxBasisSize-1);
+      for (i=0; i < primme->numEvals; i++) {
+         evecsSlot[i] = -1;
+      }
 
       /* Compute the initial H and solve for its eigenpairs */
    
       update_projection_zprimme(V, W, H, 0,primme->maxBasisSize,basisSize,
          hVecs,primme);
-      ret = solve_H_zprimme(H, hVecs, hVals, basisSize, primme->maxBasisSize,
-         &largestRitzValue, numLocked, rworkSize, rwork, iwork, primme);
+      if (WtW != NULL) {
+         update_projection_zprimme(W, W, WtW, 0, primme->maxBasisSize,
+            basisSize, hVecs, primme);
+      }
+      tphase = PHASE_START(primme_phase_solveH, primme);
+      ret = solve_H_zprimme(H, WtW, hVecs, hVals, basisSize, 
+         primme->maxBasisSize, &largestRitzValue, numLocked, rworkSize, rwork,
+         iwork, primme);
+      PHASE_STOP(primme_phase_solveH, tphase, primme);
 
       if (ret != 0) {
          primme_PushErrorMessage(Primme_main_iter, Primme_solve_h, ret, 
@@ -337,7 +448,8 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
       /* Begin the iterative process.  Keep restarting until all of the */
       /* required eigenpairs have been found (no verification)          */
       /* -------------------------------------------------------------- */
-      while (numConverged < primme->numEvals &&
+      while (numConverged < primme->numEvals && !stopRequested &&
+             !timeExhausted &&
              ( primme->maxMatvecs == 0 || 
                primme->stats.numMatvecs < primme->maxMatvecs ) &&
              ( primme->maxOuterIterations == 0 ||
@@ -351,28 +463,42 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
          /* ----------------------------------------------------------------- */
          while (basisSize < primme->maxBasisSize &&
                 basisSize < primme->n - primme->numOrthoConst - numLocked &&
+                !timeExhausted &&
                 ( primme->maxMatvecs == 0 || 
                   primme->stats.numMatvecs < primme->maxMatvecs) &&
                 ( primme->maxOuterIterations == 0 ||
                   primme->stats.numOuterIterations < primme->maxOuterIterations) ) {
 
             primme->stats.numOuterIterations++;
+            TRACK_ITERATION(primme);
             numPrevRetained = 0;
 
             /* Adjust the block size if necessary. Remember the available for */
             /* expansion slots in the basis, as blockSize may be reduced later*/
 
-            adjust_blockSize(iev, flag, &blockSize, primme->maxBlockSize, 
+            adjust_blockSize(iev, flag, &blockSize, CostModel.blockSize, 
                &ievMax, basisSize, primme->maxBasisSize, numLocked, 
                numConverged, primme->numEvals, primme->n);
             AvailableBlockSize = blockSize;
 
             /* Check the convergence of the blockSize Ritz vectors computed */
 
+            tphase = PHASE_START(primme_phase_convergence, primme);
             recentlyConverged = check_convergence_zprimme(V, W, hVecs, 
                hVals, flag, basisSize, iev, &ievMax, blockNorms, &blockSize, 
                numConverged, numLocked, evecs, tol, maxConvTol, 
-               largestRitzValue, rwork, primme);
+               largestRitzValue, rwork, iwork, primme);
+            PHASE_STOP(primme_phase_convergence, tphase, primme);
+
+            /* blockNorms no longer holds it at the restart */
+            targetResNorm = blockSize > 0 ? blockNorms[0] : 0.0L;
+
+            if (recentlyConverged < 0) {
+               primme_PushErrorMessage(Primme_main_iter, 
+                  Primme_check_convergence, recentlyConverged, __FILE__, 
+                  __LINE__, primme);
+               return CHECK_CONVERGENCE_FAILURE;
+            }
 
             /* If the total number of converged pairs, including the     */
             /* recentlyConverged ones, are greater than or equal to the  */
@@ -382,7 +508,28 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
 
             numConverged += recentlyConverged;
 
-            if (numConverged >= primme->numEvals ||
+            if (EVENTS_ON(primme)) {
+               primme_event_push(primme_event_outer,
+                  blockSize > 0 ? iev[0] : -1, numConverged, 0,
+                  blockSize > 0 ? hVals[iev[0]] : 0.0L,
+                  blockSize > 0 ? blockNorms[0] : 0.0L, primme);
+            }
+
+            /* Report the progress to monitorFun. If it asks to stop, */
+            /* restart and lock as usual and leave the iteration      */
+
+            if (primme->monitorFun != NULL) {
+               stopRequested = monitor_stop(primme_event_outer, hVals,
+                  basisSize, iev, blockNorms, blockSize, numConverged, evals,
+                  resNorms, numLocked, primme);
+               if (!primme->locking && recentlyConverged > 0) {
+                  stopRequested |= monitor_stop(primme_event_lock, hVals,
+                     basisSize, iev, blockNorms, blockSize, numConverged,
+                     evals, resNorms, numLocked, primme);
+               }
+            }
+
+            if (stopRequested || numConverged >= primme->numEvals ||
                 (primme->locking && recentlyConverged > 0
                     && primme->target != primme_smallest
                     && primme->target != primme_largest)) {
@@ -410,7 +557,7 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
                /* - - - - - - - - - - - - - - - - - - - - - - - - - - -  */
                /* If dynamic method switching, time the inner method     */
                if (primme->dynamicMethodSwitch > 0) {
-                  tstart = primme_wTimer(0); /* accumulate correction time */
+                  tstart = model_clock(primme); /* accumulate correction time */
 
                   if (CostModel.resid_0 == -1.0L)       /* remember the very */
                      CostModel.resid_0 = blockNorms[0]; /* first residual */
@@ -432,11 +579,13 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
                } /* dynamic switching */
                /* - - - - - - - - - - - - - - - - - - - - - - - - - - -  */
 
+               tphase = PHASE_START(primme_phase_correction, primme);
                ret = solve_correction_zprimme(V, W, evecs, evecsHat, UDU, 
                  ipivot, evals, numLocked, numConvergedStored, hVals, 
                  prevRitzVals, &numPrevRitzVals, flag, basisSize, blockNorms, 
                  iev, blockSize, tol, machEps, largestRitzValue, rwork, iwork, 
                  rworkSize, primme);
+               PHASE_STOP(primme_phase_correction, tphase, primme);
 
                if (ret != 0) {
                   primme_PushErrorMessage(Primme_main_iter, 
@@ -448,58 +597,114 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
                /* If dynamic method switch, accumulate inner method time */
                /* ------------------------------------------------------ */
                if (primme->dynamicMethodSwitch > 0) 
-                  CostModel.time_in_inner += primme_wTimer(0) - tstart;
+                  CostModel.time_in_inner += model_clock(primme) - tstart;
 
             } /* end of else blocksize=0 */
 
             /* Orthogonalize the corrections with respect to each other */
-            /* and the current basis.                                   */
+            /* and the current basis. Time the locked vectors part for  */
+            /* the cost model.                                          */
 
+            orthoLocked = primme->stats.timeOrthoLocked;
+            tphase = PHASE_START(primme_phase_ortho, primme);
             ret = ortho_zprimme(V, primme->nLocal, basisSize, 
                basisSize+blockSize-1, evecs, primme->nLocal, 
                primme->numOrthoConst+numLocked, primme->nLocal, primme->iseed, 
                machEps, rwork, rworkSize,primme);
+            PHASE_STOP(primme_phase_ortho, tphase, primme);
 
             if (ret < 0) {
                primme_PushErrorMessage(Primme_main_iter, Primme_ortho, ret,
                                __FILE__, __LINE__, primme);
                return ORTHO_FAILURE;
             }
+            update_locked_costs(&CostModel, 
+               primme->stats.timeOrthoLocked - orthoLocked,
+               primme->numOrthoConst + numLocked, 
+               primme->stats.timeProjectLocked - projectLocked,
+               primme->stats.numProjectLocked - projectSteps, blockSize,
+               primme);
+            projectLocked = primme->stats.timeProjectLocked;
+            projectSteps = primme->stats.numProjectLocked;
            
-            /* Compute W = A*V for the orthogonalized corrections */
-
-            update_W_zprimme(V, W, basisSize, blockSize, primme);
+            /* Compute W = A*V for the orthogonalized corrections and */
+            /* extend H by blockSize columns and rows. With a split-  */
+            /* phase matvec, the coefficients for restarting and the  */
+            /* rows of H for the previous basis are computed while    */
+            /* the product is in flight.                              */
+
+            tphase = PHASE_START(primme_phase_matvec, primme);
+            if (primme->matrixMatvecBegin != NULL && 
+                primme->matrixMatvecEnd != NULL) {
+               update_W_begin_zprimme(V, W, basisSize, blockSize, primme);
+               numPrevRetained = retain_previous_coefficients(hVecs, 
+                  previousHVecs, basisSize, iev, blockSize, primme);
+               if (WtW == NULL) {
+                  update_projection_begin_zprimme(V, W, basisSize, 
+                     primme->maxBasisSize, blockSize, hVecs, primme);
+               }
+               update_W_end_zprimme(V, W, basisSize, blockSize, primme);
+               if (WtW == NULL) {
+                  update_projection_end_zprimme(V, W, H, basisSize, 
+                     primme->maxBasisSize, blockSize, hVecs, primme);
+               }
+               else {
+                  update_projection_zprimme(V, W, H, basisSize, 
+                     primme->maxBasisSize, blockSize, hVecs, primme);
+               }
+            }
+            else {
+               update_W_zprimme(V, W, basisSize, blockSize, primme);
+               numPrevRetained = retain_previous_coefficients(hVecs, 
+                  previousHVecs, basisSize, iev, blockSize, primme);
+               update_projection_zprimme(V, W, H, basisSize, 
+                  primme->maxBasisSize, blockSize, hVecs, primme);
+            }
 
-            /* Extend H by blockSize columns and rows and solve the */
-            /* eigenproblem for the new H.                          */
+            /* Extend also W'*W and solve the eigenproblem for the new H */
 
-            numPrevRetained = retain_previous_coefficients(hVecs, 
-               previousHVecs, basisSize, iev, blockSize, primme);
-            update_projection_zprimme(V, W, H, basisSize, 
-               primme->maxBasisSize, blockSize, hVecs, primme);
+            if (WtW != NULL) {
+               update_projection_zprimme(W, W, WtW, basisSize, 
+                  primme->maxBasisSize, blockSize, hVecs, primme);
+            }
+            PHASE_STOP(primme_phase_matvec, tphase, primme);
             basisSize = basisSize + blockSize;
-            ret = solve_H_zprimme(H, hVecs, hVals, basisSize, 
+            tphase = PHASE_START(primme_phase_solveH, primme);
+            ret = solve_H_zprimme(H, WtW, hVecs, hVals, basisSize, 
                primme->maxBasisSize, &largestRitzValue, numLocked, rworkSize, 
                rwork, iwork, primme);
+            PHASE_STOP(primme_phase_solveH, tphase, primme);
 
             if (ret != 0) {
                primme_PushErrorMessage(Primme_main_iter, Primme_solve_h, ret,
                                __FILE__, __LINE__, primme);
                return SOLVE_H_FAILURE;
             }
+
+            timeExhausted = time_exhausted(primme);
             
            /* --------------------------------------------------------------- */
          } /* while (basisSize<maxBasisSize && basisSize<n-orthoConst-numLocked)
             * --------------------------------------------------------------- */
 
+         /* ------------------------------------------------------------- */
+         /* Record in the restart trace the matvecs and the convergence   */
+         /* rate of the first target since the previous restart           */
+         /* ------------------------------------------------------------- */
+
+         record_restart_progress(targetResNorm, restartMatvecs, primme);
+         restartMatvecs = primme->stats.numMatvecs;
+
          /* ------------------ */
          /* Restart the basis  */
          /* ------------------ */
 
-         basisSize = restart_zprimme(V, W, H, hVecs, hVals, flag, iev, 
+         tphase = PHASE_START(primme_phase_restart, primme);
+         basisSize = restart_zprimme(V, W, H, WtW, hVecs, hVals, flag, iev,
             evecs, evecsHat, M, UDU, ipivot, basisSize, numConverged, 
-            &numConvergedStored, numLocked, numGuesses, previousHVecs, 
-            numPrevRetained, machEps, rwork, rworkSize, primme);
+            &numConvergedStored, evecsSlot, numLocked, numGuesses, 
+            previousHVecs, numPrevRetained, machEps, rwork, rworkSize, 
+            primme);
 
          if (basisSize <= 0) {
             primme_PushErrorMessage(Primme_main_iter, Primme_restart, 
@@ -513,9 +718,11 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
          /* ----------------------------------------------------------- */
 
          if (primme->locking) {
+            tstart = model_clock(primme);
+            numPrevLocked = numLocked;
             ret = lock_vectors_zprimme(tol, &largestRitzValue, &maxConvTol,
                &basisSize, &numLocked, &numGuesses, &nextGuess, V, W, H, 
-               evecsHat, M, UDU, ipivot, hVals, hVecs, evecs, evals, perm, 
+               WtW, evecsHat, M, UDU, ipivot, hVals, hVecs, evecs, evals, perm, 
                machEps, resNorms, &numPrevRitzVals, prevRitzVals, flag, 
                rwork, rworkSize, iwork, &LockingProblem, primme);
             numConverged = primme->initSize = numLocked;
@@ -525,6 +732,21 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
                                ret, __FILE__, __LINE__, primme);
                return LOCK_VECTORS_FAILURE;
             }
+
+            if (numLocked > numPrevLocked && primme->monitorFun != NULL) {
+               stopRequested |= monitor_stop(primme_event_lock, hVals,
+                  basisSize, iev, blockNorms, 0, numConverged, evals,
+                  resNorms, numLocked, primme);
+            }
+
+            if (numLocked > numPrevLocked) {
+               tstart = (model_clock(primme) - tstart)/(numLocked-numPrevLocked);
+               if (CostModel.lock_per_vector == 0.0L)
+                  CostModel.lock_per_vector = tstart;
+               else
+                  CostModel.lock_per_vector = 
+                     (CostModel.lock_per_vector + tstart)/2.0L;
+            }
             
          }
          else {
@@ -534,6 +756,19 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
          }
 
          primme->stats.numRestarts++;
+         PHASE_STOP(primme_phase_restart, tphase, primme);
+
+         if (EVENTS_ON(primme)) {
+            primme_event_push(primme_event_restart, -1, basisSize,
+               numPrevRetained, hVals[0], primme->restartingParams.trace.resNorm,
+               primme);
+         }
+
+         if (primme->monitorFun != NULL) {
+            stopRequested |= monitor_stop(primme_event_restart, hVals,
+               basisSize, iev, blockNorms, 0, numConverged, evals, resNorms,
+               numLocked, primme);
+         }
 
          /* ------------------------------------------------------------- */
          /* If dynamic method switching == 1, update model parameters and */
@@ -541,17 +776,24 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
          /* restart. GD+k is also evaluated if a pair converges.          */
          /* ------------------------------------------------------------- */
          if (primme->dynamicMethodSwitch == 1 ) {
-            tstart = primme_wTimer(0);
+            tstart = model_clock(primme);
             ret = update_statistics(&CostModel, primme, tstart, 0, 1,
-               numConverged, blockNorms[0], largestRitzValue); 
+               numConverged, targetResNorm, largestRitzValue); 
             switch_from_GDpk(&CostModel, primme);
          } /* ---------------------------------------------------------- */
 
+         /* Move the block size or the inner iterations if they are tuned */
+
+         tune_parameters(&CostModel, targetResNorm, numConverged, primme);
+         export_model(&CostModel, primme);
+
 
         /* ----------------------------------------------------------- */
       } /* while ((numConverged < primme->numEvals)  (restarting loop)
          * ----------------------------------------------------------- */
 
+      export_model(&CostModel, primme);
+
       /* ------------------------------------------------------------ */
       /* If locking is enabled, check to make sure the required       */
       /* number of eigenvalues have been computed, else make sure the */
@@ -570,6 +812,11 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
             else
                primme->dynamicMethodSwitch = -3;  /* Close call. Use dynamic */
          }
+         if (primme->tuningParams.cacheFile != NULL &&
+             primme->dynamicMethodSwitch < 0 && CostModel.gdk_plus_MV > 0.0L)
+            write_model_cache(&CostModel, primme);
+         save_continuation(V, 0, basisSize, prevRitzVals, numPrevRitzVals,
+            largestRitzValue, &CostModel, primme);
 
          /* Return flag showing if there has been a locking problem */
          intWork[0] = LockingProblem;
@@ -582,7 +829,18 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
             return 0;
          }
          else {
-            return MAX_ITERATIONS_REACHED;
+            /* Return also the best approximations of the pairs that */
+            /* were not locked, and count the converged ones         */
+
+            ret = return_best_effort(V, W, hVals, basisSize, numLocked, tol,
+               largestRitzValue, evals, evecs, resNorms, perm, rwork, primme);
+            if (ret < 0) {
+               primme_PushErrorMessage(Primme_main_iter, Primme_lock_store,
+                               ret, __FILE__, __LINE__, primme);
+               return LOCK_STORE_FAILURE;
+            }
+            primme->initSize = numLocked + ret;
+            return stopRequested ? MONITOR_STOP : MAX_ITERATIONS_REACHED;
          }
 
       }
@@ -590,8 +848,11 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
 
          /* Determine if the maximum number of matvecs has been reached */
 
-         restartLimitReached = primme->maxMatvecs > 0 && 
-                               primme->stats.numMatvecs >= primme->maxMatvecs;
+         restartLimitReached = stopRequested || timeExhausted ||
+            (primme->maxMatvecs > 0 && 
+             primme->stats.numMatvecs >= primme->maxMatvecs) ||
+            (primme->maxOuterIterations > 0 &&
+             primme->stats.numOuterIterations >= primme->maxOuterIterations);
 
          /* ---------------------------------------------------------- */
          /* The norms of the converged Ritz vectors must be recomputed */
@@ -613,19 +874,38 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
          /* ---------------------------------------------------------- */
 
          if (restartLimitReached || converged) {
+            int j;
+
+            /* Return also the number of actually converged pairs    */
+            /* (verify_norms flags them; numConverged may undercount */
+            /* them when the limit or monitorFun stopped the solver) */
+            /* and put them first, as locking does. perm[i] is the   */
+            /* Ritz pair returned in the ith position; evecs are     */
+            /* permuted with it before returning from zprimme.       */
+
+            primme->initSize = 0;
             for (i=0; i < primme->numEvals; i++) {
-               evals[i] = hVals[i];
-               perm[i] = i;
+               if (flag[i] == CONVERGED) perm[primme->initSize++] = i;
+            }
+            for (i=0, j=primme->initSize; i < primme->numEvals; i++) {
+               if (flag[i] != CONVERGED) perm[j++] = i;
+            }
+
+            for (i=0; i < primme->numEvals; i++) {
+               evals[i] = hVals[perm[i]];
+               ((double *) rwork)[i] = resNorms[perm[i]];
+            }
+            for (i=0; i < primme->numEvals; i++) {
+               resNorms[i] = ((double *) rwork)[i];
             }
 
             Num_zcopy_zprimme(primme->nLocal*primme->numEvals, V, 1, 
                &evecs[primme->nLocal*primme->numOrthoConst], 1);
+            primme->stats.bytesMoved += 
+               (double)primme->nLocal*primme->numEvals*sizeof(Complex_Z);
 
             /* The target values all remained converged, then return */
             /* successfully, else return with a failure code.        */
-            /* Return also the number of actually converged pairs    */
- 
-            primme->initSize = numConverged;
 
             /* if dynamic method, give method recommendation for future runs */
             if (primme->dynamicMethodSwitch > 0 ) {
@@ -636,11 +916,19 @@ int main_iter_zprimme(double *evals, int *perm, Complex_Z *evecs,
                else
                   primme->dynamicMethodSwitch = -3;  /* Close call.Use dynamic*/
             }
+            if (primme->tuningParams.cacheFile != NULL &&
+                primme->dynamicMethodSwitch < 0 && CostModel.gdk_plus_MV > 0.0L)
+               write_model_cache(&CostModel, primme);
+            save_continuation(V, primme->numEvals, basisSize, prevRitzVals,
+               numPrevRitzVals, largestRitzValue, &CostModel, primme);
 
             if (converged) {
                if (primme->aNorm <= 0.0L) primme->aNorm = largestRitzValue;
                return 0;
             }
+            else if (stopRequested) {
+               return MONITOR_STOP;
+            }
             else {
                return MAX_ITERATIONS_REACHED;
             }
@@ -950,7 +1238,7 @@ static int verify_norms(Complex_Z *V, Complex_Z *W, Complex_Z *hVecs,
 
    }
       
-   (*primme->globalSumDouble)(&dwork[nev], &dwork[0], &nev, primme); 
+   primme_globalSumDouble(&dwork[nev], &dwork[0], &nev, primme); 
    converged = 1;
 
    /* Check for convergence of the residual norms. */
@@ -973,6 +1261,209 @@ static int verify_norms(Complex_Z *V, Complex_Z *W, Complex_Z *hVecs,
    return converged;
 }
 
+/*******************************************************************************
+ * Function time_exhausted - Returns true if maxTime seconds have passed since
+ *    the solver was called. With several processes, the clock of the process
+ *    with procID 0 decides, so that all processes stop at the same point.
+ *
+ ******************************************************************************/
+
+static int time_exhausted(primme_params *primme) {
+
+   double t, globalT;
+   int one = 1;
+
+   if (primme->maxTime <= 0.0L) return FALSE;
+
+   t = primme->procID == 0 ? ELAPSED_TIME(primme) : 0.0L;
+   if (primme->numProcs > 1) {
+      primme_globalSumDouble(&t, &globalT, &one, primme);
+      t = globalT;
+   }
+
+   return t >= primme->maxTime;
+}
+
+/*******************************************************************************
+ * Function return_best_effort - Called when the solver stops with locking
+ *    before numEvals pairs are locked. It places after the locked pairs the
+ *    first Ritz pairs of the basis with their true residual norms, so that
+ *    evals, evecs and resNorms hold the best approximations available.
+ *    If the basis is too small, the remaining pairs have residual norm -1.
+ *    W is overwritten.
+ *
+ * INPUT ARRAYS AND PARAMETERS
+ * ---------------------------
+ * V             The basis after restarting and locking
+ * hVals         The Ritz values of the basis
+ * basisSize     The size of the basis
+ * numLocked     The number of locked pairs
+ * tol           Required tolerance for the residual norms
+ * aNormEstimate if primme->aNorm<=0, use tol*aNormEstimate
+ * rwork         Must be at least 2*primme->numEvals in size
+ *
+ * INPUT/OUTPUT ARRAYS
+ * -------------------
+ * W             A*V on input; destroyed on output
+ * evals, evecs, resNorms, perm  The locked pairs; on output, numEvals pairs
+ *
+ * Return value
+ * ------------
+ * The number of the added pairs with residual norm below the tolerance, or
+ * a negative value if they could not be written to the locked vectors file
+ *
+ ******************************************************************************/
+
+static int return_best_effort(Complex_Z *V, Complex_Z *W, double *hVals,
+   int basisSize, int numLocked, double tol, double aNormEstimate,
+   double *evals, Complex_Z *evecs, double *resNorms, int *perm,
+   Complex_Z *rwork, primme_params *primme) {
+
+   int i, j, ret;
+   int count;     /* Number of Ritz pairs added after the locked ones */
+   int numConv;   /* Number of them with residual norm below tol      */
+   int n = primme->nLocal;
+   double *dwork = (double *) rwork;
+   Complex_Z *x;
+   Complex_Z ztmp;  /* temp complex var */
+   Complex_Z tzero = {+0.0e+00,+0.0e00};
+
+   if (primme->aNorm <= 0.0L) {
+      tol = tol * aNormEstimate;
+   }
+
+   /* Compute the residual norms of the next Ritz pairs */
+
+   count = min(basisSize, primme->numEvals - numLocked);
+   for (i=0; i < count; i++) {
+      {ztmp.r = -hVals[i]; ztmp.i = 0.0L;}
+      Num_axpy_zprimme(n, ztmp, &V[n*i], 1, &W[n*i], 1);
+      ztmp = Num_dot_zprimme(n, &W[n*i], 1, &W[n*i], 1);
+      dwork[count+i] = ztmp.r;
+   }
+   if (count > 0) {
+      primme_globalSumDouble(&dwork[count], &dwork[0], &count, primme);
+   }
+
+   numConv = 0;
+   for (j=numLocked; j < primme->numEvals; j++) {
+      i = j - numLocked;
+      perm[j] = j;
+
+      if (i < count) {
+         evals[j] = hVals[i];
+         resNorms[j] = sqrt(dwork[i]);
+         if (resNorms[j] < tol) numConv++;
+         x = &V[n*i];
+      }
+      else {
+         /* The basis is too small; return a zero vector. The residual */
+         /* vectors in W are no longer needed                          */
+         evals[j] = 0.0L;
+         resNorms[j] = -1.0L;
+         x = W;
+         if (i == count) Num_scal_zprimme(n, tzero, x, 1);
+      }
+
+      if (primme->lockStoreParams.file != NULL) {
+         ret = lock_store_write_zprimme(x, j, 1, primme);
+         if (ret != 0) return ret;
+      }
+      else {
+         Num_zcopy_zprimme(n, x, 1, &evecs[n*(primme->numOrthoConst+j)], 1);
+         primme->stats.bytesMoved += n*sizeof(Complex_Z);
+      }
+   }
+
+   return numConv;
+}
+
+/*******************************************************************************
+ * Function monitor_stop - Calls monitorFun with the current Ritz values,
+ *    residual norms and counters. With several processes, the solver stops
+ *    if monitorFun asks so on any of them, so that all processes leave the
+ *    iteration at the same point.
+ *
+ * INPUT ARRAYS AND PARAMETERS
+ * ---------------------------
+ * event        primme_event_outer, primme_event_restart or primme_event_lock
+ * hVals        The Ritz values of the basis
+ * basisSize    The size of the basis
+ * iev          The index in hVals of each vector in the block
+ * blockNorms   The residual norms of the block vectors
+ * blockSize    The size of the block, 0 if the norms are not current
+ * numConverged The number of converged pairs, including the locked ones
+ * evals        The locked eigenvalues
+ * resNorms     The residual norms of the locked eigenpairs
+ * numLocked    The number of locked eigenpairs
+ *
+ * Return value
+ * ------------
+ * Nonzero if the solver should stop
+ *
+ ******************************************************************************/
+
+static int monitor_stop(primme_event_type event, double *hVals, int basisSize,
+   int *iev, double *blockNorms, int blockSize, int numConverged,
+   double *evals, double *resNorms, int numLocked, primme_params *primme) {
+
+   primme_monitor info;
+   double stop, globalStop;
+   int one = 1;
+
+   info.event = event;
+   info.ritzVals = hVals;
+   info.basisSize = basisSize;
+   info.blockIndex = iev;
+   info.blockNorms = blockNorms;
+   info.blockSize = blockSize;
+   info.numConverged = numConverged;
+   info.lockedVals = evals;
+   info.lockedNorms = resNorms;
+   info.numLocked = numLocked;
+
+   stop = primme->monitorFun(&info, primme) ? 1.0L : 0.0L;
+
+   if (primme->numProcs > 1) {
+      primme_globalSumDouble(&stop, &globalStop, &one, primme);
+      stop = globalStop;
+   }
+
+   return stop > 0.0L;
+}
+
+/*******************************************************************************
+ * Subroutine record_restart_progress - Records in restartingParams.trace the
+ *    number of matvecs since the previous restart and the reduction per 
+ *    matvec of the residual norm of the first block vector, in log10 scale.
+ *    The restart policies may use them to choose the restart size.
+ *
+ * INPUT PARAMETERS
+ * ----------------
+ * resNorm         The residual norm of the first target at the last
+ *                 convergence check
+ * restartMatvecs  The number of matvecs at the previous restart
+ *
+ * INPUT/OUTPUT PARAMETERS
+ * -----------------------
+ * primme          The field restartingParams.trace is updated
+ ******************************************************************************/
+
+static void record_restart_progress(double resNorm, int restartMatvecs,
+   primme_params *primme) {
+
+   restart_trace *trace = &primme->restartingParams.trace;
+
+   trace->matvecs = primme->stats.numMatvecs - restartMatvecs;
+   if (trace->resNorm > 0.0L && resNorm > 0.0L && trace->matvecs > 0) {
+      trace->convRate = log10(trace->resNorm/resNorm)/trace->matvecs;
+   }
+   else {
+      trace->convRate = 0.0L;
+   }
+   trace->resNorm = resNorm;
+}
+
 /******************************************************************************
            Dynamic Method Switching uses the following functions 
     ---------------------------------------------------------------------
@@ -1038,12 +1529,16 @@ static void switch_from_JDQMR(primme_CostModel *model, primme_params *primme) {
 
       /* If more many procs, make sure that all have the same ratio */
       if (primme->numProcs > 1) {
-         (*primme->globalSumDouble)(&ratio, &globalRatio, &one, primme); 
+         primme_globalSumDouble(&ratio, &globalRatio, &one, primme); 
          ratio = globalRatio/primme->numProcs;
       }
 
       if (ratio > 1.05) { 
          /* Always use GD+k. No further model updates */
+         if (EVENTS_ON(primme)) {
+            primme_event_push(primme_event_switch, 2, -1, 0, ratio, 0.0L,
+               primme);
+         }
          primme->dynamicMethodSwitch = -1;
          primme->correctionParams.maxInnerIterations = 0;
          if (primme->printLevel >= 3 && primme->procID == 0) 
@@ -1069,11 +1564,15 @@ static void switch_from_JDQMR(primme_CostModel *model, primme_params *primme) {
 
    /* If more many procs, make sure that all have the same ratio */
    if (primme->numProcs > 1) {
-      (*primme->globalSumDouble)(&ratio, &globalRatio, &one, primme); 
+      primme_globalSumDouble(&ratio, &globalRatio, &one, primme); 
       ratio = globalRatio/primme->numProcs;
    }
    
    if (ratio > 1.05) {
+      if (EVENTS_ON(primme)) {
+         primme_event_push(primme_event_switch, primme->dynamicMethodSwitch,
+            switchto, 0, ratio, 0.0L, primme);
+      }
       primme->dynamicMethodSwitch = switchto; 
       primme->correctionParams.maxInnerIterations = 0;
    }
@@ -1148,6 +1647,10 @@ static void switch_from_GDpk(primme_CostModel *model, primme_params *primme) {
 
    /* If JDQMR never run before, switch to it to get first measurements */
    if (model->qmr_only == 0.0) {
+      if (EVENTS_ON(primme)) {
+         primme_event_push(primme_event_switch, primme->dynamicMethodSwitch,
+            switchto, 0, 0.0L, 0.0L, primme);
+      }
       primme->dynamicMethodSwitch = switchto;
       primme->correctionParams.maxInnerIterations = -1;
       if (primme->printLevel >= 3 && primme->procID == 0) 
@@ -1166,11 +1669,15 @@ static void switch_from_GDpk(primme_CostModel *model, primme_params *primme) {
 
    /* If more many procs, make sure that all have the same ratio */
    if (primme->numProcs > 1) {
-      (*primme->globalSumDouble)(&ratio, &globalRatio, &one, primme); 
+      primme_globalSumDouble(&ratio, &globalRatio, &one, primme); 
       ratio = globalRatio/primme->numProcs;
    }
 
    if (ratio < 0.95) {
+      if (EVENTS_ON(primme)) {
+         primme_event_push(primme_event_switch, primme->dynamicMethodSwitch,
+            switchto, 0, ratio, 0.0L, primme);
+      }
       primme->dynamicMethodSwitch = switchto;
       primme->correctionParams.maxInnerIterations = -1;
    } 
@@ -1496,6 +2003,7 @@ static void initializeModel(primme_CostModel *model, primme_params *primme) {
    model->gdk_plus_MV    = 0.0L;
    model->project_locked = 0.0L;
    model->reortho_locked = 0.0L;
+   model->lock_per_vector= 0.0L;
 
    model->gdk_conv_rate  = 0.0001L;
    model->jdq_conv_rate  = 0.0001L;
@@ -1512,13 +2020,566 @@ static void initializeModel(primme_CostModel *model, primme_params *primme) {
 
    model->numMV_0 = primme->stats.numMatvecs;
    model->numIt_0 = primme->stats.numOuterIterations+1;
-   model->timer_0 = primme_wTimer(0);
+   model->timer_0 = model_clock(primme);
    model->time_in_inner  = 0.0L;
    model->resid_0        = -1.0L;
 
    model->accum_jdq      = 0.0L;
    model->accum_gdk      = 0.0L;
    model->accum_jdq_gdk  = 1.0L;
+
+   model->blockSize      = primme->maxBlockSize;
+   model->tuneKnob       = primme->tuningParams.blockSize ? 0 : 1;
+   model->tuneStep[0]    = -1;
+   model->tuneStep[1]    = -1;
+   model->tuneConverged  = 0;
+   model->tuneMV         = primme->stats.numMatvecs;
+   model->tuneIt         = primme->stats.numOuterIterations;
+   model->tuneTimer      = model->timer_0;
+   model->tuneResid      = 0.0L;
+   model->tuneRate       = 0.0L;
+}
+
+/******************************************************************************
+ * Function model_clock - Returns the clock the cost model is measured with:
+ *    the wall time, or in deterministic mode the number of matvecs and
+ *    preconditioning operations performed. In the latter case the choices
+ *    of the model depend only on the iteration history and are reproducible,
+ *    but the dense work (ortho, projection, locking) is not accounted for.
+ ******************************************************************************/
+static double model_clock(primme_params *primme) {
+
+   if (primme->tuningParams.deterministic)
+      return (double) (primme->stats.numMatvecs + primme->stats.numPreconds);
+   return ELAPSED_TIME(primme);
+}
+
+/******************************************************************************
+ * Function read_model_cache - Looks up the model of the current problem in
+ *    the text file tuningParams.cacheFile. Every line of the file holds 
+ *    the key (n, cacheKey, target, numEvals, deterministic) followed by
+ *    MODEL_CACHE_SIZE measured parameters of the model; if several lines 
+ *    match, the last one is used. The process 0 reads the file and the 
+ *    values are broadcast with globalSumDouble, so all processes start 
+ *    with the same model. A missing or unreadable file is a cache miss.
+ *
+ *    The cached timings and convergence rates take the place of the 
+ *    warm-up measurements, and the ratio JDQMR/GD+k of the previous run 
+ *    counts as one evaluation for the final recommendation.
+ *
+ * INPUT/OUTPUT
+ * ------------
+ * model        The measured fields are set if the problem is in the cache
+ *
+ * Return value
+ * ------------
+ *  1 if the model was found in the cache, 0 otherwise
+ ******************************************************************************/
+static int read_model_cache(primme_CostModel *model, primme_params *primme) {
+
+   FILE *file;
+   int i, count, n, target, numEvals, deterministic;
+   long int key;
+   double entry[MODEL_CACHE_SIZE];     /* Values of the current line       */
+   double cached[MODEL_CACHE_SIZE+1];  /* Values of the last match + found */
+   double global[MODEL_CACHE_SIZE+1];
+
+   for (i=0; i <= MODEL_CACHE_SIZE; i++) cached[i] = 0.0L;
+
+   if (primme->procID == 0 &&
+       (file = fopen(primme->tuningParams.cacheFile, "r")) != NULL) {
+      while (fscanf(file, "%d %ld %d %d %d", &n, &key, &target, &numEvals,
+                    &deterministic) == 5) {
+         for (i=0; i < MODEL_CACHE_SIZE; i++) {
+            if (fscanf(file, "%le", &entry[i]) != 1) break;
+         }
+         if (i < MODEL_CACHE_SIZE) break;
+
+         if (n == primme->n && key == primme->tuningParams.cacheKey &&
+             target == (int) primme->target && numEvals == primme->numEvals &&
+             deterministic == (primme->tuningParams.deterministic != 0)) {
+            for (i=0; i < MODEL_CACHE_SIZE; i++) cached[i] = entry[i];
+            cached[MODEL_CACHE_SIZE] = 1.0L;
+         }
+      }
+      fclose(file);
+   }
+
+   if (primme->numProcs > 1) {
+      count = MODEL_CACHE_SIZE+1;
+      primme_globalSumDouble(cached, global, &count, primme);
+      for (i=0; i <= MODEL_CACHE_SIZE; i++) cached[i] = global[i];
+   }
+
+   if (cached[MODEL_CACHE_SIZE] == 0.0L) return 0;
+
+   set_model_parameters(model, cached);
+
+   if (primme->printLevel >= 3 && primme->procID == 0) {
+      fprintf(primme->outputFile, "Model read from %s. Ratio: %e\n",
+         primme->tuningParams.cacheFile, model->accum_jdq_gdk);
+   }
+
+   return 1;
+}
+
+/******************************************************************************
+ * Function write_model_cache - Stores the model of the current problem in
+ *    the file tuningParams.cacheFile, in the format of read_model_cache.
+ *    The entries of other problems are copied to a temporary file followed
+ *    by the current one, and the temporary file replaces the cache; so the
+ *    cache keeps one line per key, and a failed write leaves the previous
+ *    cache. As in read_model_cache, a malformed line ends the entries.
+ *    Only process 0 writes. A failure to write is not an error; it is 
+ *    reported with printLevel >= 1.
+ ******************************************************************************/
+static void write_model_cache(primme_CostModel *model, primme_params *primme) {
+
+   FILE *file, *tmpFile;
+   char *tmpName;
+   int i, n, target, numEvals, deterministic, ok;
+   long int key;
+   double values[MODEL_CACHE_SIZE];
+
+   if (primme->procID != 0) return;
+
+   /* The temporary file is unique, so that concurrent solves sharing */
+   /* the cache (processes, slices) do not write into the same one    */
+
+   tmpName = (char *) malloc(strlen(primme->tuningParams.cacheFile) + 8);
+   tmpFile = NULL;
+   if (tmpName != NULL) {
+#if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
+      int fd;
+      sprintf(tmpName, "%s.XXXXXX", primme->tuningParams.cacheFile);
+      fd = mkstemp(tmpName);
+      if (fd >= 0 && (tmpFile = fdopen(fd, "w")) == NULL) {
+         close(fd);
+         remove(tmpName);
+      }
+#else
+      sprintf(tmpName, "%s.tmp", primme->tuningParams.cacheFile);
+      tmpFile = fopen(tmpName, "w");
+#endif
+   }
+   if (tmpFile == NULL) {
+      if (primme->printLevel >= 1) {
+         fprintf(primme->outputFile, "Warning: cannot write the model to %s\n",
+            primme->tuningParams.cacheFile);
+      }
+      free(tmpName);
+      return;
+   }
+
+   /* Copy the entries with a different key */
+
+   if ((file = fopen(primme->tuningParams.cacheFile, "r")) != NULL) {
+      while (fscanf(file, "%d %ld %d %d %d", &n, &key, &target, &numEvals,
+                    &deterministic) == 5) {
+         for (i=0; i < MODEL_CACHE_SIZE; i++) {
+            if (fscanf(file, "%le", &values[i]) != 1) break;
+         }
+         if (i < MODEL_CACHE_SIZE) break;
+
+         if (n == primme->n && key == primme->tuningParams.cacheKey &&
+             target == (int) primme->target && numEvals == primme->numEvals &&
+             deterministic == (primme->tuningParams.deterministic != 0)) {
+            continue;
+         }
+         fprintf(tmpFile, "%d %ld %d %d %d", n, key, target, numEvals,
+            deterministic);
+         for (i=0; i < MODEL_CACHE_SIZE; i++) {
+            fprintf(tmpFile, " %.10e", values[i]);
+         }
+         fprintf(tmpFile, "\n");
+      }
+      fclose(file);
+   }
+
+   /* Add the current problem */
+
+   fprintf(tmpFile, "%d %ld %d %d %d", primme->n, primme->tuningParams.cacheKey,
+      (int) primme->target, primme->numEvals, 
+      primme->tuningParams.deterministic != 0);
+   get_model_parameters(model, values);
+   for (i=0; i < MODEL_CACHE_SIZE; i++) {
+      fprintf(tmpFile, " %.10e", values[i]);
+   }
+   ok = fprintf(tmpFile, "\n") > 0;
+   ok = (fclose(tmpFile) == 0) && ok;
+
+   /* Replace the cache; remove() is needed where rename() does not */
+   /* overwrite an existing file                                     */
+
+   if (ok && rename(tmpName, primme->tuningParams.cacheFile) != 0) {
+      remove(primme->tuningParams.cacheFile);
+      ok = rename(tmpName, primme->tuningParams.cacheFile) == 0;
+   }
+   if (!ok) {
+      remove(tmpName);
+      if (primme->printLevel >= 1) {
+         fprintf(primme->outputFile, "Warning: cannot write the model to %s\n",
+            primme->tuningParams.cacheFile);
+      }
+   }
+   free(tmpName);
+}
+
+/******************************************************************************
+ * Function get_model_parameters - Packs the measured parameters of the model
+ *    into MODEL_CACHE_SIZE values, in the order of the tuning cache.
+ ******************************************************************************/
+static void get_model_parameters(primme_CostModel *model, double *values) {
+
+   values[0]  = model->MV;
+   values[1]  = model->PR;
+   values[2]  = model->qmr_only;
+   values[3]  = model->qmr_plus_MV_PR;
+   values[4]  = model->gdk_plus_MV;
+   values[5]  = model->reortho_locked;
+   values[6]  = model->project_locked;
+   values[7]  = model->gdk_conv_rate;
+   values[8]  = model->jdq_conv_rate;
+   values[9]  = model->JDQMR_slowdown;
+   values[10] = model->ratio_MV_outer;
+   values[11] = model->accum_jdq_gdk;
+}
+
+/******************************************************************************
+ * Function set_model_parameters - Sets the measured parameters of the model
+ *    from the values packed by get_model_parameters, and the fields derived
+ *    from them.
+ ******************************************************************************/
+static void set_model_parameters(primme_CostModel *model, double *values) {
+
+   model->MV             = values[0];
+   model->PR             = values[1];
+   model->qmr_only       = values[2];
+   model->qmr_plus_MV_PR = values[3];
+   model->gdk_plus_MV    = values[4];
+   model->reortho_locked = values[5];
+   model->project_locked = values[6];
+   model->gdk_conv_rate  = values[7];
+   model->jdq_conv_rate  = values[8];
+   model->JDQMR_slowdown = values[9];
+   model->ratio_MV_outer = values[10];
+   model->accum_jdq_gdk  = values[11];
+   model->MV_PR          = model->MV + model->PR;
+   model->gdk_plus_MV_PR = model->gdk_plus_MV + model->PR;
+   model->accum_gdk      = model->gdk_plus_MV_PR;
+   model->accum_jdq      = model->gdk_plus_MV_PR*model->accum_jdq_gdk;
+}
+
+/******************************************************************************
+ * Function restore_continuation - Takes the state kept by the previous call
+ *    in primme->continuationParams.state. The state is ignored and released
+ *    if continuationParams.keepState is false or if it was saved for a 
+ *    problem of different dimension or arithmetic.
+ *
+ *    The robust shift history and the largest Ritz value are restored. If
+ *    the previous call measured the cost model, the model is restored and 
+ *    the dynamic method switch is turned on again, so that the method 
+ *    recommended by the previous call is tried first and the switching 
+ *    continues from the previous measurements.
+ *
+ * OUTPUT
+ * ------
+ * prevRitzVals     The shift history of the previous call
+ * numPrevRitzVals  Size of prevRitzVals
+ * largestRitzValue The largest Ritz value of the previous call
+ * model            The measured fields are set if the state has a model
+ * extra            The extra Ritz vectors of the previous call; they remain
+ *                  valid until save_continuation is called
+ * numExtra         Number of vectors in extra
+ *
+ * Return value
+ * ------------
+ *  1 if the model was restored, 0 otherwise
+ ******************************************************************************/
+static int restore_continuation(double *prevRitzVals, int *numPrevRitzVals,
+   double *largestRitzValue, primme_CostModel *model, Complex_Z **extra, 
+   int *numExtra, primme_params *primme) {
+
+   int i;
+   double *savedVals;
+   primme_continuation *state;
+
+   *extra = NULL;
+   *numExtra = 0;
+   state = (primme_continuation *) primme->continuationParams.state;
+   if (state == NULL) return 0;
+
+   if (!primme->continuationParams.keepState || state->n != primme->n ||
+       state->nLocal != primme->nLocal || state->elemSize != sizeof(Complex_Z)) {
+      free(state);
+      primme->continuationParams.state = NULL;
+      return 0;
+   }
+
+   savedVals = (double *) (state + 1);
+   *numPrevRitzVals = min(state->numPrevRitzVals, 
+                          primme->numEvals + primme->maxBasisSize);
+   for (i=0; i < *numPrevRitzVals; i++) {
+      prevRitzVals[i] = savedVals[i];
+   }
+   *largestRitzValue = state->largestRitzValue;
+   *extra = (Complex_Z *) (savedVals + state->numPrevRitzVals);
+   *numExtra = state->numExtra;
+
+   if (!state->dynamic || primme->dynamicMethodSwitch == 0) return 0;
+
+   set_model_parameters(model, state->model);
+   if (primme->dynamicMethodSwitch < 0) primme->dynamicMethodSwitch = 1;
+
+   if (primme->printLevel >= 3 && primme->procID == 0) {
+      fprintf(primme->outputFile, "Model kept from the previous call. "
+         "Ratio: %e\n", model->accum_jdq_gdk);
+   }
+
+   return 1;
+}
+
+/******************************************************************************
+ * Function save_continuation - Keeps in primme->continuationParams.state the
+ *    state for the next call, if continuationParams.keepState is true: the
+ *    robust shift history, the largest Ritz value, the cost model if it was
+ *    measured and up to continuationParams.maxExtraVectors Ritz vectors 
+ *    V(:,first:basisSize-1). The state of the previous call is released.
+ *    A failure to allocate the state is not an error; it is reported with
+ *    printLevel >= 1.
+ *
+ * INPUT
+ * -----
+ * V                The basis, after the last restart
+ * first            Index in V of the first Ritz vector to keep
+ * basisSize        Size of the basis
+ * prevRitzVals     The shift history
+ * numPrevRitzVals  Size of prevRitzVals
+ * largestRitzValue The largest Ritz value computed
+ * model            The cost model
+ ******************************************************************************/
+static void save_continuation(Complex_Z *V, int first, int basisSize, 
+   double *prevRitzVals, int numPrevRitzVals, double largestRitzValue, 
+   primme_CostModel *model, primme_params *primme) {
+
+   int i, numExtra;
+   size_t stateSize;
+   double *savedVals;
+   primme_continuation *state;
+
+   free(primme->continuationParams.state);
+   primme->continuationParams.state = NULL;
+   if (!primme->continuationParams.keepState) return;
+
+   numExtra = max(0, min(primme->continuationParams.maxExtraVectors,
+                         basisSize - first));
+   stateSize = sizeof(primme_continuation) +
+      numPrevRitzVals*sizeof(double) + 
+      (size_t)numExtra*primme->nLocal*sizeof(Complex_Z);
+   TRACK_ALLOC(stateSize);
+   state = (primme_continuation *) malloc(stateSize);
+
+   if (state == NULL) {
+      if (primme->printLevel >= 1 && primme->procID == 0) {
+         fprintf(primme->outputFile, 
+            "Warning: cannot keep the state for the next call\n");
+      }
+      return;
+   }
+
+   state->n = primme->n;
+   state->nLocal = primme->nLocal;
+   state->elemSize = sizeof(Complex_Z);
+   state->numPrevRitzVals = numPrevRitzVals;
+   state->numExtra = numExtra;
+   state->dynamic = primme->dynamicMethodSwitch < 0 && 
+                    model->gdk_plus_MV > 0.0L;
+   state->largestRitzValue = largestRitzValue;
+   get_model_parameters(model, state->model);
+
+   savedVals = (double *) (state + 1);
+   for (i=0; i < numPrevRitzVals; i++) {
+      savedVals[i] = prevRitzVals[i];
+   }
+   Num_zcopy_zprimme(primme->nLocal*numExtra, &V[primme->nLocal*first], 1,
+      (Complex_Z *) (savedVals + numPrevRitzVals), 1);
+   primme->stats.bytesMoved += 
+      (double)primme->nLocal*numExtra*sizeof(Complex_Z);
+
+   primme->continuationParams.state = state;
+}
+
+/******************************************************************************
+ * Function update_locked_costs - Updates the costs c_g and c_p of the model
+ *    with the times measured since the last update. ortho adds to
+ *    stats.timeOrthoLocked the time spent against the constraints and the
+ *    locked vectors (in memory or in the lock store), so c_g is that time
+ *    per column for one outer step. inner_solve adds to 
+ *    stats.timeProjectLocked the time of the projections of every QMR step
+ *    divided by the number of columns projected against, and counts the
+ *    steps in stats.numProjectLocked, so c_p is their ratio. Until a QMR 
+ *    step has been timed, c_p is estimated as half of c_g per block vector.
+ *    If the correction does not project against the locked vectors, c_p=0.
+ *    In deterministic mode the dense work is not part of the model, and 
+ *    nothing is updated.
+ *
+ * INPUT
+ * -----
+ * orthoTime    Time spent by ortho against the locked vectors
+ * numColumns   Number of constraints and locked vectors
+ * projectTime  Time per column of the QMR projections since the last update
+ * numSteps     Number of QMR steps since the last update
+ * blockSize    Number of vectors in the block
+ *
+ * INPUT/OUTPUT
+ * ------------
+ * model        The fields reortho_locked and project_locked are updated
+ ******************************************************************************/
+static void update_locked_costs(primme_CostModel *model, double orthoTime,
+   int numColumns, double projectTime, int numSteps, int blockSize,
+   primme_params *primme) {
+
+   double perColumn;
+
+   if (primme->tuningParams.deterministic) return;
+
+   /* Average the last two measurements, as for the other timings */
+   if (numColumns > 0) {
+      perColumn = orthoTime/numColumns;
+      if (model->reortho_locked == 0.0L) 
+         model->reortho_locked = perColumn;
+      else 
+         model->reortho_locked = (model->reortho_locked + perColumn)/2.0L;
+   }
+
+   if (!primme->correctionParams.projectors.LeftQ &&
+       !primme->correctionParams.projectors.RightQ) {
+      model->project_locked = 0.0L;
+   }
+   else if (numSteps > 0) {
+      perColumn = projectTime/numSteps;
+      if (model->project_locked == 0.0L) 
+         model->project_locked = perColumn;
+      else 
+         model->project_locked = (model->project_locked + perColumn)/2.0L;
+   }
+   else if (model->project_locked == 0.0L && blockSize > 0) {
+      model->project_locked = model->reortho_locked/(2.0L*blockSize);
+   }
+}
+
+/******************************************************************************
+ * Function tune_parameters - Online tuning of the block size and the 
+ *    maximum number of inner iterations, called after every restart.
+ *    As in adaptive thick restarting, the tuned parameter moves one step 
+ *    in the direction that sped up the reduction of the residual norm of
+ *    the first target, but here measured per unit of time (model_clock),
+ *    since a larger block or more inner iterations trade matvecs for time.
+ *    If the last move slowed down the convergence, it is undone and the 
+ *    other parameter is moved next. The rate is not measured if a pair 
+ *    converged since the previous restart, as the target changed.
+ *    With several processes the rate is averaged over them, so that all
+ *    take the same decision (their clocks differ) and keep calling 
+ *    globalSumDouble with the same block size.
+ *
+ *    The block size moves by one in [1, maxBlockSize]. The inner iterations
+ *    are tuned only while running JDQMR (maxInnerIterations != 0): from the
+ *    unbounded -1 the first step down caps them at the average number of 
+ *    inner iterations per outer step; then the cap is halved or doubled, 
+ *    back to -1 if it exceeds n. Dynamic method switching may reset it.
+ *
+ * INPUT
+ * -----
+ * resNorm       Residual norm of the first target
+ * numConverged  Number of converged pairs
+ *
+ * INPUT/OUTPUT
+ * ------------
+ * model         The tuning fields and blockSize are updated
+ * primme        correctionParams.maxInnerIterations may be updated
+ ******************************************************************************/
+static void tune_parameters(primme_CostModel *model, double resNorm,
+   int numConverged, primme_params *primme) {
+
+   int k, kout, prev, one = 1;
+   int canTune[2];
+   int *inner = &primme->correctionParams.maxInnerIterations;
+   double now, rate, globalRate, kinn;
+
+   canTune[0] = primme->tuningParams.blockSize && primme->maxBlockSize > 1;
+   canTune[1] = primme->tuningParams.innerIterations && *inner != 0;
+   now = model_clock(primme);
+
+   rate = 0.0L;
+   if (numConverged == model->tuneConverged && model->tuneResid > 0.0L &&
+       resNorm > 0.0L && resNorm < model->tuneResid && now > model->tuneTimer)
+      rate = log10(model->tuneResid/resNorm)/(now - model->tuneTimer);
+
+   /* If many procs, make sure that all have the same rate */
+   if (primme->numProcs > 1 && (canTune[0] || canTune[1])) {
+      primme_globalSumDouble(&rate, &globalRate, &one, primme);
+      rate = globalRate/primme->numProcs;
+   }
+
+   if (rate > 0.0L && (canTune[0] || canTune[1])) {
+      k = canTune[model->tuneKnob] ? model->tuneKnob : 1 - model->tuneKnob;
+      if (model->tuneRate > 0.0L && rate < model->tuneRate) {
+         model->tuneStep[k] = -model->tuneStep[k];
+         if (canTune[1-k]) model->tuneKnob = 1-k;
+      }
+
+      if (k == 0) {
+         prev = model->blockSize;
+         model->blockSize = max(1, min(primme->maxBlockSize, 
+                                       model->blockSize + model->tuneStep[0]));
+         if (model->blockSize == prev) model->tuneStep[0] = -model->tuneStep[0];
+      }
+      else {
+         prev = *inner;
+         if (*inner < 0 && model->tuneStep[1] < 0) {
+            kout = max(1, primme->stats.numOuterIterations - model->tuneIt);
+            kinn = ((double) (primme->stats.numMatvecs - model->tuneMV))
+                      /(kout*model->blockSize) - 2.0L;
+            *inner = max(1, (int) kinn);
+         }
+         else if (*inner > 0 && model->tuneStep[1] < 0) {
+            *inner = max(1, *inner/2);
+         }
+         else if (*inner > 0) {
+            *inner = *inner*2 > primme->n ? -1 : *inner*2;
+         }
+         if (*inner == prev) model->tuneStep[1] = -model->tuneStep[1];
+      }
+
+      if (primme->printLevel >= 3 && primme->procID == 0) {
+         fprintf(primme->outputFile, 
+            "TUNE blockSize %d maxInnerIterations %d rate %e\n",
+            model->blockSize, *inner, rate);
+      }
+   }
+
+   model->tuneRate      = rate;
+   model->tuneConverged = numConverged;
+   model->tuneMV        = primme->stats.numMatvecs;
+   model->tuneIt        = primme->stats.numOuterIterations;
+   model->tuneTimer     = now;
+   model->tuneResid     = resNorm;
+}
+
+/******************************************************************************
+ * Function export_model - Copies the state of the model to stats.model
+ ******************************************************************************/
+static void export_model(primme_CostModel *model, primme_params *primme) {
+
+   primme->stats.model.MV             = model->MV;
+   primme->stats.model.PR             = model->PR;
+   primme->stats.model.reorthoLocked  = model->reortho_locked;
+   primme->stats.model.projectLocked  = model->project_locked;
+   primme->stats.model.lockPerVector  = model->lock_per_vector;
+   primme->stats.model.ratioJDQMR_GDk = model->accum_jdq_gdk;
+   primme->stats.model.blockSize      = model->blockSize;
+   primme->stats.model.maxInnerIterations = 
+                              primme->correctionParams.maxInnerIterations;
 }
 
 #if 0
@@ -53,6 +53,8 @@
 #define ZHEEV     FORTRAN_FUNCTION(zheev)
 #define ZHETRF    FORTRAN_FUNCTION(zhetrf)
 #define ZHETRS    FORTRAN_FUNCTION(zhetrs)
+#define ZPOTRF    FORTRAN_FUNCTION(zpotrf)
+#define ZTRSM     FORTRAN_FUNCTION(ztrsm)
 
 #define DCOPY     FORTRAN_FUNCTION(dcopy)
 #define DSWAP     FORTRAN_FUNCTION(dswap)
@@ -66,6 +68,8 @@
 #define DSYEV     FORTRAN_FUNCTION(dsyev)
 #define DSYTRF    FORTRAN_FUNCTION(dsytrf)
 #define DSYTRS    FORTRAN_FUNCTION(dsytrs)
+#define DPOTRF    FORTRAN_FUNCTION(dpotrf)
+#define DTRSM     FORTRAN_FUNCTION(dtrsm)
 
 #ifdef NUM_ESSL
 #include <essl.h>
@@ -88,6 +92,8 @@
 #define ZHEEV  zheev
 #define ZHETRF zhetrf
 #define ZHETRS zhetrs
+#define ZPOTRF zpotrf
+#define ZTRSM  ztrsm
 
 #define DCOPY  SCOPY
 #define DSWAP  SSWAP
@@ -102,6 +108,8 @@
 #define DSYEV  SSYEV
 #define DSYTRF DSYTRF
 #define DSYTRS DSYTRS
+#define DPOTRF SPOTRF
+#define DTRSM  STRSM
 
 #endif /* NUM_CRAY */
 
@@ -130,6 +138,9 @@ void DSYTRF(const char *uplo, PRIMME_BLASINT *n, double *a, PRIMME_BLASINT *lda,
    PRIMME_BLASINT *ldwork, PRIMME_BLASINT *info);
 void DSYTRS(const char *uplo, PRIMME_BLASINT *n, PRIMME_BLASINT *nrhs, double *a, PRIMME_BLASINT *lda, PRIMME_BLASINT *ipivot,
    double *b, PRIMME_BLASINT *ldb, PRIMME_BLASINT *info);
+void DPOTRF(const char *uplo, PRIMME_BLASINT *n, double *a, PRIMME_BLASINT *lda, PRIMME_BLASINT *info);
+void DTRSM(const char *side, const char *uplo, const char *transa, const char *diag, PRIMME_BLASINT *m,
+   PRIMME_BLASINT *n, double *alpha, double *a, PRIMME_BLASINT *lda, double *b, PRIMME_BLASINT *ldb);
 
 void   ZCOPY(PRIMME_BLASINT *n, void *x, PRIMME_BLASINT *incx, void *y, PRIMME_BLASINT *incy);
 void   ZSWAP(PRIMME_BLASINT *n, void *x, PRIMME_BLASINT *incx, void *y, PRIMME_BLASINT *incy);
@@ -142,6 +153,8 @@ void   ZLARNV(PRIMME_BLASINT *idist, PRIMME_BLASINT *iseed, PRIMME_BLASINT *n, v
 void   ZHEEV(const char *jobz, const char *uplo, PRIMME_BLASINT *n, void *a, PRIMME_BLASINT *lda, double *w, void *work, PRIMME_BLASINT *ldwork, double *rwork, PRIMME_BLASINT *info);
 void   ZHETRF(const char *uplo, PRIMME_BLASINT *n, void *a, PRIMME_BLASINT *lda, PRIMME_BLASINT *ipivot, void *work, PRIMME_BLASINT *ldwork, PRIMME_BLASINT *info);
 void   ZHETRS(const char *uplo, PRIMME_BLASINT *n, PRIMME_BLASINT *nrhs, void *a, PRIMME_BLASINT *lda, PRIMME_BLASINT *ipivot, void *b, PRIMME_BLASINT *ldb, PRIMME_BLASINT *info);
+void   ZPOTRF(const char *uplo, PRIMME_BLASINT *n, void *a, PRIMME_BLASINT *lda, PRIMME_BLASINT *info);
+void   ZTRSM(const char *side, const char *uplo, const char *transa, const char *diag, PRIMME_BLASINT *m, PRIMME_BLASINT *n, void *alpha, void *a, PRIMME_BLASINT *lda, void *b, PRIMME_BLASINT *ldb);
 void   ZDOTCSUB(void *dot, PRIMME_BLASINT *n, void *x, PRIMME_BLASINT *incx, void *y, PRIMME_BLASINT *incy);
 
 #ifdef NUM_ESSL
@@ -172,6 +185,9 @@ void DSYTRF(_fcd uplo, PRIMME_BLASINT *n, double *a, PRIMME_BLASINT *lda, PRIMME
    PRIMME_BLASINT *ldwork, PRIMME_BLASINT *info);
 void DSYTRS(_fcd uplo, PRIMME_BLASINT *n, PRIMME_BLASINT *nrhs, double *a, PRIMME_BLASINT *lda, PRIMME_BLASINT *ipivot,
    double *b, PRIMME_BLASINT *ldb, PRIMME_BLASINT *info);
+void DPOTRF(_fcd uplo, PRIMME_BLASINT *n, double *a, PRIMME_BLASINT *lda, PRIMME_BLASINT *info);
+void DTRSM(_fcd side, _fcd uplo, _fcd transa, _fcd diag, PRIMME_BLASINT *m, PRIMME_BLASINT *n,
+   double *alpha, double *a, PRIMME_BLASINT *lda, double *b, PRIMME_BLASINT *ldb);
 
 void   ZCOPY(PRIMME_BLASINT *n, void *x, PRIMME_BLASINT *incx, void *y, PRIMME_BLASINT *incy);
 void   ZSWAP(PRIMME_BLASINT *n, void *x, PRIMME_BLASINT *incx, void *y, PRIMME_BLASINT *incy);
@@ -186,9 +202,17 @@ void   ZDOTCSUB(void *dot, PRIMME_BLASINT *n, void *x, PRIMME_BLASINT *incx, voi
 
 void   ZHETRF(_fcd uplo, PRIMME_BLASINT *n, void *a, PRIMME_BLASINT *lda, PRIMME_BLASINT *ipivot, void *work, PRIMME_BLASINT *ldwork, PRIMME_BLASINT *info);
 void   ZHETRS(_fcd uplo, PRIMME_BLASINT *n, PRIMME_BLASINT *nrhs, void *a, PRIMME_BLASINT *lda, PRIMME_BLASINT *ipivot, void *b, PRIMME_BLASINT *ldb, PRIMME_BLASINT *info);
+void   ZPOTRF(_fcd uplo, PRIMME_BLASINT *n, void *a, PRIMME_BLASINT *lda, PRIMME_BLASINT *info);
+void   ZTRSM(_fcd side, _fcd uplo, _fcd transa, _fcd diag, PRIMME_BLASINT *m, PRIMME_BLASINT *n, void *alpha, void *a, PRIMME_BLASINT *lda, void *b, PRIMME_BLASINT *ldb);
 
 #endif /* NUM_CRAY */
 
+/* Internal kernels (see Num_*_kernel in numerical.c): minimum number of   */
+/* flops for a loop to be split among OpenMP threads, and number of rows   */
+/* of A per chunk in gemv                                                  */
+#define NUM_KERNEL_OMP_MIN  32768
+#define NUM_KERNEL_ROWS     512
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
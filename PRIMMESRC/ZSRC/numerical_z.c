@@ -33,6 +33,7 @@
 #include "numerical_private_z.h"
 #include "numerical_z.h"
 #include "primme.h"
+#include "track.h"
 #include <stdlib.h>   /* free */
 
 /******************************************************************************/
@@ -42,6 +43,12 @@ void Num_zcopy_zprimme(int n, Complex_Z *x, int incx, Complex_Z *y, int incy) {
    PRIMME_BLASINT lincx = incx;
    PRIMME_BLASINT lincy = incy;
 
+#ifdef NUM_KERNELS
+   if (incx == 1 && incy == 1) {
+      Num_copy_kernel_zprimme(n, x, y);
+      return;
+   }
+#endif
    ZCOPY(&ln, x, &lincx, y, &lincy);
 }
 /******************************************************************************/
@@ -94,6 +101,31 @@ void Num_symm_zprimme(const char *side, const char *uplo, int m, int n, Complex_
 
 }
 
+/******************************************************************************/
+void Num_trsm_zprimme(const char *side, const char *uplo, const char *transa,
+   const char *diag, int m, int n, Complex_Z alpha, Complex_Z *a, int lda, Complex_Z *b,
+   int ldb) {
+
+   PRIMME_BLASINT lm = m;
+   PRIMME_BLASINT ln = n;
+   PRIMME_BLASINT llda = lda;
+   PRIMME_BLASINT lldb = ldb;
+
+#ifdef NUM_CRAY
+   _fcd side_fcd, uplo_fcd, transa_fcd, diag_fcd;
+
+   side_fcd = _cptofcd(side, strlen(side));
+   uplo_fcd = _cptofcd(uplo, strlen(uplo));
+   transa_fcd = _cptofcd(transa, strlen(transa));
+   diag_fcd = _cptofcd(diag, strlen(diag));
+   ZTRSM(side_fcd, uplo_fcd, transa_fcd, diag_fcd, &lm, &ln, &alpha, a, &llda,
+         b, &lldb);
+#else
+   ZTRSM(side, uplo, transa, diag, &lm, &ln, &alpha, a, &llda, b, &lldb);
+#endif
+
+}
+
 /******************************************************************************/
 void Num_axpy_zprimme(int n, Complex_Z alpha, Complex_Z *x, int incx, 
    Complex_Z *y, int incy) {
@@ -102,6 +134,12 @@ void Num_axpy_zprimme(int n, Complex_Z alpha, Complex_Z *x, int incx,
    PRIMME_BLASINT lincx = incx;
    PRIMME_BLASINT lincy = incy;
 
+#ifdef NUM_KERNELS
+   if (incx == 1 && incy == 1) {
+      Num_axpy_kernel_zprimme(n, alpha, x, y);
+      return;
+   }
+#endif
    ZAXPY(&ln, &alpha, x, &lincx, y, &lincy);
 
 }
@@ -116,6 +154,13 @@ void Num_gemv_zprimme(const char *transa, int m, int n, Complex_Z alpha, Complex
    PRIMME_BLASINT lincx = incx;
    PRIMME_BLASINT lincy = incy;
 
+#ifdef NUM_KERNELS
+   if (incx == 1 && incy == 1 && *transa != 't' && *transa != 'T') {
+      Num_gemv_kernel_zprimme(transa, m, n, alpha, a, lda, x, beta, y);
+      return;
+   }
+#endif
+
 #ifdef NUM_CRAY
    _fcd transa_fcd;
 
@@ -135,6 +180,11 @@ Complex_Z Num_dot_zprimme(int n, Complex_Z *x, int incx, Complex_Z *y, int incy)
    int i;
    Complex_Z zdotc = {+0.0e+00,+0.0e00};
    if (n <= 0) return(zdotc);
+#ifdef NUM_KERNELS
+   if (incx==1 && incy==1) {
+      return Num_dot_kernel_zprimme(n, x, y);
+   }
+#endif
    if (incx==1 && incy==1) {
       for (i=0;i<n;i++) { /* zdotc = zdotc + dconjg(x(i))* y(i) */
         zdotc.r += x[i].r*y[i].r + x[i].i*y[i].i;
@@ -190,6 +240,12 @@ void Num_scal_zprimme(int n, Complex_Z alpha, Complex_Z *x, int incx) {
    PRIMME_BLASINT ln = n;
    PRIMME_BLASINT lincx = incx;
 
+#ifdef NUM_KERNELS
+   if (incx == 1) {
+      Num_scal_kernel_zprimme(n, alpha, x);
+      return;
+   }
+#endif
    ZSCAL(&ln, &alpha, x, &lincx);
 
 }
@@ -201,10 +257,316 @@ void Num_swap_zprimme(int n, Complex_Z *x, int incx, Complex_Z *y, int incy) {
    PRIMME_BLASINT lincx = incx;
    PRIMME_BLASINT lincy = incy;
 
+#ifdef NUM_KERNELS
+   if (incx == 1 && incy == 1) {
+      Num_swap_kernel_zprimme(n, x, y);
+      return;
+   }
+#endif
    ZSWAP(&ln, x, &lincx, y, &lincy);
 
 }
 
+/******************************************************************************
+ * Function Num_axpy_dot - y = y + alpha*x and returns the local y'*z, 
+ *    with unit increments. The update and the dot product are fused in a
+ *    single pass over the vectors (there is no BLAS routine for this).
+ ******************************************************************************/
+Complex_Z Num_axpy_dot_zprimme(int n, Complex_Z alpha, Complex_Z *x, 
+   Complex_Z *y, Complex_Z *z) {
+
+   return Num_axpy_dot_kernel_zprimme(n, alpha, x, y, z);
+
+}
+
+/******************************************************************************
+ * Function Num_recurrence_update - performs in a single pass the two-vector
+ *    recurrence of the QMR iteration
+ *
+ *       delta = gamma*delta + eta*d,   sol = sol + delta
+ *
+ *    and returns the local sol'*sol. All vectors have unit increments.
+ ******************************************************************************/
+double Num_recurrence_update_zprimme(int n, double gamma, double eta, 
+   Complex_Z *d, Complex_Z *delta, Complex_Z *sol) {
+
+   int i;
+   double sum = 0.0L;
+
+#ifdef _OPENMP
+#  pragma omp parallel for simd if (12*n >= NUM_KERNEL_OMP_MIN) \
+      reduction(+:sum) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      delta[i].r = gamma*delta[i].r + eta*d[i].r;
+      delta[i].i = gamma*delta[i].i + eta*d[i].i;
+      sol[i].r += delta[i].r;
+      sol[i].i += delta[i].i;
+      sum += sol[i].r*sol[i].r + sol[i].i*sol[i].i;
+   }
+
+   return sum;
+}
+
+/******************************************************************************
+ * Function Num_recurrence_start - first step of Num_recurrence_update, when
+ *    delta and sol are zero, that does not read them:
+ *
+ *       delta = eta*d,   sol = delta
+ *
+ *    and returns the local sol'*sol. All vectors have unit increments.
+ ******************************************************************************/
+double Num_recurrence_start_zprimme(int n, double eta, Complex_Z *d,
+   Complex_Z *delta, Complex_Z *sol) {
+
+   int i;
+   double sum = 0.0L;
+
+#ifdef _OPENMP
+#  pragma omp parallel for simd if (6*n >= NUM_KERNEL_OMP_MIN) \
+      reduction(+:sum) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      delta[i].r = eta*d[i].r;
+      delta[i].i = eta*d[i].i;
+      sol[i] = delta[i];
+      sum += sol[i].r*sol[i].r + sol[i].i*sol[i].i;
+   }
+
+   return sum;
+}
+
+/******************************************************************************
+ * Function Num_zero - x = 0, with unit increment. The zeroed bytes are
+ *    counted with -DPRIMME_TRACK_ALLOC (see track.c).
+ ******************************************************************************/
+void Num_zero_zprimme(int n, Complex_Z *x) {
+
+   int i;
+
+   TRACK_ZERO(sizeof(Complex_Z)*n);
+   for (i=0; i < n; i++) {
+      x[i].r = 0.0;
+      x[i].i = 0.0;
+   }
+}
+
+/******************************************************************************
+ * Internal kernels for the level 1 operations and gemv with unit increments.
+ * With -DNUM_KERNELS the Num_* wrappers above call them instead of the BLAS 
+ * when the increments are one. The loops work on the real and imaginary 
+ * parts so that the compiler vectorizes them (e.g., -O3), and with OpenMP
+ * (-fopenmp) the loops with at least NUM_KERNEL_OMP_MIN flops are split 
+ * among the threads. Note that the threaded reductions do not sum in a 
+ * fixed order. They are always compiled so they can be compared against 
+ * the BLAS.
+ ******************************************************************************/
+
+void Num_copy_kernel_zprimme(int n, Complex_Z *x, Complex_Z *y) {
+
+   int i;
+
+#ifdef _OPENMP
+#  pragma omp parallel for simd if (n >= NUM_KERNEL_OMP_MIN) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      y[i].r = x[i].r;
+      y[i].i = x[i].i;
+   }
+}
+
+/******************************************************************************/
+void Num_axpy_kernel_zprimme(int n, Complex_Z alpha, Complex_Z *x, 
+   Complex_Z *y) {
+
+   int i;
+   double ar = alpha.r, ai = alpha.i;
+
+#ifdef _OPENMP
+#  pragma omp parallel for simd if (4*n >= NUM_KERNEL_OMP_MIN) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      y[i].r += ar*x[i].r - ai*x[i].i;
+      y[i].i += ar*x[i].i + ai*x[i].r;
+   }
+}
+
+/******************************************************************************
+ * Function Num_dot_kernel - returns x'*y, conjugating x
+ ******************************************************************************/
+Complex_Z Num_dot_kernel_zprimme(int n, Complex_Z *x, Complex_Z *y) {
+
+   int i;
+   double sr = 0.0L, si = 0.0L;
+   Complex_Z zdotc;
+
+#ifdef _OPENMP
+#  pragma omp parallel for simd if (4*n >= NUM_KERNEL_OMP_MIN) \
+      reduction(+:sr,si) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      sr += x[i].r*y[i].r + x[i].i*y[i].i;
+      si += x[i].r*y[i].i - x[i].i*y[i].r;
+   }
+
+   zdotc.r = sr;
+   zdotc.i = si;
+   return zdotc;
+}
+
+/******************************************************************************/
+void Num_scal_kernel_zprimme(int n, Complex_Z alpha, Complex_Z *x) {
+
+   int i;
+   double ar = alpha.r, ai = alpha.i, t;
+
+#ifdef _OPENMP
+#  pragma omp parallel for simd if (4*n >= NUM_KERNEL_OMP_MIN) \
+      private(t) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      t = ar*x[i].r - ai*x[i].i;
+      x[i].i = ar*x[i].i + ai*x[i].r;
+      x[i].r = t;
+   }
+}
+
+/******************************************************************************/
+void Num_swap_kernel_zprimme(int n, Complex_Z *x, Complex_Z *y) {
+
+   int i;
+   Complex_Z t;
+
+#ifdef _OPENMP
+#  pragma omp parallel for if (n >= NUM_KERNEL_OMP_MIN) \
+      private(t) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      t = x[i];
+      x[i] = y[i];
+      y[i] = t;
+   }
+}
+
+/******************************************************************************
+ * Function Num_gemv_kernel - y = alpha*op(A)*x + beta*y, where A is m x n
+ *    and op(A) is A if transa is "N", or the conjugate transpose of A if
+ *    transa is "C". As in the BLAS, if beta is zero y is not read.
+ *    The columns of A are processed two at a time, so that y (for "N") or 
+ *    x (for "C") is loaded once every two columns. For "N", the rows are 
+ *    also split in chunks of NUM_KERNEL_ROWS, and every chunk of y is 
+ *    updated by all the columns while it is in cache.
+ ******************************************************************************/
+void Num_gemv_kernel_zprimme(const char *transa, int m, int n, 
+   Complex_Z alpha, Complex_Z *a, int lda, Complex_Z *x, Complex_Z beta,
+   Complex_Z *y) {
+
+   int i, j, ib, i1;
+   double r0, s0, r1, s1, tr;
+   Complex_Z *a0, *a1;
+   int beta0 = (beta.r == 0.0L && beta.i == 0.0L);
+   int beta1 = (beta.r == 1.0L && beta.i == 0.0L);
+
+   if (*transa == 'n' || *transa == 'N') {
+#ifdef _OPENMP
+#     pragma omp parallel for if (4.0*m*n >= NUM_KERNEL_OMP_MIN) \
+         private(i, j, i1, r0, s0, r1, s1, tr, a0, a1) schedule(static)
+#endif
+      for (ib=0; ib < m; ib += NUM_KERNEL_ROWS) {
+         i1 = min(ib + NUM_KERNEL_ROWS, m);
+         if (beta0) {
+            for (i=ib; i < i1; i++) y[i].r = y[i].i = 0.0L;
+         }
+         else if (!beta1) {
+            for (i=ib; i < i1; i++) {
+               tr = beta.r*y[i].r - beta.i*y[i].i;
+               y[i].i = beta.r*y[i].i + beta.i*y[i].r;
+               y[i].r = tr;
+            }
+         }
+         for (j=0; j < n; j+=2) {
+            /* (r0,s0) and (r1,s1) are alpha*x[j] and alpha*x[j+1] */
+            r0 = alpha.r*x[j].r - alpha.i*x[j].i;
+            s0 = alpha.r*x[j].i + alpha.i*x[j].r;
+            a0 = &a[(size_t)lda*j];
+            if (j+1 < n) {
+               r1 = alpha.r*x[j+1].r - alpha.i*x[j+1].i;
+               s1 = alpha.r*x[j+1].i + alpha.i*x[j+1].r;
+               a1 = a0 + lda;
+               for (i=ib; i < i1; i++) {
+                  y[i].r += r0*a0[i].r - s0*a0[i].i + r1*a1[i].r - s1*a1[i].i;
+                  y[i].i += r0*a0[i].i + s0*a0[i].r + r1*a1[i].i + s1*a1[i].r;
+               }
+            }
+            else {
+               for (i=ib; i < i1; i++) {
+                  y[i].r += r0*a0[i].r - s0*a0[i].i;
+                  y[i].i += r0*a0[i].i + s0*a0[i].r;
+               }
+            }
+         }
+      }
+   }
+   else {
+      for (j=0; j < n; j+=2) {
+         /* (r0,s0) and (r1,s1) are a(:,j)'*x and a(:,j+1)'*x */
+         r0 = s0 = r1 = s1 = 0.0L;
+         a0 = &a[(size_t)lda*j];
+         a1 = (j+1 < n) ? a0 + lda : a0;
+#ifdef _OPENMP
+#        pragma omp parallel for simd if (16*m >= NUM_KERNEL_OMP_MIN) \
+            reduction(+:r0,s0,r1,s1) schedule(static)
+#endif
+         for (i=0; i < m; i++) {
+            r0 += a0[i].r*x[i].r + a0[i].i*x[i].i;
+            s0 += a0[i].r*x[i].i - a0[i].i*x[i].r;
+            r1 += a1[i].r*x[i].r + a1[i].i*x[i].i;
+            s1 += a1[i].r*x[i].i - a1[i].i*x[i].r;
+         }
+         for (i=j; i < min(j+2, n); i++) {
+            if (i > j) r0 = r1, s0 = s1;
+            tr = alpha.r*r0 - alpha.i*s0;
+            s0 = alpha.r*s0 + alpha.i*r0;
+            r0 = tr;
+            if (!beta0) {
+               r0 += beta.r*y[i].r - beta.i*y[i].i;
+               s0 += beta.r*y[i].i + beta.i*y[i].r;
+            }
+            y[i].r = r0;
+            y[i].i = s0;
+         }
+      }
+   }
+}
+
+/******************************************************************************
+ * Function Num_axpy_dot_kernel - y = y + alpha*x and returns y'*z
+ ******************************************************************************/
+Complex_Z Num_axpy_dot_kernel_zprimme(int n, Complex_Z alpha, Complex_Z *x,
+   Complex_Z *y, Complex_Z *z) {
+
+   int i;
+   double ar = alpha.r, ai = alpha.i, sr = 0.0L, si = 0.0L, yr, yi;
+   Complex_Z zdotc;
+
+#ifdef _OPENMP
+#  pragma omp parallel for simd if (8*n >= NUM_KERNEL_OMP_MIN) \
+      private(yr, yi) reduction(+:sr,si) schedule(static)
+#endif
+   for (i=0; i < n; i++) {
+      yr = y[i].r + ar*x[i].r - ai*x[i].i;
+      yi = y[i].i + ar*x[i].i + ai*x[i].r;
+      y[i].r = yr;
+      y[i].i = yi;
+      sr += yr*z[i].r + yi*z[i].i;
+      si += yr*z[i].i - yi*z[i].r;
+   }
+
+   zdotc.r = sr;
+   zdotc.i = si;
+   return zdotc;
+}
+
 /******************************************************************************/
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 #ifdef NUM_ESSL
@@ -220,10 +582,10 @@ int Num_zhpev_zprimme(int iopt, Complex_Z *ap, double *w, Complex_Z *z, int ldz,
    return zhpev(liopt, ap, w, z, lldz, ln, aux, lnaux);
 }
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
-/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
-#else
-/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+#endif
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+/* Also with ESSL, used by restart and the dense solver      */
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 void Num_zheev_zprimme(const char *jobz, const char *uplo, int n, Complex_Z *a, int lda,
    double *w, Complex_Z *work, int ldwork, double *rwork, int *info) {
@@ -249,8 +611,6 @@ void Num_zheev_zprimme(const char *jobz, const char *uplo, int n, Complex_Z *a,
    *info = linfo;
 }
 
-#endif
-
 
 /******************************************************************************/
 void Num_zhetrf_zprimme(const char *uplo, int n, Complex_Z *a, int lda, int *ipivot,
@@ -327,3 +687,23 @@ void Num_zhetrs_zprimme(const char *uplo, int n, int nrhs, Complex_Z *a, int lda
 
 }
  
+
+/******************************************************************************/
+void Num_zpotrf_zprimme(const char *uplo, int n, Complex_Z *a, int lda, int *info) {
+
+   PRIMME_BLASINT ln = n;
+   PRIMME_BLASINT llda = lda;
+   PRIMME_BLASINT linfo = 0;
+
+#ifdef NUM_CRAY
+   _fcd uplo_fcd;
+
+   uplo_fcd = _cptofcd(uplo, strlen(uplo));
+   ZPOTRF(uplo_fcd, &ln, a, &llda, &linfo);
+#else
+   ZPOTRF(uplo, &ln, a, &llda, &linfo);
+#endif
+
+   *info = (int)linfo;
+
+}
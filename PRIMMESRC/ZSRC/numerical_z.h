@@ -37,13 +37,14 @@ extern "C" {
 #endif
 
 int Num_zhpev_zprimme(int iopt, Complex_Z *ap, double *w, Complex_Z *z, int ldz, 
-   int n, Complex_Z *aux, double *rwork, int naux);
+   int n, Complex_Z *aux, int naux);
 void Num_zheev_zprimme(const char *jobz, const char *uplo, int n, Complex_Z *a, int lda, 
    double *w, Complex_Z *work, int ldwork, double *rwork, int *info);
 void Num_zhetrf_zprimme(const char *uplo, int n, Complex_Z *a, int lda, int *ipivot,
    Complex_Z *work, int ldwork, int *info);
 void Num_zhetrs_zprimme(const char *uplo, int n, int nrhs, Complex_Z *a, int lda, 
    int *ipivot, Complex_Z *b, int ldb, int *info);
+void Num_zpotrf_zprimme(const char *uplo, int n, Complex_Z *a, int lda, int *info);
 
 
 void Num_zcopy_zprimme(int n, Complex_Z *x, int incx, Complex_Z *y, int incy);
@@ -54,6 +55,9 @@ void Num_gemm_zprimme(const char *transa, const char *transb, int m, int n, int
 void Num_symm_zprimme(const char *side, const char *uplo, int m, int n, Complex_Z alpha, 
    Complex_Z *a, int lda, Complex_Z *b, int ldb, Complex_Z beta, 
    Complex_Z *c, int ldc);
+void Num_trsm_zprimme(const char *side, const char *uplo, const char *transa,
+   const char *diag, int m, int n, Complex_Z alpha, Complex_Z *a, int lda,
+   Complex_Z *b, int ldb);
 void Num_axpy_zprimme(int n, Complex_Z alpha, Complex_Z *x, int incx, 
    Complex_Z *y, int incy);
 void Num_gemv_zprimme(const char *transa, int m, int n, Complex_Z alpha, Complex_Z *a,
@@ -61,6 +65,25 @@ void Num_gemv_zprimme(const char *transa, int m, int n, Complex_Z alpha, Complex
 void Num_larnv_zprimme(int idist, int *iseed, int length, Complex_Z *x);
 void Num_scal_zprimme(int n, Complex_Z alpha, Complex_Z *x, int incx);
 void Num_swap_zprimme(int n, Complex_Z *x, int incx, Complex_Z *y, int incy);
+Complex_Z Num_axpy_dot_zprimme(int n, Complex_Z alpha, Complex_Z *x, 
+   Complex_Z *y, Complex_Z *z);
+double Num_recurrence_update_zprimme(int n, double gamma, double eta, 
+   Complex_Z *d, Complex_Z *delta, Complex_Z *sol);
+double Num_recurrence_start_zprimme(int n, double eta, Complex_Z *d,
+   Complex_Z *delta, Complex_Z *sol);
+void Num_zero_zprimme(int n, Complex_Z *x);
+
+void Num_copy_kernel_zprimme(int n, Complex_Z *x, Complex_Z *y);
+void Num_axpy_kernel_zprimme(int n, Complex_Z alpha, Complex_Z *x, 
+   Complex_Z *y);
+Complex_Z Num_dot_kernel_zprimme(int n, Complex_Z *x, Complex_Z *y);
+void Num_scal_kernel_zprimme(int n, Complex_Z alpha, Complex_Z *x);
+void Num_swap_kernel_zprimme(int n, Complex_Z *x, Complex_Z *y);
+void Num_gemv_kernel_zprimme(const char *transa, int m, int n, 
+   Complex_Z alpha, Complex_Z *a, int lda, Complex_Z *x, Complex_Z beta,
+   Complex_Z *y);
+Complex_Z Num_axpy_dot_kernel_zprimme(int n, Complex_Z alpha, Complex_Z *x,
+   Complex_Z *y, Complex_Z *z);
 
 #ifdef __cplusplus
 }
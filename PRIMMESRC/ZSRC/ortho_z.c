@@ -53,8 +53,11 @@
 #include <stdio.h>
 #include <math.h>
 #include "primme.h"         
+#include "wtime.h"
 #include "numerical_z.h"
 #include "ortho_z.h"
+#include "lock_store_z.h"
+#include "ortho_private_z.h"
  
 
 /**********************************************************************
@@ -79,7 +82,14 @@
  * nLocal     Number of rows of each vector stored on this node
  * machEps    Double machine precision
  *
- * lockFile   Handle of file containing the locked vectors
+ * If the locked vectors are kept out of core (lockStoreParams.file is 
+ * not NULL), only the first min(numLocked, numOrthoConst) vectors are in 
+ * locked, and the rest are read in panels from the file. The whole block
+ * is orthogonalized against each panel at once by ortho_lock_store before
+ * the vector by vector Gram-Schmidt against basis and locked, so every
+ * pass reads the file once for the whole block. If that Gram-Schmidt
+ * cancels most of a vector, the error left along the file vectors grows
+ * accordingly, and both steps are repeated.
  * rworkSize  Length of rwork array
  * primme     Primme struct. Contains globalSumDouble and Parallelism info
  *
@@ -98,6 +108,7 @@
  * -2  - b1 > b2
  * -3  - A limit number of randomizations has been performed without
  *       yielding an orthogonal direction
+ * -4  - Failure reading the locked vectors from the file
  * 
  **********************************************************************/
 
@@ -106,16 +117,23 @@ int ortho_zprimme(Complex_Z *basis, int ldBasis, int b1, int b2,
    double machEps, Complex_Z *rwork, int rworkSize, primme_params *primme) {
               
    int i;                   /* Loop indices */
+   int pass;                /* Projections against the file */
+   int round;               /* Passes of the whole block */
+   int amplified;           /* The last round cancelled most of a vector */
    int count;
    int returnValue;
    int minWorkSize;         
    int nOrth, reorth;
+   int numInCore;           /* Number of locked vectors kept in locked */
+   int numInFile;           /* Number of locked vectors kept in the file */
    int randomizations;
    int messages = 0;        /* messages = 1 prints the intermediate results */
    int maxNumOrthos = 2;    /* We let 2 reorthogonalizations before randomize */
    int maxNumRandoms = 10;  /* We do not allow more than 10 randomizations */
    double tol = sqrt(2.0L)/2.0L; /* We set Daniel et al. test to .707 */
    double s0, s02, s1;
+   double sFirst = 0.0L;    /* Norm of the vector before the first ortho */
+   double tLocked = 0.0L;   /* Time spent against the locked vectors */
    double temp;
    Complex_Z ztmp;
    Complex_Z *overlaps;
@@ -144,7 +162,19 @@ int ortho_zprimme(Complex_Z *basis, int ldBasis, int b1, int b2,
       return(returnValue);
    }
 
+   if (primme->lockStoreParams.file != NULL) {
+      numInCore = min(numLocked, primme->numOrthoConst);
+   }
+   else {
+      numInCore = numLocked;
+   }
+   numInFile = numLocked - numInCore;
+
    minWorkSize = 2*(numLocked + b2 + 1);
+   if (numInFile > 0) {
+      minWorkSize = max(minWorkSize, 3*(b2-b1+1) 
+         + 2*min(primme->lockStoreParams.panelSize, numInFile));
+   }
 
    if (rworkSize < minWorkSize) {
       return(minWorkSize);
@@ -152,115 +182,267 @@ int ortho_zprimme(Complex_Z *basis, int ldBasis, int b1, int b2,
    
    tol = sqrt(2.0L)/2.0L;
 
-   /*---------------------------------------------------*/
-   /* main loop to orthogonalize new vectors one by one */
-   /*---------------------------------------------------*/
+   for (round=0; round < maxNumOrthos; round++) {
+
+      /*-------------------------------------------------------------------*/
+      /* Orthogonalize the block against the locked vectors in the file.   */
+      /* The vectors in basis and locked are orthogonal to them, so the    */
+      /* Gram-Schmidt below keeps the block orthogonal to the file.        */
+      /*-------------------------------------------------------------------*/
+
+      if (numInFile > 0) {
+         tLocked -= primme_get_wtime();
+         returnValue = ortho_lock_store(basis, ldBasis, b1, b2, numInFile, 
+            nLocal, iseed, machEps, rwork, rworkSize, primme);
+         tLocked += primme_get_wtime();
+         if (returnValue != 0) {
+            return returnValue;
+         }
+      }
 
-   for(i=b1; i <= b2; i++) {
-    
-      nOrth = 0;
-      reorth = 1;
-      randomizations = 0;
+      /*---------------------------------------------------*/
+      /* main loop to orthogonalize new vectors one by one */
+      /*---------------------------------------------------*/
 
-      while (reorth) {
+      amplified = 0;
 
-         if (nOrth >= maxNumOrthos) {
-            if (randomizations >= maxNumRandoms) {
-               return -3;
-            }
-            if (messages){
-               fprintf(outputFile, "Randomizing in ortho:\n");
+      for(i=b1; i <= b2; i++) {
+    
+         nOrth = 0;
+         reorth = 1;
+         randomizations = 0;
+
+         while (reorth) {
+
+            if (nOrth >= maxNumOrthos) {
+               if (randomizations >= maxNumRandoms) {
+                  return -3;
+               }
+               if (messages){
+                  fprintf(outputFile, "Randomizing in ortho:\n");
+               }
+
+               Num_larnv_zprimme(2, iseed, nLocal, &basis[ldBasis*i]); 
+               randomizations++;
+               nOrth = 0;
+               amplified = 1;
+
+               for (pass=0; pass < 2 && numInFile > 0; pass++) {
+                  if (lock_store_project_zprimme(0, numInFile, 
+                        &basis[ldBasis*i], ldBasis, 1, rwork, rworkSize, 
+                        primme) != 0) {
+                     return -4;
+                  }
+               }
             }
 
-            Num_larnv_zprimme(2, iseed, nLocal, &basis[ldBasis*i]); 
-            randomizations++;
-            nOrth = 0;
-         }
-
-         nOrth++;
+            nOrth++;
 
-         if (nOrth == 1) {
-            ztmp = Num_dot_zprimme(nLocal, &basis[ldBasis*i], 1, 
-                                           &basis[ldBasis*i], 1);
-         }
+            if (nOrth == 1) {
+               ztmp = Num_dot_zprimme(nLocal, &basis[ldBasis*i], 1, 
+                                              &basis[ldBasis*i], 1);
+            }
             
-         if (i > 0) {
-            Num_gemv_zprimme("C", nLocal, i, tpone, basis, ldBasis, 
-               &basis[ldBasis*i], 1, tzero, rwork, 1);
-         }
-
-         if (numLocked > 0) {
-            Num_gemv_zprimme("C", nLocal, numLocked, tpone, locked, ldLocked,
-               &basis[ldBasis*i], 1, tzero, &rwork[i], 1);
-         }
+            if (i > 0) {
+               Num_gemv_zprimme("C", nLocal, i, tpone, basis, ldBasis, 
+                  &basis[ldBasis*i], 1, tzero, rwork, 1);
+            }
 
-         rwork[i+numLocked] = ztmp;
-         overlaps = &rwork[i+numLocked+1];
-         /* In Complex, the size of the array to globalSum is twice as large */
-         count = 2*(i + numLocked + 1);
-         (*primme->globalSumDouble)(rwork, overlaps, &count, primme);
+            if (numInCore > 0) {
+               tLocked -= primme_get_wtime();
+               Num_gemv_zprimme("C", nLocal, numInCore, tpone, locked, 
+                  ldLocked, &basis[ldBasis*i], 1, tzero, &rwork[i], 1);
+               tLocked += primme_get_wtime();
+            }
 
-         if (numLocked > 0) { /* locked array most recently accessed */
-            Num_gemv_zprimme("N", nLocal, numLocked, tmone, locked, ldLocked, 
-               &overlaps[i], 1, tpone, &basis[ldBasis*i], 1); 
-         }
+            rwork[i+numInCore] = ztmp;
+            overlaps = &rwork[i+numInCore+1];
+            /* In Complex, the array to globalSum is twice as large */
+            count = 2*(i + numInCore + 1);
+            primme_globalSumDouble(rwork, overlaps, &count, primme);
+
+            if (numInCore > 0) {
+               tLocked -= primme_get_wtime();
+               Num_gemv_zprimme("N", nLocal, numInCore, tmone, locked, 
+                  ldLocked, &overlaps[i], 1, tpone, &basis[ldBasis*i], 1); 
+               tLocked += primme_get_wtime();
+            }
 
-         if (i > 0) {
-            Num_gemv_zprimme("N", nLocal, i, tmone, basis, ldBasis, 
-               overlaps, 1, tpone, &basis[ldBasis*i], 1);
-         }
+            if (i > 0) {
+               Num_gemv_zprimme("N", nLocal, i, tmone, basis, ldBasis, 
+                  overlaps, 1, tpone, &basis[ldBasis*i], 1);
+            }
  
-         if (nOrth == 1) {
-            s02 = overlaps[i+numLocked].r;
-            s0 = sqrt(s02);
-         }
+            if (nOrth == 1) {
+               s02 = overlaps[i+numInCore].r;
+               s0 = sqrt(s02);
+               if (randomizations == 0) sFirst = s0;
+            }
 
-         /* Compute the norm of the resulting vector implicitly */
+            /* Compute the norm of the resulting vector implicitly */
          
-         ztmp = Num_dot_zprimme(i+numLocked,overlaps,1,overlaps,1);
-         temp = ztmp.r;
-         s1 = sqrt(max(0.0L, s02-temp));
+            ztmp = Num_dot_zprimme(i+numInCore,overlaps,1,overlaps,1);
+            temp = ztmp.r;
+            s1 = sqrt(max(0.0L, s02-temp));
          
-         /* s1 decreased too much. Numerical problems expected   */
-         /* with its implicit computation. Compute s1 explicitly */
+            /* s1 decreased too much. Numerical problems expected   */
+            /* with its implicit computation. Compute s1 explicitly */
          
-         if ( s1 < s0*sqrt(machEps) || nOrth > 1) {  
-            ztmp = Num_dot_zprimme(nLocal, &basis[ldBasis*i], 1, 
-                                           &basis[ldBasis*i], 1);
-            temp = ztmp.r;
-            count = 1;
-            (*primme->globalSumDouble)(&temp, &s1, &count, primme);
-            s1 = sqrt(s1);
-         }
+            if ( s1 < s0*sqrt(machEps) || nOrth > 1) {  
+               ztmp = Num_dot_zprimme(nLocal, &basis[ldBasis*i], 1, 
+                                              &basis[ldBasis*i], 1);
+               temp = ztmp.r;
+               count = 1;
+               primme_globalSumDouble(&temp, &s1, &count, primme);
+               s1 = sqrt(s1);
+            }
 
-         if (s1 <= machEps*s0) {
-            if (messages) {
-               fprintf(outputFile, 
-                 "Vector %d lost all significant digits in ortho\n", i-b1);
+            if (s1 <= machEps*s0) {
+               if (messages) {
+                  fprintf(outputFile, 
+                    "Vector %d lost all significant digits in ortho\n", i-b1);
+               }
+               nOrth = maxNumOrthos;
             }
-            nOrth = maxNumOrthos;
-         }
-         else if (s1 <= tol*s0) {
-            if (messages) {
-               fprintf(outputFile, "Reorthogonalizing: %d\n", i-b1);
+            else if (s1 <= tol*s0) {
+               if (messages) {
+                  fprintf(outputFile, "Reorthogonalizing: %d\n", i-b1);
+               }
+               /* No numerical benefit in normalizing before reortho */
+               s0 = s1;
+               s02 = s1*s1;
             }
-            /* No numerical benefit in normalizing the vector before reortho */
-            s0 = s1;
-            s02 = s1*s1;
-         }
-         else {
-            {ztmp.r = 1.0L/s1; ztmp.i = 0.0L;}
-            Num_scal_zprimme(nLocal, ztmp, &basis[ldBasis*i], 1);
-            reorth = 0;
-         } 
+            else {
+               {ztmp.r = 1.0L/s1; ztmp.i = 0.0L;}
+               Num_scal_zprimme(nLocal, ztmp, &basis[ldBasis*i], 1);
+               reorth = 0;
+               if (s1 <= tol*sFirst) amplified = 1;
+            } 
             
+         }
       }
+
+      if (numInFile == 0 || !amplified) break;
    }
+
+   /* The cost model of the dynamic method switch reads this time */
+   primme->stats.timeOrthoLocked += tLocked;
          
    return 0;
 }
 
 
+/**********************************************************************
+ * Function ortho_lock_store - Orthogonalizes the vectors from b1 to b2 in
+ *   basis against the locked vectors kept in the file. Every pass reads
+ *   each panel once and applies it to the whole block. As in ortho,
+ *   Daniel's test decides whether a vector needs another pass, and the
+ *   vectors that lose all their significant digits are randomized.
+ *
+ * INPUT ARRAYS AND PARAMETERS
+ * ---------------------------
+ * ldBasis    Leading dimension of the basis
+ * b1, b2     Range of indices of vectors to be orthogonalized
+ * numInFile  Number of locked vectors in the file
+ * nLocal     Number of rows of each vector stored on this node
+ * machEps    Double machine precision
+ * rworkSize  Length of rwork, at least
+ *            3*(b2-b1+1) + 2*min(panelSize, numInFile)
+ *
+ * INPUT/OUTPUT ARRAYS AND PARAMETERS
+ * ----------------------------------
+ * basis   Basis vectors stored in core memory
+ * iseed   Seeds used to generate random vectors
+ * rwork   Work array
+ *
+ * Return Value
+ * ------------
+ *  0  - success
+ * -3  - A limit number of randomizations has been performed without
+ *       yielding an orthogonal direction
+ * -4  - Failure reading the locked vectors from the file
+ * 
+ **********************************************************************/
+
+static int ortho_lock_store(Complex_Z *basis, int ldBasis, int b1, int b2,
+   int numInFile, int nLocal, int *iseed, double machEps, Complex_Z *rwork,
+   int rworkSize, primme_params *primme) {
+
+   int j, nb, count;
+   int nOrth, randomizations;
+   int done, randomized;
+   int maxNumOrthos = 2;    /* We let 2 reorthogonalizations before randomize */
+   int maxNumRandoms = 10;  /* We do not allow more than 10 randomizations */
+   double tol2 = 0.5L;      /* Daniel et al. test, .707^2 on squared norms */
+   double *s0, *s1;         /* Squared norms before and after a pass */
+   double *norms;           /* Local squared norms */
+   Complex_Z ztmp;
+
+   nb = b2-b1+1;
+   s0 = (double *) rwork;
+   s1 = s0 + nb;
+   norms = s1 + nb;
+   rwork = rwork + 3*nb;
+   rworkSize = rworkSize - 3*nb;
+
+   nOrth = 0;
+   randomizations = 0;
+   randomized = 1;
+
+   do {
+      if (randomized) {
+         for (j=0; j < nb; j++) {
+            ztmp = Num_dot_zprimme(nLocal, &basis[ldBasis*(b1+j)], 1,
+                                           &basis[ldBasis*(b1+j)], 1);
+            norms[j] = ztmp.r;
+         }
+         count = nb;
+         primme_globalSumDouble(norms, s0, &count, primme);
+      }
+
+      if (lock_store_project_zprimme(0, numInFile, &basis[ldBasis*b1],
+            ldBasis, nb, rwork, rworkSize, primme) != 0) {
+         return -4;
+      }
+      nOrth++;
+
+      for (j=0; j < nb; j++) {
+         ztmp = Num_dot_zprimme(nLocal, &basis[ldBasis*(b1+j)], 1,
+                                        &basis[ldBasis*(b1+j)], 1);
+         norms[j] = ztmp.r;
+      }
+      count = nb;
+      primme_globalSumDouble(norms, s1, &count, primme);
+
+      done = 1;
+      randomized = 0;
+      for (j=0; j < nb; j++) {
+         if (s1[j] > tol2*s0[j]) {
+            /* The vector passes Daniel's test */
+         }
+         else if (s1[j] <= machEps*machEps*s0[j] || nOrth >= maxNumOrthos) {
+            Num_larnv_zprimme(2, iseed, nLocal, &basis[ldBasis*(b1+j)]);
+            randomized = 1;
+            done = 0;
+         }
+         else {
+            done = 0;
+         }
+         s0[j] = s1[j];
+      }
+
+      if (randomized) {
+         if (++randomizations > maxNumRandoms) {
+            return -3;
+         }
+         nOrth = 0;
+      }
+   } while (!done);
+
+   return 0;
+}
+
+
 /**********************************************************************
  * Function ortho_retained_vectors -- This function orthogonalizes
  *   coefficient vectors (the eigenvectors of the projection H) that
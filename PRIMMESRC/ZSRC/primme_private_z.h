@@ -32,8 +32,21 @@
 #define ALLOCATE_WORKSPACE_FAILURE -1
 #define MALLOC_FAILURE             -2
 #define MAIN_ITER_FAILURE          -3
+#define LOCK_STORE_FAILURE         -34
+#define MEMORY_BUDGET_FAILURE      -35
+#define USER_STOP                  -36
+#define BUDGET_EXHAUSTED           -37
+#define DENSE_FAILURE              -38
 
 static int allocate_workspace(primme_params *primme, int allocate);
+static int fit_memory_budget(long int budget, primme_params *primme);
+static int check_sizes(primme_params *primme);
+static long int workspace_bytes(primme_params *primme);
+static void set_basis_size(int maxBasisSize, double restartRatio,
+   int locking, primme_params *primme);
+static void keep_user_sizes(primme_params *primme);
+static void restore_user_sizes(primme_params *primme);
+static void get_sizes(budget_sizes *sizes, primme_params *primme);
 static int check_input(double *evals, Complex_Z *evecs, double *resNorms,
                        primme_params *primme);
 #endif
@@ -43,8 +43,22 @@ static int restart_H(Complex_Z *H, Complex_Z *hVecs, double *hVals,
    int numPrevRetained, int indexOfPreviousVecs, int rworkSize, 
    Complex_Z *rwork, primme_params *primme);
 
-static int dtr(int numLocked, Complex_Z *hVecs, double *hVals, int *flags, 
- int basisSize, int numFree, int *iev, Complex_Z *rwork, primme_params *primme);
+static void restart_projection(Complex_Z *H, Complex_Z *WtW, Complex_Z *hVecs, 
+   double *hVals, int restartSize, int basisSize, Complex_Z *rwork, 
+   primme_params *primme);
+
+static int restart_size(int numLocked, Complex_Z *hVecs, double *hVals, 
+  int *flags, int basisSize, int numFree, int *iev, Complex_Z *rwork, 
+  primme_params *primme);
+
+static int dtr_search(double *hVals, double currentRitzVal, int basisSize,
+   int lMin, int numFree, int *right, primme_params *primme);
+
+static int adaptive_size(int basisSize, int lMin, int numFree,
+   primme_params *primme);
+
+static double gap_ratio(double *hVals, double currentRitzVal, int basisSize,
+   int l, int r);
 
 static int pack_converged_coefficients(int *restartSize, int basisSize, 
    int *numPrevRetained, int numLocked, int numGuesses, Complex_Z *hVecs, 
@@ -63,6 +77,11 @@ static int insert_submatrix(Complex_Z *H, double *hVals, Complex_Z *hVecs,
    int indexOfPreviousVecs, int rworkSize, Complex_Z *rwork, 
    primme_params *primme);
 
+static int pseudo_lock_converged(Complex_Z *V, int *flags, 
+   Complex_Z *evecs, Complex_Z *evecsHat, Complex_Z *M, Complex_Z *UDU, 
+   int *ipivot, int numConverged, int *numConvergedStored, int *evecsSlot, 
+   Complex_Z *rwork, int rworkSize, primme_params *primme);
+
 static void apply_preconditioner_block(Complex_Z *v, Complex_Z *result,
    int blockSize, primme_params *primme);
 
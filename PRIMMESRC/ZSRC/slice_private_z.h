@@ -0,0 +1,45 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ * File: slice_private.h
+ *
+ * Purpose - Definitions used exclusively by slice.c
+ *
+ ******************************************************************************/
+
+#ifndef ZSLICE_PRIVATE_H
+#define ZSLICE_PRIVATE_H
+
+#define SLICE_MALLOC_FAILURE   -1
+#define SLICE_INPUT_FAILURE    -2
+#define SLICE_ZPRIMME_FAILURE  -3
+
+static int solve_slice(double *evals, Complex_Z *evecs, double *resNorms,
+   Complex_Z *orthoConst, double *shift, primme_params *sliceParams,
+   primme_params *primme);
+
+static int find_slice(double eval, double lower, double upper,
+   int numSlices);
+
+static void add_comm_stats(primme_comm_stats *sum, primme_comm_stats *c);
+
+#endif
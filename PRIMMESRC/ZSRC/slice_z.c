@@ -0,0 +1,469 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ * File: slice.c
+ *
+ * Purpose - Complex, double precision spectrum slicing front end. It finds all
+ *           the eigenvalues in an interval by splitting it into slices and
+ *           solving an independent interior problem on each of them.
+ *
+ ******************************************************************************/
+
+#include <stdlib.h>   /* mallocs, free */
+#include <stdio.h>
+#include <math.h>
+#include "primme.h"
+#include "wtime.h"
+#include "solve_H_z.h"
+#include "slice_private_z.h"
+#include "numerical_z.h"
+
+/*******************************************************************************
+ * Subroutine zprimme_slice - This routine computes the eigenpairs with
+ *    eigenvalues in [lower, upper]. The interval is divided into numSlices
+ *    slices of the same width, and on each slice zprimme looks for the
+ *    primme->numEvals eigenvalues closest to the center of the slice.
+ *
+ *    As the slices are independent, each one locks only its own eigenvectors,
+ *    so the cost of orthogonalizing against the locked vectors, which grows
+ *    quadratically with their number, is paid per slice and not for the
+ *    whole interval. When the library is compiled with OpenMP, the slices
+ *    are solved concurrently by the threads of the calling process, and then
+ *    matrixMatvec, applyPreconditioner and globalSumDouble must be thread
+ *    safe. Parallel programs may also assign disjoint subintervals to groups
+ *    of processes, setting in each group the communicator in commInfo, and
+ *    gather the results afterwards.
+ *
+ *    The callbacks are called with a copy of primme for each slice, with
+ *    target set to primme_closest_abs and the center of the slice as the
+ *    only shift. The rest of the parameters are taken from primme, except
+ *    initSize, which is set to zero. The first primme->numOrthoConst columns
+ *    of evecs are used as orthogonality constraints in every slice.
+ *
+ *    Every slice keeps only the eigenvalues inside the slice. Eigenpairs
+ *    close to the boundary between two slices may be returned by both;
+ *    two eigenpairs from different slices are considered the same if their
+ *    eigenvalues are closer than the sum of their residual norms and their
+ *    eigenvectors are nearly parallel. The one with the smallest residual
+ *    norm is kept.
+ *
+ * INPUT/OUTPUT ARRAYS AND PARAMETERS
+ * ----------------------------------
+ * evals     Contains the eigenvalues in [lower, upper] in ascending order
+ *           upon return. Should be of size numSlices*primme->numEvals.
+ *
+ * evecs     The local portions of the corresponding eigenvectors, after the
+ *           primme->numOrthoConst constraints. The dimension of the array is
+ *           at least primme->nLocal*(primme->numOrthoConst +
+ *           numSlices*primme->numEvals).
+ *
+ * resNorms  The residual norms of the eigenpairs. Should be of size
+ *           numSlices*primme->numEvals
+ *
+ * numFound  Number of eigenpairs returned
+ *
+ * lower, upper  Interval of the eigenvalues sought
+ *
+ * numSlices     Number of slices the interval is divided into
+ *
+ * primme    Structure containing various solver parameters. numEvals is the
+ *           number of eigenpairs sought on each slice. On return, initSize
+ *           is set to numFound and stats holds the sum of the statistics
+ *           of all slices.
+ *
+ * Return Value
+ * ------------
+ *  0 - Success
+ * >0 - Number of slices in which all numEvals eigenvalues found are inside
+ *      the slice, so there may be more eigenvalues in them. Increase
+ *      numEvals or numSlices to find them.
+ * -1 - Failure to allocate workspace
+ * -2 - Invalid input: numSlices < 1, lower >= upper or numEvals out of range
+ * -3 - zprimme failed on some slice
+ *
+ ******************************************************************************/
+
+int zprimme_slice(double *evals, Complex_Z *evecs, double *resNorms,
+   int *numFound, double lower, double upper, int numSlices,
+   primme_params *primme) {
+
+   int i, j, k;            /* Loop variables                                 */
+   int ret;                /* Return value                                   */
+   int index;              /* Position of an eigenpair returned by a slice   */
+   int numEvals;           /* Number of eigenpairs sought on each slice      */
+   int numConverged;       /* Number of eigenpairs returned by a slice       */
+   int numIncomplete;      /* Number of slices that may miss eigenvalues     */
+   int count;              /* Number of doubles to globalSum                 */
+   int *rets;              /* Value returned by zprimme on each slice        */
+   int *perm;              /* Permutation that sorts the eigenvalues         */
+   int *removed;           /* Flags eigenpairs already found by other slice  */
+   double width;           /* Width of each slice                            */
+   double farthest;        /* Largest distance from a value to the center    */
+   double maxResNorm;      /* Largest residual norm of the eigenpairs        */
+   double ip[2], tpip[2];  /* Inner product between two eigenvectors         */
+   Complex_Z ztmp;         /* Temporary variable                             */
+   double startTime;       /* Time at the beginning                          */
+   double *shifts;         /* Center of each slice                           */
+   double *rwork;          /* Temporary vector for permuting eigenvectors    */
+   Complex_Z *V;           /* Eigenvectors after the constraints             */
+   primme_params *sliceParams; /* Copy of primme for each slice              */
+
+   startTime = primme_get_wtime();
+
+   /* ---------------------------- */
+   /* Clear previous error reports */
+   /* ---------------------------- */
+   primme_DeleteStackTrace(primme);
+   *numFound = 0;
+
+   /* ----------------------------------------- */
+   /* Set some defaults for sequential programs */
+   /* ----------------------------------------- */
+   if (primme->numProcs == 1) {
+      primme->nLocal = primme->n;
+      primme->procID = 0;
+      if (primme->globalSumDouble == NULL)
+         primme->globalSumDouble = primme_seq_globalSumDouble;
+   }
+
+   numEvals = primme->numEvals;
+   if (numSlices < 1 || !(lower < upper) || numEvals < 1 ||
+         numEvals > primme->n) {
+      primme_PushErrorMessage(Primme_zprimme_slice, Primme_check_input,
+            SLICE_INPUT_FAILURE, __FILE__, __LINE__, primme);
+      return SLICE_INPUT_FAILURE;
+   }
+   width = (upper - lower)/numSlices;
+   V = &evecs[primme->nLocal*primme->numOrthoConst];
+
+   /* --------------------------------------------------------------- */
+   /* Allocate the copies of primme and other data kept for each slice */
+   /* --------------------------------------------------------------- */
+   shifts = (double *)primme_calloc(numSlices, sizeof(double), "shifts");
+   rets = (int *)primme_calloc(numSlices, sizeof(int), "rets");
+   sliceParams = (primme_params *)primme_calloc(numSlices,
+         sizeof(primme_params), "sliceParams");
+   perm = (int *)primme_calloc(2*numSlices*numEvals, sizeof(int), "perm");
+   removed = (int *)primme_calloc(numSlices*numEvals, sizeof(int), "removed");
+   rwork = (double *)primme_calloc(primme->nLocal, sizeof(Complex_Z), "rwork");
+
+   if (shifts == NULL || rets == NULL || sliceParams == NULL || perm == NULL
+         || removed == NULL || rwork == NULL) {
+      free(shifts); free(rets); free(sliceParams);
+      free(perm); free(removed); free(rwork);
+      primme_PushErrorMessage(Primme_zprimme_slice, Primme_malloc, 0,
+            __FILE__, __LINE__, primme);
+      return SLICE_MALLOC_FAILURE;
+   }
+
+   for (i=0; i < numSlices; i++) {
+      shifts[i] = lower + (i + 0.5L)*width;
+   }
+
+   /* ---------------------------------------------------------------- */
+   /* Solve the slices. Slice i returns its eigenpairs in the positions */
+   /* i*numEvals, ..., (i+1)*numEvals-1 of evals, V and resNorms.       */
+   /* ---------------------------------------------------------------- */
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+   for (i=0; i < numSlices; i++) {
+      rets[i] = solve_slice(&evals[i*numEvals],
+         &V[primme->nLocal*i*numEvals], &resNorms[i*numEvals], evecs,
+         &shifts[i], &sliceParams[i], primme);
+   }
+
+   /* ------------------------------------------------------------------ */
+   /* Accumulate the statistics and report the first slice that failed   */
+   /* ------------------------------------------------------------------ */
+
+   ret = 0;
+   primme->stats.numOuterIterations = 0;
+   primme->stats.numRestarts = 0;
+   primme->stats.numMatvecs = 0;
+   primme->stats.numPreconds = 0;
+   primme->stats.bytesMoved = 0.0L;
+   primme->stats.comm.numReductions = 0;
+   primme->stats.comm.numDoubles = 0.0L;
+   primme->stats.comm.time = 0.0L;
+   for (j=0; j < primme_num_phases; j++) {
+      primme->stats.commPhase[j] = primme->stats.comm;
+   }
+   for (i=0; i < numSlices; i++) {
+      primme->stats.numOuterIterations +=
+                                      sliceParams[i].stats.numOuterIterations;
+      primme->stats.numRestarts += sliceParams[i].stats.numRestarts;
+      primme->stats.numMatvecs += sliceParams[i].stats.numMatvecs;
+      primme->stats.numPreconds += sliceParams[i].stats.numPreconds;
+      primme->stats.bytesMoved += sliceParams[i].stats.bytesMoved;
+      add_comm_stats(&primme->stats.comm, &sliceParams[i].stats.comm);
+      for (j=0; j < primme_num_phases; j++) {
+         add_comm_stats(&primme->stats.commPhase[j],
+               &sliceParams[i].stats.commPhase[j]);
+      }
+      if (rets[i] != 0 && ret == 0) {
+         primme->stackTrace = sliceParams[i].stackTrace;
+         sliceParams[i].stackTrace = NULL;
+         primme_PushErrorMessage(Primme_zprimme_slice, Primme_zprimme,
+               rets[i], __FILE__, __LINE__, primme);
+         ret = SLICE_ZPRIMME_FAILURE;
+      }
+      primme_DeleteStackTrace(&sliceParams[i]);
+   }
+
+   /* If not given, report the largest estimation of ||A|| */
+   if (primme->aNorm <= 0.0L) {
+      for (i=0; i < numSlices; i++) {
+         primme->aNorm = max(primme->aNorm, sliceParams[i].aNorm);
+      }
+   }
+
+   if (ret != 0) {
+      free(shifts); free(rets); free(sliceParams);
+      free(perm); free(removed); free(rwork);
+      primme->stats.elapsedTime = primme_get_wtime() - startTime;
+      return ret;
+   }
+
+   /* ----------------------------------------------------------------- */
+   /* Move to the front the eigenpairs inside the slice that found them */
+   /* and count the slices that may not have found all its eigenvalues. */
+   /* ----------------------------------------------------------------- */
+
+   k = 0;
+   numIncomplete = 0;
+   for (i=0; i < numSlices; i++) {
+      numConverged = sliceParams[i].initSize;
+      farthest = 0.0L;
+      for (j=0; j < numConverged; j++) {
+         index = i*numEvals + j;
+         farthest = max(farthest, fabs(evals[index] - shifts[i]));
+         if (find_slice(evals[index], lower, upper, numSlices) != i) continue;
+         evals[k] = evals[index];
+         resNorms[k] = resNorms[index];
+         if (k != index) {
+            Num_zcopy_zprimme(primme->nLocal, &V[primme->nLocal*index], 1,
+               &V[primme->nLocal*k], 1);
+         }
+         k++;
+      }
+      if (numConverged < primme->n &&
+            (numConverged < numEvals || farthest < width/2.0L)) {
+         numIncomplete++;
+      }
+   }
+
+   /* ----------------------------------------------------------- */
+   /* Sort the eigenpairs in ascending order of the eigenvalues   */
+   /* ----------------------------------------------------------- */
+
+   for (i=0; i < k; i++) {
+      perm[i] = i;
+   }
+   for (i=1; i < k; i++) {
+      index = perm[i];
+      for (j=i; j > 0 && evals[perm[j-1]] > evals[index]; j--) {
+         perm[j] = perm[j-1];
+      }
+      perm[j] = index;
+   }
+
+   for (i=0; i < k; i++) perm[k+i] = perm[i];
+   permute_evecs_zprimme(evals, 1, &perm[k], rwork, k, 1);
+   for (i=0; i < k; i++) perm[k+i] = perm[i];
+   permute_evecs_zprimme(resNorms, 1, &perm[k], rwork, k, 1);
+   primme->stats.bytesMoved += sizeof(Complex_Z)*primme->nLocal*
+      (double)permute_evecs_zprimme((double *) V, 2, perm, rwork, k,
+         primme->nLocal);
+
+   /* ----------------------------------------------------------------- */
+   /* Remove the eigenpairs found by two neighbor slices. As evals and  */
+   /* resNorms are the same on all processes, all of them perform the   */
+   /* same global sums.                                                 */
+   /* ----------------------------------------------------------------- */
+
+   maxResNorm = 0.0L;
+   for (i=0; i < k; i++) {
+      maxResNorm = max(maxResNorm, resNorms[i]);
+   }
+
+   for (i=1; i < k; i++) {
+      for (j=i-1; j >= 0 && evals[i]-evals[j] <= resNorms[i]+maxResNorm; j--){
+         if (removed[j] || evals[i]-evals[j] > resNorms[i]+resNorms[j] ||
+               find_slice(evals[i], lower, upper, numSlices) ==
+               find_slice(evals[j], lower, upper, numSlices)) {
+            continue;
+         }
+         ztmp = Num_dot_zprimme(primme->nLocal, &V[primme->nLocal*i], 1,
+               &V[primme->nLocal*j], 1);
+         tpip[0] = ztmp.r;
+         tpip[1] = ztmp.i;
+         /* In Complex, the size of the array to globalSum is twice as large */
+         count = 2;
+         primme_globalSumDouble(tpip, ip, &count, primme);
+         if (ip[0]*ip[0] + ip[1]*ip[1] > 0.5L) {
+            if (resNorms[i] < resNorms[j]) {
+               removed[j] = 1;
+            }
+            else {
+               removed[i] = 1;
+               break;
+            }
+         }
+      }
+   }
+
+   for (i=0, j=0; i < k; i++) {
+      if (removed[i]) continue;
+      if (i != j) {
+         evals[j] = evals[i];
+         resNorms[j] = resNorms[i];
+         Num_zcopy_zprimme(primme->nLocal, &V[primme->nLocal*i], 1,
+            &V[primme->nLocal*j], 1);
+      }
+      j++;
+   }
+
+   *numFound = primme->initSize = j;
+
+   free(shifts); free(rets); free(sliceParams);
+   free(perm); free(removed); free(rwork);
+
+   primme->stats.elapsedTime = primme_get_wtime() - startTime;
+   return numIncomplete;
+}
+
+
+/*******************************************************************************
+ * Subroutine solve_slice - Calls zprimme to find the eigenpairs closest to
+ *    the center of a slice, using a copy of primme.
+ *
+ * INPUT ARRAYS AND PARAMETERS
+ * ---------------------------
+ * orthoConst  The primme->numOrthoConst orthogonality constraints
+ * shift       Center of the slice
+ * primme      Structure containing various solver parameters
+ *
+ * OUTPUT ARRAYS AND PARAMETERS
+ * ----------------------------
+ * evals       The eigenvalues found, of size primme->numEvals
+ * evecs       The eigenvectors found, of size primme->nLocal*primme->numEvals
+ * resNorms    Their residual norms, of size primme->numEvals
+ * sliceParams The copy of primme used. Its initSize is the number of
+ *             eigenpairs found, and stats and stackTrace are the ones of
+ *             this slice.
+ *
+ * Return Value
+ * ------------
+ * The value returned by zprimme, or SLICE_MALLOC_FAILURE
+ ******************************************************************************/
+
+static int solve_slice(double *evals, Complex_Z *evecs, double *resNorms,
+   Complex_Z *orthoConst, double *shift, primme_params *sliceParams,
+   primme_params *primme) {
+
+   int ret;
+   Complex_Z *V;  /* The constraints followed by the eigenvectors */
+
+   *sliceParams = *primme;
+   sliceParams->target = primme_closest_abs;
+   sliceParams->numTargetShifts = 1;
+   sliceParams->targetShifts = shift;
+   sliceParams->initSize = 0;
+   sliceParams->intWorkSize = 0;
+   sliceParams->realWorkSize = 0;
+   sliceParams->intWork = NULL;
+   sliceParams->realWork = NULL;
+   sliceParams->stackTrace = NULL;
+
+   /* Slices share primme, so their locked vectors are kept in memory */
+   sliceParams->lockStoreParams.fileName = NULL;
+   sliceParams->lockStoreParams.file = NULL;
+   sliceParams->lockStoreParams.panel = NULL;
+
+   /* The state kept for the next call and the tuning cache belong to    */
+   /* primme; slices run concurrently and would free the same state and  */
+   /* write the same file                                                */
+   sliceParams->continuationParams.keepState = 0;
+   sliceParams->continuationParams.state = NULL;
+   sliceParams->tuningParams.cacheFile = NULL;
+
+   V = (Complex_Z *)primme_calloc(
+         primme->nLocal*(primme->numOrthoConst+primme->numEvals),
+         sizeof(Complex_Z), "V");
+
+   if (V == NULL) {
+      primme_PushErrorMessage(Primme_zprimme_slice, Primme_malloc, 0,
+            __FILE__, __LINE__, sliceParams);
+      sliceParams->initSize = 0;
+      return SLICE_MALLOC_FAILURE;
+   }
+
+   Num_zcopy_zprimme(primme->nLocal*primme->numOrthoConst, orthoConst, 1,
+         V, 1);
+
+   ret = zprimme(evals, V, resNorms, sliceParams);
+
+   if (ret == 0) {
+      Num_zcopy_zprimme(primme->nLocal*sliceParams->initSize,
+            &V[primme->nLocal*primme->numOrthoConst], 1, evecs, 1);
+   }
+   else {
+      sliceParams->initSize = 0;
+   }
+
+   free(V);
+   primme_Free(sliceParams);
+   sliceParams->intWork = NULL;
+   sliceParams->realWork = NULL;
+
+   return ret;
+}
+
+
+/*******************************************************************************
+ * Function find_slice - Returns the slice of [lower, upper] containing eval,
+ *    or -1 if eval is outside the interval. Slices are closed on the left and
+ *    open on the right, except the last one that also includes upper.
+ ******************************************************************************/
+
+static int find_slice(double eval, double lower, double upper,
+   int numSlices) {
+
+   int slice;
+
+   if (eval < lower || eval > upper) return -1;
+   slice = (int)floor((eval - lower)/(upper - lower)*numSlices);
+   return min(slice, numSlices-1);
+}
+
+
+/*******************************************************************************
+ * Function add_comm_stats - Adds the reductions in c to sum.
+ ******************************************************************************/
+
+static void add_comm_stats(primme_comm_stats *sum, primme_comm_stats *c) {
+   sum->numReductions += c->numReductions;
+   sum->numDoubles += c->numDoubles;
+   sum->time += c->time;
+}
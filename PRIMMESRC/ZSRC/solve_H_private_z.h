@@ -31,9 +31,16 @@
 
 #ifdef NUM_ESSL
 #define NUM_DSPEV_FAILURE -1
-#else
-#define NUM_DSYEV_FAILURE -1
 #endif
+#define NUM_DSYEV_FAILURE -1
+
+static int solve_H_harmonic(Complex_Z *H, Complex_Z *WtW, Complex_Z *hVecs, 
+   double *hVals, int basisSize, int maxBasisSize, double targetShift,
+   int lrwork, Complex_Z *rwork, int *iwork, primme_params *primme);
+
+static int solve_H_refined(Complex_Z *H, Complex_Z *WtW, Complex_Z *hVecs, 
+   double *hVals, int basisSize, int maxBasisSize, double targetShift,
+   int lrwork, Complex_Z *rwork, int *iwork, primme_params *primme);
 
 #endif
 
@@ -39,6 +39,8 @@
  * INPUT ARRAYS AND PARAMETERS
  * ---------------------------
  * H             The matrix V'*A*V
+ * WtW           The matrix W'*W, with W = A*V. It is maintained only if
+ *               the harmonic or the refined extraction is used (NULL else)
  * basisSize     Current size of the orthonormal basis V
  * maxBasisSize  The maximum size of the basis V
  * numLocked     Number of eigenvalues locked, to determine ordering shift.
@@ -50,7 +52,8 @@
  * hVecs             The eigenvectors of H
  * hVals             The eigenvalues of H
  * largestRitzValue  Maintains the largest in absolute value Ritz value seen
- * rwork             Must be of size at least 3*maxBasisSize
+ * rwork             Must be of size at least 3*maxBasisSize, or
+ *                   2*maxBasisSize^2 + 4*maxBasisSize if WtW is not NULL
  * iwork             Permutation array for evecs/evals with desired targeting 
  *                   order. hVecs/hVals are permuted in the right order.
  *
@@ -60,13 +63,15 @@
  *     - -1 Num_zheev was unsuccsessful
  ******************************************************************************/
 
-int solve_H_zprimme(Complex_Z *H, Complex_Z *hVecs, double *hVals, 
-   int basisSize, int maxBasisSize, double *largestRitzValue, int numLocked, 
-   int lrwork, Complex_Z *rwork, int *iwork, primme_params *primme) {
+int solve_H_zprimme(Complex_Z *H, Complex_Z *WtW, Complex_Z *hVecs, 
+   double *hVals, int basisSize, int maxBasisSize, double *largestRitzValue, 
+   int numLocked, int lrwork, Complex_Z *rwork, int *iwork, 
+   primme_params *primme) {
 
    int i, j; /* Loop variables    */
    int info; /* dsyev error value */
    int index;
+   int ret;  /* Return value      */
    int *permu, *permw;
    double targetShift;
 
@@ -82,6 +87,37 @@ int solve_H_zprimme(Complex_Z *H, Complex_Z *hVecs, double *hVals,
    int apSize, idx;
 #endif
 
+   /* ------------------------------------------------------------------- */
+   /* Interior targets may use the harmonic or the refined extraction     */
+   /* with respect to the current shift instead of the Rayleigh-Ritz one. */
+   /* If W'*W-2*shift*H+shift^2*I is not numerically positive definite,   */
+   /* V contains a vector y with (A-shift*I)*V*y close to zero. The       */
+   /* harmonic extraction then falls back to the refined one, which finds */
+   /* that vector without factorizing the matrix.                         */
+   /* ------------------------------------------------------------------- */
+
+   if (WtW != NULL) {
+      targetShift = 
+        primme->targetShifts[min(primme->numTargetShifts-1, numLocked)];
+
+      if (primme->projectionParams.projection == primme_proj_harmonic) {
+         ret = solve_H_harmonic(H, WtW, hVecs, hVals, basisSize, 
+            maxBasisSize, targetShift, lrwork, rwork, iwork, primme);
+      }
+      if (primme->projectionParams.projection != primme_proj_harmonic
+            || ret == 1) {
+         ret = solve_H_refined(H, WtW, hVecs, hVals, basisSize, 
+            maxBasisSize, targetShift, lrwork, rwork, iwork, primme);
+      }
+
+      if (ret == 0) {
+         for (i = 0; i < basisSize; i++) {
+            *largestRitzValue = max(*largestRitzValue, fabs(hVals[i]));
+         }
+      }
+      return ret;
+   }
+
 
    /* ------------------------------------------------------------------- */
    /* Copy the upper triangular portion of H into hvecs.  We need to do   */
@@ -116,7 +152,7 @@ int solve_H_zprimme(Complex_Z *H, Complex_Z *hVecs, double *hVals,
    /* -------------------------------------------------------------------- */
    /* Assign also 3N double work space after the 2N complex rwork finishes */
    /* -------------------------------------------------------------------- */
-   doubleWork = (double *) (&rwork[apsize + 2*basisSize]);
+   doubleWork = (double *) (&rwork[apSize + 2*basisSize]);
 
    info = Num_zhpev_zprimme(21, rwork, hVals, hVecs, basisSize, basisSize, 
       &rwork[apSize], lrwork);
@@ -265,6 +301,316 @@ int solve_H_zprimme(Complex_Z *H, Complex_Z *hVecs, double *hVals,
    return 0;   
 }
 
+/*******************************************************************************
+ * Subroutine solve_H_harmonic - This procedure computes the harmonic Ritz 
+ *            pairs of A with respect to the shift sigma. With G = R'*R the 
+ *            Cholesky factorization of (W-sigma*V)'*(W-sigma*V), that is
+ *            W'*W - 2*sigma*H + sigma^2*I, it solves the hermitian problem
+ *
+ *               R^{-H}*(H-sigma*I)*R^{-1}*z = nu*z,  y = R^{-1}*z,
+ *
+ *            whose largest eigenvalues nu = 1/(theta-sigma) correspond to
+ *            the harmonic Ritz values theta closest to sigma. The vectors y
+ *            are normalized and their Rayleigh quotients y'*H*y are returned
+ *            in hVals, as they give smaller residuals than theta.
+ *        
+ * INPUT ARRAYS AND PARAMETERS
+ * ---------------------------
+ * H             The matrix V'*A*V
+ * WtW           The matrix W'*W
+ * basisSize     Current size of the orthonormal basis V
+ * maxBasisSize  The maximum size of the basis V (leading dimension of H, WtW)
+ * targetShift   The shift sigma
+ * lrwork        Length of the work array rwork
+ * primme        Strucuture containing various solver parameters
+ * 
+ * OUTPUT ARRAYS
+ * -------------
+ * hVecs         The harmonic Ritz vectors in the desired targeting order
+ * hVals         Their Rayleigh quotients
+ * rwork         Must be of size at least 2*basisSize^2 + 4*basisSize
+ * iwork         Permutation array of size 2*basisSize
+ *
+ * Return Value
+ * ------------
+ * int -  0 upon successful return
+ *     -  1 if the Cholesky factorization failed
+ *     - -1 Num_zheev was unsuccsessful
+ ******************************************************************************/
+
+static int solve_H_harmonic(Complex_Z *H, Complex_Z *WtW, Complex_Z *hVecs, 
+   double *hVals, int basisSize, int maxBasisSize, double targetShift,
+   int lrwork, Complex_Z *rwork, int *iwork, primme_params *primme) {
+
+   int i, j;        /* Loop variables    */
+   int info;        /* LAPACK error value */
+   int index;
+   int *permu, *permw;
+   Complex_Z *R;    /* The Cholesky factor of (W-sigma*V)'*(W-sigma*V) */
+   Complex_Z *work;
+   double *doubleWork;
+   double norm;
+   Complex_Z ztmp;
+   Complex_Z tpone = {+1.0e+00,+0.0e00}, tzero = {+0.0e+00,+0.0e00};
+
+   permu = iwork;
+   permw = permu + basisSize;
+   R     = rwork;
+   work  = rwork + basisSize*basisSize;
+   doubleWork = (double *) (work + 2*basisSize);
+
+   /* ------------------------------------------------------------------- */
+   /* R = chol(W'*W - 2*sigma*H + sigma^2*I) and hVecs = H - sigma*I,     */
+   /* the latter stored in full since it is multiplied from both sides   */
+   /* ------------------------------------------------------------------- */
+
+   for (j=0; j < basisSize; j++) {
+      for (i=0; i <= j; i++) {
+         R[basisSize*j+i].r = WtW[maxBasisSize*j+i].r 
+                              - 2.0L*targetShift*H[maxBasisSize*j+i].r;
+         R[basisSize*j+i].i = WtW[maxBasisSize*j+i].i 
+                              - 2.0L*targetShift*H[maxBasisSize*j+i].i;
+         hVecs[basisSize*j+i] = H[maxBasisSize*j+i];
+         hVecs[basisSize*i+j].r = H[maxBasisSize*j+i].r;
+         hVecs[basisSize*i+j].i = -H[maxBasisSize*j+i].i;
+      }
+      R[basisSize*j+j].r += targetShift*targetShift;
+      R[basisSize*j+j].i = 0.0L;
+      hVecs[basisSize*j+j].r -= targetShift;
+      hVecs[basisSize*j+j].i = 0.0L;
+   }
+
+   Num_zpotrf_zprimme("U", basisSize, R, basisSize, &info);
+
+   if (info != 0) {
+      return 1;
+   }
+
+   Num_trsm_zprimme("L", "U", "C", "N", basisSize, basisSize, tpone, R, 
+      basisSize, hVecs, basisSize);
+   Num_trsm_zprimme("R", "U", "N", "N", basisSize, basisSize, tpone, R, 
+      basisSize, hVecs, basisSize);
+
+#ifdef NUM_ESSL
+   for (j=0, index=0; j < basisSize; j++) {
+      for (i=0; i <= j; i++) {
+         work[index++] = hVecs[basisSize*j+i];
+      }
+   }
+
+   info = Num_zhpev_zprimme(21, work, hVals, hVecs, basisSize, basisSize, 
+      &work[index], lrwork-basisSize*basisSize-index);
+
+   if (info != 0) {
+      primme_PushErrorMessage(Primme_solve_h, Primme_num_zhpev, info, __FILE__, 
+         __LINE__, primme);
+      return NUM_DSPEV_FAILURE;
+   }
+
+#else
+   Num_zheev_zprimme("V", "U", basisSize, hVecs, basisSize, hVals, work, 
+                2*basisSize, doubleWork, &info);
+
+   if (info != 0) {
+      primme_PushErrorMessage(Primme_solve_h, Primme_num_zheev, info, __FILE__, 
+         __LINE__, primme);
+      return NUM_DSYEV_FAILURE;
+   }
+
+#endif
+
+   Num_trsm_zprimme("L", "U", "N", "N", basisSize, basisSize, tpone, R, 
+      basisSize, hVecs, basisSize);
+
+   /* ---------------------------------------------------------------------- */
+   /* ORDER the vectors according to the desired target. hVals holds nu in   */
+   /* ascending order; positive nu correspond to harmonic Ritz values to the */
+   /* right of the shift, and the largest |nu| to the closest to the shift.  */
+   /* ---------------------------------------------------------------------- */
+
+   for (j=0; j < basisSize && hVals[j] < 0.0L; j++);
+
+   index = 0;
+   if (primme->target == primme_closest_geq) {
+      for (i=basisSize-1; i >= j; i--) permu[index++] = i;
+      for (i=0; i < j; i++) permu[index++] = i;
+   }
+   else if (primme->target == primme_closest_leq) {
+      for (i=0; i < j; i++) permu[index++] = i;
+      for (i=basisSize-1; i >= j; i--) permu[index++] = i;
+   }
+   else { /* primme_closest_abs */
+      i = 0; 
+      j = basisSize-1;
+      while (i <= j) {
+         if (fabs(hVals[i]) > fabs(hVals[j]))
+            permu[index++] = i++;
+         else
+            permu[index++] = j--;
+      }
+   }
+
+   for (i=0; i < basisSize; i++) 
+       permw[i] = permu[i];
+   permute_evecs_zprimme(hVals, 1, permu, (double *) work, basisSize, 1);
+   permute_evecs_zprimme((double *) hVecs, 2, permw, (double *) work,
+                         basisSize, basisSize);
+
+   /* ------------------------------------------------------------------- */
+   /* Normalize the vectors and set hVals to their Rayleigh quotients     */
+   /* ------------------------------------------------------------------- */
+
+   for (i=0; i < basisSize; i++) {
+      ztmp = Num_dot_zprimme(basisSize, &hVecs[basisSize*i], 1,
+                                        &hVecs[basisSize*i], 1);
+      norm = sqrt(ztmp.r);
+      ztmp.r = 1.0L/norm;
+      ztmp.i = 0.0L;
+      Num_scal_zprimme(basisSize, ztmp, &hVecs[basisSize*i], 1);
+   }
+
+   Num_symm_zprimme("L", "U", basisSize, basisSize, tpone, H, maxBasisSize,
+      hVecs, basisSize, tzero, R, basisSize);
+
+   for (i=0; i < basisSize; i++) {
+      ztmp = Num_dot_zprimme(basisSize, &hVecs[basisSize*i], 1,
+                                        &R[basisSize*i], 1);
+      hVals[i] = ztmp.r;
+   }
+
+   return 0;
+}
+
+/*******************************************************************************
+ * Subroutine solve_H_refined - This procedure computes the refined Ritz 
+ *            vectors with respect to the shift sigma, i.e., the unit vectors
+ *            y that minimize ||(A-sigma*I)*V*y||. They are the eigenvectors
+ *            of W'*W - 2*sigma*H + sigma^2*I with the smallest eigenvalues.
+ *            That matrix is R'*R, with R the triangular factor of the QR
+ *            decomposition of W-sigma*V, so they are the right singular
+ *            vectors of R. It is formed from the projections kept by the
+ *            solver instead of factorizing the distributed W-sigma*V, and
+ *            it needs no factorization that could fail when V contains an
+ *            eigenvector with eigenvalue sigma.
+ *            hVals returns their Rayleigh quotients y'*H*y. For closest_geq
+ *            (closest_leq) the vectors whose Rayleigh quotient is to the
+ *            right (left) of the shift are moved first, keeping their order.
+ *
+ * INPUT ARRAYS AND PARAMETERS
+ * ---------------------------
+ * H             The matrix V'*A*V
+ * WtW           The matrix W'*W
+ * basisSize     Current size of the orthonormal basis V
+ * maxBasisSize  The maximum size of the basis V (leading dimension of H, WtW)
+ * targetShift   The shift sigma
+ * lrwork        Length of the work array rwork
+ * primme        Strucuture containing various solver parameters
+ * 
+ * OUTPUT ARRAYS
+ * -------------
+ * hVecs         The refined Ritz vectors in the desired targeting order
+ * hVals         Their Rayleigh quotients
+ * rwork         Must be of size at least 2*basisSize^2 + 4*basisSize
+ * iwork         Permutation array of size 2*basisSize
+ *
+ * Return Value
+ * ------------
+ * int -  0 upon successful return
+ *     - -1 Num_zheev was unsuccsessful
+ ******************************************************************************/
+
+static int solve_H_refined(Complex_Z *H, Complex_Z *WtW, Complex_Z *hVecs, 
+   double *hVals, int basisSize, int maxBasisSize, double targetShift,
+   int lrwork, Complex_Z *rwork, int *iwork, primme_params *primme) {
+
+   int i, j;        /* Loop variables    */
+   int info;        /* LAPACK error value */
+   int index;
+   int *permu, *permw;
+   Complex_Z *HY;
+   Complex_Z *work;
+   double *doubleWork;
+   Complex_Z ztmp;
+   Complex_Z tpone = {+1.0e+00,+0.0e00}, tzero = {+0.0e+00,+0.0e00};
+
+   permu = iwork;
+   permw = permu + basisSize;
+   HY    = rwork;
+   work  = rwork + basisSize*basisSize;
+   doubleWork = (double *) (work + 2*basisSize);
+
+   for (j=0; j < basisSize; j++) {
+      for (i=0; i <= j; i++) {
+         hVecs[basisSize*j+i].r = WtW[maxBasisSize*j+i].r 
+                                  - 2.0L*targetShift*H[maxBasisSize*j+i].r;
+         hVecs[basisSize*j+i].i = WtW[maxBasisSize*j+i].i 
+                                  - 2.0L*targetShift*H[maxBasisSize*j+i].i;
+      }
+      hVecs[basisSize*j+j].r += targetShift*targetShift;
+      hVecs[basisSize*j+j].i = 0.0L;
+   }
+
+#ifdef NUM_ESSL
+   for (j=0, index=0; j < basisSize; j++) {
+      for (i=0; i <= j; i++) {
+         work[index++] = hVecs[basisSize*j+i];
+      }
+   }
+
+   info = Num_zhpev_zprimme(21, work, hVals, hVecs, basisSize, basisSize, 
+      &work[index], lrwork-basisSize*basisSize-index);
+
+   if (info != 0) {
+      primme_PushErrorMessage(Primme_solve_h, Primme_num_zhpev, info, __FILE__, 
+         __LINE__, primme);
+      return NUM_DSPEV_FAILURE;
+   }
+
+#else
+   Num_zheev_zprimme("V", "U", basisSize, hVecs, basisSize, hVals, work, 
+                2*basisSize, doubleWork, &info);
+
+   if (info != 0) {
+      primme_PushErrorMessage(Primme_solve_h, Primme_num_zheev, info, __FILE__, 
+         __LINE__, primme);
+      return NUM_DSYEV_FAILURE;
+   }
+
+#endif
+
+   Num_symm_zprimme("L", "U", basisSize, basisSize, tpone, H, maxBasisSize,
+      hVecs, basisSize, tzero, HY, basisSize);
+
+   for (i=0; i < basisSize; i++) {
+      ztmp = Num_dot_zprimme(basisSize, &hVecs[basisSize*i], 1,
+                                        &HY[basisSize*i], 1);
+      hVals[i] = ztmp.r;
+   }
+
+   if (primme->target == primme_closest_abs) 
+      return 0;
+
+   index = 0;
+   for (i=0; i < basisSize; i++) {
+      if ((primme->target == primme_closest_geq && hVals[i] >= targetShift) ||
+          (primme->target == primme_closest_leq && hVals[i] <= targetShift))
+         permu[index++] = i;
+   }
+   for (i=0; i < basisSize; i++) {
+      if (!((primme->target == primme_closest_geq && hVals[i] >= targetShift) ||
+            (primme->target == primme_closest_leq && hVals[i] <= targetShift)))
+         permu[index++] = i;
+   }
+
+   for (i=0; i < basisSize; i++) 
+       permw[i] = permu[i];
+   permute_evecs_zprimme(hVals, 1, permu, (double *) work, basisSize, 1);
+   permute_evecs_zprimme((double *) hVecs, 2, permw, (double *) work,
+                         basisSize, basisSize);
+
+   return 0;
+}
+
 /******************************************************************************
  * Subroutine permute_evecs- This routine permutes a set of vectors according
  *            to a permutation array perm. It is supposed to be called on 
@@ -290,16 +636,18 @@ int solve_H_zprimme(Complex_Z *H, Complex_Z *hVecs, double *hVals,
  *
  ******************************************************************************/
      
-void permute_evecs_zprimme(double *evecs, int elemSize, int *perm, 
+int permute_evecs_zprimme(double *evecs, int elemSize, int *perm, 
    double *rwork, int nev, int nLocal) {
 
    int currentIndex;     /* Index of eigenvector in sorted order              */
    int sourceIndex;      /* Position of out-of-order vector in original order */
    int destinationIndex; /* Position of out-of-order vector in sorted order   */
    int tempIndex;        /* Used to swap                                      */
+   int numCopies;        /* Number of vectors copied                          */
    int tmpSize;
    
    currentIndex = 0;
+   numCopies = 0;
    tmpSize = nLocal*elemSize;
 
    /* Continue until all eigenvectors are in the sorted order */
@@ -313,11 +661,12 @@ void permute_evecs_zprimme(double *evecs, int elemSize, int *perm,
 
       /* Return if they are in the sorted order */
       if (currentIndex >= nev) {
-         return;
+         return numCopies;
       }
 
       /* Copy the vector to a buffer for swapping */
       Num_dcopy_primme(tmpSize, &evecs[currentIndex*tmpSize], 1, rwork, 1);
+      numCopies++;
 
       destinationIndex = currentIndex;
       /* Copy vector perm[destinationIndex] into position destinationIndex */
@@ -327,6 +676,7 @@ void permute_evecs_zprimme(double *evecs, int elemSize, int *perm,
          sourceIndex = perm[destinationIndex];
          Num_dcopy_primme(tmpSize, &evecs[sourceIndex*tmpSize], 1, 
             &evecs[destinationIndex*tmpSize], 1);
+         numCopies++;
          tempIndex = perm[destinationIndex];
          perm[destinationIndex] = destinationIndex;
          destinationIndex = tempIndex;
@@ -334,6 +684,7 @@ void permute_evecs_zprimme(double *evecs, int elemSize, int *perm,
 
       /* Copy the vector from the buffer to where it belongs */
       Num_dcopy_primme(tmpSize, rwork, 1, &evecs[destinationIndex*tmpSize], 1);
+      numCopies++;
       perm[destinationIndex] = destinationIndex;
 
       currentIndex++;
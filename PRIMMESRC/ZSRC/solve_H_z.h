@@ -29,11 +29,12 @@
 #ifndef SOLVE_H_H
 #define SOLVE_H_H
 
-int solve_H_zprimme(Complex_Z *H, Complex_Z *hVecs, double *hVals, 
-   int basisSize, int maxBasisSize, double *largestEval, int numLocked,
-   int lrwork, Complex_Z *rwork, int *perm, primme_params *primme);
+int solve_H_zprimme(Complex_Z *H, Complex_Z *WtW, Complex_Z *hVecs, 
+   double *hVals, int basisSize, int maxBasisSize, double *largestEval, 
+   int numLocked, int lrwork, Complex_Z *rwork, int *perm, 
+   primme_params *primme);
 
-void permute_evecs_zprimme(double *evecs, int elemSize, int *perm, 
+int permute_evecs_zprimme(double *evecs, int elemSize, int *perm, 
    double *rwork, int nev, int nLocal);
 
 
@@ -55,3 +55,41 @@ void update_W_zprimme(Complex_Z *V, Complex_Z *W, int basisSize, int blockSize,
    primme->stats.numMatvecs += blockSize;
 
 }
+
+/*******************************************************************************
+ * Subroutines update_W_begin and update_W_end - Split-phase version of 
+ *    update_W. If primme->matrixMatvecBegin and primme->matrixMatvecEnd 
+ *    are set, update_W_begin starts the product and update_W_end completes
+ *    it; W(:,basisSize:basisSize+blockSize-1) must not be read and 
+ *    V(:,basisSize:basisSize+blockSize-1) must not be modified in between.
+ *    Otherwise the product is done by update_W_begin with matrixMatvec.
+ *
+ *    Both are called with the same arguments as update_W.
+ ******************************************************************************/
+
+void update_W_begin_zprimme(Complex_Z *V, Complex_Z *W, int basisSize, 
+   int blockSize, primme_params *primme) {
+
+   if (primme->matrixMatvecBegin == NULL || primme->matrixMatvecEnd == NULL) {
+      update_W_zprimme(V, W, basisSize, blockSize, primme);
+      return;
+   }
+
+   (*primme->matrixMatvecBegin)(&V[primme->nLocal*basisSize],
+                         &W[primme->nLocal*basisSize], &blockSize, primme);
+
+   primme->stats.numMatvecs += blockSize;
+
+}
+
+void update_W_end_zprimme(Complex_Z *V, Complex_Z *W, int basisSize, 
+   int blockSize, primme_params *primme) {
+
+   if (primme->matrixMatvecBegin == NULL || primme->matrixMatvecEnd == NULL) {
+      return;
+   }
+
+   (*primme->matrixMatvecEnd)(&V[primme->nLocal*basisSize],
+                         &W[primme->nLocal*basisSize], &blockSize, primme);
+
+}
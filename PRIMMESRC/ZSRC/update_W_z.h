@@ -33,4 +33,10 @@
 void update_W_zprimme(Complex_Z *V, Complex_Z *W, int basisSize, int blockSize,
    primme_params *primme);
 
+void update_W_begin_zprimme(Complex_Z *V, Complex_Z *W, int basisSize, 
+   int blockSize, primme_params *primme);
+
+void update_W_end_zprimme(Complex_Z *V, Complex_Z *W, int basisSize, 
+   int blockSize, primme_params *primme);
+
 #endif
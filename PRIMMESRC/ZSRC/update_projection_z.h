@@ -34,4 +34,11 @@ void update_projection_zprimme(Complex_Z *X, Complex_Z *Y, Complex_Z *Z,
    int numCols, int maxCols, int blockSize, Complex_Z *rwork, 
    primme_params *primme);
 
+void update_projection_begin_zprimme(Complex_Z *V, Complex_Z *W, int numCols, 
+   int maxCols, int blockSize, Complex_Z *rwork, primme_params *primme);
+
+void update_projection_end_zprimme(Complex_Z *V, Complex_Z *W, Complex_Z *H, 
+   int numCols, int maxCols, int blockSize, Complex_Z *rwork, 
+   primme_params *primme);
+
 #endif
@@ -48,7 +48,15 @@ int readMatrixNative(const char* matrixFileName, CSRMatrix **matrix_, double *fn
    CSRMatrix *matrix;
 
    matrix = (CSRMatrix*)primme_calloc(1, sizeof(CSRMatrix), "CSRMatrix");
-   if (!strcmp("mtx", &matrixFileName[strlen(matrixFileName)-3])) {  
+   if (!strncmp("gen:", matrixFileName, 4)) {
+      /* synthetic matrix, see gen.c */
+      ret = generateMatrixNative(&matrixFileName[4], matrix);
+      if (ret < 0) {
+         fprintf(stderr, "ERROR: Could not generate matrix\n");
+         return(-1);
+      }
+   }
+   else if (!strcmp("mtx", &matrixFileName[strlen(matrixFileName)-3])) {  
       /* coordinate format storing both lower and upper triangular parts */
       ret = readfullMTX(matrixFileName, &matrix->AElts, &matrix->JA, 
          &matrix->IA, &matrix->m, &matrix->n, &matrix->nnz);
@@ -40,6 +40,7 @@ typedef struct {
 } CSRMatrix;
 
 int readMatrixNative(const char* matrixFileName, CSRMatrix **matrix_, double *fnorm);
+int generateMatrixNative(const char *spec, CSRMatrix *matrix);
 double frobeniusNorm(const CSRMatrix *matrix);
 void shiftCSRMatrix(double shift, CSRMatrix *matrix);
 
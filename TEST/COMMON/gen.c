@@ -0,0 +1,394 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ * File: gen.c
+ *
+ * Purpose - Generators of synthetic CSR matrices for testing and benchmarking.
+ *           They are selected with a matrix file name of the form
+ *
+ *              gen:<name>:<arg1>[:<arg2>...]
+ *
+ *           lap2d:nx[:ny]            5-point Laplacian on a nx x ny grid
+ *           lap3d:nx[:ny:nz]         7-point Laplacian on a nx x ny x nz grid
+ *           band:n[:bw]              Toeplitz band matrix with bw diagonals
+ *                                    on each side (default 5)
+ *           randspd:n[:k[:seed]]     random symmetric positive definite,
+ *                                    diagonally dominant with about k
+ *                                    off-diagonal entries per row (default 10)
+ *           anderson:L[:W[:seed]]    3D Anderson model on a periodic L^3
+ *                                    lattice with disorder W (default 16.5)
+ *
+ *           Prefixing the name with 'h' (e.g., hlap2d) gives the complex
+ *           Hermitian variant: every off-diagonal entry is multiplied by a
+ *           random phase (a random magnetic flux). It is only available in
+ *           the complex driver.
+ *
+ *           The random entries are computed from a hash of the indices, so
+ *           the matrices do not depend on the order of generation and their
+ *           size is only limited by the memory for the CSR arrays.
+ *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "csr.h"
+#include "primme.h"
+
+#define GEN_MAX_ARGS 4
+
+static double hashUniform(unsigned long long a, unsigned long long b,
+      unsigned long long seed);
+static void beginRow(CSRMatrix *matrix, int i);
+static void addEntry(CSRMatrix *matrix, int i, int j, double v, int hermitian,
+      unsigned long long seed);
+static int allocMatrix(CSRMatrix *matrix, int n, size_t maxnnz);
+static void finishMatrix(CSRMatrix *matrix);
+static int genStencil(CSRMatrix *matrix, int nx, int ny, int nz,
+      int periodic, double W, int hermitian, unsigned long long seed);
+static int genBand(CSRMatrix *matrix, int n, int bw, int hermitian);
+static int genRandSPD(CSRMatrix *matrix, int n, int k, int hermitian,
+      unsigned long long seed);
+
+/******************************************************************************
+ * Function generateMatrixNative - generates the matrix described by spec
+ *    (without the prefix "gen:"). Returns 0 on success.
+ ******************************************************************************/
+int generateMatrixNative(const char *spec, CSRMatrix *matrix) {
+
+   char name[64];
+   const char *p;
+   char *end;
+   double arg[GEN_MAX_ARGS];
+   int nargs, hermitian, ret;
+   size_t len;
+
+   /* Parse <name>:<arg1>:<arg2>... */
+
+   p = strchr(spec, ':');
+   len = p ? (size_t)(p - spec) : strlen(spec);
+   if (len == 0 || len >= sizeof(name)) {
+      fprintf(stderr, "ERROR(generateMatrixNative): invalid matrix '%s'\n", spec);
+      return -1;
+   }
+   strncpy(name, spec, len);
+   name[len] = '\0';
+   for (nargs=0; p && *p == ':' && nargs < GEN_MAX_ARGS; nargs++) {
+      arg[nargs] = strtod(p+1, &end);
+      if (end == p+1) break;
+      p = end;
+   }
+   if (nargs < 1 || (p && *p != '\0')) {
+      fprintf(stderr, "ERROR(generateMatrixNative): invalid arguments in '%s'\n",
+            spec);
+      return -1;
+   }
+
+   hermitian = 0;
+   if (name[0] == 'h') {
+#ifndef USE_DOUBLECOMPLEX
+      fprintf(stderr, "ERROR(generateMatrixNative): '%s' is only supported in"
+            " complex arithmetic\n", name);
+      return -1;
+#else
+      hermitian = 1;
+      memmove(name, name+1, strlen(name));
+#endif
+   }
+
+   if (strcmp(name, "lap2d") == 0) {
+      ret = genStencil(matrix, (int)arg[0], nargs > 1 ? (int)arg[1] : (int)arg[0],
+            1, 0, 0.0, hermitian, 1);
+   }
+   else if (strcmp(name, "lap3d") == 0) {
+      ret = genStencil(matrix, (int)arg[0], nargs > 1 ? (int)arg[1] : (int)arg[0],
+            nargs > 2 ? (int)arg[2] : (int)arg[0], 0, 0.0, hermitian, 1);
+   }
+   else if (strcmp(name, "band") == 0) {
+      ret = genBand(matrix, (int)arg[0], nargs > 1 ? (int)arg[1] : 5, hermitian);
+   }
+   else if (strcmp(name, "randspd") == 0) {
+      ret = genRandSPD(matrix, (int)arg[0], nargs > 1 ? (int)arg[1] : 10,
+            hermitian, nargs > 2 ? (unsigned long long)arg[2] : 1);
+   }
+   else if (strcmp(name, "anderson") == 0) {
+      ret = genStencil(matrix, (int)arg[0], (int)arg[0], (int)arg[0], 1,
+            nargs > 1 ? arg[1] : 16.5, hermitian,
+            nargs > 2 ? (unsigned long long)arg[2] : 1);
+   }
+   else {
+      fprintf(stderr, "ERROR(generateMatrixNative): unknown generator '%s'\n",
+            name);
+      return -1;
+   }
+
+   return ret;
+}
+
+/******************************************************************************
+ * Subroutine genStencil - Generates the 5-point (nz == 1) or 7-point stencil
+ *    with 2 or 3 in the diagonal per dimension and -1 for the neighbors.
+ *    If periodic, the boundaries wrap around, the diagonal is a uniform
+ *    random value in [-W/2, W/2] and the hopping is -1 (Anderson model);
+ *    otherwise the boundaries are Dirichlet (Laplacian).
+ ******************************************************************************/
+static int genStencil(CSRMatrix *matrix, int nx, int ny, int nz,
+      int periodic, double W, int hermitian, unsigned long long seed) {
+
+   int x, y, z, i, d, c;
+   int dims[3], strides[3], coord[3];
+   double diag;
+
+   if (nx < 1 || ny < 1 || nz < 1 || (periodic && (nx < 3 || ny < 3 || nz < 3))
+         || (double)nx*ny*nz > 2e9) {
+      fprintf(stderr, "ERROR(genStencil): invalid dimensions %d x %d x %d\n",
+            nx, ny, nz);
+      return -1;
+   }
+
+   dims[0] = nx; dims[1] = ny; dims[2] = nz;
+   strides[0] = 1; strides[1] = nx; strides[2] = nx*ny;
+   if (allocMatrix(matrix, nx*ny*nz, (size_t)nx*ny*nz*(nz > 1 ? 7 : 5)) != 0)
+      return -1;
+
+   for (z=0, i=0; z < nz; z++) {
+      for (y=0; y < ny; y++) {
+         for (x=0; x < nx; x++, i++) {
+            coord[0] = x; coord[1] = y; coord[2] = z;
+            beginRow(matrix, i);
+
+            /* Neighbors before the diagonal, then the diagonal, and then */
+            /* the neighbors after, so the columns are mostly sorted      */
+
+            for (d=2; d >= 0; d--) {
+               if (dims[d] == 1) continue;
+               c = coord[d] - 1;
+               if (c >= 0) {
+                  addEntry(matrix, i, i - strides[d], -1.0, hermitian, seed);
+               }
+               else if (periodic) {
+                  addEntry(matrix, i, i + (dims[d]-1)*strides[d], -1.0,
+                        hermitian, seed);
+               }
+            }
+            if (periodic) {
+               diag = W*(hashUniform(i, i, seed) - 0.5);
+            }
+            else {
+               diag = 2.0*((nx > 1) + (ny > 1) + (nz > 1));
+            }
+            addEntry(matrix, i, i, diag, 0, seed);
+            for (d=0; d < 3; d++) {
+               if (dims[d] == 1) continue;
+               c = coord[d] + 1;
+               if (c < dims[d]) {
+                  addEntry(matrix, i, i + strides[d], -1.0, hermitian, seed);
+               }
+               else if (periodic) {
+                  addEntry(matrix, i, i - (dims[d]-1)*strides[d], -1.0,
+                        hermitian, seed);
+               }
+            }
+         }
+      }
+   }
+
+   finishMatrix(matrix);
+   return 0;
+}
+
+/******************************************************************************
+ * Subroutine genBand - Generates the Toeplitz matrix with 2*bw in the
+ *    diagonal and -1 in the bw diagonals above and below.
+ ******************************************************************************/
+static int genBand(CSRMatrix *matrix, int n, int bw, int hermitian) {
+
+   int i, j;
+
+   if (n < 1 || bw < 0) {
+      fprintf(stderr, "ERROR(genBand): invalid size %d or bandwidth %d\n", n,
+            bw);
+      return -1;
+   }
+   bw = min(bw, n-1);
+   if (allocMatrix(matrix, n, (size_t)n*(2*bw+1)) != 0) return -1;
+
+   for (i=0; i < n; i++) {
+      beginRow(matrix, i);
+      for (j=max(0, i-bw); j <= min(n-1, i+bw); j++) {
+         addEntry(matrix, i, j, i == j ? 2.0*bw : -1.0, hermitian, 1);
+      }
+   }
+
+   finishMatrix(matrix);
+   return 0;
+}
+
+/******************************************************************************
+ * Subroutine genRandSPD - Generates a symmetric matrix where row i has
+ *    k/2 entries in random columns with values in [-1, 0), plus their
+ *    transposes, and a diagonal that makes it strictly diagonally dominant
+ *    (so it is positive definite). The random columns are generated twice,
+ *    first to count the entries per row and then to place them, so no
+ *    coordinate list is stored.
+ ******************************************************************************/
+static int genRandSPD(CSRMatrix *matrix, int n, int k, int hermitian,
+      unsigned long long seed) {
+
+   int i, j, t, half = max(1, k/2);
+   int *count;
+   double v, *diag;
+
+   if (n < 2 || k < 1) {
+      fprintf(stderr, "ERROR(genRandSPD): invalid size %d or entries %d\n", n,
+            k);
+      return -1;
+   }
+
+   count = (int *)primme_calloc(n+1, sizeof(int), "count");
+   diag = (double *)primme_calloc(n, sizeof(double), "diag");
+
+   /* Count the entries per row and sum the absolute values per row */
+
+   for (i=0; i < n; i++) {
+      for (t=0; t < half; t++) {
+         j = (int)(hashUniform(i, t, seed)*(n-1));
+         if (j >= i) j++;
+         v = 1.0 - hashUniform(i, t, seed+1);
+         count[i]++; count[j]++;
+         diag[i] += v; diag[j] += v;
+      }
+   }
+   if (allocMatrix(matrix, n, (size_t)n*(2*half+1)) != 0) {
+      free(count); free(diag);
+      return -1;
+   }
+
+   /* Set IA from the counts plus the diagonal. The diagonal goes first */
+   /* in every row, and count is reused as the next free position.      */
+
+   matrix->IA[0] = 1;
+   for (i=0; i < n; i++) {
+      matrix->IA[i+1] = matrix->IA[i] + count[i] + 1;
+      count[i] = matrix->IA[i] - 1;
+      matrix->JA[count[i]] = i+1;
+      matrix->AElts[count[i]] = diag[i] + 1.0;
+      count[i]++;
+   }
+   matrix->nnz = matrix->IA[n] - 1;
+
+   for (i=0; i < n; i++) {
+      for (t=0; t < half; t++) {
+         j = (int)(hashUniform(i, t, seed)*(n-1));
+         if (j >= i) j++;
+         v = -(1.0 - hashUniform(i, t, seed+1));
+         matrix->nnz = count[i];
+         addEntry(matrix, i, j, v, hermitian, seed);
+         count[i]++;
+         matrix->nnz = count[j];
+         addEntry(matrix, j, i, v, hermitian, seed);
+         count[j]++;
+      }
+   }
+   matrix->nnz = matrix->IA[n] - 1;
+
+   free(count);
+   free(diag);
+   return 0;
+}
+
+/******************************************************************************
+ * Function hashUniform - returns a pseudo-random number in [0,1) that only
+ *    depends on (a, b, seed) (SplitMix64 finalizer).
+ ******************************************************************************/
+static double hashUniform(unsigned long long a, unsigned long long b,
+      unsigned long long seed) {
+
+   unsigned long long z;
+
+   z = a*0x9E3779B97F4A7C15ULL + b*0xC2B2AE3D27D4EB4FULL
+      + seed*0x165667B19E3779F9ULL;
+   z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+   z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+   z = z ^ (z >> 31);
+   return (z >> 11)*(1.0/9007199254740992.0);
+}
+
+/******************************************************************************
+ * Subroutines to fill the CSR arrays (1-based indices) row by row
+ ******************************************************************************/
+
+static int allocMatrix(CSRMatrix *matrix, int n, size_t maxnnz) {
+
+   if (maxnnz > 2000000000) {
+      fprintf(stderr, "ERROR: too many nonzeros for int indices\n");
+      return -1;
+   }
+   matrix->m = matrix->n = n;
+   matrix->nnz = 0;
+   matrix->IA = (int *)malloc(sizeof(int)*(n+1));
+   matrix->JA = (int *)malloc(sizeof(int)*maxnnz);
+   matrix->AElts = (PRIMME_NUM *)malloc(sizeof(PRIMME_NUM)*maxnnz);
+   if (!matrix->IA || !matrix->JA || !matrix->AElts) {
+      fprintf(stderr, "ERROR: not enough memory for a matrix with %d rows\n",
+            n);
+      free(matrix->IA); free(matrix->JA); free(matrix->AElts);
+      return -1;
+   }
+   return 0;
+}
+
+static void beginRow(CSRMatrix *matrix, int i) {
+   matrix->IA[i] = matrix->nnz + 1;
+}
+
+/* Appends A(i,j) = v; in the Hermitian variant the off-diagonal entries */
+/* are multiplied by exp(i*theta), with -theta for the transpose         */
+
+static void addEntry(CSRMatrix *matrix, int i, int j, double v, int hermitian,
+      unsigned long long seed) {
+
+#ifdef USE_DOUBLECOMPLEX
+   double theta;
+
+   if (hermitian && i != j) {
+      theta = 6.283185307179586*hashUniform(min(i,j), max(i,j), seed+2);
+      if (i > j) theta = -theta;
+      matrix->AElts[matrix->nnz] = v*(cos(theta) + sin(theta)*IMAGINARY);
+   }
+   else
+#endif
+   {
+      matrix->AElts[matrix->nnz] = v;
+   }
+   matrix->JA[matrix->nnz] = j+1;
+   matrix->nnz++;
+}
+
+static void finishMatrix(CSRMatrix *matrix) {
+
+   matrix->IA[matrix->n] = matrix->nnz + 1;
+   matrix->JA = (int *)realloc(matrix->JA, sizeof(int)*matrix->nnz);
+   matrix->AElts = (PRIMME_NUM *)realloc(matrix->AElts,
+         sizeof(PRIMME_NUM)*matrix->nnz);
+}
@@ -32,6 +32,7 @@
 #include <unistd.h>
 #include <string.h>
 #include <math.h>
+#include <assert.h>
 #include "native.h"
 
 static void getDiagonal(const CSRMatrix *matrix, double *diag);
@@ -84,6 +85,30 @@ void CSRMatrixMatvec(void *x, void *y, int *blockSize, primme_params *primme) {
    }
 }
 
+/******************************************************************************
+ * Split-phase version of CSRMatrixMatvec. The begin function only records 
+ * the pending product, and the end function computes it, so that a solver 
+ * that reads y or modifies x before calling the end function gets a wrong 
+ * result.
+ *
+******************************************************************************/
+static void *pendingX = NULL, *pendingY = NULL;
+static int pendingBlockSize = 0;
+
+void CSRMatrixMatvecBegin(void *x, void *y, int *blockSize, 
+                                        primme_params *primme) {
+   pendingX = x;
+   pendingY = y;
+   pendingBlockSize = *blockSize;
+}
+
+void CSRMatrixMatvecEnd(void *x, void *y, int *blockSize, 
+                                        primme_params *primme) {
+   assert(x == pendingX && y == pendingY && *blockSize == pendingBlockSize);
+   CSRMatrixMatvec(pendingX, pendingY, &pendingBlockSize, primme);
+   pendingX = pendingY = NULL;
+}
+
 /******************************************************************************
  * Applies the (already inverted) diagonal preconditioner
  *
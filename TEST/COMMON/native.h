@@ -33,6 +33,10 @@
 #include "primme.h"
 
 void CSRMatrixMatvec(void *x, void *y, int *blockSize, primme_params *primme);
+void CSRMatrixMatvecBegin(void *x, void *y, int *blockSize, 
+                                        primme_params *primme);
+void CSRMatrixMatvecEnd(void *x, void *y, int *blockSize, 
+                                        primme_params *primme);
 int createInvDiagPrecNative(const CSRMatrix *matrix, double shift, double **prec);
 void ApplyInvDiagPrecNative(void *x, void *y, int *blockSize, 
                                         primme_params *primme);
@@ -47,6 +47,8 @@ int read_solver_params(char *configFileName, char *outputFileName,
    char ident[2048];
    char op[128];
    char stringValue[128];
+   static char cacheFileName[1024];
+   char eventFileName[1024];
    FILE *configFile;
 
    if ((configFile = fopen(configFileName, "r")) == NULL) {
@@ -157,18 +159,48 @@ int read_solver_params(char *configFileName, char *outputFileName,
          else if (strcmp(ident, "primme.initSize") == 0) {
             ret = fscanf(configFile, "%d", &primme->initSize);
          }
+         else if (strcmp(ident, "primme.initFilterDegree") == 0) {
+            ret = fscanf(configFile, "%d", &primme->initFilterDegree);
+         }
          else if (strcmp(ident, "primme.numOrthoConst") == 0) {
             ret = fscanf(configFile, "%d", &primme->numOrthoConst);
          }
          else if (strcmp(ident, "primme.maxOuterIterations") == 0) {
             ret = fscanf(configFile, "%d", &primme->maxOuterIterations);
          }
+         else if (strcmp(ident, "primme.maxTime") == 0) {
+            ret = fscanf(configFile, "%le", &primme->maxTime);
+         }
+         else if (strcmp(ident, "primme.denseThreshold") == 0) {
+            ret = fscanf(configFile, "%d", &primme->denseThreshold);
+         }
          else if (strcmp(ident, "primme.maxMatvecs") == 0) {
             ret = fscanf(configFile, "%d", &primme->maxMatvecs);
          }
          else if (strcmp(ident, "primme.printLevel") == 0) {
             ret = fscanf(configFile, "%d", &primme->printLevel);
          }
+         else if (strcmp(ident, "primme.projection.projection") == 0) {
+            ret = fscanf(configFile, "%s", stringValue); 
+            if (ret == 1) {
+               if (strcmp(stringValue, "primme_proj_RR") == 0) {
+                  primme->projectionParams.projection = primme_proj_RR;
+               }
+               else if (strcmp(stringValue, "primme_proj_harmonic") == 0) {
+                  primme->projectionParams.projection = primme_proj_harmonic;
+               }
+               else if (strcmp(stringValue, "primme_proj_refined") == 0) {
+                  primme->projectionParams.projection = primme_proj_refined;
+               }
+               else {
+                  printf("Invalid projection.projection value\n");
+                  ret = 0;
+               }
+            }
+         }
+         else if (strcmp(ident, "primme.lockStore.panelSize") == 0) {
+            ret = fscanf(configFile, "%d", &primme->lockStoreParams.panelSize);
+         }
          else if (strcmp(ident, "primme.restarting.scheme") == 0) {
             ret = fscanf(configFile, "%s", stringValue); 
             if (ret == 1) {
@@ -178,6 +210,12 @@ int read_solver_params(char *configFileName, char *outputFileName,
                else if (strcmp(stringValue, "primme_dtr") == 0) {
                   primme->restartingParams.scheme = primme_dtr;
                }
+               else if (strcmp(stringValue, "primme_adaptive_thick") == 0) {
+                  primme->restartingParams.scheme = primme_adaptive_thick;
+               }
+               else if (strcmp(stringValue, "primme_budget_thick") == 0) {
+                  primme->restartingParams.scheme = primme_budget_thick;
+               }
                else {
                   printf("Invalid restart.scheme value\n");
                   ret = 0;
@@ -188,6 +226,13 @@ int read_solver_params(char *configFileName, char *outputFileName,
             ret = fscanf(configFile, "%d", 
                      &primme->restartingParams.maxPrevRetain);
          }
+         else if (strcmp(ident, "primme.memoryBudget") == 0) {
+            ret = fscanf(configFile, "%ld", &primme->memoryBudget);
+         }
+         else if (strcmp(ident, "primme.restarting.maxBasisBytes") == 0) {
+            ret = fscanf(configFile, "%ld", 
+                     &primme->restartingParams.maxBasisBytes);
+         }
          else if (strcmp(ident, "primme.target") == 0) {
             ret = fscanf(configFile, "%s", stringValue);
             if (ret == 1) {
@@ -289,6 +334,64 @@ int read_solver_params(char *configFileName, char *outputFileName,
             ret = fscanf(configFile, "%lf", 
                &primme->correctionParams.relTolBase);
          }
+         else if (strcmp(ident, "primme.tuning.blockSize") == 0) {
+            ret = fscanf(configFile, "%d", &primme->tuningParams.blockSize);
+         }
+         else if (strcmp(ident, "primme.tuning.innerIterations") == 0) {
+            ret = fscanf(configFile, "%d", 
+               &primme->tuningParams.innerIterations);
+         }
+         else if (strcmp(ident, "primme.tuning.deterministic") == 0) {
+            ret = fscanf(configFile, "%d", 
+               &primme->tuningParams.deterministic);
+         }
+         else if (strcmp(ident, "primme.tuning.cacheFile") == 0) {
+            ret = fscanf(configFile, "%1023s", cacheFileName);
+            primme->tuningParams.cacheFile = cacheFileName;
+         }
+         else if (strcmp(ident, "primme.tuning.cacheKey") == 0) {
+            ret = fscanf(configFile, "%ld", &primme->tuningParams.cacheKey);
+         }
+         else if (strcmp(ident, "primme.continuation.keepState") == 0) {
+            ret = fscanf(configFile, "%d", 
+               &primme->continuationParams.keepState);
+         }
+         else if (strcmp(ident, "primme.continuation.maxExtraVectors") == 0) {
+            ret = fscanf(configFile, "%d", 
+               &primme->continuationParams.maxExtraVectors);
+         }
+         else if (strcmp(ident, "primme.events.file") == 0) {
+            ret = fscanf(configFile, "%1023s", eventFileName);
+            if (ret == 1 && primme->procID == 0) {
+               if (strcmp(eventFileName, "stdout") == 0) {
+                  primme->eventParams.file = stdout;
+               }
+               else if ((primme->eventParams.file = fopen(eventFileName, "w"))
+                     == NULL) {
+                  fprintf(stderr, "ERROR(read_solver_params): Could not open "
+                        "events file %s\n", eventFileName);
+                  return(-1);
+               }
+            }
+         }
+         else if (strcmp(ident, "primme.events.format") == 0) {
+            ret = fscanf(configFile, "%s", stringValue);
+            if (ret == 1) {
+               if (strcmp(stringValue, "csv") == 0) {
+                  primme->eventParams.format = primme_event_csv;
+               }
+               else if (strcmp(stringValue, "json") == 0) {
+                  primme->eventParams.format = primme_event_json;
+               }
+               else {
+                  printf("Invalid events.format value\n");
+                  ret = 0;
+               }
+            }
+         }
+         else if (strcmp(ident, "primme.events.bufferSize") == 0) {
+            ret = fscanf(configFile, "%d", &primme->eventParams.bufferSize);
+         }
          else if (strcmp(ident, "primme.iseed") == 0) {
             ret = 1;
             for (i=0;i<4; i++) {
@@ -472,6 +575,51 @@ int read_driver_params(char *configFileName, driver_params *driver) {
          else if (strcmp(ident, "driver.filter") == 0) {
             ret = fscanf(configFile, "%lf", &driver->filter);
          }
+         else if (strcmp(ident, "driver.slices") == 0) {
+            ret = fscanf(configFile, "%d", &driver->slices);
+         }
+         else if (strcmp(ident, "driver.sliceLower") == 0) {
+            ret = fscanf(configFile, "%le", &driver->sliceLower);
+         }
+         else if (strcmp(ident, "driver.sliceUpper") == 0) {
+            ret = fscanf(configFile, "%le", &driver->sliceUpper);
+         }
+         else if (strcmp(ident, "driver.lockFile") == 0) {
+            ret = fscanf(configFile, "%s", driver->lockFileName);
+         }
+         else if (strcmp(ident, "driver.splitMatvec") == 0) {
+            ret = fscanf(configFile, "%d", &driver->splitMatvec);
+         }
+         else if (strcmp(ident, "driver.benchFile") == 0) {
+            ret = fscanf(configFile, "%s", driver->benchFileName);
+         }
+         else if (strcmp(ident, "driver.stopAfter") == 0) {
+            ret = fscanf(configFile, "%d", &driver->stopAfter);
+         }
+         else if (strcmp(ident, "driver.minConverged") == 0) {
+            ret = fscanf(configFile, "%d", &driver->minConverged);
+         }
+         else if (strcmp(ident, "driver.timeOutAfter") == 0) {
+            ret = fscanf(configFile, "%d", &driver->timeOutAfter);
+         }
+         else if (strcmp(ident, "driver.checkCache") == 0) {
+            ret = fscanf(configFile, "%d", &driver->checkCache);
+         }
+         else if (strcmp(ident, "driver.checkEvents") == 0) {
+            ret = fscanf(configFile, "%s", driver->checkEventsFileName);
+         }
+         else if (strcmp(ident, "driver.virtualRanks") == 0) {
+            ret = fscanf(configFile, "%d", &driver->virtualRanks);
+         }
+         else if (strcmp(ident, "driver.virtualLatency") == 0) {
+            ret = fscanf(configFile, "%le", &driver->virtualLatency);
+         }
+         else if (strcmp(ident, "driver.greedyRestart") == 0) {
+            ret = fscanf(configFile, "%d", &driver->greedyRestart);
+         }
+         else if (strcmp(ident, "driver.resolve") == 0) {
+            ret = fscanf(configFile, "%d", &driver->resolve);
+         }
          else if (strncmp(ident, "driver.", 7) == 0) {
             fprintf(stderr, 
               "ERROR(read_driver_params): Invalid parameter '%s'\n", ident);
@@ -523,13 +671,34 @@ fprintf(outputFile, "driver.shift         = %e\n", driver.shift);
 fprintf(outputFile, "driver.isymm         = %d\n", driver.isymm);
 fprintf(outputFile, "driver.level         = %d\n", driver.level);
 fprintf(outputFile, "driver.threshold     = %f\n", driver.threshold);
-fprintf(outputFile, "driver.filter        = %f\n\n", driver.filter);
+fprintf(outputFile, "driver.filter        = %f\n", driver.filter);
+fprintf(outputFile, "driver.slices        = %d\n", driver.slices);
+fprintf(outputFile, "driver.sliceLower    = %e\n", driver.sliceLower);
+fprintf(outputFile, "driver.sliceUpper    = %e\n", driver.sliceUpper);
+fprintf(outputFile, "driver.lockFile      = %s\n", driver.lockFileName);
+fprintf(outputFile, "driver.splitMatvec   = %d\n", driver.splitMatvec);
+fprintf(outputFile, "driver.benchFile     = %s\n", driver.benchFileName);
+fprintf(outputFile, "driver.stopAfter     = %d\n", driver.stopAfter);
+fprintf(outputFile, "driver.minConverged  = %d\n", driver.minConverged);
+fprintf(outputFile, "driver.timeOutAfter  = %d\n", driver.timeOutAfter);
+fprintf(outputFile, "driver.checkCache    = %d\n", driver.checkCache);
+fprintf(outputFile, "driver.checkEvents   = %s\n", driver.checkEventsFileName);
+fprintf(outputFile, "driver.virtualRanks  = %d\n", driver.virtualRanks);
+fprintf(outputFile, "driver.virtualLatency = %e\n", driver.virtualLatency);
+fprintf(outputFile, "driver.greedyRestart = %d\n", driver.greedyRestart);
+fprintf(outputFile, "driver.resolve       = %d\n\n", driver.resolve);
 
 }
 
 void driver_display_method(primme_preset_method method, FILE *outputFile) {
 
-const char *strMethod[] = {"DYNAMIC",
+fprintf(outputFile, "method               = %s\n", driver_method_name(method));
+
+}
+
+const char *driver_method_name(primme_preset_method method) {
+
+static const char *strMethod[] = {"DYNAMIC",
                            "DEFAULT_MIN_TIME",
                            "DEFAULT_MIN_MATVECS",
                            "Arnoldi",
@@ -544,7 +713,7 @@ const char *strMethod[] = {"DYNAMIC",
                            "SUBSPACE_ITERATION",
                            "LOBPCG_OrthoBasis",
                            "LOBPCG_OrthoBasis_Window"};
- 
-fprintf(outputFile, "method               = %s\n", strMethod[method]);
+
+return strMethod[method];
 
 }
@@ -72,6 +72,57 @@ typedef struct driver_params {
    double threshold;
    double filter;
    double shift;
+
+   /* Spectrum slicing: if slices > 0, find the eigenvalues in        */
+   /* [sliceLower, sliceUpper] with d/zprimme_slice                   */
+   int slices;
+   double sliceLower;
+   double sliceUpper;
+
+   /* If not empty, the locked eigenvectors are kept in this file     */
+   char lockFileName[1024];
+
+   /* If nonzero, the matrix is also given as a split-phase matvec    */
+   int splitMatvec;
+
+   /* If not empty, append a line with the timings of the run to this */
+   /* CSV file (see bench/bench.sh)                                   */
+   char benchFileName[1024];
+
+   /* If positive, a monitorFun stops the solver once this many pairs */
+   /* have converged                                                  */
+   int stopAfter;
+
+   /* If positive, running out of maxMatvecs, maxOuterIterations or     */
+   /* maxTime is expected once this many pairs have converged           */
+   int minConverged;
+
+   /* If positive, a monitorFun sets the smallest maxTime once this many  */
+   /* pairs have converged, so that the solver stops as if out of time    */
+   int timeOutAfter;
+
+   /* If nonzero, the run fails unless primme.tuning.cacheFile has one   */
+   /* line with the key of the problem after the solve                   */
+   int checkCache;
+
+   /* If not empty, the run fails unless this JSON events file, written  */
+   /* by primme.events.file, is well formed and complete                 */
+   char checkEventsFileName[1024];
+
+   /* If greater than one, solve with this many threads that act as MPI */
+   /* processes (see COMMON/vranks.c), waiting virtualLatency           */
+   /* microseconds in every globalSumDouble                             */
+   int virtualRanks;
+   double virtualLatency;
+
+   /* If nonzero, solve again from the returned eigenvectors and the    */
+   /* state kept by the first call (continuationParams.keepState); the  */
+   /* second solve must take fewer matvecs than the first               */
+   int resolve;
+
+   /* If nonzero, a restartPolicy asks to keep the whole basis at every */
+   /* restart                                                           */
+   int greedyRestart;
    
 } driver_params;
 
@@ -81,6 +132,7 @@ int read_solver_params(char *configFileName, char *outputFileName,
 int read_driver_params(char *configFileName, driver_params *driver);
 void driver_display_params(driver_params driver, FILE *outputFile);
 void driver_display_method(primme_preset_method method, FILE *outputFile);
+const char *driver_method_name(primme_preset_method method);
 int readfullMTX(char *mtfile, double **A, int **JA, int **IA, int *n, int *nnz);
 int readUpperMTX(char *mtfile, double **A, int **JA, int **IA, int *n, int *nnz);
 int readmtx(char *mtfile, double **A, int **JA, int **IA, int *n, int *nnz);
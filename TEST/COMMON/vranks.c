@@ -0,0 +1,282 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ * File: vranks.c
+ * 
+ * Purpose - Virtual ranks: solve the problem with numRanks threads in one
+ *           process, as numRanks MPI processes would do, to exercise and
+ *           measure the parallel code paths (numProcs, nLocal and
+ *           globalSumDouble) without MPI.
+ *
+ *  Every thread owns a block of consecutive rows of the vectors and calls
+ *  d/zprimme with its own copy of primme_params. globalSumDouble is an
+ *  allreduce through shared memory and two barriers, that optionally waits
+ *  a fixed latency to model the network. The matrix and the preconditioner
+ *  of the sequential problem are applied by the thread with procID 0 on the
+ *  gathered vectors, so any matrix of the driver works.
+ * 
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "vranks.h"
+
+typedef struct vranks_context {
+   int numRanks;
+   double latency;               /* Seconds waited in every reduction      */
+   pthread_barrier_t barrier;
+   double **sendBufs;            /* sendBuf of every rank in a reduction   */
+   PRIMME_NUM *X, *Y;            /* Gathered vectors                       */
+   int capacity;                 /* Number of columns of X and Y           */
+   primme_params *primme;        /* The sequential problem                 */
+   double numReductions;         /* Calls to globalSumDouble               */
+   double reductionBytes;        /* Bytes reduced in them                  */
+} vranks_context;
+
+typedef struct vrank {
+   primme_params primme;         /* Copy of the parameters of this rank    */
+   int offset;                   /* First row owned by this rank           */
+   double *evals, *rnorms;
+   PRIMME_NUM *evecs;            /* Rows of evecs owned by this rank       */
+   int ret;                      /* Value returned by d/zprimme            */
+} vrank;
+
+static void partition(int n, int numRanks, int procID, int *nLocal,
+      int *offset) {
+   *nLocal = n/numRanks + (procID < n%numRanks ? 1 : 0);
+   *offset = procID*(n/numRanks) + min(procID, n%numRanks);
+}
+
+static void wait_latency(double latency) {
+   struct timespec ts;
+   ts.tv_sec = (time_t)latency;
+   ts.tv_nsec = (long)((latency - (double)ts.tv_sec)*1e9);
+   nanosleep(&ts, NULL);
+}
+
+/******************************************************************************
+ * Sum of the sendBuf of all ranks in the same order on every rank, so that
+ * all ranks receive identical values.
+ *
+******************************************************************************/
+static void vranksGlobalSumDouble(void *sendBuf, void *recvBuf, int *count, 
+                         primme_params *primme) {
+   vranks_context *ctx = (vranks_context *)primme->commInfo;
+   double *sum;
+   int i, r;
+
+   if (ctx->latency > 0.0) wait_latency(ctx->latency);
+   sum = (double *)primme_calloc(max(*count, 1), sizeof(double), "sum");
+   ctx->sendBufs[primme->procID] = (double *)sendBuf;
+   pthread_barrier_wait(&ctx->barrier);
+   for (r=0; r < ctx->numRanks; r++) {
+      for (i=0; i < *count; i++) sum[i] += ctx->sendBufs[r][i];
+   }
+   if (primme->procID == 0) {
+      ctx->numReductions += 1;
+      ctx->reductionBytes += (double)*count*sizeof(double);
+   }
+   /* sendBuf and recvBuf may be the same array */
+   pthread_barrier_wait(&ctx->barrier);
+   memcpy(recvBuf, sum, sizeof(double)*(*count));
+   free(sum);
+}
+
+/******************************************************************************
+ * Gather x, apply the matrix or the preconditioner of the sequential problem
+ * on procID 0 and scatter the result to y, by blocks of capacity columns.
+ *
+******************************************************************************/
+static void vranksApply(void *x, void *y, int blockSize, int precond,
+      primme_params *primme) {
+   vranks_context *ctx = (vranks_context *)primme->commInfo;
+   int n = ctx->primme->n, nLocal, offset, i, j, cols;
+   PRIMME_NUM *xv = (PRIMME_NUM *)x, *yv = (PRIMME_NUM *)y;
+
+   partition(n, ctx->numRanks, primme->procID, &nLocal, &offset);
+   for (i=0; i < blockSize; i+=ctx->capacity) {
+      cols = min(ctx->capacity, blockSize-i);
+      for (j=0; j < cols; j++) {
+         memcpy(&ctx->X[n*j+offset], &xv[nLocal*(i+j)],
+               sizeof(PRIMME_NUM)*nLocal);
+      }
+      pthread_barrier_wait(&ctx->barrier);
+      if (primme->procID == 0) {
+         if (precond) {
+            ctx->primme->ShiftsForPreconditioner =
+               primme->ShiftsForPreconditioner ?
+               primme->ShiftsForPreconditioner + i : NULL;
+            ctx->primme->applyPreconditioner(ctx->X, ctx->Y, &cols,
+                  ctx->primme);
+         }
+         else {
+            ctx->primme->matrixMatvec(ctx->X, ctx->Y, &cols, ctx->primme);
+         }
+      }
+      pthread_barrier_wait(&ctx->barrier);
+      for (j=0; j < cols; j++) {
+         memcpy(&yv[nLocal*(i+j)], &ctx->Y[n*j+offset],
+               sizeof(PRIMME_NUM)*nLocal);
+      }
+   }
+}
+
+static void vranksMatvec(void *x, void *y, int *blockSize,
+      primme_params *primme) {
+   vranksApply(x, y, *blockSize, 0, primme);
+}
+
+static void vranksPrecond(void *x, void *y, int *blockSize,
+      primme_params *primme) {
+   vranksApply(x, y, *blockSize, 1, primme);
+}
+
+static void *vrankMain(void *arg) {
+   vrank *r = (vrank *)arg;
+
+   r->ret = PREFIX(primme)(r->evals, COMPLEXZ(r->evecs), r->rnorms,
+         &r->primme);
+   return NULL;
+}
+
+/******************************************************************************
+ * Subroutine vranksSolve - Solve the problem in primme with numRanks virtual
+ *    ranks. On input evecs holds the initial guesses and, on output, the
+ *    eigenvectors, both with all n rows, as in the sequential case. The
+ *    statistics and initSize of primme are set from the rank 0.
+ *
+ * INPUT PARAMETERS
+ * ----------------
+ * numRanks     Number of threads
+ * latency      Seconds added to every call to globalSumDouble
+ * maxEvals     Number of columns of evecs
+ *
+ * OUTPUT PARAMETERS
+ * -----------------
+ * numReductions, reductionBytes  Calls to globalSumDouble and bytes reduced
+ *
+ * Return value
+ * ------------
+ * The value returned by d/zprimme on the rank 0, or -1 if the threads could
+ * not be created
+ *
+******************************************************************************/
+int vranksSolve(int numRanks, double latency, double *evals,
+      PRIMME_NUM *evecs, double *rnorms, int maxEvals, primme_params *primme,
+      double *numReductions, double *reductionBytes) {
+
+   vranks_context ctx;
+   vrank *ranks;
+   pthread_t *threads;
+   int n = primme->n, nLocal, i, j, ret = 0;
+
+   ctx.numRanks = numRanks;
+   ctx.latency = latency;
+   ctx.primme = primme;
+   ctx.capacity = max(1, max(primme->maxBasisSize, primme->maxBlockSize));
+   ctx.numReductions = ctx.reductionBytes = 0.0;
+   ctx.sendBufs = (double **)primme_calloc(numRanks, sizeof(double *),
+         "sendBufs");
+   ctx.X = (PRIMME_NUM *)primme_calloc((size_t)n*ctx.capacity,
+         sizeof(PRIMME_NUM), "X");
+   ctx.Y = (PRIMME_NUM *)primme_calloc((size_t)n*ctx.capacity,
+         sizeof(PRIMME_NUM), "Y");
+   pthread_barrier_init(&ctx.barrier, NULL, numRanks);
+   ranks = (vrank *)primme_calloc(numRanks, sizeof(vrank), "ranks");
+   threads = (pthread_t *)primme_calloc(numRanks, sizeof(pthread_t),
+         "threads");
+
+   for (i=0; i < numRanks; i++) {
+      vrank *r = &ranks[i];
+      r->primme = *primme;
+      r->primme.numProcs = numRanks;
+      r->primme.procID = i;
+      partition(n, numRanks, i, &nLocal, &r->offset);
+      r->primme.nLocal = nLocal;
+      r->primme.commInfo = &ctx;
+      r->primme.globalSumDouble = vranksGlobalSumDouble;
+      r->primme.matrixMatvec = vranksMatvec;
+      r->primme.matrixMatvecBegin = NULL;
+      r->primme.matrixMatvecEnd = NULL;
+      r->primme.applyPreconditioner = primme->applyPreconditioner ?
+         vranksPrecond : NULL;
+      r->primme.intWork = NULL;
+      r->primme.realWork = NULL;
+      r->primme.intWorkSize = 0;
+      r->primme.realWorkSize = 0;
+      r->evals = i == 0 ? evals :
+         (double *)primme_calloc(maxEvals, sizeof(double), "evals");
+      r->rnorms = i == 0 ? rnorms :
+         (double *)primme_calloc(maxEvals, sizeof(double), "rnorms");
+      r->evecs = (PRIMME_NUM *)primme_calloc((size_t)nLocal*maxEvals,
+            sizeof(PRIMME_NUM), "evecs");
+      for (j=0; j < maxEvals; j++) {
+         memcpy(&r->evecs[nLocal*j], &evecs[n*j+r->offset],
+               sizeof(PRIMME_NUM)*nLocal);
+      }
+   }
+
+   for (i=0; i < numRanks; i++) {
+      if (pthread_create(&threads[i], NULL, vrankMain, &ranks[i]) != 0) {
+         fprintf(stderr, "ERROR: could not create the virtual rank %d\n", i);
+         exit(EXIT_FAILURE);
+      }
+   }
+   for (i=0; i < numRanks; i++) {
+      pthread_join(threads[i], NULL);
+   }
+
+   for (i=0; i < numRanks; i++) {
+      vrank *r = &ranks[i];
+      nLocal = r->primme.nLocal;
+      for (j=0; j < maxEvals; j++) {
+         memcpy(&evecs[n*j+r->offset], &r->evecs[nLocal*j],
+               sizeof(PRIMME_NUM)*nLocal);
+      }
+      if (i == 0) {
+         ret = r->ret;
+         primme->stats = r->primme.stats;
+         primme->initSize = r->primme.initSize;
+         primme->aNorm = r->primme.aNorm;
+         primme->dynamicMethodSwitch = r->primme.dynamicMethodSwitch;
+      }
+      else {
+         free(r->evals);
+         free(r->rnorms);
+      }
+      free(r->evecs);
+      primme_Free(&r->primme);
+   }
+
+   *numReductions = ctx.numReductions;
+   *reductionBytes = ctx.reductionBytes;
+   pthread_barrier_destroy(&ctx.barrier);
+   free(ctx.sendBufs);
+   free(ctx.X);
+   free(ctx.Y);
+   free(ranks);
+   free(threads);
+   return ret;
+}
@@ -0,0 +1,94 @@
+#!/bin/sh
+#*******************************************************************************
+#  File: bench.sh
+#
+#  Purpose - Performance benchmark of PRIMME with the driver. It runs every
+#            combination of synthetic matrix (see COMMON/gen.c), preset
+#            method, block size and target, and appends a CSV line per run
+#            to the results file (see writeBenchLine in driver.c).
+#            Compare two results files with bench/compare.sh.
+#
+#  Usage (from TEST): bench/bench.sh, or make bench. The grid is set with
+#  these environment variables (defaults in brackets):
+#
+#     BENCH_RESULTS    results file [bench/results.csv]
+#     BENCH_SCALE      small (n~1e4), medium (n~1e6) or large (n~1e7) [small]
+#     BENCH_MATRICES   list of gen: matrices, overrides BENCH_SCALE
+#     BENCH_PRECISION  double and/or doublecomplex [double doublecomplex];
+#                      the complex runs use the Hermitian variants
+#     BENCH_METHODS    preset methods
+#                      [DEFAULT_MIN_TIME DEFAULT_MIN_MATVECS GD_Olsen_plusK
+#                       JDQMR_ETol LOBPCG_OrthoBasis_Window]
+#     BENCH_BLOCKS     block sizes [1 4]
+#     BENCH_TARGETS    smallest and/or largest [smallest largest]
+#     BENCH_NEV        number of eigenpairs [10]
+#     BENCH_EPS        tolerance [1e-8]
+#     BENCH_PREC       driver preconditioner [noprecond]
+#     BENCH_MAXMATVECS maximum number of matvecs per run [100000]
+#     BENCH_REPS       repetitions of every run [1]
+#
+#******************************************************************************
+
+RESULTS=${BENCH_RESULTS:-bench/results.csv}
+SCALE=${BENCH_SCALE:-small}
+PRECISIONS=${BENCH_PRECISION:-double doublecomplex}
+METHODS=${BENCH_METHODS:-DEFAULT_MIN_TIME DEFAULT_MIN_MATVECS GD_Olsen_plusK JDQMR_ETol LOBPCG_OrthoBasis_Window}
+BLOCKS=${BENCH_BLOCKS:-1 4}
+TARGETS=${BENCH_TARGETS:-smallest largest}
+NEV=${BENCH_NEV:-10}
+EPS=${BENCH_EPS:-1e-8}
+PREC=${BENCH_PREC:-noprecond}
+MAXMATVECS=${BENCH_MAXMATVECS:-100000}
+REPS=${BENCH_REPS:-1}
+
+case $SCALE in
+   small)  MATRICES="lap2d:100 lap3d:22 band:10000:5 randspd:10000:10 anderson:22:16.5" ;;
+   medium) MATRICES="lap2d:1000 lap3d:100 band:1000000:5 randspd:1000000:10 anderson:100:16.5" ;;
+   large)  MATRICES="lap2d:3163 lap3d:216 band:10000000:5 randspd:10000000:10 anderson:216:16.5" ;;
+   *) echo "Invalid BENCH_SCALE '$SCALE'" >&2; exit 1 ;;
+esac
+MATRICES=${BENCH_MATRICES:-$MATRICES}
+
+TMP=${TMPDIR:-/tmp}/primme_bench.$$
+mkdir -p $TMP || exit 1
+trap 'rm -rf $TMP' 0
+fail=0
+
+for precision in $PRECISIONS; do
+   for matrix in $MATRICES; do
+      matrix=${matrix#gen:}
+      if [ $precision = doublecomplex ]; then matrix=h${matrix#h}; fi
+      cat > $TMP/driver <<EOC
+driver.matrixFile    = gen:$matrix
+driver.outputFile    = $TMP/log
+driver.PrecChoice    = $PREC
+driver.benchFile     = $RESULTS
+EOC
+      for method in $METHODS; do
+         for block in $BLOCKS; do
+            for target in $TARGETS; do
+               cat > $TMP/solver <<EOC
+primme.printLevel = 1
+primme.numEvals = $NEV
+primme.eps = $EPS
+primme.maxBlockSize = $block
+primme.maxMatvecs = $MAXMATVECS
+primme.target = primme_$target
+method = $method
+EOC
+               rep=0
+               while [ $rep -lt $REPS ]; do
+                  echo "$precision gen:$matrix $method bs=$block $target"
+                  if ! ./primme_$precision $TMP/driver $TMP/solver > /dev/null 2>&1; then
+                     echo "   FAILED:"; tail -5 $TMP/log; fail=1
+                  fi
+                  rep=`expr $rep + 1`
+               done
+            done
+         done
+      done
+   done
+done
+
+echo "Results appended to $RESULTS"
+exit $fail
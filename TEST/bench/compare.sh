@@ -0,0 +1,71 @@
+#!/bin/sh
+#*******************************************************************************
+#  File: compare.sh
+#
+#  Purpose - Compares a results file of bench/bench.sh against a baseline and
+#            flags the regressions. The runs are matched by precision, matrix,
+#            preconditioner, method, block size, target, number of
+#            eigenpairs and tolerance; repeated runs take the minimum time.
+#            A run is a regression if
+#              - it converges fewer eigenpairs or its status becomes nonzero,
+#              - it takes more than TIME_TOL relative and MIN_TIME seconds
+#                longer, or
+#              - it takes more than MV_TOL relative more matvecs.
+#
+#  Usage: bench/compare.sh baseline.csv results.csv [TIME_TOL [MV_TOL [MIN_TIME]]]
+#         (defaults 0.10, 0.05 and 0.05), or make bench_compare.
+#         Returns nonzero if there are regressions.
+#
+#******************************************************************************
+
+if [ $# -lt 2 ]; then
+   echo "Usage: $0 baseline.csv results.csv [TIME_TOL [MV_TOL [MIN_TIME]]]" >&2
+   exit 2
+fi
+for f in "$1" "$2"; do
+   if [ ! -r "$f" ]; then echo "Could not read '$f'" >&2; exit 2; fi
+done
+
+awk -F, -v ttol=${3:-0.10} -v mtol=${4:-0.05} -v mintime=${5:-0.05} '
+   FNR == 1 {
+      for (i=1; i<=NF; i++) col[$i] = i
+      next
+   }
+   {
+      key = $1
+      for (i=2; i<=col["eps"]; i++) key = key "," $i
+      t = $col["time"]
+      if (FILENAME == ARGV[1]) { f = "b"; inb[key] = 1 }
+      else { f = "r"; if (!(key in inr)) order[++n] = key; inr[key] = 1 }
+      if (!((f,key) in time) || t < time[f,key]) time[f,key] = t
+      mv[f,key] = $col["matvecs"]; conv[f,key] = $col["converged"]
+      status[f,key] = $col["status"]
+   }
+   END {
+      bad = 0
+      printf("%-8s %8s %8s %7s %8s %8s  %s\n", "result", "time", "base",
+             "ratio", "matvecs", "base", "run")
+      for (i=1; i<=n; i++) {
+         k = order[i]
+         if (!(k in inb)) { printf("%-8s %8.3f %8s %7s %8d %8s  %s\n", "NEW",
+               time["r",k], "-", "-", mv["r",k], "-", k); continue }
+         tb = time["b",k]; tr = time["r",k]
+         res = "ok"
+         if (conv["r",k] < conv["b",k] || (status["r",k] != 0 && status["b",k] == 0))
+            res = "FAIL"
+         else if (mv["r",k] > mv["b",k]*(1+mtol))
+            res = "MATVECS"
+         else if (tr > tb*(1+ttol) && tr - tb > mintime)
+            res = "SLOWER"
+         else if (tr < tb*(1-ttol) && tb - tr > mintime)
+            res = "faster"
+         if (res != "ok" && res != "faster") bad++
+         printf("%-8s %8.3f %8.3f %7.2f %8d %8d  %s\n", res, tr, tb,
+                tb > 0 ? tr/tb : 0, mv["r",k], mv["b",k], k)
+      }
+      missing = 0
+      for (k in inb) if (!(k in inr)) missing++
+      if (missing > 0) printf("%d run(s) of the baseline are not in the results\n", missing)
+      printf("%d regression(s)\n", bad)
+      exit (bad > 0)
+   }' "$1" "$2"
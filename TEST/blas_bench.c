@@ -0,0 +1,239 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ * File: blas_bench.c
+ *
+ * Purpose - Microbenchmark of the internal kernels in numerical.c
+ *           (Num_*_kernel) against the linked BLAS.
+ *
+ *  Usage: blas_bench_double [n [reps [ncols]]]
+ *         blas_bench_doublecomplex [n [reps [ncols]]]
+ *
+ *  For every operation it prints the time per call of the BLAS and of the
+ *  kernel, the memory bandwidth of the kernel (counting the vectors read
+ *  and written once), the speedup and the largest difference between both
+ *  results. The gemv operations use an n x ncols matrix as in the
+ *  orthogonalization and the projection updates. The reference for the
+ *  complex dot product is a plain loop, because PRIMME does not call
+ *  zdotc (its return value is not portable across Fortran compilers).
+ *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "num.h"
+#include "wtime.h"
+
+#ifdef USE_DOUBLECOMPLEX
+#  define SCALAR Complex_Z
+#  define ABSDIFF(X, Y) (cabs((X) - (Y)))
+#else
+#  define SCALAR double
+#  define ABSDIFF(X, Y) (fabs((X) - (Y)))
+#endif
+
+#define BLAS_(NAME) FORTRAN_FUNCTION(NAME)
+#define BLAS(NAME) BLAS_(PREFIX(NAME))
+
+void BLAS(copy)(PRIMME_BLASINT *n, PRIMME_NUM *x, PRIMME_BLASINT *incx, PRIMME_NUM *y, PRIMME_BLASINT *incy);
+void BLAS(axpy)(PRIMME_BLASINT *n, PRIMME_NUM *alpha, PRIMME_NUM *x, PRIMME_BLASINT *incx,
+   PRIMME_NUM *y, PRIMME_BLASINT *incy);
+void BLAS(scal)(PRIMME_BLASINT *n, PRIMME_NUM *alpha, PRIMME_NUM *x, PRIMME_BLASINT *incx);
+void BLAS(gemv)(const char *transa, PRIMME_BLASINT *m, PRIMME_BLASINT *n, PRIMME_NUM *alpha,
+   PRIMME_NUM *a, PRIMME_BLASINT *lda, PRIMME_NUM *x, PRIMME_BLASINT *incx, PRIMME_NUM *beta,
+   PRIMME_NUM *y, PRIMME_BLASINT *incy);
+#ifndef USE_DOUBLECOMPLEX
+double BLAS(dot)(PRIMME_BLASINT *n, PRIMME_NUM *x, PRIMME_BLASINT *incx, PRIMME_NUM *y, PRIMME_BLASINT *incy);
+#endif
+
+static PRIMME_NUM refDot(int n, PRIMME_NUM *x, PRIMME_NUM *y) {
+#ifdef USE_DOUBLECOMPLEX
+   int i;
+   PRIMME_NUM s = 0.0;
+   for (i=0; i < n; i++) s += CONJ(x[i])*y[i];
+   return s;
+#else
+   PRIMME_BLASINT ln = n, one = 1;
+   return BLAS(dot)(&ln, x, &one, y, &one);
+#endif
+}
+
+static PRIMME_NUM fromScalar(SCALAR x) {
+#ifdef USE_DOUBLECOMPLEX
+   return x.r + x.i*IMAGINARY;
+#else
+   return x;
+#endif
+}
+
+static double maxDiff(int n, PRIMME_NUM *x, PRIMME_NUM *y) {
+   int i;
+   double d = 0.0;
+   for (i=0; i < n; i++) d = max(d, ABSDIFF(x[i], y[i]));
+   return d;
+}
+
+static void fill(int n, PRIMME_NUM *x, int seed) {
+   int i;
+   for (i=0; i < n; i++) {
+      x[i] = sin(seed + i) + cos(seed*3 + i)*IMAGINARY;
+   }
+}
+
+static void report(const char *op, double tref, double tker, double bytes,
+      double diff) {
+   printf("%-10s %12.3e %12.3e %9.2f %8.2f %10.2e\n", op, tref, tker,
+         bytes/tker*1e-9, tref/tker, diff);
+}
+
+int main(int argc, char *argv[]) {
+
+   int n = argc > 1 ? atoi(argv[1]) : 1000000;
+   int reps = argc > 2 ? atoi(argv[2]) : 100;
+   int ncols = argc > 3 ? atoi(argv[3]) : 16;
+   int r;
+   PRIMME_BLASINT ln = n, lncols = ncols, one = 1;
+   size_t s = sizeof(PRIMME_NUM);
+   PRIMME_NUM *x, *y, *y0, *z, *a, *xc, *yc, *yc0;
+   PRIMME_NUM alpha = 0.5 + 0.25*IMAGINARY, alpha2 = -0.5 - 0.25*IMAGINARY;
+   PRIMME_NUM tpone = 1.0, tzero = 0.0, dref = 0.0, dker = 0.0;
+   double t, tref, tker;
+
+   x = (PRIMME_NUM *)malloc(s*n);
+   y = (PRIMME_NUM *)malloc(s*n);
+   y0 = (PRIMME_NUM *)malloc(s*n);
+   z = (PRIMME_NUM *)malloc(s*n);
+   a = (PRIMME_NUM *)malloc(s*n*ncols);
+   xc = (PRIMME_NUM *)malloc(s*ncols);
+   yc = (PRIMME_NUM *)malloc(s*ncols);
+   yc0 = (PRIMME_NUM *)malloc(s*ncols);
+   if (!x || !y || !y0 || !z || !a || !xc || !yc || !yc0) {
+      fprintf(stderr, "ERROR: not enough memory for n=%d ncols=%d\n", n,
+            ncols);
+      return 1;
+   }
+   fill(n, x, 1); fill(n, z, 2); fill(n*ncols, a, 3); fill(ncols, xc, 4);
+
+   printf("n=%d reps=%d ncols=%d\n", n, reps, ncols);
+   printf("%-10s %12s %12s %9s %8s %10s\n", "op", "BLAS (s)", "kernel (s)",
+         "GB/s", "speedup", "max diff");
+
+   /* copy */
+   t = primme_wTimer(0);
+   for (r=0; r < reps; r++) BLAS(copy)(&ln, x, &one, y0, &one);
+   tref = (primme_wTimer(0) - t)/reps;
+   t = primme_wTimer(0);
+   for (r=0; r < reps; r++) SUF(Num_copy_kernel)(n, COMPLEXZ(x), COMPLEXZ(y));
+   tker = (primme_wTimer(0) - t)/reps;
+   report("copy", tref, tker, 2.0*s*n, maxDiff(n, y, y0));
+
+   /* axpy; alternate alpha and -alpha to keep y bounded */
+   t = primme_wTimer(0);
+   for (r=0; r < reps; r++) {
+      BLAS(axpy)(&ln, r%2 ? &alpha2 : &alpha, x, &one, y0, &one);
+   }
+   tref = (primme_wTimer(0) - t)/reps;
+   t = primme_wTimer(0);
+   for (r=0; r < reps; r++) {
+      SUF(Num_axpy_kernel)(n, COMPLEXZV(r%2 ? alpha2 : alpha), COMPLEXZ(x),
+            COMPLEXZ(y));
+   }
+   tker = (primme_wTimer(0) - t)/reps;
+   report("axpy", tref, tker, 3.0*s*n, maxDiff(n, y, y0));
+
+   /* dot */
+   t = primme_wTimer(0);
+   for (r=0; r < reps; r++) dref += refDot(n, x, z);
+   tref = (primme_wTimer(0) - t)/reps;
+   t = primme_wTimer(0);
+   for (r=0; r < reps; r++) {
+      dker += fromScalar(SUF(Num_dot_kernel)(n, COMPLEXZ(x), COMPLEXZ(z)));
+   }
+   tker = (primme_wTimer(0) - t)/reps;
+   report("dot", tref, tker, 2.0*s*n, ABSDIFF(dref, dker)/reps);
+
+   /* scal; alternate alpha and 1/alpha */
+   t = primme_wTimer(0);
+   for (r=0; r < reps; r++) {
+      PRIMME_NUM f = r%2 ? 1.0/alpha : alpha;
+      BLAS(scal)(&ln, &f, y0, &one);
+   }
+   tref = (primme_wTimer(0) - t)/reps;
+   t = primme_wTimer(0);
+   for (r=0; r < reps; r++) {
+      SUF(Num_scal_kernel)(n, COMPLEXZV(r%2 ? 1.0/alpha : alpha), COMPLEXZ(y));
+   }
+   tker = (primme_wTimer(0) - t)/reps;
+   report("scal", tref, tker, 2.0*s*n, maxDiff(n, y, y0));
+
+   /* axpy followed by dot against the fused kernel */
+   dref = dker = 0.0;
+   t = primme_wTimer(0);
+   for (r=0; r < reps; r++) {
+      BLAS(axpy)(&ln, r%2 ? &alpha2 : &alpha, x, &one, y0, &one);
+      dref += refDot(n, y0, z);
+   }
+   tref = (primme_wTimer(0) - t)/reps;
+   t = primme_wTimer(0);
+   for (r=0; r < reps; r++) {
+      dker += fromScalar(SUF(Num_axpy_dot_kernel)(n,
+               COMPLEXZV(r%2 ? alpha2 : alpha), COMPLEXZ(x), COMPLEXZ(y),
+               COMPLEXZ(z)));
+   }
+   tker = (primme_wTimer(0) - t)/reps;
+   report("axpy+dot", tref, tker, 4.0*s*n,
+         max(maxDiff(n, y, y0), ABSDIFF(dref, dker)/reps));
+
+   /* gemv "N": y = a*xc */
+   t = primme_wTimer(0);
+   for (r=0; r < reps; r++) {
+      BLAS(gemv)("N", &ln, &lncols, &tpone, a, &ln, xc, &one, &tzero, y0, &one);
+   }
+   tref = (primme_wTimer(0) - t)/reps;
+   t = primme_wTimer(0);
+   for (r=0; r < reps; r++) {
+      SUF(Num_gemv_kernel)("N", n, ncols, COMPLEXZV(tpone), COMPLEXZ(a), n,
+            COMPLEXZ(xc), COMPLEXZV(tzero), COMPLEXZ(y));
+   }
+   tker = (primme_wTimer(0) - t)/reps;
+   report("gemv N", tref, tker, (ncols + 1.0)*s*n, maxDiff(n, y, y0));
+
+   /* gemv "C": yc = a'*z */
+   t = primme_wTimer(0);
+   for (r=0; r < reps; r++) {
+      BLAS(gemv)("C", &ln, &lncols, &tpone, a, &ln, z, &one, &tzero, yc0, &one);
+   }
+   tref = (primme_wTimer(0) - t)/reps;
+   t = primme_wTimer(0);
+   for (r=0; r < reps; r++) {
+      SUF(Num_gemv_kernel)("C", n, ncols, COMPLEXZV(tpone), COMPLEXZ(a), n,
+            COMPLEXZ(z), COMPLEXZV(tzero), COMPLEXZ(yc));
+   }
+   tker = (primme_wTimer(0) - t)/reps;
+   report("gemv C", tref, tker, (ncols + 1.0)*s*n, maxDiff(ncols, yc, yc0));
+
+   free(x); free(y); free(y0); free(z); free(a); free(xc); free(yc);
+   free(yc0);
+
+   return 0;
+}
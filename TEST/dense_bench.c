@@ -0,0 +1,138 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ * File: dense_bench.c
+ *
+ * Purpose - Benchmark of the dense solver for small problems against the
+ *           iterative solver, to choose denseThreshold.
+ *
+ *  Usage: dense_bench_double [numEvals [maxN [reps]]]
+ *         dense_bench_doublecomplex ...
+ *
+ *  For n = 25, 50, 100, ... up to maxN it solves the numEvals smallest
+ *  eigenpairs of the matrix tridiag(-1,2,-1) of size n with DEFAULT_MIN_TIME
+ *  and eps 1e-10, once with the dense solver disabled (denseThreshold = -1)
+ *  and once forcing it (denseThreshold = n). It prints the best time of
+ *  reps runs and the matvecs of both, the speedup of the dense solver and
+ *  the largest n for which it is faster. The crossover depends on the cost
+ *  of the matvec, which is the cheapest possible here, and on numEvals.
+ *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "primme.h"
+#include "num.h"
+
+static void laplacianMatvec(void *x, void *y, int *blockSize,
+      primme_params *primme) {
+   int i, j, n = primme->n;
+   PRIMME_NUM *xv, *yv;
+
+   for (j=0; j < *blockSize; j++) {
+      xv = (PRIMME_NUM *)x + n*j;
+      yv = (PRIMME_NUM *)y + n*j;
+      for (i=0; i < n; i++) {
+         yv[i] = 2.0*xv[i] - (i > 0 ? xv[i-1] : 0.0)
+            - (i < n-1 ? xv[i+1] : 0.0);
+      }
+   }
+}
+
+/* Best time (stats.elapsedTime) of reps runs with the given         */
+/* denseThreshold; it returns a negative time if PRIMME fails         */
+
+static double solve(int n, int numEvals, int denseThreshold, int reps,
+      int *matvecs, double *evals, PRIMME_NUM *evecs, double *rnorms) {
+
+   int r, ret;
+   double t, best = -1.0;
+   primme_params primme;
+
+   for (r=0; r < reps; r++) {
+      primme_initialize(&primme);
+      primme.n = n;
+      primme.matrixMatvec = laplacianMatvec;
+      primme.numEvals = numEvals;
+      primme.eps = 1e-10;
+      primme.aNorm = 4.0;
+      primme.target = primme_smallest;
+      primme.denseThreshold = denseThreshold;
+      primme_set_method(DEFAULT_MIN_TIME, &primme);
+
+      ret = PREFIX(primme)(evals, COMPLEXZ(evecs), rnorms, &primme);
+      t = primme.stats.elapsedTime;
+      *matvecs = primme.stats.numMatvecs;
+      primme_Free(&primme);
+      if (ret != 0) {
+         fprintf(stderr, "ERROR: PRIMME returned %d for n=%d\n", ret, n);
+         return -1.0;
+      }
+      if (best < 0.0 || t < best) best = t;
+   }
+
+   return best;
+}
+
+int main(int argc, char *argv[]) {
+
+   int numEvals = argc > 1 ? atoi(argv[1]) : 10;
+   int maxN = argc > 2 ? atoi(argv[2]) : 800;
+   int reps = argc > 3 ? atoi(argv[3]) : 3;
+   int n, mvIter, mvDense, crossover = 0;
+   double tIter, tDense, *evals, *rnorms;
+   PRIMME_NUM *evecs;
+
+   if (numEvals < 1 || maxN < 25 || reps < 1) {
+      fprintf(stderr, "ERROR: invalid arguments\n");
+      return 1;
+   }
+
+   evals = (double *)malloc(sizeof(double)*numEvals);
+   rnorms = (double *)malloc(sizeof(double)*numEvals);
+   evecs = (PRIMME_NUM *)malloc(sizeof(PRIMME_NUM)*maxN*numEvals);
+   if (!evals || !rnorms || !evecs) {
+      fprintf(stderr, "ERROR: not enough memory for maxN=%d\n", maxN);
+      return 1;
+   }
+
+   printf("numEvals=%d reps=%d\n", numEvals, reps);
+   printf("%8s %12s %8s %12s %8s %8s\n", "n", "iter (s)", "matvecs",
+         "dense (s)", "matvecs", "speedup");
+
+   for (n=25; n <= maxN; n *= 2) {
+      if (numEvals >= n/2) continue;
+      tIter = solve(n, numEvals, -1, reps, &mvIter, evals, evecs, rnorms);
+      tDense = solve(n, numEvals, n, reps, &mvDense, evals, evecs, rnorms);
+      if (tIter < 0.0 || tDense < 0.0) return 1;
+      printf("%8d %12.3e %8d %12.3e %8d %8.2f\n", n, tIter, mvIter, tDense,
+            mvDense, tIter/tDense);
+      if (tDense < tIter) crossover = n;
+   }
+
+   printf("The dense solver is faster up to n=%d\n", crossover);
+
+   free(evals); free(rnorms); free(evecs);
+
+   return 0;
+}
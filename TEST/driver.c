@@ -53,6 +53,9 @@
 #include <unistd.h>
 #include <math.h>
 #include <assert.h>
+#if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
+#  include <sys/resource.h>
+#endif
 
 #ifdef USE_MPI
 #  include <mpi.h>
@@ -66,6 +69,9 @@
 #ifdef USE_PETSC
 # include "petscw.h"
 #endif
+#ifdef USE_VRANKS
+#  include "vranks.h"
+#endif
 
 /* primme.h header file is required to run primme */
 #include "primme.h"
@@ -91,6 +97,18 @@ static int writeBinaryEvecsAndPrimmeParams(const char *fileName, PRIMME_NUM *X,
 static int readBinaryEvecsAndPrimmeParams(const char *fileName, PRIMME_NUM *X, PRIMME_NUM **Xout,
                                           int n, int Xcols, int *Xcolsout, int nLocal,
                                           int *perm, primme_params *primme);
+static void setBenchTimers(primme_params *primme);
+static int stopAfterMonitor(primme_monitor *info, primme_params *primme);
+static int stopAfter;   /* Set from driver.stopAfter */
+static int timeOutAfterMonitor(primme_monitor *info, primme_params *primme);
+static int timeOutAfter;   /* Set from driver.timeOutAfter */
+static int greedyRestartPolicy(double *hVals, int basisSize, int lMin,
+   int numFree, int target, int *right, primme_params *primme);
+static int countCacheEntries(primme_params *primme);
+static int checkEventsFile(const char *eventsFileName, primme_params *primme);
+static int writeBenchLine(const char *benchFileName, driver_params *driver,
+                          primme_params *primme, primme_preset_method method,
+                          int ret, double time);
 
 
 
@@ -148,6 +166,12 @@ static int real_main (int argc, char *argv[]) {
    /* Other miscellaneous items */
    int ret, retX=0;
    int i;
+   int maxEvals, numFound;
+   int firstMatvecs, retResolve=0;
+   double numReductions=0.0, reductionBytes=0.0;
+   char lockFileName[1100];
+   static const char *phaseNames[] = {"solveH", "convergence", "correction",
+      "ortho", "matvec", "restart"};
    int master = 1;
    int procID = 0;
 
@@ -208,6 +232,15 @@ static int real_main (int argc, char *argv[]) {
    broadCast(&primme, &method, &driver, master, comm);
 #endif
 
+   if (driver.virtualRanks > 1) {
+#ifdef USE_VRANKS
+      ASSERT_MSG(driver.slices <= 0 && !driver.lockFileName[0], -1,
+            "driver.virtualRanks is not supported with slices or lockFile\n");
+#else
+      ASSERT_MSG(0, -1, "driver.virtualRanks needs USE_VRANKS\n");
+#endif
+   }
+
    /* --------------------------------------- */
    /* Set up matrix vector and preconditioner */
    /* --------------------------------------- */
@@ -220,11 +253,33 @@ static int real_main (int argc, char *argv[]) {
       fprintf(primme.outputFile, "No preset method. Using custom settings\n");
    }
 
+   /* Time the matvec and the preconditioner for the benchmark line */
+   if (driver.benchFileName[0]) {
+      setBenchTimers(&primme);
+   }
+
+   /* Stop the solver once driver.stopAfter pairs have converged */
+   if (driver.stopAfter > 0) {
+      primme.monitorFun = stopAfterMonitor;
+      stopAfter = driver.stopAfter;
+   }
+
+   /* Run out of maxTime once driver.timeOutAfter pairs have converged */
+   else if (driver.timeOutAfter > 0) {
+      primme.monitorFun = timeOutAfterMonitor;
+      timeOutAfter = driver.timeOutAfter;
+   }
+
+   /* Ask to keep the whole basis at every restart */
+   if (driver.greedyRestart) {
+      primme.restartingParams.restartPolicy = greedyRestartPolicy;
+   }
+
    /* --------------------------------------- */
    /* Optional: report memory requirements    */
    /* --------------------------------------- */
 
-   ret = dprimme(NULL,NULL,NULL,&primme);
+   ret = PREFIX(primme)(NULL,NULL,NULL,&primme);
    if (master) {
       fprintf(primme.outputFile,"PRIMME will allocate the following memory:\n");
       fprintf(primme.outputFile," processor %d, real workspace, %ld bytes\n",
@@ -249,12 +304,17 @@ static int real_main (int argc, char *argv[]) {
    /*                            Run the d/zprimme solver                   */
    /* --------------------------------------------------------------------- */
 
-   /* Allocate space for converged Ritz values and residual norms */
+   /* Allocate space for converged Ritz values and residual norms. */
+   /* With spectrum slicing, up to numEvals per slice are returned.  */
 
-   evals = (double *)primme_calloc(primme.numEvals, sizeof(double), "evals");
-   evecs = (PRIMME_NUM *)primme_calloc(primme.nLocal*primme.numEvals, 
+   maxEvals = primme.numEvals;
+   if (driver.slices > 0) {
+      maxEvals = primme.numOrthoConst + driver.slices*primme.numEvals;
+   }
+   evals = (double *)primme_calloc(maxEvals, sizeof(double), "evals");
+   evecs = (PRIMME_NUM *)primme_calloc(primme.nLocal*maxEvals, 
                                 sizeof(PRIMME_NUM), "evecs");
-   rnorms = (double *)primme_calloc(primme.numEvals, sizeof(double), "rnorms");
+   rnorms = (double *)primme_calloc(maxEvals, sizeof(double), "rnorms");
 
    /* ------------------------ */
    /* Initial guess (optional) */
@@ -296,22 +356,99 @@ static int real_main (int argc, char *argv[]) {
    /*  Call primme  */
    /* ------------- */
 
+   /* Keep the locked vectors in a file, one per process (optional) */
+
+   if (driver.lockFileName[0]) {
+      if (primme.numProcs > 1) {
+         sprintf(lockFileName, "%s.%d", driver.lockFileName, procID);
+      }
+      else {
+         strcpy(lockFileName, driver.lockFileName);
+      }
+      primme.lockStoreParams.fileName = lockFileName;
+   }
+
    wt1 = primme_get_wtime(); 
 #if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
    primme_get_time(&ut1,&st1);
 #endif
 
-   ret = PREFIX(primme)(evals, COMPLEXZ(evecs), rnorms, &primme);
+   if (driver.slices > 0) {
+      ret = PREFIX(primme_slice)(evals, COMPLEXZ(evecs), rnorms, &numFound,
+            driver.sliceLower, driver.sliceUpper, driver.slices, &primme);
+      primme.numEvals = numFound;
+   }
+#ifdef USE_VRANKS
+   else if (driver.virtualRanks > 1) {
+      ret = vranksSolve(driver.virtualRanks, driver.virtualLatency*1e-6,
+            evals, evecs, rnorms, maxEvals, &primme, &numReductions,
+            &reductionBytes);
+   }
+#endif
+   else {
+      ret = PREFIX(primme)(evals, COMPLEXZ(evecs), rnorms, &primme);
+
+      /* Solve again continuing from the returned eigenvectors and the */
+      /* state kept by the first call                                  */
+      if (ret == 0 && driver.resolve) {
+         firstMatvecs = primme.stats.numMatvecs;
+         ret = PREFIX(primme)(evals, COMPLEXZ(evecs), rnorms, &primme);
+         if (master) {
+            fprintf(primme.outputFile, "Resolve matvecs: %d (first solve %d)\n",
+                  primme.stats.numMatvecs, firstMatvecs);
+         }
+         if (ret == 0 && primme.stats.numMatvecs >= firstMatvecs) {
+            retResolve = 1;
+         }
+      }
+   }
 
    wt2 = primme_get_wtime();
 #if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
    primme_get_time(&ut2,&st2);
 #endif
 
+   /* Read back the eigenvectors from the file of the locked vectors */
+
+   if (driver.lockFileName[0]) {
+      FILE *f = fopen(lockFileName, "rb");
+      ASSERT_MSG(f != NULL, 1, "Could not open '%s'\n", lockFileName);
+      if (ret == 0 || ret == -36 || ret == -37) {
+         ASSERT_MSG(fread(&evecs[primme.nLocal*primme.numOrthoConst],
+               sizeof(PRIMME_NUM), primme.nLocal*primme.numEvals, f) 
+               == (size_t)primme.nLocal*primme.numEvals, 1, 
+               "Could not read '%s'\n", lockFileName);
+      }
+      fclose(f);
+      remove(lockFileName);
+   }
+
+   if (driver.benchFileName[0] && master) {
+      ASSERT_MSG(writeBenchLine(driver.benchFileName, &driver, &primme, method,
+                                ret, wt2-wt1) == 0, 1, "");
+   }
+
    if (driver.checkXFileName[0]) {
       retX = check_solution(driver.checkXFileName, &primme, evals, evecs, rnorms, permutation);
    }
 
+   /* The JSON event stream is well formed and complete */
+   if (driver.checkEventsFileName[0] && master) {
+      if (checkEventsFile(driver.checkEventsFileName, &primme) != 0) {
+         retX = 1;
+      }
+   }
+
+   /* The tuning cache keeps one line per problem */
+   if (driver.checkCache && master && primme.tuningParams.cacheFile) {
+      i = countCacheEntries(&primme);
+      if (i != 1) {
+         fprintf(primme.outputFile, "Warning: %d lines for this problem in %s\n",
+               i, primme.tuningParams.cacheFile);
+         retX = 1;
+      }
+   }
+
    /* --------------------------------------------------------------------- */
    /* Save evecs and primme params  (optional)                              */
    /* --------------------------------------------------------------------- */
@@ -345,6 +482,25 @@ static int real_main (int argc, char *argv[]) {
       fprintf(primme.outputFile, "Restarts  : %-d\n", primme.stats.numRestarts);
       fprintf(primme.outputFile, "Matvecs   : %-d\n", primme.stats.numMatvecs);
       fprintf(primme.outputFile, "Preconds  : %-d\n", primme.stats.numPreconds);
+      fprintf(primme.outputFile, "Bytes moved: %-g\n", primme.stats.bytesMoved);
+      fprintf(primme.outputFile, "Reductions: %-d (%.2f per iteration), "
+            "%-g doubles, %f seconds\n", primme.stats.comm.numReductions,
+            (double)primme.stats.comm.numReductions/
+            max(1, primme.stats.numOuterIterations),
+            primme.stats.comm.numDoubles, primme.stats.comm.time);
+      for (i=0; i < primme_num_phases; i++) {
+         fprintf(primme.outputFile, "  %-12s: %-d, %-g doubles, %f seconds\n",
+               phaseNames[i], primme.stats.commPhase[i].numReductions,
+               primme.stats.commPhase[i].numDoubles,
+               primme.stats.commPhase[i].time);
+      }
+      if (driver.virtualRanks > 1) {
+         fprintf(primme.outputFile, "Virtual ranks: %d, %-.0f reductions "
+               "(%.2f per iteration), %-g bytes\n", driver.virtualRanks,
+               numReductions,
+               numReductions/max(1, primme.stats.numOuterIterations),
+               reductionBytes);
+      }
       if (primme.locking && primme.intWork && primme.intWork[0] == 1) {
          fprintf(primme.outputFile, "\nA locking problem has occurred.\n");
          fprintf(primme.outputFile,
@@ -366,6 +522,19 @@ static int real_main (int argc, char *argv[]) {
       }
    }
 
+   /* Without locking, the converged pairs returned by a stopped solver */
+   /* must be the first initSize ones                                   */
+   if ((ret == -36 || ret == -37) && !primme.locking && primme.aNorm > 0.0
+         && master) {
+      for (i=0; i < primme.initSize; i++) {
+         if (rnorms[i] >= primme.eps*primme.aNorm) {
+            fprintf(primme.outputFile, "Warning: Eval[%d] is among the first "
+                  "%d pairs but it is not converged\n", i+1, primme.initSize);
+            retX = 1;
+         }
+      }
+   }
+
    fclose(primme.outputFile);
    destroyMatrixAndPrecond(&driver, &primme, permutation);
    primme_Free(&primme);
@@ -373,12 +542,28 @@ static int real_main (int argc, char *argv[]) {
    free(evecs);
    free(rnorms);
 
+   /* A stop requested by driver.stopAfter, or an exhausted budget after */
+   /* driver.minConverged pairs have converged, is expected              */
+   if (ret == -36 && driver.stopAfter > 0 && primme.initSize >= driver.stopAfter) {
+      ret = 0;
+   }
+   if (ret == -37 && driver.minConverged > 0
+         && primme.initSize >= driver.minConverged) {
+      ret = 0;
+   }
+
    if (ret != 0 && master) {
       fprintf(primme.outputFile, 
          "Error: dprimme returned with nonzero exit status: %d \n",ret);
       return -1;
    }
 
+   if (retResolve != 0 && master) {
+      fprintf(primme.outputFile, 
+         "Error: the second solve did not take fewer matvecs than the first\n");
+      return -1;
+   }
+
    if (retX != 0 && master) {
       fprintf(primme.outputFile, 
          "Error: found some issues in the solution return by dprimme\n");
@@ -394,6 +579,211 @@ static int real_main (int argc, char *argv[]) {
 /******************************************************************************/
 /* Matvec, preconditioner and other utilities                                 */
 
+/******************************************************************************/
+/* Timers for driver.benchFile: the matvec and the preconditioner set by      */
+/* setMatrixAndPrecond are called through these wrappers                     */
+
+static void (*benchMatvec)(void *, void *, int *, primme_params *);
+static void (*benchPrecond)(void *, void *, int *, primme_params *);
+static double benchTimeMatvec, benchTimePrecond;
+
+static void benchMatrixMatvec(void *x, void *y, int *blockSize, 
+                              primme_params *primme) {
+   double t = primme_get_wtime();
+   benchMatvec(x, y, blockSize, primme);
+   benchTimeMatvec += primme_get_wtime() - t;
+}
+
+static void benchApplyPreconditioner(void *x, void *y, int *blockSize, 
+                                     primme_params *primme) {
+   double t = primme_get_wtime();
+   benchPrecond(x, y, blockSize, primme);
+   benchTimePrecond += primme_get_wtime() - t;
+}
+
+static void setBenchTimers(primme_params *primme) {
+   benchTimeMatvec = benchTimePrecond = 0.0;
+   benchMatvec = primme->matrixMatvec;
+   primme->matrixMatvec = benchMatrixMatvec;
+   if (primme->applyPreconditioner) {
+      benchPrecond = primme->applyPreconditioner;
+      primme->applyPreconditioner = benchApplyPreconditioner;
+   }
+}
+
+/******************************************************************************/
+/* Monitor for driver.stopAfter: ask the solver to stop once that many pairs */
+/* have converged                                                            */
+
+static int stopAfterMonitor(primme_monitor *info, primme_params *primme) {
+   (void)primme;
+   return info->numConverged >= stopAfter;
+}
+
+/******************************************************************************/
+/* Monitor for driver.timeOutAfter: once that many pairs have converged, set  */
+/* the smallest maxTime so that the solver stops at the next time check       */
+
+static int timeOutAfterMonitor(primme_monitor *info, primme_params *primme) {
+   if (info->numConverged >= timeOutAfter) primme->maxTime = 1e-300;
+   return 0;
+}
+
+/******************************************************************************/
+/* Restart policy for driver.greedyRestart: keep every Ritz vector, from both */
+/* ends, so PRIMME has to leave the vacancies for the next block by itself    */
+
+static int greedyRestartPolicy(double *hVals, int basisSize, int lMin,
+   int numFree, int target, int *right, primme_params *primme) {
+   (void)hVals; (void)lMin; (void)numFree; (void)target; (void)primme;
+   *right = basisSize;
+   return basisSize;
+}
+
+/******************************************************************************
+ * Returns the number of lines in tuningParams.cacheFile with the key of the
+ * problem (n, cacheKey, target, numEvals, deterministic), or -1 if the file
+ * cannot be read.
+ ******************************************************************************/
+static int countCacheEntries(primme_params *primme) {
+
+   FILE *f;
+   char line[1024];
+   int count=0, n, target, numEvals, deterministic;
+   long int key;
+
+   if (!(f = fopen(primme->tuningParams.cacheFile, "r"))) return -1;
+   while (fgets(line, sizeof(line), f)) {
+      if (sscanf(line, "%d %ld %d %d %d", &n, &key, &target, &numEvals,
+                 &deterministic) == 5
+            && n == primme->n && key == primme->tuningParams.cacheKey
+            && target == (int)primme->target && numEvals == primme->numEvals
+            && deterministic == (primme->tuningParams.deterministic != 0)) {
+         count++;
+      }
+   }
+   fclose(f);
+   return count;
+}
+
+/******************************************************************************
+ * Parses the JSON event stream written by primme in eventsFileName and
+ * reports the number of records of each type. Returns nonzero if the file
+ * is empty, a line is not a record, or the stream misses the records every
+ * run writes: some outer iterations, one timing record per phase and, with
+ * locking, one lock record per converged pair.
+ ******************************************************************************/
+#undef __FUNCT__
+#define __FUNCT__ "checkEventsFile"
+static int checkEventsFile(const char *eventsFileName, primme_params *primme) {
+
+   static const char *types[] = {"outer", "restart", "lock", "inner",
+      "switch", "timing", "counter"};
+   const int numTypes = sizeof(types)/sizeof(types[0]);
+   int counts[sizeof(types)/sizeof(types[0])];
+   char line[1024], type[16], index[32], reason[32], end;
+   double time, value, resNorm;
+   int i, lineNumber=0, matvecs, iterations, count;
+   FILE *f;
+
+   ASSERT_MSG((f = fopen(eventsFileName, "r")), 1,
+         "Could not open events file %s\n", eventsFileName);
+   for (i=0; i < numTypes; i++) counts[i] = 0;
+   while (fgets(line, sizeof(line), f)) {
+      lineNumber++;
+      if (sscanf(line, "{\"event\":\"%15[a-z]\",\"time\":%le,\"matvecs\":%d,"
+               "\"iterations\":%d,\"index\":%31[^,],\"count\":%d,"
+               "\"reason\":%31[^,],\"value\":%le,\"resNorm\":%le%c",
+               type, &time, &matvecs, &iterations, index, &count, reason,
+               &value, &resNorm, &end) != 10 || end != '}'
+            || matvecs < 0 || matvecs > primme->stats.numMatvecs) {
+         fclose(f);
+         ASSERT_MSG(0, 1, "Malformed record at line %d of %s\n", lineNumber,
+               eventsFileName);
+      }
+      for (i=0; i < numTypes && strcmp(type, types[i]) != 0; i++);
+      if (i >= numTypes) {
+         fclose(f);
+         ASSERT_MSG(0, 1, "Unknown event '%s' at line %d of %s\n", type,
+               lineNumber, eventsFileName);
+      }
+      counts[i]++;
+   }
+   fclose(f);
+
+   fprintf(primme->outputFile, "Events:");
+   for (i=0; i < numTypes; i++) {
+      fprintf(primme->outputFile, " %d %s", counts[i], types[i]);
+   }
+   fprintf(primme->outputFile, "\n");
+
+   ASSERT_MSG(lineNumber > 0, 1, "No records in %s\n", eventsFileName);
+   ASSERT_MSG(counts[primme_event_outer] > 0, 1,
+         "No outer iteration records in %s\n", eventsFileName);
+   ASSERT_MSG(counts[primme_event_timing] == primme_num_phases, 1,
+         "%d timing records in %s, expected %d\n",
+         counts[primme_event_timing], eventsFileName, primme_num_phases);
+   ASSERT_MSG(!primme->locking || counts[primme_event_lock] == primme->initSize,
+         1, "%d lock records in %s, expected %d\n", counts[primme_event_lock],
+         eventsFileName, primme->initSize);
+   return 0;
+}
+
+/******************************************************************************
+ * Appends to benchFileName a CSV line with the configuration and the
+ * performance of the run; the header is written if the file is empty.
+ * The timing columns are the total wallclock time, the time in the matvec,
+ * in the preconditioner and in the rest (the solver), and the peak resident
+ * memory of the process in MB (0 if not available).
+ ******************************************************************************/
+#undef __FUNCT__
+#define __FUNCT__ "writeBenchLine"
+static int writeBenchLine(const char *benchFileName, driver_params *driver,
+                          primme_params *primme, primme_preset_method method,
+                          int ret, double time) {
+
+   static const char *strTarget[] = {"smallest", "largest", "closest_geq",
+                                     "closest_leq", "closest_abs"};
+   const char *strPrecChoice[] = {"noprecond", "jacobi", "davidsonjacobi", "ilut"};
+   double peakMem = 0.0;
+   FILE *f;
+
+#if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
+   struct rusage usage;
+   if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#  if defined (__APPLE__)
+      peakMem = usage.ru_maxrss/1048576.0;  /* bytes */
+#  else
+      peakMem = usage.ru_maxrss/1024.0;     /* kilobytes */
+#  endif
+   }
+#endif
+
+   f = fopen(benchFileName, "a");
+   ASSERT_MSG(f != NULL, -1, "Could not open '%s'\n", benchFileName);
+   fseek(f, 0, SEEK_END);
+   if (ftell(f) == 0) {
+      fprintf(f, "precision,matrix,n,precond,method,blockSize,target,numEvals,"
+            "eps,status,converged,time,matvecs,preconds,iterations,restarts,"
+            "timeMatvec,timePrecond,timeSolver,peakMemMB\n");
+   }
+#ifdef USE_DOUBLECOMPLEX
+   fprintf(f, "doublecomplex,");
+#else
+   fprintf(f, "double,");
+#endif
+   fprintf(f, "%s,%d,%s,%s,%d,%s,%d,%g,%d,%d,%.6f,%d,%d,%d,%d,%.6f,%.6f,%.6f,%.1f\n",
+         driver->matrixFileName, primme->n, strPrecChoice[driver->PrecChoice],
+         driver_method_name(method), primme->maxBlockSize,
+         strTarget[primme->target], primme->numEvals, primme->eps, ret,
+         primme->initSize, time, primme->stats.numMatvecs,
+         primme->stats.numPreconds, primme->stats.numOuterIterations,
+         primme->stats.numRestarts, benchTimeMatvec, benchTimePrecond,
+         time - benchTimeMatvec - benchTimePrecond, peakMem);
+   fclose(f);
+   return 0;
+}
+
 /******************************************************************************/
 
 #ifdef USE_MPI
@@ -421,6 +811,20 @@ static void broadCast(primme_params *primme, primme_preset_method *method,
    MPI_Bcast(&driver->threshold, 1, MPI_DOUBLE, 0, comm);
    MPI_Bcast(&driver->filter, 1, MPI_DOUBLE, 0, comm);
    MPI_Bcast(&driver->shift, 1, MPI_DOUBLE, 0, comm);
+   MPI_Bcast(&driver->slices, 1, MPI_INT, 0, comm);
+   MPI_Bcast(&driver->sliceLower, 1, MPI_DOUBLE, 0, comm);
+   MPI_Bcast(&driver->sliceUpper, 1, MPI_DOUBLE, 0, comm);
+   MPI_Bcast(driver->lockFileName, 1024, MPI_CHAR, 0, comm);
+   MPI_Bcast(driver->benchFileName, 1024, MPI_CHAR, 0, comm);
+   MPI_Bcast(&driver->stopAfter, 1, MPI_INT, 0, comm);
+   MPI_Bcast(&driver->minConverged, 1, MPI_INT, 0, comm);
+   MPI_Bcast(&driver->timeOutAfter, 1, MPI_INT, 0, comm);
+   MPI_Bcast(&driver->checkCache, 1, MPI_INT, 0, comm);
+   MPI_Bcast(driver->checkEventsFileName, 1024, MPI_CHAR, 0, comm);
+   MPI_Bcast(&driver->virtualRanks, 1, MPI_INT, 0, comm);
+   MPI_Bcast(&driver->virtualLatency, 1, MPI_DOUBLE, 0, comm);
+   MPI_Bcast(&driver->resolve, 1, MPI_INT, 0, comm);
+   MPI_Bcast(&driver->greedyRestart, 1, MPI_INT, 0, comm);
 
    MPI_Bcast(&(primme->numEvals), 1, MPI_INT, 0, comm);
    MPI_Bcast(&(primme->target), 1, MPI_INT, 0, comm);
@@ -442,10 +846,16 @@ static void broadCast(primme_params *primme, primme_preset_method *method,
    MPI_Bcast(&(primme->maxBlockSize), 1, MPI_INT, 0, comm);
    MPI_Bcast(&(primme->maxMatvecs), 1, MPI_INT, 0, comm);
    MPI_Bcast(&(primme->maxOuterIterations), 1, MPI_INT, 0, comm);
+   MPI_Bcast(&(primme->maxTime), 1, MPI_DOUBLE, 0, comm);
+   MPI_Bcast(&(primme->denseThreshold), 1, MPI_INT, 0, comm);
    MPI_Bcast(&(primme->aNorm), 1, MPI_DOUBLE, 0, comm);
    MPI_Bcast(&(primme->eps), 1, MPI_DOUBLE, 0, comm);
    MPI_Bcast(&(primme->printLevel), 1, MPI_INT, 0, comm);
 
+   MPI_Bcast(&(primme->projectionParams.projection), 1, MPI_INT, 0, comm);
+
+   MPI_Bcast(&(primme->lockStoreParams.panelSize), 1, MPI_INT, 0, comm);
+
    MPI_Bcast(&(primme->restartingParams.scheme), 1, MPI_INT, 0, comm);
    MPI_Bcast(&(primme->restartingParams.maxPrevRetain), 1, MPI_INT, 0, comm);
 
@@ -510,6 +920,10 @@ static int setMatrixAndPrecond(driver_params *driver, primme_params *primme, int
             return -1;
          primme->matrix = matrix;
          primme->matrixMatvec = CSRMatrixMatvec;
+         if (driver->splitMatvec) {
+            primme->matrixMatvecBegin = CSRMatrixMatvecBegin;
+            primme->matrixMatvecEnd = CSRMatrixMatvecEnd;
+         }
          primme->n = primme->nLocal = matrix->n;
          switch(driver->PrecChoice) {
          case driver_noprecond:
@@ -760,6 +1174,7 @@ static int check_solution(const char *checkXFileName, primme_params *primme, dou
       CHECK_PRIMME_PARAM(numOrthoConst);
       CHECK_PRIMME_PARAM(maxBasisSize);
       CHECK_PRIMME_PARAM(minRestartSize);
+      CHECK_PRIMME_PARAM(projectionParams.projection);
       CHECK_PRIMME_PARAM(restartingParams.scheme);
       CHECK_PRIMME_PARAM(restartingParams.maxPrevRetain);
       CHECK_PRIMME_PARAM(correctionParams.precondition);
@@ -0,0 +1,323 @@
+/*******************************************************************************
+ *   PRIMME PReconditioned Iterative MultiMethod Eigensolver
+ *   Copyright (C) 2015 College of William & Mary,
+ *   James R. McCombs, Eloy Romero Alcalde, Andreas Stathopoulos, Lingfei Wu
+ *
+ *   This file is part of PRIMME.
+ *
+ *   PRIMME is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   PRIMME is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *******************************************************************************
+ * File: kernel_bench.c
+ *
+ * Purpose - Microbenchmark of the internal routines of the solver, each one
+ *           called in isolation on a synthetic state instead of inside
+ *           main_iter.
+ *
+ *  Usage: kernel_bench_double [n [basisSize [blockSize [numLocked [reps
+ *                             [warmup [innerIts]]]]]]]
+ *         kernel_bench_doublecomplex ...
+ *
+ *  The state is built with the matrix tridiag(-1,2,-1) of size n: numLocked
+ *  orthonormal locked vectors, an orthonormal basis V of basisSize-blockSize
+ *  vectors orthogonal to them, W=A*V and H=V'*A*V. Then it times, after
+ *  warmup untimed calls, reps calls of
+ *
+ *    ortho        orthogonalization of a random block of blockSize vectors
+ *                 against V and the locked vectors
+ *    update_proj  the new blockSize columns of H, after the block is added
+ *    solve_H      the Rayleigh-Ritz on the full basisSize basis
+ *    restart      restarting the full basis to minRestartSize vectors, with
+ *                 maxPrevRetain vectors of the previous step, with locking
+ *    inner_solve  the unpreconditioned JDQMR solve of the first Ritz pair,
+ *                 with the projectors (I-QQ')(I-xx') on both sides and up to
+ *                 innerIts iterations
+ *
+ *  The state modified by a routine is restored before every call, outside
+ *  the timed region. For every routine it prints the minimum, median, mean
+ *  and maximum time per call, and the matvecs per call.
+ *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "primme.h"
+#include "num.h"
+#include "wtime.h"
+#ifdef USE_DOUBLECOMPLEX
+#  include "../PRIMMESRC/ZSRC/ortho_z.h"
+#  include "../PRIMMESRC/ZSRC/update_W_z.h"
+#  include "../PRIMMESRC/ZSRC/update_projection_z.h"
+#  include "../PRIMMESRC/ZSRC/solve_H_z.h"
+#  include "../PRIMMESRC/ZSRC/restart_z.h"
+#  include "../PRIMMESRC/ZSRC/inner_solve_z.h"
+#else
+#  include "../PRIMMESRC/DSRC/ortho_d.h"
+#  include "../PRIMMESRC/DSRC/update_W_d.h"
+#  include "../PRIMMESRC/DSRC/update_projection_d.h"
+#  include "../PRIMMESRC/DSRC/solve_H_d.h"
+#  include "../PRIMMESRC/DSRC/restart_d.h"
+#  include "../PRIMMESRC/DSRC/inner_solve_d.h"
+#endif
+
+static void laplacianMatvec(void *x, void *y, int *blockSize,
+      primme_params *primme) {
+   int i, j, n = primme->n;
+   PRIMME_NUM *xv, *yv;
+
+   for (j=0; j < *blockSize; j++) {
+      xv = (PRIMME_NUM *)x + n*j;
+      yv = (PRIMME_NUM *)y + n*j;
+      for (i=0; i < n; i++) {
+         yv[i] = 2.0*xv[i] - (i > 0 ? xv[i-1] : 0.0)
+            - (i < n-1 ? xv[i+1] : 0.0);
+      }
+   }
+}
+
+static void fill(int n, PRIMME_NUM *x, int seed) {
+   int i;
+   for (i=0; i < n; i++) {
+      x[i] = sin(seed + i*1.1) + cos(seed*3 + i*0.7)*IMAGINARY;
+   }
+}
+
+static int compareDoubles(const void *a, const void *b) {
+   double x = *(const double *)a, y = *(const double *)b;
+   return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void report(const char *op, double *times, int reps, double matvecs) {
+   int r;
+   double mean = 0.0;
+
+   for (r=0; r < reps; r++) mean += times[r];
+   qsort(times, reps, sizeof(double), compareDoubles);
+   printf("%-12s %12.3e %12.3e %12.3e %12.3e %8.1f\n", op, times[0],
+         times[reps/2], mean/reps, times[reps-1], matvecs/reps);
+}
+
+/* Orthogonalize X(:,B1:B2) against the first NL columns of L */
+
+#define ORTHO(X, B1, B2, L, NL) \
+   SUF(ortho)(COMPLEXZ(X), n, B1, B2, COMPLEXZ(L), n, NL, n, primme.iseed, \
+         machEps, COMPLEXZ(rwork), rworkSize, &primme)
+
+int main(int argc, char *argv[]) {
+
+   int n = argc > 1 ? atoi(argv[1]) : 100000;
+   int m = argc > 2 ? atoi(argv[2]) : 24;
+   int b = argc > 3 ? atoi(argv[3]) : 2;
+   int k = argc > 4 ? atoi(argv[4]) : 4;
+   int reps = argc > 5 ? atoi(argv[5]) : 20;
+   int warmup = argc > 6 ? atoi(argv[6]) : 2;
+   int innerIts = argc > 7 ? atoi(argv[7]) : 20;
+   int r, j, m0, maxPrev, numPrev, restartSize, numConvergedStored = 0;
+   int rworkSize, *flags, *iev, *iwork;
+   size_t s = sizeof(PRIMME_NUM);
+   PRIMME_NUM *V, *W, *H, *hVecs, *evecs, *block0, *V0, *W0, *H0, *hVecs0;
+   PRIMME_NUM *prev, *prev0, *x, *res, *res0, *sol, *rwork;
+   PRIMME_NUM tpone = 1.0, tzero = 0.0, xKinvx = 1.0;
+   double *hVals, *hVals0, *times, machEps, largest = 0.0, rnorm, mv, t;
+   primme_params primme;
+
+   if (b < 1 || m <= b || k < 0 || n < m + k + 1 || reps < 1 || warmup < 0) {
+      fprintf(stderr, "ERROR: invalid sizes; it needs 0 < blockSize < "
+            "basisSize and basisSize+numLocked < n\n");
+      return 1;
+   }
+   m0 = m - b;
+
+   /* Set the parameters as dprimme/zprimme would, with locking, no */
+   /* preconditioner and a fixed number of inner iterations         */
+
+   primme_initialize(&primme);
+   primme.n = n;
+   primme.matrixMatvec = laplacianMatvec;
+   primme.numEvals = k + b;
+   primme.maxBasisSize = m;
+   primme.maxBlockSize = b;
+   primme_set_method(DEFAULT_MIN_TIME, &primme);
+   primme.locking = 1;
+   primme.correctionParams.precondition = 0;
+   primme.correctionParams.maxInnerIterations = innerIts;
+   primme.correctionParams.convTest = primme_full_LTolerance;
+   PREFIX(primme)(NULL, NULL, NULL, &primme);
+   for (j=0; j < 4; j++) primme.iseed[j] = j;
+   machEps = MACHINE_EPSILON;
+
+   rworkSize = (int)(primme.realWorkSize/s);
+   maxPrev = primme.restartingParams.maxPrevRetain;
+   V = (PRIMME_NUM *)malloc(s*n*m);
+   W = (PRIMME_NUM *)malloc(s*n*m);
+   V0 = (PRIMME_NUM *)malloc(s*n*m);
+   W0 = (PRIMME_NUM *)malloc(s*n*m);
+   block0 = (PRIMME_NUM *)malloc(s*n*b);
+   evecs = (PRIMME_NUM *)malloc(s*n*(k+1));
+   x = (PRIMME_NUM *)malloc(s*n);
+   res = (PRIMME_NUM *)malloc(s*n);
+   res0 = (PRIMME_NUM *)malloc(s*n);
+   sol = (PRIMME_NUM *)malloc(s*n);
+   H = (PRIMME_NUM *)malloc(s*m*m);
+   H0 = (PRIMME_NUM *)malloc(s*m*m);
+   hVecs = (PRIMME_NUM *)malloc(s*m*m);
+   hVecs0 = (PRIMME_NUM *)malloc(s*m*m);
+   prev = (PRIMME_NUM *)malloc(s*m*(maxPrev+1));
+   prev0 = (PRIMME_NUM *)malloc(s*m*(maxPrev+1));
+   hVals = (double *)malloc(sizeof(double)*m);
+   hVals0 = (double *)malloc(sizeof(double)*m);
+   times = (double *)malloc(sizeof(double)*(reps+warmup));
+   flags = (int *)malloc(sizeof(int)*m);
+   iev = (int *)malloc(sizeof(int)*b);
+   iwork = (int *)malloc(sizeof(int)*2*m);
+   rwork = (PRIMME_NUM *)malloc(s*rworkSize);
+   if (!V || !W || !V0 || !W0 || !block0 || !evecs || !x || !res || !res0
+         || !sol || !H || !H0 || !hVecs || !hVecs0 || !prev || !prev0
+         || !hVals || !hVals0 || !times || !flags || !iev || !iwork || !rwork) {
+      fprintf(stderr, "ERROR: not enough memory for n=%d basisSize=%d\n", n,
+            m);
+      return 1;
+   }
+   for (j=0; j < b; j++) iev[j] = j;
+
+   /* Locked vectors, and the basis of m-b vectors orthogonal to them */
+
+   fill(n*k, evecs, 1);
+   fill(n*m, V, 2);
+   fill(n*b, block0, 3);
+   if ((k > 0 && ORTHO(evecs, 0, k-1, evecs, 0) < 0) ||
+       ORTHO(V, 0, m-1, evecs, k) < 0) {
+      fprintf(stderr, "ERROR: ortho failed building the state\n");
+      return 1;
+   }
+   SUF(update_W)(COMPLEXZ(V), COMPLEXZ(W), 0, m, &primme);
+   SUF(update_projection)(COMPLEXZ(V), COMPLEXZ(W), COMPLEXZ(H), 0, m, m,
+         COMPLEXZ(rwork), &primme);
+
+   /* Coefficients retained from the previous step, as main_iter does */
+
+   SUF(solve_H)(COMPLEXZ(H), NULL, COMPLEXZ(hVecs), hVals, m0, m, &largest,
+         k, rworkSize, COMPLEXZ(rwork), iwork, &primme);
+   numPrev = min(maxPrev, m0);
+   for (j=0; j < numPrev; j++) {
+      memcpy(&prev0[m*j], &hVecs[m0*j], s*m0);
+      memset(&prev0[m*j+m0], 0, s*(m-m0));
+   }
+
+   SUF(solve_H)(COMPLEXZ(H), NULL, COMPLEXZ(hVecs0), hVals0, m, m, &largest,
+         k, rworkSize, COMPLEXZ(rwork), iwork, &primme);
+   memcpy(V0, V, s*n*m);
+   memcpy(W0, W, s*n*m);
+   memcpy(H0, H, s*m*m);
+
+   /* First Ritz pair and its residual for the inner solver */
+
+   SUF(Num_gemv)("N", n, m, COMPLEXZV(tpone), COMPLEXZ(V), n,
+         COMPLEXZ(hVecs0), 1, COMPLEXZV(tzero), COMPLEXZ(x), 1);
+   SUF(Num_gemv)("N", n, m, COMPLEXZV(tpone), COMPLEXZ(W), n,
+         COMPLEXZ(hVecs0), 1, COMPLEXZV(tzero), COMPLEXZ(res0), 1);
+   SUF(Num_axpy)(n, COMPLEXZV(-hVals0[0]), COMPLEXZ(x), 1, COMPLEXZ(res0), 1);
+   rnorm = sqrt(REAL_PARTZ(SUF(Num_dot)(n, COMPLEXZ(res0), 1,
+               COMPLEXZ(res0), 1)));
+
+   printf("n=%d basisSize=%d blockSize=%d numLocked=%d maxPrevRetain=%d "
+         "minRestartSize=%d reps=%d warmup=%d innerIts=%d\n", n, m, b, k,
+         maxPrev, primme.minRestartSize, reps, warmup, innerIts);
+   printf("%-12s %12s %12s %12s %12s %8s\n", "routine", "min (s)",
+         "median (s)", "mean (s)", "max (s)", "MV/call");
+
+   /* ortho of the new block against V(:,0:m-b-1) and the locked vectors */
+
+   for (r=0; r < warmup + reps; r++) {
+      memcpy(&V[n*m0], block0, s*n*b);
+      t = primme_wTimer(0);
+      ORTHO(V, m0, m-1, evecs, k);
+      times[r] = primme_wTimer(0) - t;
+   }
+   report("ortho", times+warmup, reps, 0.0);
+
+   /* H(:,m-b:m-1) */
+
+   for (r=0; r < warmup + reps; r++) {
+      t = primme_wTimer(0);
+      SUF(update_projection)(COMPLEXZ(V0), COMPLEXZ(W0), COMPLEXZ(H), m0, m,
+            b, COMPLEXZ(rwork), &primme);
+      times[r] = primme_wTimer(0) - t;
+   }
+   report("update_proj", times+warmup, reps, 0.0);
+
+   /* Rayleigh-Ritz */
+
+   for (r=0; r < warmup + reps; r++) {
+      memcpy(H, H0, s*m*m);
+      t = primme_wTimer(0);
+      SUF(solve_H)(COMPLEXZ(H), NULL, COMPLEXZ(hVecs), hVals, m, m, &largest,
+            k, rworkSize, COMPLEXZ(rwork), iwork, &primme);
+      times[r] = primme_wTimer(0) - t;
+   }
+   report("solve_H", times+warmup, reps, 0.0);
+
+   /* restart V, W and H */
+
+   for (r=0; r < warmup + reps; r++) {
+      memcpy(V, V0, s*n*m);
+      memcpy(W, W0, s*n*m);
+      memcpy(H, H0, s*m*m);
+      memcpy(hVecs, hVecs0, s*m*m);
+      memcpy(hVals, hVals0, sizeof(double)*m);
+      memcpy(prev, prev0, s*m*numPrev);
+      SUF(reset_flags)(flags, 0, m-1);
+      t = primme_wTimer(0);
+      restartSize = SUF(restart)(COMPLEXZ(V), COMPLEXZ(W), COMPLEXZ(H), NULL,
+            COMPLEXZ(hVecs), hVals, flags, iev, COMPLEXZ(evecs), NULL, NULL,
+            NULL, NULL, m, 0, &numConvergedStored, NULL, k, 0, COMPLEXZ(prev),
+            numPrev, machEps, COMPLEXZ(rwork), rworkSize, &primme);
+      times[r] = primme_wTimer(0) - t;
+      if (restartSize < 0) {
+         fprintf(stderr, "ERROR: restart returned %d\n", restartSize);
+         return 1;
+      }
+   }
+   report("restart", times+warmup, reps, 0.0);
+
+   /* JDQMR on the first Ritz pair; x is placed after the locked vectors */
+   /* as the left projector [Q x], as setup_JD_projectors does           */
+
+   memcpy(&evecs[n*k], x, s*n);
+   mv = 0.0;
+   for (r=0; r < warmup + reps; r++) {
+      double rn = rnorm;
+      int mv0 = primme.stats.numMatvecs;
+      memcpy(res, res0, s*n);
+      t = primme_wTimer(0);
+      SUF(inner_solve)(COMPLEXZ(x), COMPLEXZ(res), &rn, COMPLEXZ(evecs), NULL,
+            NULL, NULL, COMPLEXZ(&xKinvx), COMPLEXZ(evecs), COMPLEXZ(evecs),
+            COMPLEXZ(x), k+1, k, 1, COMPLEXZ(sol), hVals0[0], hVals0[0],
+            machEps*4.0, 4.0, machEps, COMPLEXZ(rwork), rworkSize, &primme);
+      times[r] = primme_wTimer(0) - t;
+      if (r >= warmup) mv += primme.stats.numMatvecs - mv0;
+   }
+   report("inner_solve", times+warmup, reps, mv);
+
+   free(V); free(W); free(V0); free(W0); free(block0); free(evecs); free(x);
+   free(res); free(res0); free(sol); free(H); free(H0); free(hVecs);
+   free(hVecs0); free(prev); free(prev0); free(hVals); free(hVals0);
+   free(times); free(flags); free(iev); free(iwork); free(rwork);
+   primme_Free(&primme);
+
+   return 0;
+}